@@ -0,0 +1,441 @@
+#include "Blend.hpp"
+
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BLEND_SSE2
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+// avx2 is compiled in for just these functions and only used if the cpu turns out to have it
+#include <immintrin.h>
+#define BLEND_AVX2
+#if defined(__GNUC__)
+#define BLEND_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BLEND_TARGET_AVX2
+#endif
+#endif
+#elif defined(__wasm_simd128__)
+// there's no checking for features at runtime in wasm, so this is only used when building with -msimd128
+#include <wasm_simd128.h>
+#define BLEND_WASM_SIMD
+#endif
+
+/*
+* The compositing here follows the W3C compositing spec for separable blend modes:
+*   co = cs*as*(1 - ab) + B(cb, cs)*as*ab + cb*ab*(1 - as)
+*   ao = as + ab*(1 - as)
+* with colors in 0 to 1. co comes out premultiplied, so it's divided by ao to get back to straight alpha.
+* Erase is Porter-Duff destination out instead: ao = ab*(1 - as), and the color doesn't change.
+* Anything that ends up with an alpha that rounds to 0 is set to all 0s, so erased tiles can be freed.
+*
+* Every kernel is a template on the mode, and on whether src is a whole span or one color used for every pixel.
+* The vector kernels do the same float operations in the same order as the scalar one, and round the same way
+* (adding a half and truncating), so every instruction set gives exactly the same pixels.
+*/
+
+// smallest alpha (0 to 1) that doesn't round down to 0
+#define MIN_VISIBLE_ALPHA (0.5f / 255.0f)
+
+const char* getBlendModeName(BlendMode mode) {
+    switch (mode) {
+        case BLEND_NORMAL: return "Normal";
+        case BLEND_MULTIPLY: return "Multiply";
+        case BLEND_SCREEN: return "Screen";
+        case BLEND_ADD: return "Add";
+        case BLEND_LIGHTEN: return "Lighten";
+        case BLEND_DARKEN: return "Darken";
+        case BLEND_ERASE: return "Erase";
+        default: return "Unknown";
+    }
+}
+
+template<BlendMode Mode>
+static inline float blendChannel(float cb, float cs) {
+    switch (Mode) {
+        case BLEND_MULTIPLY: return cb * cs;
+        case BLEND_SCREEN: return cb + cs - cb * cs;
+        case BLEND_ADD: return std::min(cb + cs, 1.0f);
+        case BLEND_LIGHTEN: return std::max(cb, cs);
+        case BLEND_DARKEN: return std::min(cb, cs);
+        default: return cs;
+    }
+}
+
+template<BlendMode Mode>
+static inline Pixel blendPixel(Pixel b, Pixel s, float opacity) {
+    const float scale = 1.0f / 255.0f;
+    float as = s.a * scale * opacity;
+    float ab = b.a * scale;
+    float both = as * ab;
+    if (Mode == BLEND_ERASE) {
+        float ao = ab - both;
+        if (ao < MIN_VISIBLE_ALPHA) {
+            return (Pixel){0, 0, 0, 0};
+        }
+        return (Pixel){b.r, b.g, b.b, (Uint8)(ao * 255.0f + 0.5f)};
+    }
+    float ao = as + ab - both;
+    if (ao < MIN_VISIBLE_ALPHA) {
+        return (Pixel){0, 0, 0, 0};
+    }
+    float srcOnly = as - both;
+    float backdropOnly = ab - both;
+    Uint8 channels[3];
+    const Uint8 sc[3] = {s.r, s.g, s.b};
+    const Uint8 bc[3] = {b.r, b.g, b.b};
+    for (int c = 0; c < 3; c++) {
+        float cs = sc[c] * scale;
+        float cb = bc[c] * scale;
+        float co = cs * srcOnly + blendChannel<Mode>(cb, cs) * both + cb * backdropOnly;
+        channels[c] = (Uint8)std::min(co / ao * 255.0f + 0.5f, 255.0f);
+    }
+    return (Pixel){channels[0], channels[1], channels[2], (Uint8)(ao * 255.0f + 0.5f)};
+}
+
+template<BlendMode Mode, bool Solid>
+static void blendSpanScalar(Pixel* dst, const Pixel* backdrop, const Pixel* src, int count, float opacity) {
+    for (int i = 0; i < count; i++) {
+        dst[i] = blendPixel<Mode>(backdrop[i], src[Solid ? 0 : i], opacity);
+    }
+}
+
+#ifdef BLEND_SSE2
+
+template<BlendMode Mode>
+static inline __m128 blendChannelsSSE2(__m128 cb, __m128 cs) {
+    switch (Mode) {
+        case BLEND_MULTIPLY: return _mm_mul_ps(cb, cs);
+        case BLEND_SCREEN: return _mm_sub_ps(_mm_add_ps(cb, cs), _mm_mul_ps(cb, cs));
+        case BLEND_ADD: return _mm_min_ps(_mm_add_ps(cb, cs), _mm_set1_ps(1.0f));
+        case BLEND_LIGHTEN: return _mm_max_ps(cb, cs);
+        case BLEND_DARKEN: return _mm_min_ps(cb, cs);
+        default: return cs;
+    }
+}
+
+/*
+* Blend one pixel, held as r,g,b,a floats in the lanes of a vector, already scaled to 0 to 1.
+* @return The result scaled back up to 0 to 255
+*/
+template<BlendMode Mode>
+static inline __m128 blendPixelSSE2(__m128 cb, __m128 cs, __m128 opacity) {
+    const __m128 alphaLane = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+    __m128 as = _mm_mul_ps(_mm_shuffle_ps(cs, cs, _MM_SHUFFLE(3, 3, 3, 3)), opacity);
+    __m128 ab = _mm_shuffle_ps(cb, cb, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128 both = _mm_mul_ps(as, ab);
+    __m128 ao, color;
+    if (Mode == BLEND_ERASE) {
+        ao = _mm_sub_ps(ab, both);
+        color = cb;
+    } else {
+        ao = _mm_sub_ps(_mm_add_ps(as, ab), both);
+        __m128 co = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(cs, _mm_sub_ps(as, both)), // as*(1 - ab)
+            _mm_mul_ps(blendChannelsSSE2<Mode>(cb, cs), both)),
+            _mm_mul_ps(cb, _mm_sub_ps(ab, both))); // ab*(1 - as)
+        // keep the divide away from 0, those pixels get zeroed anyway
+        color = _mm_div_ps(co, _mm_max_ps(ao, _mm_set1_ps(MIN_VISIBLE_ALPHA)));
+    }
+    __m128 result = _mm_or_ps(_mm_andnot_ps(alphaLane, color), _mm_and_ps(alphaLane, ao));
+    result = _mm_and_ps(result, _mm_cmpge_ps(ao, _mm_set1_ps(MIN_VISIBLE_ALPHA)));
+    return _mm_mul_ps(result, _mm_set1_ps(255.0f));
+}
+
+/*
+* Split 4 packed pixels into a float vector each, scaled to 0 to 1.
+*/
+static inline void unpackPixelsSSE2(__m128i pixels, __m128 out[4]) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+    __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+    __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+    out[0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale);
+    out[1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale);
+    out[2] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale);
+    out[3] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale);
+}
+
+template<BlendMode Mode, bool Solid>
+static void blendSpanSSE2(Pixel* dst, const Pixel* backdrop, const Pixel* src, int count, float opacity) {
+    const __m128 opacityVector = _mm_set1_ps(opacity);
+    const __m128 half = _mm_set1_ps(0.5f);
+    __m128 solid[4];
+    if (Solid) {
+        Uint32 packed;
+        memcpy(&packed, src, sizeof(packed));
+        unpackPixelsSSE2(_mm_set1_epi32((int)packed), solid);
+    }
+    int i = 0;
+    // 4 pixels at a time, one pixel per float vector
+    for (; i + 4 <= count; i += 4) {
+        __m128 cb[4], cs[4];
+        unpackPixelsSSE2(_mm_loadu_si128((const __m128i*)&backdrop[i]), cb);
+        if (!Solid) {
+            unpackPixelsSSE2(_mm_loadu_si128((const __m128i*)&src[i]), cs);
+        }
+        __m128i out32[4];
+        for (int p = 0; p < 4; p++) {
+            // everything is positive, so adding a half and truncating rounds like the scalar kernel.
+            // cvtps would round halves to even instead
+            __m128 blended = blendPixelSSE2<Mode>(cb[p], Solid ? solid[0] : cs[p], opacityVector);
+            out32[p] = _mm_cvttps_epi32(_mm_add_ps(blended, half));
+        }
+        __m128i out16lo = _mm_packs_epi32(out32[0], out32[1]);
+        __m128i out16hi = _mm_packs_epi32(out32[2], out32[3]);
+        _mm_storeu_si128((__m128i*)&dst[i], _mm_packus_epi16(out16lo, out16hi));
+    }
+    blendSpanScalar<Mode, Solid>(dst + i, backdrop + i, Solid ? src : src + i, count - i, opacity);
+}
+
+#endif
+
+#ifdef BLEND_AVX2
+
+// same as the sse2 kernel, but with 2 pixels per vector, one in each 128 bit lane
+
+template<BlendMode Mode>
+BLEND_TARGET_AVX2 static inline __m256 blendChannelsAVX2(__m256 cb, __m256 cs) {
+    switch (Mode) {
+        case BLEND_MULTIPLY: return _mm256_mul_ps(cb, cs);
+        case BLEND_SCREEN: return _mm256_sub_ps(_mm256_add_ps(cb, cs), _mm256_mul_ps(cb, cs));
+        case BLEND_ADD: return _mm256_min_ps(_mm256_add_ps(cb, cs), _mm256_set1_ps(1.0f));
+        case BLEND_LIGHTEN: return _mm256_max_ps(cb, cs);
+        case BLEND_DARKEN: return _mm256_min_ps(cb, cs);
+        default: return cs;
+    }
+}
+
+template<BlendMode Mode>
+BLEND_TARGET_AVX2 static inline __m256 blendPixelPairAVX2(__m256 cb, __m256 cs, __m256 opacity) {
+    const __m256 alphaLane = _mm256_castsi256_ps(_mm256_setr_epi32(0, 0, 0, -1, 0, 0, 0, -1));
+    __m256 as = _mm256_mul_ps(_mm256_shuffle_ps(cs, cs, _MM_SHUFFLE(3, 3, 3, 3)), opacity);
+    __m256 ab = _mm256_shuffle_ps(cb, cb, _MM_SHUFFLE(3, 3, 3, 3));
+    __m256 both = _mm256_mul_ps(as, ab);
+    __m256 ao, color;
+    if (Mode == BLEND_ERASE) {
+        ao = _mm256_sub_ps(ab, both);
+        color = cb;
+    } else {
+        ao = _mm256_sub_ps(_mm256_add_ps(as, ab), both);
+        __m256 co = _mm256_add_ps(_mm256_add_ps(
+            _mm256_mul_ps(cs, _mm256_sub_ps(as, both)),
+            _mm256_mul_ps(blendChannelsAVX2<Mode>(cb, cs), both)),
+            _mm256_mul_ps(cb, _mm256_sub_ps(ab, both)));
+        color = _mm256_div_ps(co, _mm256_max_ps(ao, _mm256_set1_ps(MIN_VISIBLE_ALPHA)));
+    }
+    __m256 result = _mm256_blendv_ps(color, ao, alphaLane);
+    result = _mm256_and_ps(result, _mm256_cmp_ps(ao, _mm256_set1_ps(MIN_VISIBLE_ALPHA), _CMP_GE_OQ));
+    return _mm256_mul_ps(result, _mm256_set1_ps(255.0f));
+}
+
+/*
+* Load 2 pixels into a float vector, scaled to 0 to 1.
+*/
+BLEND_TARGET_AVX2 static inline __m256 loadPixelPairAVX2(const Pixel* pixels) {
+    __m256i channels = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)pixels));
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(channels), _mm256_set1_ps(1.0f / 255.0f));
+}
+
+template<BlendMode Mode, bool Solid>
+BLEND_TARGET_AVX2 static void blendSpanAVX2(Pixel* dst, const Pixel* backdrop, const Pixel* src, int count, float opacity) {
+    const __m256 opacityVector = _mm256_set1_ps(opacity);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const Pixel solidPair[2] = {src[0], src[0]};
+    const __m256 solid = loadPixelPairAVX2(solidPair);
+    // the packs below work within each 128 bit lane, which leaves the pixels in the order 0 2 4 6 1 3 5 7
+    const __m256i pixelOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i out32[4];
+        for (int pair = 0; pair < 4; pair++) {
+            __m256 cb = loadPixelPairAVX2(&backdrop[i + pair * 2]);
+            __m256 cs = Solid ? solid : loadPixelPairAVX2(&src[i + pair * 2]);
+            out32[pair] = _mm256_cvttps_epi32(_mm256_add_ps(blendPixelPairAVX2<Mode>(cb, cs, opacityVector), half));
+        }
+        __m256i out16lo = _mm256_packs_epi32(out32[0], out32[1]);
+        __m256i out16hi = _mm256_packs_epi32(out32[2], out32[3]);
+        __m256i out8 = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(out16lo, out16hi), pixelOrder);
+        _mm256_storeu_si256((__m256i*)&dst[i], out8);
+    }
+    blendSpanSSE2<Mode, Solid>(dst + i, backdrop + i, Solid ? src : src + i, count - i, opacity);
+}
+
+#endif
+
+#ifdef BLEND_WASM_SIMD
+
+template<BlendMode Mode>
+static inline v128_t blendChannelsWasm(v128_t cb, v128_t cs) {
+    switch (Mode) {
+        case BLEND_MULTIPLY: return wasm_f32x4_mul(cb, cs);
+        case BLEND_SCREEN: return wasm_f32x4_sub(wasm_f32x4_add(cb, cs), wasm_f32x4_mul(cb, cs));
+        case BLEND_ADD: return wasm_f32x4_min(wasm_f32x4_add(cb, cs), wasm_f32x4_splat(1.0f));
+        case BLEND_LIGHTEN: return wasm_f32x4_max(cb, cs);
+        case BLEND_DARKEN: return wasm_f32x4_min(cb, cs);
+        default: return cs;
+    }
+}
+
+template<BlendMode Mode>
+static inline v128_t blendPixelWasm(v128_t cb, v128_t cs, v128_t opacity) {
+    const v128_t alphaLane = wasm_i32x4_make(0, 0, 0, -1);
+    v128_t as = wasm_f32x4_mul(wasm_i32x4_shuffle(cs, cs, 3, 3, 3, 3), opacity);
+    v128_t ab = wasm_i32x4_shuffle(cb, cb, 3, 3, 3, 3);
+    v128_t both = wasm_f32x4_mul(as, ab);
+    v128_t ao, color;
+    if (Mode == BLEND_ERASE) {
+        ao = wasm_f32x4_sub(ab, both);
+        color = cb;
+    } else {
+        ao = wasm_f32x4_sub(wasm_f32x4_add(as, ab), both);
+        v128_t co = wasm_f32x4_add(wasm_f32x4_add(
+            wasm_f32x4_mul(cs, wasm_f32x4_sub(as, both)),
+            wasm_f32x4_mul(blendChannelsWasm<Mode>(cb, cs), both)),
+            wasm_f32x4_mul(cb, wasm_f32x4_sub(ab, both)));
+        color = wasm_f32x4_div(co, wasm_f32x4_max(ao, wasm_f32x4_splat(MIN_VISIBLE_ALPHA)));
+    }
+    v128_t result = wasm_v128_bitselect(ao, color, alphaLane);
+    result = wasm_v128_and(result, wasm_f32x4_ge(ao, wasm_f32x4_splat(MIN_VISIBLE_ALPHA)));
+    return wasm_f32x4_mul(result, wasm_f32x4_splat(255.0f));
+}
+
+static inline void unpackPixelsWasm(v128_t pixels, v128_t out[4]) {
+    const v128_t scale = wasm_f32x4_splat(1.0f / 255.0f);
+    v128_t lo = wasm_u16x8_extend_low_u8x16(pixels);
+    v128_t hi = wasm_u16x8_extend_high_u8x16(pixels);
+    out[0] = wasm_f32x4_mul(wasm_f32x4_convert_i32x4(wasm_u32x4_extend_low_u16x8(lo)), scale);
+    out[1] = wasm_f32x4_mul(wasm_f32x4_convert_i32x4(wasm_u32x4_extend_high_u16x8(lo)), scale);
+    out[2] = wasm_f32x4_mul(wasm_f32x4_convert_i32x4(wasm_u32x4_extend_low_u16x8(hi)), scale);
+    out[3] = wasm_f32x4_mul(wasm_f32x4_convert_i32x4(wasm_u32x4_extend_high_u16x8(hi)), scale);
+}
+
+template<BlendMode Mode, bool Solid>
+static void blendSpanWasm(Pixel* dst, const Pixel* backdrop, const Pixel* src, int count, float opacity) {
+    const v128_t opacityVector = wasm_f32x4_splat(opacity);
+    const v128_t half = wasm_f32x4_splat(0.5f);
+    v128_t solid[4];
+    if (Solid) {
+        unpackPixelsWasm(wasm_v128_load32_splat(src), solid);
+    }
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        v128_t cb[4], cs[4];
+        unpackPixelsWasm(wasm_v128_load(&backdrop[i]), cb);
+        if (!Solid) {
+            unpackPixelsWasm(wasm_v128_load(&src[i]), cs);
+        }
+        v128_t out32[4];
+        for (int p = 0; p < 4; p++) {
+            // everything is positive, so adding a half and truncating rounds
+            v128_t blended = blendPixelWasm<Mode>(cb[p], Solid ? solid[0] : cs[p], opacityVector);
+            out32[p] = wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_add(blended, half));
+        }
+        v128_t out16lo = wasm_i16x8_narrow_i32x4(out32[0], out32[1]);
+        v128_t out16hi = wasm_i16x8_narrow_i32x4(out32[2], out32[3]);
+        wasm_v128_store(&dst[i], wasm_u8x16_narrow_i16x8(out16lo, out16hi));
+    }
+    blendSpanScalar<Mode, Solid>(dst + i, backdrop + i, Solid ? src : src + i, count - i, opacity);
+}
+
+#endif
+
+typedef void (*BlendSpanFunction)(Pixel* dst, const Pixel* backdrop, const Pixel* src, int count, float opacity);
+
+/*
+* One instruction set's kernels for every mode, indexed by BlendMode.
+*/
+struct BlendKernels {
+    BlendSpanFunction spans[BLEND_MODE_COUNT];
+    BlendSpanFunction solidSpans[BLEND_MODE_COUNT];
+};
+
+#define BLEND_KERNELS_FOR_SOURCE(kernel, solid) { \
+    kernel<BLEND_NORMAL, solid>, kernel<BLEND_MULTIPLY, solid>, kernel<BLEND_SCREEN, solid>, kernel<BLEND_ADD, solid>, \
+    kernel<BLEND_LIGHTEN, solid>, kernel<BLEND_DARKEN, solid>, kernel<BLEND_ERASE, solid>}
+#define BLEND_KERNELS(kernel) {BLEND_KERNELS_FOR_SOURCE(kernel, false), BLEND_KERNELS_FOR_SOURCE(kernel, true)}
+
+static const BlendKernels scalarKernels = BLEND_KERNELS(blendSpanScalar);
+#ifdef BLEND_SSE2
+static const BlendKernels sse2Kernels = BLEND_KERNELS(blendSpanSSE2);
+#endif
+#ifdef BLEND_AVX2
+static const BlendKernels avx2Kernels = BLEND_KERNELS(blendSpanAVX2);
+#endif
+#ifdef BLEND_WASM_SIMD
+static const BlendKernels wasmKernels = BLEND_KERNELS(blendSpanWasm);
+#endif
+
+/*
+* @return The kernels of a set, or NULL if they aren't compiled in or the cpu can't run them
+*/
+static const BlendKernels* getKernelSet(BlendKernelSet set) {
+    switch (set) {
+        case BLEND_KERNELS_SCALAR: return &scalarKernels;
+#ifdef BLEND_SSE2
+        case BLEND_KERNELS_SSE2: return &sse2Kernels;
+#endif
+#ifdef BLEND_AVX2
+        case BLEND_KERNELS_AVX2: return SDL_HasAVX2() ? &avx2Kernels : NULL;
+#endif
+#ifdef BLEND_WASM_SIMD
+        case BLEND_KERNELS_WASM_SIMD: return &wasmKernels;
+#endif
+        default: return NULL;
+    }
+}
+
+static const BlendKernels* pickBlendKernels() {
+    // the widest available set
+    for (int set = BLEND_KERNEL_SET_COUNT - 1; set >= 0; set--) {
+        const BlendKernels* kernels = getKernelSet((BlendKernelSet)set);
+        if (kernels) {
+            return kernels;
+        }
+    }
+    return &scalarKernels;
+}
+
+const char* getBlendKernelSetName(BlendKernelSet set) {
+    switch (set) {
+        case BLEND_KERNELS_SCALAR: return "scalar";
+        case BLEND_KERNELS_SSE2: return "SSE2";
+        case BLEND_KERNELS_WASM_SIMD: return "wasm SIMD";
+        case BLEND_KERNELS_AVX2: return "AVX2";
+        default: return "Unknown";
+    }
+}
+
+bool isBlendKernelSetAvailable(BlendKernelSet set) {
+    return getKernelSet(set) != NULL;
+}
+
+void blendPixelSpanWithKernels(BlendKernelSet set, Pixel* dst, const Pixel* backdrop, const Pixel* src, int count,
+    BlendMode mode, float opacity, bool solid) {
+    const BlendKernels* kernels = getKernelSet(set);
+    if (!kernels || (unsigned)mode >= BLEND_MODE_COUNT) {
+        return;
+    }
+    (solid ? kernels->solidSpans : kernels->spans)[mode](dst, backdrop, src, count, opacity);
+}
+
+static const BlendKernels* getBlendKernels() {
+    // layers get composited from the thread pool, but static locals are only initialized once either way
+    static const BlendKernels* kernels = pickBlendKernels();
+    return kernels;
+}
+
+void blendPixelSpan(Pixel* dst, const Pixel* backdrop, const Pixel* src, int count, BlendMode mode, float opacity) {
+    if ((unsigned)mode >= BLEND_MODE_COUNT) {
+        mode = BLEND_NORMAL;
+    }
+    getBlendKernels()->spans[mode](dst, backdrop, src, count, opacity);
+}
+
+void blendColorSpan(Pixel* dst, Pixel color, int count, BlendMode mode) {
+    if ((unsigned)mode >= BLEND_MODE_COUNT) {
+        mode = BLEND_NORMAL;
+    }
+    getBlendKernels()->solidSpans[mode](dst, dst, &color, count, 1.0f);
+}
@@ -0,0 +1,62 @@
+#ifndef BLEND_INCLUDED
+#define BLEND_INCLUDED
+
+#include "Pixel.hpp"
+
+/*
+* How a layer's or the pen's colors combine with what's under it. Alpha always composites source over,
+* except for erase, which takes away from what's under it as much as the source's alpha and ignores its color.
+*/
+enum BlendMode {
+    BLEND_NORMAL,
+    BLEND_MULTIPLY,
+    BLEND_SCREEN,
+    BLEND_ADD,
+    BLEND_LIGHTEN,
+    BLEND_DARKEN,
+    BLEND_ERASE,
+    BLEND_MODE_COUNT
+};
+
+const char* getBlendModeName(BlendMode mode);
+
+/*
+* Composite src over backdrop into dst, pixel by pixel. Pixels are straight (not premultiplied) alpha.
+* dst can be the same as backdrop.
+* Uses the widest vector instructions the cpu has, picked the first time anything is blended.
+* @param opacity Multiplies the alpha of src, from 0 to 1
+*/
+void blendPixelSpan(Pixel* dst, const Pixel* backdrop, const Pixel* src, int count, BlendMode mode, float opacity);
+
+/*
+* Composite one color over count pixels in place, the same as blendPixelSpan with every src pixel set to color.
+*/
+void blendColorSpan(Pixel* dst, Pixel color, int count, BlendMode mode);
+
+/*
+* The instruction sets there are blend kernels for, narrowest to widest. Every set gives exactly the same pixels.
+* blendPixelSpan picks the widest one the cpu has, the rest of these are only for checking and benchmarking the kernels.
+*/
+enum BlendKernelSet {
+    BLEND_KERNELS_SCALAR,
+    BLEND_KERNELS_SSE2,
+    BLEND_KERNELS_WASM_SIMD,
+    BLEND_KERNELS_AVX2,
+    BLEND_KERNEL_SET_COUNT
+};
+
+const char* getBlendKernelSetName(BlendKernelSet set);
+
+/*
+* @return Whether the set's kernels are compiled in and the cpu can run them
+*/
+bool isBlendKernelSetAvailable(BlendKernelSet set);
+
+/*
+* Same as blendPixelSpan with a particular set of kernels. Does nothing if the set isn't available.
+* @param solid Use src[0] for every pixel, like blendColorSpan
+*/
+void blendPixelSpanWithKernels(BlendKernelSet set, Pixel* dst, const Pixel* backdrop, const Pixel* src, int count,
+    BlendMode mode, float opacity, bool solid);
+
+#endif
@@ -0,0 +1,66 @@
+#include "Brush.hpp"
+
+#include <math.h>
+#include <algorithm>
+
+#include "Spans.hpp"
+
+void getBrushRowSpan(BrushShape shape, int size, int row, int* start, int* end) {
+    if (shape == BRUSH_SQUARE || size <= 2) {
+        // tiny round brushes are squares anyway
+        *start = 0;
+        *end = size;
+        return;
+    }
+    // done in doubled coordinates so everything stays an integer: the circle is centered at (size, size)
+    // with radius size, pixel i has its center at 2i+1. so column i is covered when
+    // (2i+1-size)^2 + (2row+1-size)^2 <= size^2
+    long long dy = 2 * row + 1 - size;
+    long long remaining = (long long)size * size - dy * dy;
+    if (remaining < 0) {
+        *start = 0;
+        *end = 0;
+        return;
+    }
+    // biggest dx with dx^2 <= remaining, correcting for sqrt rounding
+    long long dx = (long long)sqrt((double)remaining);
+    while (dx * dx > remaining) dx--;
+    while ((dx + 1) * (dx + 1) <= remaining) dx++;
+    // covered columns satisfy |2i+1-size| <= dx
+    int first = (int)ceil((size - 1 - dx) / 2.0);
+    int last = (int)floor((size - 1 + dx) / 2.0);
+    *start = std::max(first, 0);
+    *end = std::min(last + 1, size);
+    if (*end < *start) *end = *start;
+}
+
+void fillTileGridSpan(TileGrid* tiles, int x, int y, int length, BrushPaint paint) {
+    if (paint.pixel.a == 0) {
+        // blending in nothing doesn't change anything
+        return;
+    }
+    bool erasing = paint.mode == BLEND_ERASE;
+    // opaque paint covers up whatever's there, so no need to blend
+    bool overwrite = paint.pixel.a == 255 && (paint.mode == BLEND_NORMAL || erasing);
+    Pixel fill = erasing ? (Pixel){0, 0, 0, 0} : paint.pixel;
+
+    int endX = x + length;
+    int tileY = y >> TILE_SHIFT;
+    while (x < endX) {
+        int spanEnd = std::min((x | TILE_MASK) + 1, endX);
+        int tileX = x >> TILE_SHIFT;
+        // erasing a tile that's already transparent doesn't need to allocate it
+        if (!erasing || getTile(tiles, tileX, tileY)) {
+            Pixel* tilePixels = getWritableTilePixels(tiles, tileX, tileY);
+            if (tilePixels) {
+                Pixel* dst = &tilePixels[(x & TILE_MASK) + (y & TILE_MASK) * TILE_SIZE];
+                if (overwrite) {
+                    fillPixelSpan(dst, fill, spanEnd - x);
+                } else {
+                    blendColorSpan(dst, paint.pixel, spanEnd - x, paint.mode);
+                }
+            }
+        }
+        x = spanEnd;
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef BRUSH_INCLUDED
+#define BRUSH_INCLUDED
+
+#include "Pixel.hpp"
+#include "Tiles.hpp"
+#include "Blend.hpp"
+
+enum BrushShape {
+    BRUSH_SQUARE,
+    BRUSH_ROUND
+};
+
+/*
+* What a brush puts down: a color, and how it's blended over what's already there.
+*/
+struct BrushPaint {
+    Pixel pixel;
+    BlendMode mode;
+};
+
+/*
+* Get the pixels a brush covers on one row of its size x size bounding box.
+* A round brush covers the pixels whose centers are inside the circle filling the box.
+* @param row The row in the brush box, 0 to size-1
+* @param start Set to the first covered column
+* @param end Set to one past the last covered column, equal to start if nothing is covered
+*/
+void getBrushRowSpan(BrushShape shape, int size, int row, int* start, int* end);
+
+/*
+* Blend paint into length pixels on row y starting at x, going tile by tile. The span must be inside the grid.
+* Opaque normal paint and opaque erasing just overwrite the pixels.
+*/
+void fillTileGridSpan(TileGrid* tiles, int x, int y, int length, BrushPaint paint);
+
+#endif
@@ -0,0 +1,227 @@
+#include "CanvasSave.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "ProjectFile.hpp"
+
+// size of each IDAT chunk written
+#define PNG_CHUNK_SIZE (64 * 1024)
+
+static void writeBE32(Uint8* dst, Uint32 value) {
+    dst[0] = value >> 24;
+    dst[1] = value >> 16;
+    dst[2] = value >> 8;
+    dst[3] = value;
+}
+
+/*
+* Write a PNG chunk: length, type, data, then the CRC of the type and data.
+* @return false on write error
+*/
+static bool writePNGChunk(FILE* file, const char* type, const Uint8* data, Uint32 length) {
+    Uint8 header[8];
+    writeBE32(header, length);
+    memcpy(header + 4, type, 4);
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, (const Bytef*)type, 4);
+    if (length) {
+        crc = crc32(crc, data, length);
+    }
+    Uint8 footer[4];
+    writeBE32(footer, (Uint32)crc);
+
+    return fwrite(header, 1, 8, file) == 8
+        && (length == 0 || fwrite(data, 1, length, file) == length)
+        && fwrite(footer, 1, 4, file) == 4;
+}
+
+/*
+* Run the deflate stream, writing an IDAT chunk every time the output buffer fills up.
+* @return false on error
+*/
+static bool deflateToFile(z_stream* stream, int flush, Uint8* outBuffer, FILE* file) {
+    do {
+        int result = deflate(stream, flush);
+        if (result == Z_STREAM_ERROR) {
+            return false;
+        }
+        Uint32 produced = PNG_CHUNK_SIZE - stream->avail_out;
+        if (stream->avail_out == 0 || (flush == Z_FINISH && produced > 0)) {
+            if (!writePNGChunk(file, "IDAT", outBuffer, produced)) {
+                return false;
+            }
+            stream->next_out = outBuffer;
+            stream->avail_out = PNG_CHUNK_SIZE;
+        }
+        if (flush == Z_FINISH && result == Z_STREAM_END) {
+            return true;
+        }
+    } while (stream->avail_in > 0 || flush == Z_FINISH);
+    return true;
+}
+
+/*
+* Write the snapshot as an 8 bit RGBA PNG. Pixels are already stored r,g,b,a in memory,
+* which is exactly the byte order PNG wants, so rows go in as is.
+*/
+static SaveState writePNG(SaveJob* job, FILE* file) {
+    const TileGrid* tiles = &job->snapshot.composite;
+    static const Uint8 signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (fwrite(signature, 1, 8, file) != 8) {
+        return SAVE_FAILED;
+    }
+
+    Uint8 ihdr[13];
+    writeBE32(ihdr, tiles->width);
+    writeBE32(ihdr + 4, tiles->height);
+    ihdr[8] = 8; // bit depth
+    ihdr[9] = 6; // color type RGBA
+    ihdr[10] = 0; // compression
+    ihdr[11] = 0; // filter method
+    ihdr[12] = 0; // no interlacing
+    if (!writePNGChunk(file, "IHDR", ihdr, sizeof(ihdr))) {
+        return SAVE_FAILED;
+    }
+
+    // each row is a filter type byte followed by the pixels
+    size_t rowSize = 1 + (size_t)tiles->width * sizeof(Pixel);
+    Uint8* row = (Uint8*)malloc(rowSize);
+    Uint8* outBuffer = (Uint8*)malloc(PNG_CHUNK_SIZE);
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (!row || !outBuffer || deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        free(row);
+        free(outBuffer);
+        return SAVE_FAILED;
+    }
+    stream.next_out = outBuffer;
+    stream.avail_out = PNG_CHUNK_SIZE;
+
+    SaveState state = SAVE_DONE;
+    row[0] = 0; // no filtering
+    for (int y = 0; y < tiles->height; y++) {
+        if (SDL_AtomicGet(&job->cancelled)) {
+            state = SAVE_CANCELLED;
+            break;
+        }
+        if ((y & TILE_MASK) == 0) {
+            // composite each row of tiles as it's reached. the thread pool is the main thread's, so no parallel here
+            SDL_Rect tileRowRect = {0, y, tiles->width, TILE_SIZE};
+            compositeLayerTiles(&job->snapshot, tileRowRect, false);
+        }
+        SDL_Rect rowRect = {0, y, tiles->width, 1};
+        readTileGridRect(tiles, rowRect, (Pixel*)(row + 1), (int)(rowSize - 1));
+        stream.next_in = row;
+        stream.avail_in = (uInt)rowSize;
+        if (!deflateToFile(&stream, Z_NO_FLUSH, outBuffer, file)) {
+            state = SAVE_FAILED;
+            break;
+        }
+        SDL_AtomicSet(&job->progress, y + 1);
+    }
+
+    if (state == SAVE_DONE) {
+        if (!deflateToFile(&stream, Z_FINISH, outBuffer, file) || !writePNGChunk(file, "IEND", NULL, 0)) {
+            state = SAVE_FAILED;
+        }
+    }
+
+    deflateEnd(&stream);
+    free(outBuffer);
+    free(row);
+    return state;
+}
+
+static int saveThread(void* param) {
+    SaveJob* job = (SaveJob*)param;
+
+    SaveState state = SAVE_FAILED;
+    FILE* file = fopen(job->tempPath, "wb");
+    if (file) {
+        if (job->format == SAVE_FORMAT_PROJECT) {
+            state = writeProjectFile(&job->snapshot, file, &job->progress, &job->cancelled);
+        } else {
+            state = writePNG(job, file);
+        }
+        if (fclose(file) != 0 && state == SAVE_DONE) {
+            state = SAVE_FAILED;
+        }
+        if (state == SAVE_DONE) {
+            // replace the old file in one go, so it's either the old or the complete new image.
+            // windows won't rename over an existing file
+#ifdef _WIN32
+            remove(job->path);
+#endif
+            if (rename(job->tempPath, job->path) != 0) {
+                state = SAVE_FAILED;
+            }
+        }
+        if (state != SAVE_DONE) {
+            remove(job->tempPath);
+        }
+    }
+
+    // the snapshot isn't needed anymore, let the canvas have its tiles back
+    destroyLayerStack(&job->snapshot);
+
+    SDL_AtomicSet(&job->state, state);
+    return 0;
+}
+
+SaveJob* startSave(const LayerStack* layers, const char* path, SaveFormat format) {
+    // new'd rather than calloc'd since the snapshot has vectors, () zeroes the rest
+    SaveJob* job = new SaveJob();
+    job->path = SDL_strdup(path);
+    size_t tempPathSize = strlen(path) + 5;
+    job->tempPath = (char*)malloc(tempPathSize);
+    if (!job->path || !job->tempPath || copyLayerStack(&job->snapshot, layers)) {
+        SDL_Log("Error: Failed to start saving %s.", path);
+        SDL_free(job->path);
+        free(job->tempPath);
+        delete job;
+        return NULL;
+    }
+    SDL_snprintf(job->tempPath, tempPathSize, "%s.tmp", path);
+    job->format = format;
+    const TileGrid* composite = &layers->composite;
+    job->progressTotal = format == SAVE_FORMAT_PROJECT ?
+        composite->tilesX * composite->tilesY * getLayerCount(layers) : composite->height;
+    SDL_AtomicSet(&job->state, SAVE_RUNNING);
+
+    job->thread = SDL_CreateThread(saveThread, "canvas save", job);
+    if (!job->thread) {
+        // no threads, just do it now
+        saveThread(job);
+    }
+    return job;
+}
+
+SaveState getSaveState(SaveJob* job) {
+    return (SaveState)SDL_AtomicGet(&job->state);
+}
+
+float getSaveProgress(SaveJob* job) {
+    if (job->progressTotal == 0) {
+        return 1.0f;
+    }
+    return (float)SDL_AtomicGet(&job->progress) / job->progressTotal;
+}
+
+void cancelSave(SaveJob* job) {
+    SDL_AtomicSet(&job->cancelled, 1);
+}
+
+SaveState finishSave(SaveJob* job) {
+    if (job->thread) {
+        SDL_WaitThread(job->thread, NULL);
+    }
+    SaveState state = getSaveState(job);
+    SDL_free(job->path);
+    free(job->tempPath);
+    delete job;
+    return state;
+}
@@ -0,0 +1,64 @@
+#ifndef CANVAS_SAVE_INCLUDED
+#define CANVAS_SAVE_INCLUDED
+
+#include <SDL2/SDL.h>
+
+#include "Tiles.hpp"
+#include "Layers.hpp"
+
+enum SaveFormat {
+    SAVE_FORMAT_PNG,
+    SAVE_FORMAT_PROJECT // see ProjectFile.hpp
+};
+
+enum SaveState {
+    SAVE_RUNNING,
+    SAVE_DONE,
+    SAVE_FAILED,
+    SAVE_CANCELLED
+};
+
+/*
+* A save running on a worker thread. The canvas layers are snapshotted when the save starts,
+* so the canvas can keep being drawn on while it's being written (changed tiles just get copied).
+* The image is written to a temporary file first and moved over the real path once complete,
+* so a cancelled or failed save never leaves a half written file behind.
+*/
+struct SaveJob {
+    LayerStack snapshot; // for PNGs the layers get composited on the worker thread
+    char* path;
+    char* tempPath;
+    SaveFormat format;
+    SDL_Thread* thread; // NULL if the save ran on the calling thread
+    int progressTotal; // units of work in the save, rows for PNG, tiles for projects
+    SDL_atomic_t progress; // units of work done
+    SDL_atomic_t cancelled;
+    SDL_atomic_t state; // a SaveState
+};
+
+/*
+* Start saving the layers to path in the background. PNGs get the layers composited into one image.
+* If threads aren't available, the save is done before returning.
+* @return The job, to be polled and then finished with finishSave, or NULL on error
+*/
+SaveJob* startSave(const LayerStack* layers, const char* path, SaveFormat format);
+
+SaveState getSaveState(SaveJob* job);
+
+/*
+* @return How far along the save is, from 0 to 1
+*/
+float getSaveProgress(SaveJob* job);
+
+/*
+* Ask the save to stop. It stops after the current row or tile, removing the temporary file.
+*/
+void cancelSave(SaveJob* job);
+
+/*
+* Wait for the save to stop running and free the job.
+* @return The state the save ended in
+*/
+SaveState finishSave(SaveJob* job);
+
+#endif
@@ -0,0 +1,270 @@
+#include "Fill.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "ThreadPool.hpp"
+#include "Selection.hpp"
+
+// painting fewer pixels than this isn't worth waking up the thread pool for
+#define PARALLEL_FILL_MIN_PIXELS (TILE_PIXELS * 4)
+
+/*
+* Rows are matched a tile at a time, with bit n of a Uint64 for column n of the tile,
+* which works out since tiles are 64 pixels wide.
+*/
+
+/*
+* What counts as the color being filled.
+*/
+struct FillMatcher {
+    const TileGrid* tiles;
+    Pixel target; // the start pixel, made all 0s if it's transparent
+    int tolerance;
+    bool transparentMatches; // if the pixels of unallocated tiles match
+};
+
+struct FillSeed {
+    int x;
+    int y;
+};
+
+static inline Pixel normalizeFillPixel(Pixel pixel) {
+    return pixel.a == 0 ? (Pixel){0, 0, 0, 0} : pixel;
+}
+
+static inline bool fillPixelMatches(const FillMatcher* matcher, Pixel pixel) {
+    pixel = normalizeFillPixel(pixel);
+    const Pixel& target = matcher->target;
+    int tolerance = matcher->tolerance;
+    return abs(pixel.r - target.r) <= tolerance && abs(pixel.g - target.g) <= tolerance
+        && abs(pixel.b - target.b) <= tolerance && abs(pixel.a - target.a) <= tolerance;
+}
+
+// bits for the columns below column, which can be 0 to 64
+static inline Uint64 getColumnBitsBelow(int column) {
+    return column >= 64 ? ~(Uint64)0 : (((Uint64)1 << column) - 1);
+}
+
+/*
+* Get which pixels of a tile's row match, bit n for column n of the tile. Columns past the edge of the grid never match.
+*/
+static Uint64 getRowMatches(const FillMatcher* matcher, int tileX, int y) {
+    const TileGrid* tiles = matcher->tiles;
+    Uint64 columns = getColumnBitsBelow(tiles->width - (tileX << TILE_SHIFT));
+    const Tile* tile = getTile(tiles, tileX, y >> TILE_SHIFT);
+    if (!tile) {
+        return matcher->transparentMatches ? columns : 0;
+    }
+    const Pixel* row = &tile->pixels[(y & TILE_MASK) * TILE_SIZE];
+    Uint64 matches = 0;
+    for (int i = 0; i < TILE_SIZE; i++) {
+        matches |= (Uint64)fillPixelMatches(matcher, row[i]) << i;
+    }
+    return matches & columns;
+}
+
+/*
+* Set the bits for pixels x0 to x1 on a row of the filled mask.
+*/
+static void markFilled(Uint64* filledRow, int x0, int x1) {
+    int x = x0;
+    while (x < x1) {
+        int chunkEnd = std::min((x | TILE_MASK) + 1, x1);
+        filledRow[x >> TILE_SHIFT] |= getColumnBitsBelow(chunkEnd - x) << (x & TILE_MASK);
+        x = chunkEnd;
+    }
+}
+
+/*
+* Queue a seed for each run of matching pixels in x0 to x1 on row y that hasn't been filled yet.
+*/
+static void seedRow(const FillMatcher* matcher, const Uint64* filledRow, int y, int x0, int x1, std::vector<FillSeed>* seeds) {
+    int x = x0;
+    while (x < x1) {
+        int tileX = x >> TILE_SHIFT;
+        int chunkEnd = std::min((x | TILE_MASK) + 1, x1);
+        Uint64 range = getColumnBitsBelow(chunkEnd - x) << (x & TILE_MASK);
+        Uint64 open = getRowMatches(matcher, tileX, y) & ~filledRow[tileX] & range;
+        // runs start where a bit is set and the one below it isn't.
+        // a run going over the tile edge gets a seed on both sides, the second one just finds it already filled
+        Uint64 runStarts = open & ~(open << 1);
+        while (runStarts) {
+            seeds->push_back((FillSeed){(tileX << TILE_SHIFT) + __builtin_ctzll(runStarts), y});
+            runStarts &= runStarts - 1;
+        }
+        x = chunkEnd;
+    }
+}
+
+/*
+* Scanline fill: take a seed, fill the whole run of matching pixels it's in, then seed the rows above and below that run.
+*/
+static void findContiguousRegion(const FillMatcher* matcher, int startX, int startY, FillRegion* region) {
+    const TileGrid* tiles = matcher->tiles;
+    int tilesX = tiles->tilesX;
+    // a bit per pixel filled so far, a word per tile on each row
+    std::vector<Uint64> filled((size_t)tilesX * tiles->height, 0);
+    std::vector<FillSeed> seeds;
+    seeds.push_back((FillSeed){startX, startY});
+
+    while (!seeds.empty()) {
+        FillSeed seed = seeds.back();
+        seeds.pop_back();
+        int y = seed.y;
+        Uint64* filledRow = &filled[(size_t)y * tilesX];
+        int seedTileX = seed.x >> TILE_SHIFT;
+        int seedColumn = seed.x & TILE_MASK;
+        Uint64 seedOpen = getRowMatches(matcher, seedTileX, y) & ~filledRow[seedTileX];
+        if (!((seedOpen >> seedColumn) & 1)) {
+            continue;
+        }
+
+        // go left to the start of the run
+        int left = 0;
+        int tileX = seedTileX;
+        Uint64 open = seedOpen;
+        int column = seedColumn;
+        while (true) {
+            Uint64 closedBelow = ~open & getColumnBitsBelow(column);
+            if (closedBelow) {
+                // one past the highest closed pixel
+                left = (tileX << TILE_SHIFT) + 64 - __builtin_clzll(closedBelow);
+                break;
+            }
+            if (tileX == 0) {
+                left = 0;
+                break;
+            }
+            tileX--;
+            open = getRowMatches(matcher, tileX, y) & ~filledRow[tileX];
+            column = TILE_SIZE;
+        }
+
+        // and right to the end of it
+        int right = tiles->width;
+        tileX = seedTileX;
+        open = seedOpen;
+        column = seedColumn;
+        while (true) {
+            Uint64 closedAbove = ~open & ~getColumnBitsBelow(column);
+            if (closedAbove) {
+                right = (tileX << TILE_SHIFT) + __builtin_ctzll(closedAbove);
+                break;
+            }
+            if (tileX == tilesX - 1) {
+                right = tiles->width;
+                break;
+            }
+            tileX++;
+            open = getRowMatches(matcher, tileX, y) & ~filledRow[tileX];
+            column = 0;
+        }
+
+        markFilled(filledRow, left, right);
+        region->tileRowSpans[y >> TILE_SHIFT].push_back((FillSpan){left, y, right - left});
+        if (y > 0) {
+            seedRow(matcher, &filled[(size_t)(y - 1) * tilesX], y - 1, left, right, &seeds);
+        }
+        if (y + 1 < tiles->height) {
+            seedRow(matcher, &filled[(size_t)(y + 1) * tilesX], y + 1, left, right, &seeds);
+        }
+    }
+}
+
+/*
+* Every matching pixel, each row of tiles searched on its own thread.
+*/
+static void findGlobalRegion(const FillMatcher* matcher, FillRegion* region) {
+    const TileGrid* tiles = matcher->tiles;
+    getThreadPool()->parallelFor(tiles->tilesY, [&](int tileY) {
+        std::vector<FillSpan>& spans = region->tileRowSpans[tileY];
+        int endY = std::min((tileY + 1) << TILE_SHIFT, tiles->height);
+        for (int y = tileY << TILE_SHIFT; y < endY; y++) {
+            for (int tileX = 0; tileX < tiles->tilesX; tileX++) {
+                Uint64 matches = getRowMatches(matcher, tileX, y);
+                while (matches) {
+                    int runStart = __builtin_ctzll(matches);
+                    Uint64 rest = ~(matches >> runStart);
+                    int runLength = rest ? __builtin_ctzll(rest) : 64 - runStart;
+                    int x = (tileX << TILE_SHIFT) + runStart;
+                    if (!spans.empty() && spans.back().y == y && spans.back().x + spans.back().length == x) {
+                        // carries on from the last tile
+                        spans.back().length += runLength;
+                    } else {
+                        spans.push_back((FillSpan){x, y, runLength});
+                    }
+                    if (runStart + runLength >= 64) break;
+                    matches &= ~(Uint64)0 << (runStart + runLength);
+                }
+            }
+        }
+    });
+}
+
+bool findFillRegion(const TileGrid* tiles, int x, int y, int tolerance, FillMode mode, const BrushPaint* paint, FillRegion* region) {
+    region->tileRowSpans.assign(tiles->tilesY, std::vector<FillSpan>());
+    region->bounds = (SDL_Rect){0, 0, 0, 0};
+    region->pixelCount = 0;
+    if (x < 0 || y < 0 || x >= tiles->width || y >= tiles->height || (paint && paint->pixel.a == 0)) {
+        return false;
+    }
+
+    FillMatcher matcher;
+    matcher.tiles = tiles;
+    matcher.target = normalizeFillPixel(getPixel(tiles, x, y));
+    matcher.tolerance = std::max(0, std::min(tolerance, 255));
+    matcher.transparentMatches = fillPixelMatches(&matcher, (Pixel){0, 0, 0, 0});
+
+    if (paint && matcher.tolerance == 0) {
+        // everything that matches is exactly the start color, so if painting leaves that alone it leaves everything alone
+        Pixel painted = matcher.target;
+        blendColorSpan(&painted, paint->pixel, 1, paint->mode);
+        painted = normalizeFillPixel(painted);
+        if (memcmp(&painted, &matcher.target, sizeof(Pixel)) == 0) {
+            return false;
+        }
+    }
+
+    if (mode == FILL_GLOBAL) {
+        findGlobalRegion(&matcher, region);
+    } else {
+        findContiguousRegion(&matcher, x, y, region);
+    }
+
+    int minX = tiles->width, minY = tiles->height, maxX = 0, maxY = 0;
+    for (size_t row = 0; row < region->tileRowSpans.size(); row++) {
+        const std::vector<FillSpan>& spans = region->tileRowSpans[row];
+        for (size_t i = 0; i < spans.size(); i++) {
+            minX = std::min(minX, spans[i].x);
+            maxX = std::max(maxX, spans[i].x + spans[i].length);
+            minY = std::min(minY, spans[i].y);
+            maxY = std::max(maxY, spans[i].y + 1);
+            region->pixelCount += spans[i].length;
+        }
+    }
+    if (region->pixelCount == 0) {
+        return false;
+    }
+    region->bounds = (SDL_Rect){minX, minY, maxX - minX, maxY - minY};
+    return true;
+}
+
+void paintFillRegion(TileGrid* tiles, const FillRegion* region, BrushPaint paint, const SelectionMask* selection) {
+    // spans in different rows of tiles never touch the same tile
+    auto paintTileRow = [&](int tileY) {
+        const std::vector<FillSpan>& spans = region->tileRowSpans[tileY];
+        for (size_t i = 0; i < spans.size(); i++) {
+            fillSelectedSpan(tiles, selection, spans[i].x, spans[i].y, spans[i].length, paint);
+        }
+    };
+    int numTileRows = (int)region->tileRowSpans.size();
+    if (region->pixelCount >= PARALLEL_FILL_MIN_PIXELS) {
+        getThreadPool()->parallelFor(numTileRows, paintTileRow);
+    } else {
+        for (int tileY = 0; tileY < numTileRows; tileY++) {
+            paintTileRow(tileY);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef FILL_INCLUDED
+#define FILL_INCLUDED
+
+#include <vector>
+
+#include "Tiles.hpp"
+#include "Brush.hpp"
+
+struct SelectionMask;
+
+enum FillMode {
+    FILL_CONTIGUOUS, // only the matching area connected to the start pixel
+    FILL_GLOBAL // every matching pixel
+};
+
+struct FillSpan {
+    int x;
+    int y;
+    int length;
+};
+
+/*
+* The pixels a fill covers, as spans of rows.
+*/
+struct FillRegion {
+    std::vector<std::vector<FillSpan>> tileRowSpans; // spans in each row of tiles, so that rows of tiles can be filled in parallel
+    SDL_Rect bounds; // around every span
+    int pixelCount;
+};
+
+/*
+* Find the pixels a fill starting at x,y covers: the ones within tolerance of the color at x,y,
+* either connected to it (without going diagonally) or anywhere in the grid.
+* Works a tile row at a time with a bit per pixel, and uses an explicit queue of spans instead of recursing,
+* so big areas don't overflow the stack. Global fills search rows of tiles in parallel.
+* @param tolerance The most any channel can differ from the start pixel's and still match, 0 to 255.
+* Fully transparent pixels are all treated as the same color.
+* @param paint What the fill will put down, used to tell if filling would do anything. NULL to always find the region
+* @return false if filling wouldn't change anything, like when the area is already filled with paint.
+* region is left empty then
+*/
+bool findFillRegion(const TileGrid* tiles, int x, int y, int tolerance, FillMode mode, const BrushPaint* paint, FillRegion* region);
+
+/*
+* Blend paint into every pixel of a region found with findFillRegion, spreading rows of tiles over the thread pool.
+* @param selection Only pixels in it are painted, NULL to paint the whole region
+*/
+void paintFillRegion(TileGrid* tiles, const FillRegion* region, BrushPaint paint, const SelectionMask* selection);
+
+#endif
@@ -0,0 +1,83 @@
+#include "FontAtlas.hpp"
+
+#include <string.h>
+#include <sys/stat.h>
+
+void getFontAtlasPath(char* path, size_t pathSize, const char* ttfPath, int pointSize) {
+    // just the file name of the TTF, without the directory or extension
+    const char* name = ttfPath;
+    for (const char* c = ttfPath; *c; c++) {
+        if (*c == '/' || *c == '\\') {
+            name = c + 1;
+        }
+    }
+    const char* extension = strrchr(name, '.');
+    int nameLength = extension ? (int)(extension - name) : (int)strlen(name);
+    SDL_snprintf(path, pathSize, FONT_ATLAS_DIR "%.*s-%d.fcatlas", nameLength, name, pointSize);
+}
+
+/*
+* Check the atlas exists and was baked after the TTF last changed.
+*/
+static bool isFontAtlasCurrent(const char* atlasPath, const char* ttfPath) {
+    struct stat atlasStat;
+    if (stat(atlasPath, &atlasStat) != 0) {
+        return false;
+    }
+    struct stat ttfStat;
+    if (stat(ttfPath, &ttfStat) != 0) {
+        // nothing to be out of date with
+        return true;
+    }
+    return atlasStat.st_mtime >= ttfStat.st_mtime;
+}
+
+int loadFontWithAtlas(FC_Font* font, SDL_Renderer* renderer, const char* ttfPath, int pointSize, SDL_Color color, TTF_Font** ttf) {
+    *ttf = NULL;
+    char atlasPath[256];
+    getFontAtlasPath(atlasPath, sizeof(atlasPath), ttfPath, pointSize);
+    if (isFontAtlasCurrent(atlasPath, ttfPath)) {
+        if (!TTF_WasInit() && TTF_Init() < 0) {
+            SDL_Log("Error: Failed to initialize SDL_ttf. TTF_Error: %s", TTF_GetError());
+            return -1;
+        }
+        // opening the TTF only reads its tables, glyphs are rasterized from it only if the atlas doesn't have them
+        *ttf = TTF_OpenFont(ttfPath, pointSize);
+        if (FC_LoadFontFromAtlas(font, renderer, atlasPath, *ttf, color)) {
+            return 0;
+        }
+        SDL_Log("Warning: Failed to load font atlas %s, loading the font from %s.", atlasPath, ttfPath);
+        if (*ttf) {
+            TTF_CloseFont(*ttf);
+            *ttf = NULL;
+        }
+    } else {
+        SDL_Log("Font atlas %s is missing or out of date, loading the font from %s. Run make fontAtlases to bake it.",
+            atlasPath, ttfPath);
+    }
+
+    // FontCache returns 1 on success, 0 on error
+    if (FC_LoadFont(font, renderer, ttfPath, pointSize, color, TTF_STYLE_NORMAL) == 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int bakeFontAtlas(SDL_Renderer* renderer, const char* ttfPath, int pointSize) {
+    char atlasPath[256];
+    getFontAtlasPath(atlasPath, sizeof(atlasPath), ttfPath, pointSize);
+
+    FC_Font* font = FC_CreateFont();
+    int result = 0;
+    if (FC_LoadFont(font, renderer, ttfPath, pointSize, FC_MakeColor(0, 0, 0, 255), TTF_STYLE_NORMAL) == 0) {
+        SDL_Log("Error: Failed to load font %s to bake.", ttfPath);
+        result = -1;
+    } else if (FC_SaveGlyphAtlas(font, atlasPath) == 0) {
+        SDL_Log("Error: Failed to write font atlas %s.", atlasPath);
+        result = -1;
+    } else {
+        SDL_Log("Baked %s at %d points to %s.", ttfPath, pointSize, atlasPath);
+    }
+    FC_FreeFont(font);
+    return result;
+}
@@ -0,0 +1,34 @@
+#ifndef FONT_ATLAS_INCLUDED
+#define FONT_ATLAS_INCLUDED
+
+#include <stddef.h>
+
+#include <SDL2/SDL.h>
+
+#include "SDL_FontCache/SDL_FontCache.h"
+
+// where `make fontAtlases` bakes glyph atlases to, inside assets so web builds preload them too
+#define FONT_ATLAS_DIR "assets/fonts/atlases/"
+
+/*
+* Get the path of the glyph atlas of a TTF at a point size, like assets/fonts/atlases/FreeSans-24.fcatlas.
+*/
+void getFontAtlasPath(char* path, size_t pathSize, const char* ttfPath, int pointSize);
+
+/*
+* Load a font from its baked glyph atlas, so nothing gets rasterized at startup. When the atlas is missing,
+* older than the TTF or can't be read, the font is loaded from the TTF like FC_LoadFont does instead.
+* @param ttf Set to the TTF the font caches glyphs the atlas doesn't have from, to be closed after the font is freed.
+*            Set to NULL when the font was loaded from the TTF, as the font owns it then
+* @return 0 on success, -1 on error
+*/
+int loadFontWithAtlas(FC_Font* font, SDL_Renderer* renderer, const char* ttfPath, int pointSize, SDL_Color color, TTF_Font** ttf);
+
+/*
+* Load a font from a TTF and write its glyph atlas for loadFontWithAtlas.
+* The renderer has to support render targets, so the glyph cache can be read back.
+* @return 0 on success, -1 on error
+*/
+int bakeFontAtlas(SDL_Renderer* renderer, const char* ttfPath, int pointSize);
+
+#endif
@@ -0,0 +1,282 @@
+#include "History.hpp"
+
+#include <string.h>
+
+/*
+* Delta encoding. The XOR of the before and after tile pixels is stored as a sequence of runs,
+* each starting with a header word: the run type in the top 2 bits and the pixel count in the rest.
+*   DELTA_SKIP:    count unchanged pixels, no data follows
+*   DELTA_FILL:    count pixels all changed by the same value, one data word follows
+*   DELTA_LITERAL: count changed pixels, count data words follow
+*/
+#define DELTA_SKIP 0u
+#define DELTA_FILL 1u
+#define DELTA_LITERAL 2u
+#define DELTA_TYPE_SHIFT 30
+#define DELTA_COUNT_MASK ((1u << DELTA_TYPE_SHIFT) - 1)
+// equal values needed in a row before it's worth ending a literal run for a fill run
+#define DELTA_MIN_FILL 3
+
+static inline Uint32 loadPixel(const Tile* tile, int index) {
+    if (!tile) return 0;
+    Uint32 value;
+    memcpy(&value, &tile->pixels[index], sizeof(value));
+    return value;
+}
+
+/*
+* Encode the difference between two states of a tile (NULL for transparent).
+* @return false if the tiles are the same, so there's nothing to store
+*/
+static bool encodeTileDelta(const Tile* before, const Tile* after, std::vector<Uint32>* out) {
+    if (before == after) {
+        return false;
+    }
+    Uint32 diff[TILE_PIXELS];
+    bool changed = false;
+    for (int i = 0; i < TILE_PIXELS; i++) {
+        diff[i] = loadPixel(before, i) ^ loadPixel(after, i);
+        changed |= diff[i] != 0;
+    }
+    if (!changed) {
+        return false;
+    }
+
+    int i = 0;
+    while (i < TILE_PIXELS) {
+        int runEnd = i + 1;
+        if (diff[i] == 0) {
+            while (runEnd < TILE_PIXELS && diff[runEnd] == 0) runEnd++;
+            out->push_back((DELTA_SKIP << DELTA_TYPE_SHIFT) | (runEnd - i));
+        } else {
+            while (runEnd < TILE_PIXELS && diff[runEnd] == diff[i]) runEnd++;
+            if (runEnd - i >= DELTA_MIN_FILL) {
+                out->push_back((DELTA_FILL << DELTA_TYPE_SHIFT) | (runEnd - i));
+                out->push_back(diff[i]);
+            } else {
+                // keep going until we hit an unchanged pixel or something worth a fill run
+                runEnd = i + 1;
+                while (runEnd < TILE_PIXELS && diff[runEnd] != 0) {
+                    int repeats = 1;
+                    while (repeats < DELTA_MIN_FILL && runEnd + repeats < TILE_PIXELS && diff[runEnd + repeats] == diff[runEnd]) repeats++;
+                    if (repeats >= DELTA_MIN_FILL) break;
+                    runEnd++;
+                }
+                out->push_back((DELTA_LITERAL << DELTA_TYPE_SHIFT) | (runEnd - i));
+                out->insert(out->end(), &diff[i], &diff[runEnd]);
+            }
+        }
+        i = runEnd;
+    }
+    out->shrink_to_fit();
+    return true;
+}
+
+static inline void xorPixel(Pixel* pixel, Uint32 value) {
+    Uint32 current;
+    memcpy(&current, pixel, sizeof(current));
+    current ^= value;
+    memcpy(pixel, &current, sizeof(current));
+}
+
+/*
+* Apply a delta to its tile, in either direction. Only the changed runs are touched.
+*/
+static void applyTileDelta(const TileDelta* delta, TileGrid* tiles) {
+    int tileX = delta->tileIndex % tiles->tilesX;
+    int tileY = delta->tileIndex / tiles->tilesX;
+    Pixel* pixels = getWritableTilePixels(tiles, tileX, tileY);
+    if (!pixels) {
+        return;
+    }
+
+    const Uint32* data = delta->data.data();
+    const Uint32* end = data + delta->data.size();
+    int pixelIndex = 0;
+    while (data < end) {
+        Uint32 header = *data++;
+        Uint32 type = header >> DELTA_TYPE_SHIFT;
+        int count = header & DELTA_COUNT_MASK;
+        if (type == DELTA_FILL) {
+            Uint32 value = *data++;
+            for (int i = 0; i < count; i++) {
+                xorPixel(&pixels[pixelIndex + i], value);
+            }
+        } else if (type == DELTA_LITERAL) {
+            for (int i = 0; i < count; i++) {
+                xorPixel(&pixels[pixelIndex + i], data[i]);
+            }
+            data += count;
+        }
+        pixelIndex += count;
+    }
+
+    // the tile might have gone back to being transparent
+    SDL_Rect tileRect = {tileX << TILE_SHIFT, tileY << TILE_SHIFT, TILE_SIZE, TILE_SIZE};
+    releaseTransparentTiles(tiles, tileRect);
+}
+
+static void freeEntry(History* history, HistoryEntry* entry) {
+    history->memoryUsed -= entry->bytes;
+    entry->deltas.clear();
+    entry->bytes = 0;
+}
+
+void initHistory(History* history, size_t memoryBudget) {
+    history->memoryBudget = memoryBudget;
+    history->memoryUsed = 0;
+    history->recording = false;
+    history->strokeLayer = 0;
+}
+
+void clearHistory(History* history) {
+    history->undoStack.clear();
+    history->redoStack.clear();
+    history->memoryUsed = 0;
+    for (auto& strokeTile : history->strokeTiles) {
+        releaseTile(strokeTile.second);
+    }
+    history->strokeTiles.clear();
+    history->recording = false;
+}
+
+void destroyHistory(History* history) {
+    clearHistory(history);
+}
+
+void beginHistoryStroke(History* history, int layer) {
+    history->recording = true;
+    history->strokeLayer = layer;
+}
+
+void recordTilesBeforeChange(History* history, const TileGrid* tiles, SDL_Rect rect) {
+    if (!history->recording) {
+        return;
+    }
+    int firstTileX, firstTileY, lastTileX, lastTileY;
+    if (!getTileRange(tiles, rect, &firstTileX, &firstTileY, &lastTileX, &lastTileY)) {
+        return;
+    }
+    for (int tileY = firstTileY; tileY <= lastTileY; tileY++) {
+        for (int tileX = firstTileX; tileX <= lastTileX; tileX++) {
+            int index = tileX + tileY * tiles->tilesX;
+            if (history->strokeTiles.find(index) == history->strokeTiles.end()) {
+                // holding a reference makes the next write copy the tile, leaving this one as the before state
+                history->strokeTiles[index] = retainTile(getTileAtIndex(tiles, index));
+            }
+        }
+    }
+}
+
+void endHistoryStroke(History* history, const TileGrid* tiles) {
+    if (!history->recording) {
+        return;
+    }
+    history->recording = false;
+
+    HistoryEntry entry;
+    entry.layer = history->strokeLayer;
+    entry.bytes = 0;
+    for (auto& strokeTile : history->strokeTiles) {
+        TileDelta delta;
+        delta.tileIndex = strokeTile.first;
+        if (encodeTileDelta(strokeTile.second, getTileAtIndex(tiles, strokeTile.first), &delta.data)) {
+            entry.bytes += sizeof(TileDelta) + delta.data.size() * sizeof(Uint32);
+            entry.deltas.push_back(std::move(delta));
+        }
+        releaseTile(strokeTile.second);
+    }
+    history->strokeTiles.clear();
+
+    if (entry.deltas.empty()) {
+        return;
+    }
+
+    // a new change makes the undone changes unreachable
+    for (size_t i = 0; i < history->redoStack.size(); i++) {
+        freeEntry(history, &history->redoStack[i]);
+    }
+    history->redoStack.clear();
+
+    history->memoryUsed += entry.bytes;
+    history->undoStack.push_back(std::move(entry));
+
+    // forget the oldest strokes until we're back in budget
+    while (history->memoryUsed > history->memoryBudget && !history->undoStack.empty()) {
+        freeEntry(history, &history->undoStack.front());
+        history->undoStack.pop_front();
+    }
+}
+
+static SDL_Rect applyEntry(const HistoryEntry* entry, TileGrid* tiles) {
+    SDL_Rect changed = {0, 0, 0, 0};
+    for (size_t i = 0; i < entry->deltas.size(); i++) {
+        const TileDelta* delta = &entry->deltas[i];
+        applyTileDelta(delta, tiles);
+        SDL_Rect tileRect = {
+            (delta->tileIndex % tiles->tilesX) << TILE_SHIFT,
+            (delta->tileIndex / tiles->tilesX) << TILE_SHIFT,
+            TILE_SIZE,
+            TILE_SIZE
+        };
+        SDL_UnionRect(&changed, &tileRect, &changed);
+    }
+    return changed;
+}
+
+template<class Stack>
+static void remapStackLayers(History* history, Stack* stack, const std::vector<int>& newLayers) {
+    size_t kept = 0;
+    for (size_t i = 0; i < stack->size(); i++) {
+        HistoryEntry& entry = (*stack)[i];
+        int layer = (entry.layer >= 0 && entry.layer < (int)newLayers.size()) ? newLayers[entry.layer] : -1;
+        if (layer < 0) {
+            freeEntry(history, &entry);
+            continue;
+        }
+        entry.layer = layer;
+        if (kept != i) {
+            (*stack)[kept] = std::move(entry);
+        }
+        kept++;
+    }
+    stack->resize(kept);
+}
+
+void remapHistoryLayers(History* history, const std::vector<int>& newLayers) {
+    remapStackLayers(history, &history->undoStack, newLayers);
+    remapStackLayers(history, &history->redoStack, newLayers);
+    if (history->recording && history->strokeLayer < (int)newLayers.size()) {
+        history->strokeLayer = newLayers[history->strokeLayer];
+    }
+}
+
+int getUndoLayer(const History* history) {
+    return history->undoStack.empty() ? -1 : history->undoStack.back().layer;
+}
+
+int getRedoLayer(const History* history) {
+    return history->redoStack.empty() ? -1 : history->redoStack.back().layer;
+}
+
+bool undoHistory(History* history, TileGrid* tiles, SDL_Rect* changedRect) {
+    if (history->undoStack.empty()) {
+        return false;
+    }
+    HistoryEntry entry = std::move(history->undoStack.back());
+    history->undoStack.pop_back();
+    *changedRect = applyEntry(&entry, tiles);
+    history->redoStack.push_back(std::move(entry));
+    return true;
+}
+
+bool redoHistory(History* history, TileGrid* tiles, SDL_Rect* changedRect) {
+    if (history->redoStack.empty()) {
+        return false;
+    }
+    HistoryEntry entry = std::move(history->redoStack.back());
+    history->redoStack.pop_back();
+    *changedRect = applyEntry(&entry, tiles);
+    history->undoStack.push_back(std::move(entry));
+    return true;
+}
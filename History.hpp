@@ -0,0 +1,98 @@
+#ifndef HISTORY_INCLUDED
+#define HISTORY_INCLUDED
+
+#include <stddef.h>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+
+#include <SDL2/SDL.h>
+
+#include "Tiles.hpp"
+
+/*
+* The change a stroke made to one tile, stored as the before and after pixels XOR'd together
+* and run length encoded. Since XOR is its own inverse, the same delta takes the tile
+* from before to after (redo) and from after to before (undo).
+* Unchanged pixels XOR to zero, so they just become skip runs.
+*/
+struct TileDelta {
+    int tileIndex; // index into TileGrid::tiles
+    std::vector<Uint32> data; // encoded runs, see History.cpp
+};
+
+struct HistoryEntry {
+    int layer; // index of the layer the stroke was drawn on
+    std::vector<TileDelta> deltas;
+    size_t bytes; // memory used by the deltas
+};
+
+/*
+* Undo / redo history of canvas strokes, only keeping the tiles each stroke changed.
+*/
+struct History {
+    std::deque<HistoryEntry> undoStack; // most recent at the back
+    std::vector<HistoryEntry> redoStack; // most recently undone at the back
+    size_t memoryBudget; // the oldest entries get dropped when the history uses more than this
+    size_t memoryUsed;
+
+    bool recording;
+    int strokeLayer; // layer of the stroke being recorded
+    // state of every tile touched by the stroke being recorded, from before the stroke touched it.
+    // they're retained, so with copy on write tiles, this is just a reference until the tile is written to
+    std::unordered_map<int, Tile*> strokeTiles;
+};
+
+void initHistory(History* history, size_t memoryBudget);
+void destroyHistory(History* history);
+/*
+* Forget all history, for example when a different canvas is loaded.
+*/
+void clearHistory(History* history);
+
+/*
+* Start recording a stroke drawn on the given layer.
+*/
+void beginHistoryStroke(History* history, int layer);
+/*
+* Remember the current state of the tiles touching rect, if they haven't been already in this stroke.
+* Must be called before writing to the tiles while a stroke is being recorded.
+*/
+void recordTilesBeforeChange(History* history, const TileGrid* tiles, SDL_Rect rect);
+/*
+* Finish the stroke, storing what changed as a new undo entry. Clears the redo stack if anything changed.
+*/
+void endHistoryStroke(History* history, const TileGrid* tiles);
+
+/*
+* Keep entries pointing at the right layers after layers were added, removed or moved.
+* @param newLayers The new index of each old layer, or -1 if it was removed, which drops its entries.
+* The other layers' entries stay valid since each entry only touches its own layer
+*/
+void remapHistoryLayers(History* history, const std::vector<int>& newLayers);
+
+/*
+* @return The layer the stroke undoHistory would undo was drawn on, -1 if there's nothing to undo
+*/
+int getUndoLayer(const History* history);
+/*
+* @return The layer the stroke redoHistory would redo was drawn on, -1 if there's nothing to redo
+*/
+int getRedoLayer(const History* history);
+
+/*
+* Undo the last stroke.
+* @param tiles The tiles of the layer from getUndoLayer
+* @param changedRect Set to the area of the canvas that was changed, so it can be redrawn
+* @return true if there was anything to undo
+*/
+bool undoHistory(History* history, TileGrid* tiles, SDL_Rect* changedRect);
+/*
+* Redo the last undone stroke.
+* @param tiles The tiles of the layer from getRedoLayer
+* @param changedRect Set to the area of the canvas that was changed, so it can be redrawn
+* @return true if there was anything to redo
+*/
+bool redoHistory(History* history, TileGrid* tiles, SDL_Rect* changedRect);
+
+#endif
@@ -0,0 +1,209 @@
+#include "Layers.hpp"
+
+#include <algorithm>
+
+#include "ThreadPool.hpp"
+
+// compositing fewer tiles than this isn't worth waking up the thread pool for
+#define PARALLEL_COMPOSITE_MIN_TILES 4
+
+static const Pixel transparentTilePixels[TILE_PIXELS] = {};
+
+/*
+* Get the grid for a level of compositing: level i is layer i's below, and the top level is the stack composite.
+*/
+static TileGrid* getLevelGrid(LayerStack* stack, int level) {
+    if (level < (int)stack->layers.size()) {
+        return &stack->layers[level].below;
+    }
+    return &stack->composite;
+}
+
+/*
+* Lower every tile's valid level to at most level.
+*/
+static void invalidateLevels(LayerStack* stack, int level) {
+    for (size_t i = 0; i < stack->validLevels.size(); i++) {
+        stack->validLevels[i] = std::min(stack->validLevels[i], level);
+    }
+}
+
+int initLayerStack(LayerStack* stack, int width, int height) {
+    stack->width = width;
+    stack->height = height;
+    if (initTileGrid(&stack->composite, width, height)) {
+        return -1;
+    }
+    stack->validLevels.assign((size_t)stack->composite.tilesX * stack->composite.tilesY, 0);
+    if (insertLayer(stack, 0)) {
+        destroyTileGrid(&stack->composite);
+        return -1;
+    }
+    return 0;
+}
+
+void destroyLayerStack(LayerStack* stack) {
+    for (size_t i = 0; i < stack->layers.size(); i++) {
+        destroyTileGrid(&stack->layers[i].tiles);
+        destroyTileGrid(&stack->layers[i].below);
+    }
+    stack->layers.clear();
+    destroyTileGrid(&stack->composite);
+    stack->validLevels.clear();
+}
+
+int copyLayerStack(LayerStack* dst, const LayerStack* src) {
+    dst->width = src->width;
+    dst->height = src->height;
+    if (copyTileGrid(&dst->composite, &src->composite)) {
+        return -1;
+    }
+    dst->validLevels = src->validLevels;
+    for (size_t i = 0; i < src->layers.size(); i++) {
+        Layer layer = src->layers[i];
+        if (copyTileGrid(&layer.tiles, &src->layers[i].tiles)) {
+            destroyLayerStack(dst);
+            return -1;
+        }
+        if (copyTileGrid(&layer.below, &src->layers[i].below)) {
+            destroyTileGrid(&layer.tiles);
+            destroyLayerStack(dst);
+            return -1;
+        }
+        dst->layers.push_back(layer);
+    }
+    return 0;
+}
+
+int insertLayer(LayerStack* stack, int index) {
+    TileGrid tiles;
+    if (initTileGrid(&tiles, stack->width, stack->height)) {
+        return -1;
+    }
+    if (insertLayerTiles(stack, index, tiles, 1.0f, true, BLEND_NORMAL)) {
+        return -1;
+    }
+    return 0;
+}
+
+int insertLayerTiles(LayerStack* stack, int index, TileGrid tiles, float opacity, bool visible, BlendMode blendMode) {
+    Layer layer;
+    layer.tiles = tiles;
+    layer.opacity = opacity;
+    layer.visible = visible;
+    layer.blendMode = blendMode;
+    if (initTileGrid(&layer.below, stack->width, stack->height)) {
+        destroyTileGrid(&layer.tiles);
+        return -1;
+    }
+    stack->layers.insert(stack->layers.begin() + index, layer);
+    // the new layer's below starts out empty, which is only right for the bottom layer.
+    // and everything above it needs the new layer blended in
+    invalidateLevels(stack, std::max(index - 1, 0));
+    return 0;
+}
+
+void removeLayer(LayerStack* stack, int index) {
+    int numLayers = (int)stack->layers.size();
+    if (numLayers <= 1) {
+        return;
+    }
+    Layer* removed = &stack->layers[index];
+    // the removed layer's below is still right for whatever takes its place, so keep it there
+    // and throw out the one that had the removed layer blended in
+    TileGrid* replacement = getLevelGrid(stack, index + 1);
+    std::swap(removed->below, *replacement);
+    destroyTileGrid(&removed->tiles);
+    destroyTileGrid(&removed->below);
+    stack->layers.erase(stack->layers.begin() + index);
+    invalidateLevels(stack, index);
+}
+
+void swapLayerWithAbove(LayerStack* stack, int index) {
+    Layer* layer = &stack->layers[index];
+    Layer* above = &stack->layers[index + 1];
+    // the caches stay where they are, everything below the pair is the same
+    std::swap(layer->tiles, above->tiles);
+    std::swap(layer->opacity, above->opacity);
+    std::swap(layer->visible, above->visible);
+    std::swap(layer->blendMode, above->blendMode);
+    invalidateLevels(stack, index);
+}
+
+void invalidateLayerRect(LayerStack* stack, int layerIndex, SDL_Rect rect) {
+    int firstTileX, firstTileY, lastTileX, lastTileY;
+    if (!getTileRange(&stack->composite, rect, &firstTileX, &firstTileY, &lastTileX, &lastTileY)) {
+        return;
+    }
+    for (int tileY = firstTileY; tileY <= lastTileY; tileY++) {
+        for (int tileX = firstTileX; tileX <= lastTileX; tileX++) {
+            int& validLevel = stack->validLevels[tileX + tileY * stack->composite.tilesX];
+            validLevel = std::min(validLevel, layerIndex);
+        }
+    }
+}
+
+/*
+* Bring a tile's composites up to date, starting from the first one that changed.
+* Only touches this tile, so different tiles can be composited on different threads.
+*/
+static void compositeTile(LayerStack* stack, int index) {
+    int numLayers = (int)stack->layers.size();
+    for (int level = stack->validLevels[index]; level < numLayers; level++) {
+        const Layer* layer = &stack->layers[level];
+        Tile* backdrop = getTileAtIndex(getLevelGrid(stack, level), index);
+        Tile* src = (layer->visible && layer->opacity > 0.0f) ? getTileAtIndex(&layer->tiles, index) : NULL;
+        Tile** slot = &getLevelGrid(stack, level + 1)->tiles[index];
+
+        Tile* result;
+        if (!src || (!backdrop && layer->blendMode == BLEND_ERASE)) {
+            // nothing to blend in or nothing to erase, so it's the same as below
+            result = retainTile(backdrop);
+        } else if (!backdrop && layer->opacity >= 1.0f) {
+            // blending onto nothing leaves the layer as it is, whatever the mode
+            result = retainTile(src);
+        } else if (*slot && SDL_AtomicGet(&(*slot)->refCount) == 1) {
+            // nothing else uses the old result, so write over it
+            blendPixelSpan((*slot)->pixels, backdrop ? backdrop->pixels : transparentTilePixels, src->pixels,
+                TILE_PIXELS, layer->blendMode, layer->opacity);
+            continue;
+        } else {
+            result = createTile();
+            if (!result) {
+                continue;
+            }
+            blendPixelSpan(result->pixels, backdrop ? backdrop->pixels : transparentTilePixels, src->pixels,
+                TILE_PIXELS, layer->blendMode, layer->opacity);
+        }
+        releaseTile(*slot);
+        *slot = result;
+    }
+    stack->validLevels[index] = numLayers;
+}
+
+void compositeLayerTiles(LayerStack* stack, SDL_Rect rect, bool parallel) {
+    int firstTileX, firstTileY, lastTileX, lastTileY;
+    if (!getTileRange(&stack->composite, rect, &firstTileX, &firstTileY, &lastTileX, &lastTileY)) {
+        return;
+    }
+    int numLayers = (int)stack->layers.size();
+    std::vector<int> changed;
+    for (int tileY = firstTileY; tileY <= lastTileY; tileY++) {
+        for (int tileX = firstTileX; tileX <= lastTileX; tileX++) {
+            int index = tileX + tileY * stack->composite.tilesX;
+            if (stack->validLevels[index] < numLayers) {
+                changed.push_back(index);
+            }
+        }
+    }
+
+    if (parallel && changed.size() >= PARALLEL_COMPOSITE_MIN_TILES) {
+        getThreadPool()->parallelFor((int)changed.size(), [&](int i) {
+            compositeTile(stack, changed[i]);
+        });
+    } else {
+        for (size_t i = 0; i < changed.size(); i++) {
+            compositeTile(stack, changed[i]);
+        }
+    }
+}
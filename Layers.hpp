@@ -0,0 +1,92 @@
+#ifndef LAYERS_INCLUDED
+#define LAYERS_INCLUDED
+
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "Tiles.hpp"
+#include "Blend.hpp"
+
+struct Layer {
+    TileGrid tiles;
+    float opacity; // 0 to 1
+    bool visible;
+    BlendMode blendMode;
+
+    // cached composite of all the layers under this one, so changing this layer only has to blend it
+    // onto the cache instead of going through the whole stack again. Tiles are shared with the layer
+    // or the cache below wherever blending wouldn't change anything
+    TileGrid below;
+};
+
+/*
+* Layers composited together into the image that's shown. Compositing is done per tile and only for
+* tiles that changed, and only once something asks for them (see compositeLayerTiles).
+*/
+struct LayerStack {
+    int width; // in pixels
+    int height;
+    std::vector<Layer> layers; // bottom to top
+    TileGrid composite; // all the layers composited
+
+    // for each tile, the number of layers whose composites (the layer's below, then the stack composite)
+    // are up to date. layer 0's below is always empty, so this is at least 0, and layers.size() if nothing needs compositing
+    std::vector<int> validLevels;
+};
+
+/*
+* Initialize a stack with a single empty layer.
+* @return 0 on success, -1 on allocation failure
+*/
+int initLayerStack(LayerStack* stack, int width, int height);
+void destroyLayerStack(LayerStack* stack);
+
+/*
+* Make dst a copy of src, sharing all the tiles. dst should not be initialized already.
+* @return 0 on success, -1 on allocation failure
+*/
+int copyLayerStack(LayerStack* dst, const LayerStack* src);
+
+inline int getLayerCount(const LayerStack* stack) {
+    return (int)stack->layers.size();
+}
+
+/*
+* Insert an empty, visible, normal layer.
+* @param index Where the layer goes, 0 for the bottom and getLayerCount for the top
+* @return 0 on success, -1 on allocation failure
+*/
+int insertLayer(LayerStack* stack, int index);
+
+/*
+* Insert a layer using tiles for its pixels, taking ownership of them.
+* The grid has to be the same size as the stack.
+* @return 0 on success, -1 on allocation failure (the tiles are destroyed)
+*/
+int insertLayerTiles(LayerStack* stack, int index, TileGrid tiles, float opacity, bool visible, BlendMode blendMode);
+
+/*
+* Remove a layer. The last layer can't be removed.
+*/
+void removeLayer(LayerStack* stack, int index);
+
+/*
+* Swap a layer with the one above it.
+*/
+void swapLayerWithAbove(LayerStack* stack, int index);
+
+/*
+* Mark the tiles of a layer touching rect as changed, so everything above them gets composited again.
+* Must be called after changing the layer's pixels. For changes to its opacity, visibility or blend mode,
+* use the whole canvas as the rect.
+*/
+void invalidateLayerRect(LayerStack* stack, int layerIndex, SDL_Rect rect);
+
+/*
+* Composite the changed tiles touching rect.
+* @param parallel Whether to use the thread pool. Must be false when called from a worker thread
+*/
+void compositeLayerTiles(LayerStack* stack, SDL_Rect rect, bool parallel);
+
+#endif
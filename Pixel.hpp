@@ -0,0 +1,32 @@
+#ifndef PIXEL_INCLUDED
+#define PIXEL_INCLUDED
+
+#include <SDL2/SDL.h>
+
+// the format used for canvas textures
+#define SDL_PIXELFORMAT SDL_PIXELFORMAT_RGBA8888
+
+/*
+* A single canvas pixel, stored as 4 bytes in r,g,b,a order (SDL_PIXELFORMAT_RGBA32).
+*/
+struct Pixel {
+    Uint8 r;
+    Uint8 g;
+    Uint8 b;
+    Uint8 a;
+};
+
+inline Uint32 pixelToRGBA8888(Pixel pixel) {
+    return ((Uint32)pixel.r << 24) | ((Uint32)pixel.g << 16) | ((Uint32)pixel.b << 8) | (Uint32)pixel.a;
+}
+
+/*
+* Convert a row of pixels to packed RGBA8888 texture pixels.
+*/
+inline void convertPixelsToRGBA8888(const Pixel* src, Uint32* dst, int count) {
+    for (int i = 0; i < count; i++) {
+        dst[i] = pixelToRGBA8888(src[i]);
+    }
+}
+
+#endif
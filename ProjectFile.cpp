@@ -0,0 +1,331 @@
+#include "ProjectFile.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <zlib.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define TILE_DATA_SIZE (TILE_PIXELS * sizeof(Pixel))
+
+static void writeLE32(Uint8* dst, Uint32 value) {
+    dst[0] = value;
+    dst[1] = value >> 8;
+    dst[2] = value >> 16;
+    dst[3] = value >> 24;
+}
+
+static Uint32 readLE32(const Uint8* src) {
+    return (Uint32)src[0] | ((Uint32)src[1] << 8) | ((Uint32)src[2] << 16) | ((Uint32)src[3] << 24);
+}
+
+#define HEADER_SIZE 32
+#define LAYER_ENTRY_SIZE 16
+#define TILE_ENTRY_SIZE 16
+
+static void encodeHeader(const ProjectFileHeader* header, Uint8* dst) {
+    memcpy(dst, header->magic, 4);
+    writeLE32(dst + 4, header->version);
+    writeLE32(dst + 8, header->width);
+    writeLE32(dst + 12, header->height);
+    writeLE32(dst + 16, header->tileSize);
+    writeLE32(dst + 20, header->tilesX);
+    writeLE32(dst + 24, header->tilesY);
+    writeLE32(dst + 28, header->layerCount);
+}
+
+static void decodeHeader(const Uint8* src, ProjectFileHeader* header) {
+    memcpy(header->magic, src, 4);
+    header->version = readLE32(src + 4);
+    header->width = readLE32(src + 8);
+    header->height = readLE32(src + 12);
+    header->tileSize = readLE32(src + 16);
+    header->tilesX = readLE32(src + 20);
+    header->tilesY = readLE32(src + 24);
+    header->layerCount = readLE32(src + 28);
+}
+
+static void encodeLayerEntry(const ProjectLayerEntry* entry, Uint8* dst) {
+    Uint32 opacityBits;
+    memcpy(&opacityBits, &entry->opacity, 4);
+    writeLE32(dst, entry->flags);
+    writeLE32(dst + 4, entry->blendMode);
+    writeLE32(dst + 8, opacityBits);
+    writeLE32(dst + 12, entry->reserved);
+}
+
+static void decodeLayerEntry(const Uint8* src, ProjectLayerEntry* entry) {
+    Uint32 opacityBits = readLE32(src + 8);
+    entry->flags = readLE32(src);
+    entry->blendMode = readLE32(src + 4);
+    memcpy(&entry->opacity, &opacityBits, 4);
+    entry->reserved = readLE32(src + 12);
+}
+
+static void encodeTileEntry(const ProjectTileEntry* entry, Uint8* dst) {
+    writeLE32(dst, (Uint32)entry->offset);
+    writeLE32(dst + 4, (Uint32)(entry->offset >> 32));
+    writeLE32(dst + 8, entry->compressedSize);
+    writeLE32(dst + 12, entry->reserved);
+}
+
+static void decodeTileEntry(const Uint8* src, ProjectTileEntry* entry) {
+    entry->offset = (Uint64)readLE32(src) | ((Uint64)readLE32(src + 4) << 32);
+    entry->compressedSize = readLE32(src + 8);
+    entry->reserved = readLE32(src + 12);
+}
+
+SaveState writeProjectFile(const LayerStack* layers, FILE* file, SDL_atomic_t* progress, SDL_atomic_t* cancelled) {
+    const TileGrid* composite = &layers->composite;
+    int numTiles = composite->tilesX * composite->tilesY;
+    int numLayers = getLayerCount(layers);
+
+    ProjectFileHeader header;
+    memcpy(header.magic, PROJECT_FILE_MAGIC, 4);
+    header.version = PROJECT_FILE_VERSION;
+    header.width = composite->width;
+    header.height = composite->height;
+    header.tileSize = TILE_SIZE;
+    header.tilesX = composite->tilesX;
+    header.tilesY = composite->tilesY;
+    header.layerCount = numLayers;
+
+    // header and index get written at the end, once the tile offsets are known
+    size_t layerIndexSize = LAYER_ENTRY_SIZE + (size_t)numTiles * TILE_ENTRY_SIZE;
+    std::vector<Uint8> index(HEADER_SIZE + layerIndexSize * numLayers);
+    if (fwrite(index.data(), 1, index.size(), file) != index.size()) {
+        return SAVE_FAILED;
+    }
+    encodeHeader(&header, index.data());
+
+    uLong maxCompressedSize = compressBound(TILE_DATA_SIZE);
+    std::vector<Uint8> compressed(maxCompressedSize);
+    Uint64 offset = index.size();
+    for (int layerIndex = 0; layerIndex < numLayers; layerIndex++) {
+        const Layer* layer = &layers->layers[layerIndex];
+        Uint8* layerEntries = &index[HEADER_SIZE + layerIndexSize * layerIndex];
+        ProjectLayerEntry layerEntry;
+        layerEntry.flags = layer->visible ? PROJECT_LAYER_VISIBLE : 0;
+        layerEntry.blendMode = layer->blendMode;
+        layerEntry.opacity = layer->opacity;
+        layerEntry.reserved = 0;
+        encodeLayerEntry(&layerEntry, layerEntries);
+
+        for (int i = 0; i < numTiles; i++) {
+            if (SDL_AtomicGet(cancelled)) {
+                return SAVE_CANCELLED;
+            }
+            ProjectTileEntry entry = {0, 0, 0};
+            const Tile* tile = getTileAtIndex(&layer->tiles, i);
+            if (tile) {
+                uLongf compressedSize = maxCompressedSize;
+                if (compress2(compressed.data(), &compressedSize, (const Bytef*)tile->pixels, TILE_DATA_SIZE, Z_DEFAULT_COMPRESSION) != Z_OK
+                    || fwrite(compressed.data(), 1, compressedSize, file) != compressedSize) {
+                    return SAVE_FAILED;
+                }
+                entry.offset = offset;
+                entry.compressedSize = (Uint32)compressedSize;
+                offset += compressedSize;
+            }
+            encodeTileEntry(&entry, layerEntries + LAYER_ENTRY_SIZE + (size_t)i * TILE_ENTRY_SIZE);
+            SDL_AtomicAdd(progress, 1);
+        }
+    }
+
+    if (fseek(file, 0, SEEK_SET) != 0 || fwrite(index.data(), 1, index.size(), file) != index.size()) {
+        return SAVE_FAILED;
+    }
+    return SAVE_DONE;
+}
+
+/*
+* The contents of a project file in memory, mapped when possible, otherwise read in whole.
+* Shared by the sources of all the layers in the file, so it's reference counted like them.
+*/
+class ProjectFileData {
+public:
+    const Uint8* data;
+    size_t size;
+    bool mapped;
+
+    ProjectFileData() : data(NULL), size(0), mapped(false) {
+        SDL_AtomicSet(&refCount, 1);
+    }
+
+    ProjectFileData* retain() {
+        SDL_AtomicIncRef(&refCount);
+        return this;
+    }
+    void release() {
+        if (SDL_AtomicDecRef(&refCount)) {
+            delete this;
+        }
+    }
+
+    bool open(const char* path) {
+#ifndef _WIN32
+        int fd = ::open(path, O_RDONLY);
+        if (fd >= 0) {
+            struct stat info;
+            if (fstat(fd, &info) == 0 && info.st_size > 0) {
+                void* mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping != MAP_FAILED) {
+                    data = (const Uint8*)mapping;
+                    size = (size_t)info.st_size;
+                    mapped = true;
+                }
+            }
+            close(fd);
+            if (mapped) return true;
+        }
+#endif
+        // no mmap, just read the whole thing
+        data = (const Uint8*)SDL_LoadFile(path, &size);
+        return data != NULL;
+    }
+
+private:
+    SDL_atomic_t refCount;
+
+    ~ProjectFileData() {
+        if (!data) return;
+#ifndef _WIN32
+        if (mapped) {
+            munmap((void*)data, size);
+            return;
+        }
+#endif
+        SDL_free((void*)data);
+    }
+};
+
+/*
+* Loads the tiles of one layer of a project file.
+*/
+class ProjectLayerSource : public TileSource {
+public:
+    ProjectFileData* file;
+    const Uint8* tileEntries; // the layer's tile index
+
+    ProjectLayerSource(ProjectFileData* file, const Uint8* tileEntries) : file(file->retain()), tileEntries(tileEntries) {}
+
+    ~ProjectLayerSource() {
+        file->release();
+    }
+
+    bool loadTile(int tileIndex, Pixel* pixels) {
+        ProjectTileEntry entry;
+        decodeTileEntry(tileEntries + (size_t)tileIndex * TILE_ENTRY_SIZE, &entry);
+        uLongf decompressedSize = TILE_DATA_SIZE;
+        return uncompress((Bytef*)pixels, &decompressedSize, file->data + entry.offset, entry.compressedSize) == Z_OK
+            && decompressedSize == TILE_DATA_SIZE;
+    }
+};
+
+/*
+* Make a grid for one layer of the file, checking every tile entry is inside the file so loadTile doesn't have to.
+* @return 0 on success, -1 on error
+*/
+static int openProjectLayer(const char* path, ProjectFileData* file, const ProjectFileHeader* header, const Uint8* tileEntries, TileGrid* tiles) {
+    Uint64 numTiles = (Uint64)header->tilesX * header->tilesY;
+    std::vector<Uint8> pending(numTiles);
+    bool anyPending = false;
+    for (Uint64 i = 0; i < numTiles; i++) {
+        ProjectTileEntry entry;
+        decodeTileEntry(tileEntries + i * TILE_ENTRY_SIZE, &entry);
+        if (entry.offset == 0) continue;
+        if (entry.offset > file->size || entry.compressedSize > file->size - entry.offset) {
+            SDL_Log("Error: Project file %s has a tile outside of the file.", path);
+            return -1;
+        }
+        pending[i] = 1;
+        anyPending = true;
+    }
+
+    if (initTileGrid(tiles, header->width, header->height)) {
+        return -1;
+    }
+    // layers with nothing to load don't keep the file around
+    if (anyPending && setTileGridSource(tiles, new ProjectLayerSource(file, tileEntries), pending.data())) {
+        destroyTileGrid(tiles);
+        return -1;
+    }
+    return 0;
+}
+
+int openProjectFile(const char* path, LayerStack* layers) {
+    ProjectFileData* file = new ProjectFileData();
+    if (!file->open(path)) {
+        SDL_Log("Error: Failed to open project file %s.", path);
+        file->release();
+        return -1;
+    }
+
+    ProjectFileHeader header;
+    if (file->size < HEADER_SIZE) {
+        SDL_Log("Error: %s is too small to be a project file.", path);
+        file->release();
+        return -1;
+    }
+    decodeHeader(file->data, &header);
+    // version 1 had a single layer and no layer entries
+    Uint32 numLayers = header.version == 1 ? 1 : header.layerCount;
+    size_t layerEntrySize = header.version == 1 ? 0 : LAYER_ENTRY_SIZE;
+    if (memcmp(header.magic, PROJECT_FILE_MAGIC, 4) != 0 || header.version == 0 || header.version > PROJECT_FILE_VERSION
+        || header.tileSize != TILE_SIZE || header.width == 0 || header.height == 0
+        || header.width > (Uint32)SDL_MAX_SINT32 || header.height > (Uint32)SDL_MAX_SINT32
+        || header.tilesX != (header.width + TILE_SIZE - 1) / TILE_SIZE
+        || header.tilesY != (header.height + TILE_SIZE - 1) / TILE_SIZE
+        || numLayers == 0 || numLayers > PROJECT_MAX_LAYERS) {
+        SDL_Log("Error: %s is not a supported project file.", path);
+        file->release();
+        return -1;
+    }
+    Uint64 numTiles = (Uint64)header.tilesX * header.tilesY;
+    Uint64 layerIndexSize = layerEntrySize + numTiles * TILE_ENTRY_SIZE;
+    // the header size was checked above, dividing keeps a huge tile count from wrapping the product around
+    if (layerIndexSize > (file->size - HEADER_SIZE) / numLayers) {
+        SDL_Log("Error: Project file %s is truncated.", path);
+        file->release();
+        return -1;
+    }
+
+    if (initLayerStack(layers, header.width, header.height)) {
+        file->release();
+        return -1;
+    }
+    for (Uint32 layerIndex = 0; layerIndex < numLayers; layerIndex++) {
+        const Uint8* layerEntries = file->data + HEADER_SIZE + layerIndexSize * layerIndex;
+        ProjectLayerEntry layerEntry = {PROJECT_LAYER_VISIBLE, BLEND_NORMAL, 1.0f, 0};
+        if (layerEntrySize) {
+            decodeLayerEntry(layerEntries, &layerEntry);
+        }
+        // anything out of range gets the defaults rather than failing the whole file
+        if (layerEntry.blendMode >= BLEND_MODE_COUNT) {
+            layerEntry.blendMode = BLEND_NORMAL;
+        }
+        if (!(layerEntry.opacity >= 0.0f && layerEntry.opacity <= 1.0f)) {
+            layerEntry.opacity = 1.0f;
+        }
+
+        TileGrid tiles;
+        if (openProjectLayer(path, file, &header, layerEntries + layerEntrySize, &tiles)
+            || insertLayerTiles(layers, getLayerCount(layers), tiles, layerEntry.opacity,
+                (layerEntry.flags & PROJECT_LAYER_VISIBLE) != 0, (BlendMode)layerEntry.blendMode)) {
+            destroyLayerStack(layers);
+            file->release();
+            return -1;
+        }
+    }
+    // the stack starts with an empty layer, which the file's layers go on top of
+    removeLayer(layers, 0);
+
+    file->release();
+    return 0;
+}
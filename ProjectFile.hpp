@@ -0,0 +1,72 @@
+#ifndef PROJECT_FILE_INCLUDED
+#define PROJECT_FILE_INCLUDED
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+#include "Tiles.hpp"
+#include "Layers.hpp"
+#include "CanvasSave.hpp"
+
+/*
+* Native project file format. Everything is little endian.
+*
+*   ProjectFileHeader
+*   for each layer, bottom to top:
+*     ProjectLayerEntry
+*     ProjectTileEntry[tilesX * tilesY]   tile index, row major like TileGrid::tiles
+*   tile data                             each tile zlib compressed on its own
+*
+* Version 1 files have a single layer with no ProjectLayerEntry, just the tile index.
+* Transparent tiles have an offset of 0 and no data. Because tiles are compressed independently,
+* a project can be mapped into memory and only the tiles that are actually needed get decompressed.
+* PNG is still used for importing and exporting images.
+*/
+
+#define PROJECT_FILE_MAGIC "PXAP"
+#define PROJECT_FILE_VERSION 2
+// most layers a project file can have, to reject garbage counts
+#define PROJECT_MAX_LAYERS 4096
+
+struct ProjectFileHeader {
+    char magic[4];
+    Uint32 version;
+    Uint32 width; // in pixels
+    Uint32 height;
+    Uint32 tileSize; // must be TILE_SIZE
+    Uint32 tilesX;
+    Uint32 tilesY;
+    Uint32 layerCount; // reserved (0) in version 1
+};
+
+struct ProjectLayerEntry {
+    Uint32 flags; // PROJECT_LAYER_VISIBLE
+    Uint32 blendMode; // a BlendMode
+    float opacity; // stored as its IEEE 754 bits
+    Uint32 reserved;
+};
+
+#define PROJECT_LAYER_VISIBLE 1
+
+struct ProjectTileEntry {
+    Uint64 offset; // from the start of the file, 0 for a transparent tile
+    Uint32 compressedSize;
+    Uint32 reserved;
+};
+
+/*
+* Write the layers as a project file, used by the background save.
+* @param progress Incremented once per tile written
+* @param cancelled Checked between tiles, stops the write if set
+*/
+SaveState writeProjectFile(const LayerStack* layers, FILE* file, SDL_atomic_t* progress, SDL_atomic_t* cancelled);
+
+/*
+* Open a project file into an empty layer stack. The file is mapped into memory and tiles are only
+* decompressed once something accesses them (see TileSource), so opening big projects is quick.
+* @param layers Stack to initialize, should not be initialized already
+* @return 0 on success, -1 on error
+*/
+int openProjectFile(const char* path, LayerStack* layers);
+
+#endif
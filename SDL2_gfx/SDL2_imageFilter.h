@@ -51,17 +51,25 @@ extern "C" {
 #endif
 
 	/* Comments:                                                                           */
-	/*  1.) MMX functions work best if all data blocks are aligned on a 32 bytes boundary. */
-	/*  2.) Data that is not within an 8 byte boundary is processed using the C routine.   */
-	/*  3.) Convolution routines do not have C routines at this time.                      */
+	/*  1.) The filters use SSE2/AVX2 (runtime detected), NEON or WebAssembly SIMD         */
+	/*      where available, the MMX names below are kept for compatibility.               */
+	/*  2.) Bytes that don't fill a whole SIMD vector are processed using the C routine.   */
+	/*  3.) Every filter gives exactly the same bytes with and without SIMD.               */
 
-	// Detect MMX capability in CPU
+	// Detect SIMD capability in CPU
 	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterMMXdetect(void);
 
-	// Force use of MMX off (or turn possible use back on)
+	// Force use of SIMD off (or turn possible use back on)
 	SDL2_IMAGEFILTER_SCOPE void SDL_imageFilterMMXoff(void);
 	SDL2_IMAGEFILTER_SCOPE void SDL_imageFilterMMXon(void);
 
+	// Pick the SIMD instruction set by name ("SSE2", "AVX2", "NEON", "WASM"), NULL for the best one the CPU has.
+	// Returns -1 if it isn't built in or the CPU doesn't have it
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterSelectSIMD(const char *name);
+
+	// The name of the SIMD instruction set in use, NULL if there's none or SIMD is off
+	SDL2_IMAGEFILTER_SCOPE const char *SDL_imageFilterSIMDName(void);
+
 	//
 	// All routines return:
 	//   0   OK
@@ -83,7 +91,7 @@ extern "C" {
 	//  SDL_imageFilterMult: D = saturation(S1 * S2)
 	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterMult(unsigned char *Src1, unsigned char *Src2, unsigned char *Dest, unsigned int length);
 
-	//  SDL_imageFilterMultNor: D = S1 * S2   (non-MMX)
+	//  SDL_imageFilterMultNor: D = S1 * S2
 	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterMultNor(unsigned char *Src1, unsigned char *Src2, unsigned char *Dest, unsigned int length);
 
 	//  SDL_imageFilterMultDivby2: D = saturation255(S1/2 * S2)
@@ -100,7 +108,7 @@ extern "C" {
 	//  SDL_imageFilterBitOr: D = S1 | S2
 	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterBitOr(unsigned char *Src1, unsigned char *Src2, unsigned char *Dest, unsigned int length);
 
-	//  SDL_imageFilterDiv: D = S1 / S2   (non-MMX)
+	//  SDL_imageFilterDiv: D = S1 / S2
 	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterDiv(unsigned char *Src1, unsigned char *Src2, unsigned char *Dest, unsigned int length);
 
 	//  SDL_imageFilterBitNegation: D = !S
@@ -158,6 +166,86 @@ extern "C" {
 	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterNormalizeLinear(unsigned char *Src, unsigned char *Dest, unsigned int length, int Cmin,
 		int Cmax, int Nmin, int Nmax);
 
+	//
+	// Convolutions of 2D byte arrays of rows x columns with a size x size kernel of signed shorts, row by row.
+	// Only pixels the whole kernel fits around are written, the border of D keeps what it had.
+	// S and D must be different arrays. All routines return 0 OK, -1 Error.
+	// Multi-row arrays are spread over the parallel for loop set with SDL_imageFilterSetParallelFor.
+	//
+
+	//  SDL_imageFilterConvolveKernelNxNDivide: Dij = saturation0and255(sum(Kkl * Si+k,j+l) / Divisor)
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterConvolveKernel3x3Divide(unsigned char *Src, unsigned char *Dest, int rows, int columns,
+		signed short *Kernel, unsigned char Divisor);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterConvolveKernel5x5Divide(unsigned char *Src, unsigned char *Dest, int rows, int columns,
+		signed short *Kernel, unsigned char Divisor);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterConvolveKernel7x7Divide(unsigned char *Src, unsigned char *Dest, int rows, int columns,
+		signed short *Kernel, unsigned char Divisor);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterConvolveKernel9x9Divide(unsigned char *Src, unsigned char *Dest, int rows, int columns,
+		signed short *Kernel, unsigned char Divisor);
+
+	//  SDL_imageFilterConvolveKernelNxNShiftRight: Dij = saturation0and255(sum(Kkl * (Si+k,j+l >> N)))
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterConvolveKernel3x3ShiftRight(unsigned char *Src, unsigned char *Dest, int rows,
+		int columns, signed short *Kernel, unsigned char NRightShift);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterConvolveKernel5x5ShiftRight(unsigned char *Src, unsigned char *Dest, int rows,
+		int columns, signed short *Kernel, unsigned char NRightShift);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterConvolveKernel7x7ShiftRight(unsigned char *Src, unsigned char *Dest, int rows,
+		int columns, signed short *Kernel, unsigned char NRightShift);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterConvolveKernel9x9ShiftRight(unsigned char *Src, unsigned char *Dest, int rows,
+		int columns, signed short *Kernel, unsigned char NRightShift);
+
+	//  SDL_imageFilterSobelX: Dij = saturation255(| horizontal Sobel gradient of S |)
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterSobelX(unsigned char *Src, unsigned char *Dest, int rows, int columns);
+
+	//  SDL_imageFilterSobelXShiftRight: Dij = saturation255(| horizontal Sobel gradient of S >> N |)
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterSobelXShiftRight(unsigned char *Src, unsigned char *Dest, int rows, int columns,
+		unsigned char NRightShift);
+
+	//
+	// Pipelines: a sequence of the one source filters, run in one pass per cache sized block.
+	// The result is the same as copying S to D and running each filter over D in turn.
+	// Filters with constants that make them do nothing aren't added. All routines return 0 OK, -1 Error.
+	//
+
+	typedef struct SDL_imageFilterPipeline SDL_imageFilterPipeline;
+
+	// A parallel for loop: calls job(data, i) for every i from 0 to count - 1, on any threads, and returns once they're all done
+	typedef void (*SDL_imageFilterParallelFor)(int count, void (*job)(void *data, int index), void *data);
+
+	// Spread the blocks of big pipelines over a parallel for loop, NULL (the default) to run them on the calling thread
+	SDL2_IMAGEFILTER_SCOPE void SDL_imageFilterSetParallelFor(SDL_imageFilterParallelFor parallelFor);
+
+	// Create an empty pipeline, NULL if out of memory
+	SDL2_IMAGEFILTER_SCOPE SDL_imageFilterPipeline *SDL_imageFilterPipelineCreate(void);
+	SDL2_IMAGEFILTER_SCOPE void SDL_imageFilterPipelineDestroy(SDL_imageFilterPipeline *pipeline);
+
+	// Remove all filters, to record the pipeline again
+	SDL2_IMAGEFILTER_SCOPE void SDL_imageFilterPipelineClear(SDL_imageFilterPipeline *pipeline);
+
+	// Run the pipeline: D = filters(S). S and D may be the same array.
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineRun(SDL_imageFilterPipeline *pipeline, unsigned char *Src, unsigned char *Dest,
+		unsigned int length);
+
+	// Add filters to the end of the pipeline, with the same constants as the filter routines
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineBitNegation(SDL_imageFilterPipeline *pipeline);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineAddByte(SDL_imageFilterPipeline *pipeline, unsigned char C);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineAddUint(SDL_imageFilterPipeline *pipeline, unsigned int C);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineAddByteToHalf(SDL_imageFilterPipeline *pipeline, unsigned char C);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineSubByte(SDL_imageFilterPipeline *pipeline, unsigned char C);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineSubUint(SDL_imageFilterPipeline *pipeline, unsigned int C);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineShiftRight(SDL_imageFilterPipeline *pipeline, unsigned char N);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineShiftRightUint(SDL_imageFilterPipeline *pipeline, unsigned char N);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineMultByByte(SDL_imageFilterPipeline *pipeline, unsigned char C);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineShiftRightAndMultByByte(SDL_imageFilterPipeline *pipeline, unsigned char N,
+		unsigned char C);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineShiftLeftByte(SDL_imageFilterPipeline *pipeline, unsigned char N);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineShiftLeftUint(SDL_imageFilterPipeline *pipeline, unsigned char N);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineShiftLeft(SDL_imageFilterPipeline *pipeline, unsigned char N);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineBinarizeUsingThreshold(SDL_imageFilterPipeline *pipeline, unsigned char T);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineClipToRange(SDL_imageFilterPipeline *pipeline, unsigned char Tmin,
+		unsigned char Tmax);
+	SDL2_IMAGEFILTER_SCOPE int SDL_imageFilterPipelineNormalizeLinear(SDL_imageFilterPipeline *pipeline, int Cmin, int Cmax,
+		int Nmin, int Nmax);
+
 	/* Ends C function definitions when using C++ */
 #ifdef __cplusplus
 }
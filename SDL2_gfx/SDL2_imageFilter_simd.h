@@ -0,0 +1,491 @@
+/*
+
+SDL2_imageFilter_simd.h: SIMD kernels for the byte-image filters
+
+This file is included by SDL2_imageFilter.c once for every instruction set the
+filters are built for, after defining the vector type and operations for it:
+
+FILTER_ISA     Suffix of the kernel names, e.g. SSE2 gives SDL_imageFilterAddSSE2.
+FILTER_TARGET  Attributes letting the kernels use the instruction set (may be empty).
+FV             The vector type, FV_BYTES bytes wide.
+FV_LOAD(p), FV_STORE(p, v), FV_SET1(b)  Unaligned load and store, all bytes set to b.
+FV_ADDS, FV_SUBS, FV_MIN, FV_MAX, FV_CMPEQ  Unsigned byte add and subtract with saturation, min, max and compare.
+FV_AND, FV_OR, FV_XOR, FV_ANDNOT(m, v)  Bitwise operations, ANDNOT being ~m & v.
+FV_SRL8, FV_SLL8, FV_SRL32, FV_SLL32  Shifts of bytes and 32 bit words by 0 up to their size.
+FV_MULSAT(a, b), FV_MULLO(a, b)  Byte products, saturated to 255 or keeping the low byte.
+FV_DIV(a, b)   Byte quotients, with 255 for division by 0.
+FV_NORMALIZE(v, factor, offset)  v * factor + offset in 16 bits, 255 if over 255 and the low byte otherwise.
+
+and for the convolutions, which work on the bytes as pairs of 16 bit and sums of 32 bit lanes:
+
+FV_ZIP8_LO, FV_ZIP8_HI  Interleave the bytes of the low or high halves of a and b (of each 128bit lane).
+FV_WIDEN_LO, FV_WIDEN_HI  Widen the low or high bytes (of each 128bit lane) to 16 bits.
+FV_SET1_32(x), FV_ADD32(a, b)  All 32 bit words set to x, sums of 32 bit words.
+FV_MADD16(a, b)  Sums of the products of neighbouring signed 16 bit lanes, in 32 bits.
+FV_DIV32(v, d)  Signed 32 bit quotients truncated towards 0, close enough to clamp to 0..255 exactly.
+FV_ABS32(v)    Magnitudes of 32 bit words.
+FV_PACK32(a, b, c, d)  32 bit words to bytes clamped to 0..255, undoing the interleaving and widening.
+
+Every kernel processes as many whole vectors as fit in length and returns how many
+bytes that was, leaving the rest to the C kernels. They must give exactly the same
+results as the C kernels.
+
+*/
+
+#define FILTER_PASTE2(a, b) a##b
+#define FILTER_PASTE(a, b) FILTER_PASTE2(a, b)
+#define FILTER_KERNEL(name) FILTER_PASTE(FILTER_PASTE(SDL_imageFilter, name), FILTER_ISA)
+
+/*!
+\brief Fills a vector sized buffer with the 4 bytes of an unsigned int, lowest byte first.
+*/
+#define FILTER_UINT_PATTERN(pattern, C) \
+	do { \
+		unsigned int k; \
+		for (k = 0; k < FV_BYTES; k++) { \
+			(pattern)[k] = (unsigned char) (((C) >> (8 * (k & 3))) & 0xff); \
+		} \
+	} while (0)
+
+/*!
+\brief Loops over the whole vectors in length with i, the number of bytes done so far.
+*/
+#define FILTER_FOR_VECTORS(i, length) for ((i) = 0; (i) + FV_BYTES <= (length); (i) += FV_BYTES)
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(Add)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_ADDS(FV_LOAD(Src1 + i), FV_LOAD(Src2 + i)));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(Mean)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		/* halves can't add up to more than 254 */
+		FV_STORE(Dest + i, FV_ADDS(FV_SRL8(FV_LOAD(Src1 + i), 1), FV_SRL8(FV_LOAD(Src2 + i), 1)));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(Sub)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_SUBS(FV_LOAD(Src1 + i), FV_LOAD(Src2 + i)));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(AbsDiff)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FV a, b;
+	FILTER_FOR_VECTORS(i, length) {
+		a = FV_LOAD(Src1 + i);
+		b = FV_LOAD(Src2 + i);
+		/* one of the two differences saturates to 0 */
+		FV_STORE(Dest + i, FV_OR(FV_SUBS(a, b), FV_SUBS(b, a)));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(Mult)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_MULSAT(FV_LOAD(Src1 + i), FV_LOAD(Src2 + i)));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(MultNor)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_MULLO(FV_LOAD(Src1 + i), FV_LOAD(Src2 + i)));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(MultDivby2)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_MULSAT(FV_SRL8(FV_LOAD(Src1 + i), 1), FV_LOAD(Src2 + i)));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(MultDivby4)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_MULSAT(FV_SRL8(FV_LOAD(Src1 + i), 1), FV_SRL8(FV_LOAD(Src2 + i), 1)));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(BitAnd)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_AND(FV_LOAD(Src1 + i), FV_LOAD(Src2 + i)));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(BitOr)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_OR(FV_LOAD(Src1 + i), FV_LOAD(Src2 + i)));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(Div)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_DIV(FV_LOAD(Src1 + i), FV_LOAD(Src2 + i)));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(BitNegation)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FV ones = FV_SET1(0xff);
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_XOR(FV_LOAD(Src1 + i), ones));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(AddByte)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FV c = FV_SET1(args->C);
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_ADDS(FV_LOAD(Src1 + i), c));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(AddUint)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	unsigned char pattern[FV_BYTES];
+	FV c;
+	FILTER_UINT_PATTERN(pattern, args->C);
+	c = FV_LOAD(pattern);
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_ADDS(FV_LOAD(Src1 + i), c));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(AddByteToHalf)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FV c = FV_SET1(args->C);
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_ADDS(FV_SRL8(FV_LOAD(Src1 + i), 1), c));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(SubByte)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FV c = FV_SET1(args->C);
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_SUBS(FV_LOAD(Src1 + i), c));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(SubUint)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	unsigned char pattern[FV_BYTES];
+	FV c;
+	FILTER_UINT_PATTERN(pattern, args->C);
+	c = FV_LOAD(pattern);
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_SUBS(FV_LOAD(Src1 + i), c));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(ShiftRight)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_SRL8(FV_LOAD(Src1 + i), args->N));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(ShiftRightUint)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_SRL32(FV_LOAD(Src1 + i), args->N));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(MultByByte)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FV c = FV_SET1(args->C);
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_MULSAT(FV_LOAD(Src1 + i), c));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(ShiftRightAndMultByByte)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FV c = FV_SET1(args->C);
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_MULSAT(FV_SRL8(FV_LOAD(Src1 + i), args->N), c));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(ShiftLeftByte)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_SLL8(FV_LOAD(Src1 + i), args->N));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(ShiftLeftUint)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_SLL32(FV_LOAD(Src1 + i), args->N));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(ShiftLeft)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FV v;
+	/* bytes above 255 >> N overflow, N is at least 1 */
+	FV limit = FV_SET1((255 >> args->N) + 1);
+	FILTER_FOR_VECTORS(i, length) {
+		v = FV_LOAD(Src1 + i);
+		FV_STORE(Dest + i, FV_OR(FV_SLL8(v, args->N), FV_CMPEQ(FV_MAX(v, limit), v)));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(BinarizeUsingThreshold)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FV v;
+	FV t = FV_SET1(args->T);
+	FILTER_FOR_VECTORS(i, length) {
+		v = FV_LOAD(Src1 + i);
+		FV_STORE(Dest + i, FV_CMPEQ(FV_MAX(v, t), v));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(ClipToRange)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	FV v, inrange;
+	FV tmin = FV_SET1(args->Tmin);
+	FV tmax = FV_SET1(args->Tmax);
+	FILTER_FOR_VECTORS(i, length) {
+		v = FV_LOAD(Src1 + i);
+		/* like the C kernel, Tmin wins where it's above Tmax */
+		inrange = FV_CMPEQ(FV_MAX(v, tmin), v);
+		FV_STORE(Dest + i, FV_OR(FV_AND(inrange, FV_MIN(v, tmax)), FV_ANDNOT(inrange, tmin)));
+	}
+	return (i);
+}
+
+FILTER_TARGET static unsigned int FILTER_KERNEL(NormalizeLinear)(const unsigned char *Src1, const unsigned char *Src2, unsigned char *Dest,
+	unsigned int length, const tFilterArgs *args)
+{
+	unsigned int i;
+	int factor, offset;
+	if (args->Cmax == args->Cmin) {
+		return (0);
+	}
+	factor = (args->Nmax - args->Nmin) / (args->Cmax - args->Cmin);
+	/* S * factor + offset has to fit in 16 bits for every byte, or it's left to the C kernel */
+	if ((factor < -128) || (factor > 128) || (args->Cmin < -65536) || (args->Cmin > 65536) ||
+		(args->Nmin < -65536) || (args->Nmin > 65536)) {
+		return (0);
+	}
+	offset = args->Nmin - factor * args->Cmin;
+	if ((offset < -32768) || (offset > 32767) || (offset + 255 * factor < -32768) || (offset + 255 * factor > 32767)) {
+		return (0);
+	}
+	FILTER_FOR_VECTORS(i, length) {
+		FV_STORE(Dest + i, FV_NORMALIZE(FV_LOAD(Src1 + i), factor, offset));
+	}
+	return (i);
+}
+
+/*!
+\brief Convolves the start of a row a vector of pixels at a time, see SDL_imageFilterConvolveC.
+
+Neighbouring columns of the kernel are interleaved, so each multiply-add does two of them. The loads of column
+column + 1 stay inside the row as long as the last window does, and the odd last column pairs up with 0 instead.
+*/
+FILTER_TARGET static unsigned int FILTER_KERNEL(Convolve)(const unsigned char *Src, unsigned char *Dest, unsigned int length,
+	int pitch, const tConvolveArgs *args)
+{
+	unsigned int i;
+	int row, column;
+	const unsigned char *window;
+	FV zero = FV_SET1(0);
+	FV sum0, sum1, sum2, sum3, left, right, lo, hi, weights;
+	FILTER_FOR_VECTORS(i, length) {
+		sum0 = sum1 = sum2 = sum3 = zero;
+		for (row = 0; row < args->size; row++) {
+			window = Src + row * pitch + i;
+			for (column = 0; column < args->size; column += 2) {
+				left = FV_SRL8(FV_LOAD(window + column), args->NRightShift);
+				right = (column + 1 < args->size) ? FV_SRL8(FV_LOAD(window + column + 1), args->NRightShift) : zero;
+				weights = FV_SET1_32(args->pairs[row][column / 2]);
+				lo = FV_ZIP8_LO(left, right);
+				hi = FV_ZIP8_HI(left, right);
+				sum0 = FV_ADD32(sum0, FV_MADD16(FV_WIDEN_LO(lo), weights));
+				sum1 = FV_ADD32(sum1, FV_MADD16(FV_WIDEN_HI(lo), weights));
+				sum2 = FV_ADD32(sum2, FV_MADD16(FV_WIDEN_LO(hi), weights));
+				sum3 = FV_ADD32(sum3, FV_MADD16(FV_WIDEN_HI(hi), weights));
+			}
+		}
+		if (args->Divisor != 0) {
+			sum0 = FV_DIV32(sum0, args->Divisor);
+			sum1 = FV_DIV32(sum1, args->Divisor);
+			sum2 = FV_DIV32(sum2, args->Divisor);
+			sum3 = FV_DIV32(sum3, args->Divisor);
+		}
+		if (args->absolute) {
+			sum0 = FV_ABS32(sum0);
+			sum1 = FV_ABS32(sum1);
+			sum2 = FV_ABS32(sum2);
+			sum3 = FV_ABS32(sum3);
+		}
+		FV_STORE(Dest + i, FV_PACK32(sum0, sum1, sum2, sum3));
+	}
+	return (i);
+}
+
+/*!
+\brief The kernels, in the order of the FILTER_ ids.
+*/
+static const tFilterKernel FILTER_PASTE(SDL_imageFilterKernels, FILTER_ISA)[FILTER_COUNT] = {
+	FILTER_KERNEL(Add),
+	FILTER_KERNEL(Mean),
+	FILTER_KERNEL(Sub),
+	FILTER_KERNEL(AbsDiff),
+	FILTER_KERNEL(Mult),
+	FILTER_KERNEL(MultNor),
+	FILTER_KERNEL(MultDivby2),
+	FILTER_KERNEL(MultDivby4),
+	FILTER_KERNEL(BitAnd),
+	FILTER_KERNEL(BitOr),
+	FILTER_KERNEL(Div),
+	FILTER_KERNEL(BitNegation),
+	FILTER_KERNEL(AddByte),
+	FILTER_KERNEL(AddUint),
+	FILTER_KERNEL(AddByteToHalf),
+	FILTER_KERNEL(SubByte),
+	FILTER_KERNEL(SubUint),
+	FILTER_KERNEL(ShiftRight),
+	FILTER_KERNEL(ShiftRightUint),
+	FILTER_KERNEL(MultByByte),
+	FILTER_KERNEL(ShiftRightAndMultByByte),
+	FILTER_KERNEL(ShiftLeftByte),
+	FILTER_KERNEL(ShiftLeftUint),
+	FILTER_KERNEL(ShiftLeft),
+	FILTER_KERNEL(BinarizeUsingThreshold),
+	FILTER_KERNEL(ClipToRange),
+	FILTER_KERNEL(NormalizeLinear)
+};
+
+#undef FILTER_PASTE2
+#undef FILTER_PASTE
+#undef FILTER_KERNEL
+#undef FILTER_UINT_PATTERN
+#undef FILTER_FOR_VECTORS
+
+/* the next instruction set defines its own */
+#undef FILTER_ISA
+#undef FILTER_TARGET
+#undef FV
+#undef FV_BYTES
+#undef FV_LOAD
+#undef FV_STORE
+#undef FV_SET1
+#undef FV_ADDS
+#undef FV_SUBS
+#undef FV_MIN
+#undef FV_MAX
+#undef FV_CMPEQ
+#undef FV_AND
+#undef FV_OR
+#undef FV_XOR
+#undef FV_ANDNOT
+#undef FV_SRL8
+#undef FV_SLL8
+#undef FV_SRL32
+#undef FV_SLL32
+#undef FV_MULSAT
+#undef FV_MULLO
+#undef FV_DIV
+#undef FV_NORMALIZE
+#undef FV_ZIP8_LO
+#undef FV_ZIP8_HI
+#undef FV_WIDEN_LO
+#undef FV_WIDEN_HI
+#undef FV_SET1_32
+#undef FV_MADD16
+#undef FV_ADD32
+#undef FV_DIV32
+#undef FV_ABS32
+#undef FV_PACK32
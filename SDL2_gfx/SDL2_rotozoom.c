@@ -34,6 +34,11 @@ Andreas Schiffler -- aschiffler at ferzkopp dot net
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ROTOZOOM_SSE2
+#endif
+
 #include "SDL2_rotozoom.h"
 
 /* ---- Internally used structures */
@@ -60,6 +65,11 @@ typedef struct tColorY {
 */
 #define MAX(a,b)    (((a) > (b)) ? (a) : (b))
 
+/*! 
+\brief Returns minimum of two numbers a and b.
+*/
+#define MIN(a,b)    (((a) < (b)) ? (a) : (b))
+
 /*! 
 \brief Number of guard rows added to destination surfaces.
 
@@ -77,6 +87,106 @@ to a situation where the program can segfault.
 */
 #define VALUE_LIMIT	0.001
 
+/*!
+\brief Destination pixels below which splitting the rows across threads isn't worth it.
+*/
+#define PARALLEL_MIN_PIXELS (128 * 128)
+
+/*!
+\brief The parallel for loop set with rotozoomSetParallelFor, NULL to do everything on the calling thread.
+*/
+static RotozoomParallelFor _parallelFor = NULL;
+
+/*!
+\brief Whether the zoomers use their SIMD paths, set with rotozoomSetSIMD.
+*/
+static int _useSIMD = 1;
+
+/*!
+\brief A job over a range of destination rows, from firstrow up to (not including) endrow.
+*/
+typedef void (*tRowsJob)(void *data, int firstrow, int endrow);
+
+/*!
+\brief Destination rows split into bands, one band per parallel job.
+*/
+typedef struct tRowBands {
+	tRowsJob job;
+	void *data;
+	int rows;
+	int bandrows;
+} tRowBands;
+
+/*!
+\brief Sets the parallel for loop the 32 bit zoomer, shrinker and rotozoomer spread their destination rows over.
+
+\param parallelFor Called with the number of jobs, a job function and its data. It has to call job(data, i) for
+every i from 0 to count - 1, in any order and on any threads, and return once they've all returned.
+NULL (the default) runs everything on the calling thread.
+*/
+void rotozoomSetParallelFor(RotozoomParallelFor parallelFor)
+{
+	_parallelFor = parallelFor;
+}
+
+/*!
+\brief Turns the SIMD paths of the zoomers off or back on.
+
+The SIMD paths give exactly the same pixels as the plain C ones, this is there to compare the two.
+
+\param enabled 0 to only use plain C, anything else to use SIMD where it's available (the default).
+*/
+void rotozoomSetSIMD(int enabled)
+{
+	_useSIMD = enabled;
+}
+
+/*!
+\brief Runs one band of rows.
+*/
+static void _runRowBand(void *data, int index)
+{
+	tRowBands *bands = (tRowBands *) data;
+	int firstrow = index * bands->bandrows;
+	bands->job(bands->data, firstrow, MIN(firstrow + bands->bandrows, bands->rows));
+}
+
+/*!
+\brief Runs a job over all the rows of a destination, split into bands across the parallel for loop if it's big enough.
+
+\param width Destination width, to tell how much work each row is.
+\param height Destination height.
+\param job The job to run on each band of rows. Different bands must only write to their own rows.
+\param data Passed to job.
+*/
+static void _forEachRowBand(int width, int height, tRowsJob job, void *data)
+{
+	tRowBands bands;
+	int numbands;
+
+	numbands = (int) (((double) width * height) / PARALLEL_MIN_PIXELS);
+	if ((_parallelFor == NULL) || (numbands < 2) || (height < 2)) {
+		job(data, 0, height);
+		return;
+	}
+	numbands = MIN(numbands, height);
+	bands.job = job;
+	bands.data = data;
+	bands.rows = height;
+	bands.bandrows = (height + numbands - 1) / numbands;
+	_parallelFor((height + bands.bandrows - 1) / bands.bandrows, _runRowBand, &bands);
+}
+
+/*!
+\brief Reads a pixel as one 32 bit value.
+*/
+static Uint32 _loadPixel(const tColorRGBA *pixel)
+{
+	Uint32 value;
+	memcpy(&value, pixel, sizeof(value));
+	return value;
+}
+
 /*!
 \brief Returns colorkey info for a surface
 */
@@ -103,75 +213,121 @@ Assumes dst surface was allocated with the correct dimensions.
 
 \return 0 for success or -1 for error.
 */
-int _shrinkSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int factorx, int factory)
-{
-	int x, y, dx, dy, dgap, ra, ga, ba, aa;
-	int n_average;
-	tColorRGBA *sp, *osp, *oosp;
-	tColorRGBA *dp;
-
-	/*
-	* Averaging integer shrink
-	*/
+/*!
+\brief Everything a band of rows of the 32 bit shrinker needs.
+*/
+typedef struct tShrinkJob {
+	SDL_Surface *src;
+	SDL_Surface *dst;
+	int factorx;
+	int factory;
+} tShrinkJob;
 
-	/* Precalculate division factor */
-	n_average = factorx*factory;
+/*!
+\brief Adds up each channel of a factorx by factory box of source pixels.
+*/
+static void _sumBoxRGBA(const tColorRGBA *boxsp, int pitch, int factorx, int factory, int sum[4])
+{
+	int dx, dy;
+	const tColorRGBA *sp;
+
+	sum[0] = sum[1] = sum[2] = sum[3] = 0;
+	for (dy = 0; dy < factory; dy++) {
+		sp = (const tColorRGBA *) ((const Uint8 *) boxsp + pitch * dy);
+		for (dx = 0; dx < factorx; dx++) {
+			sum[0] += sp[dx].r;
+			sum[1] += sp[dx].g;
+			sum[2] += sp[dx].b;
+			sum[3] += sp[dx].a;
+		}
+	}
+}
 
-	/*
-	* Scan destination
-	*/
-	sp = (tColorRGBA *) src->pixels;
-	
-	dp = (tColorRGBA *) dst->pixels;
-	dgap = dst->pitch - dst->w * 4;
+#ifdef ROTOZOOM_SSE2
+/*!
+\brief _sumBoxRGBA, four pixels at a time.
+*/
+static void _sumBoxRGBASSE2(const tColorRGBA *boxsp, int pitch, int factorx, int factory, int sum[4])
+{
+	int dx, dy;
+	const tColorRGBA *sp;
+	__m128i zero, acc, pixels, lo, hi;
+
+	zero = _mm_setzero_si128();
+	acc = zero;
+	for (dy = 0; dy < factory; dy++) {
+		sp = (const tColorRGBA *) ((const Uint8 *) boxsp + pitch * dy);
+		dx = 0;
+		/* widened to 32 bits a channel so big boxes can't overflow */
+		for (; dx + 3 < factorx; dx += 4) {
+			pixels = _mm_loadu_si128((const __m128i *) (sp + dx));
+			lo = _mm_unpacklo_epi8(pixels, zero);
+			hi = _mm_unpackhi_epi8(pixels, zero);
+			acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(lo, zero));
+			acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(lo, zero));
+			acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(hi, zero));
+			acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(hi, zero));
+		}
+		for (; dx < factorx; dx++) {
+			pixels = _mm_cvtsi32_si128((int) _loadPixel(sp + dx));
+			acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(_mm_unpacklo_epi8(pixels, zero), zero));
+		}
+	}
+	_mm_storeu_si128((__m128i *) sum, acc);
+}
+#endif
 
-	for (y = 0; y < dst->h; y++) {
+/*!
+\brief Shrinks the destination rows firstrow to endrow.
+*/
+static void _shrinkRowsRGBA(void *data, int firstrow, int endrow)
+{
+	tShrinkJob *job = (tShrinkJob *) data;
+	int x, y, n_average;
+	int sum[4];
+	const tColorRGBA *boxsp;
+	tColorRGBA *dp;
 
-		osp=sp;
-		for (x = 0; x < dst->w; x++) {
+	/* Precalculate division factor */
+	n_average = job->factorx * job->factory;
 
+	for (y = firstrow; y < endrow; y++) {
+		dp = (tColorRGBA *) ((Uint8 *) job->dst->pixels + job->dst->pitch * y);
+		boxsp = (const tColorRGBA *) ((Uint8 *) job->src->pixels + job->src->pitch * job->factory * y);
+		for (x = 0; x < job->dst->w; x++) {
 			/* Trace out source box and accumulate */
-			oosp=sp;
-			ra=ga=ba=aa=0;
-			for (dy=0; dy < factory; dy++) {
-				for (dx=0; dx < factorx; dx++) {
-					ra += sp->r;
-					ga += sp->g;
-					ba += sp->b;
-					aa += sp->a;
-
-					sp++;
-				} 
-				/* src dx loop */
-				sp = (tColorRGBA *)((Uint8*)sp + (src->pitch - 4*factorx)); // next y
-			}
-			/* src dy loop */
-
-			/* next box-x */
-			sp = (tColorRGBA *)((Uint8*)oosp + 4*factorx);
+#ifdef ROTOZOOM_SSE2
+			if (_useSIMD) {
+				_sumBoxRGBASSE2(boxsp, job->src->pitch, job->factorx, job->factory, sum);
+			} else
+#endif
+			_sumBoxRGBA(boxsp, job->src->pitch, job->factorx, job->factory, sum);
 
 			/* Store result in destination */
-			dp->r = ra/n_average;
-			dp->g = ga/n_average;
-			dp->b = ba/n_average;
-			dp->a = aa/n_average;
+			dp->r = sum[0] / n_average;
+			dp->g = sum[1] / n_average;
+			dp->b = sum[2] / n_average;
+			dp->a = sum[3] / n_average;
 
-			/*
-			* Advance destination pointer 
-			*/
+			/* next box-x */
+			boxsp += job->factorx;
 			dp++;
-		} 
-		/* dst x loop */
+		}
+	}
+}
 
-		/* next box-y */
-		sp = (tColorRGBA *)((Uint8*)osp + src->pitch*factory);
+int _shrinkSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int factorx, int factory)
+{
+	tShrinkJob job;
 
-		/*
-		* Advance destination pointers 
-		*/
-		dp = (tColorRGBA *) ((Uint8 *) dp + dgap);
-	} 
-	/* dst y loop */
+	/*
+	* Averaging integer shrink, rows of destination boxes split across threads
+	*/
+	job.src = src;
+	job.dst = dst;
+	job.factorx = factorx;
+	job.factory = factory;
+	_forEachRowBand(dst->w * factorx * factory, dst->h, _shrinkRowsRGBA, &job);
 
 	return (0);
 }
@@ -274,12 +430,155 @@ Assumes dst surface was allocated with the correct dimensions.
 
 \return 0 for success or -1 for error.
 */
+/*!
+\brief Everything a band of rows of the 32 bit zoomer needs.
+*/
+typedef struct tZoomJob {
+	SDL_Surface *src;
+	SDL_Surface *dst;
+	const int *sax;
+	const int *say;
+	int flipx;
+	int flipy;
+	int smooth;
+} tZoomJob;
+
+/*!
+\brief Bilinearly interpolates between 4 pixels, with 16 bit fractions ex and ey.
+*/
+static void _interpolateRGBA(const tColorRGBA *c00, const tColorRGBA *c01, const tColorRGBA *c10, const tColorRGBA *c11,
+	int ex, int ey, tColorRGBA *dp)
+{
+	int t1, t2;
+	t1 = ((((c01->r - c00->r) * ex) >> 16) + c00->r) & 0xff;
+	t2 = ((((c11->r - c10->r) * ex) >> 16) + c10->r) & 0xff;
+	dp->r = (((t2 - t1) * ey) >> 16) + t1;
+	t1 = ((((c01->g - c00->g) * ex) >> 16) + c00->g) & 0xff;
+	t2 = ((((c11->g - c10->g) * ex) >> 16) + c10->g) & 0xff;
+	dp->g = (((t2 - t1) * ey) >> 16) + t1;
+	t1 = ((((c01->b - c00->b) * ex) >> 16) + c00->b) & 0xff;
+	t2 = ((((c11->b - c10->b) * ex) >> 16) + c10->b) & 0xff;
+	dp->b = (((t2 - t1) * ey) >> 16) + t1;
+	t1 = ((((c01->a - c00->a) * ex) >> 16) + c00->a) & 0xff;
+	t2 = ((((c11->a - c10->a) * ex) >> 16) + c10->a) & 0xff;
+	dp->a = (((t2 - t1) * ey) >> 16) + t1;
+}
+
+#ifdef ROTOZOOM_SSE2
+/*!
+\brief Interpolates 16 bit lanes from a to b by the unsigned 16 bit fractions in w, the same as _interpolateRGBA.
+
+(b - a) * w >> 16 is worked out as the difference of the full 32 bit products b * w and a * w, so no bit of
+the fractions is lost and it rounds down like the arithmetic shift does. a and b must be from 0 to 255.
+*/
+static __m128i _lerpEpi16(__m128i a, __m128i b, __m128i w)
+{
+	__m128i sign, lowa, lowb, borrow;
+
+	sign = _mm_set1_epi16((short) 0x8000);
+	lowa = _mm_mullo_epi16(a, w);
+	lowb = _mm_mullo_epi16(b, w);
+	/* -1 where the low halves borrow from the high ones, compared unsigned */
+	borrow = _mm_cmplt_epi16(_mm_xor_si128(lowb, sign), _mm_xor_si128(lowa, sign));
+	return _mm_add_epi16(_mm_add_epi16(a, _mm_sub_epi16(_mm_mulhi_epu16(b, w), _mm_mulhi_epu16(a, w))), borrow);
+}
+#endif
+
+/*!
+\brief Zooms the destination rows firstrow to endrow.
+*/
+static void _zoomRowsRGBA(void *data, int firstrow, int endrow)
+{
+	tZoomJob *job = (tZoomJob *) data;
+	SDL_Surface *src = job->src;
+	SDL_Surface *dst = job->dst;
+	int x, y, sx, sy, ex, ey, spixelw, spixelh, spixelgap, stepx, stepy;
+	const tColorRGBA *srow, *c00, *c01, *c10, *c11;
+	tColorRGBA *dp;
+#ifdef ROTOZOOM_SSE2
+	int ex1;
+	const tColorRGBA *d00, *d01, *d10, *d11;
+	__m128i zero, wx, wy, a, b, c, d, top, bottom;
+#endif
+
+	spixelw = (src->w - 1);
+	spixelh = (src->h - 1);
+	spixelgap = src->pitch / 4;
+	/* next pixel over and down in the source, going backwards when flipped */
+	stepx = job->flipx ? -1 : 1;
+	stepy = job->flipy ? -spixelgap : spixelgap;
+
+	for (y = firstrow; y < endrow; y++) {
+		dp = (tColorRGBA *) ((Uint8 *) dst->pixels + dst->pitch * y);
+		sy = job->say[y] >> 16;
+		srow = (const tColorRGBA *) src->pixels + spixelgap * (job->flipy ? spixelh - sy : sy);
+		if (!job->smooth) {
+			/*
+			* Non-Interpolating Zoom 
+			*/
+			for (x = 0; x < dst->w; x++) {
+				sx = job->sax[x] >> 16;
+				dp[x] = srow[job->flipx ? spixelw - sx : sx];
+			}
+			continue;
+		}
+
+		/*
+		* Interpolating Zoom 
+		*/
+		ey = job->say[y] & 0xffff;
+		/* the last row and column have nothing past them to blend with */
+		if (sy >= spixelh) stepy = 0;
+		x = 0;
+#ifdef ROTOZOOM_SSE2
+		/*
+		* Two pixels at a time, 4 channels each in 16 bit lanes, with the same rounding as _interpolateRGBA
+		*/
+		zero = _mm_setzero_si128();
+		wy = _mm_set1_epi16((short) ey);
+		for (; _useSIMD && x + 1 < dst->w; x += 2) {
+			sx = job->sax[x] >> 16;
+			ex = job->sax[x] & 0xffff;
+			c00 = srow + (job->flipx ? spixelw - sx : sx);
+			c01 = (sx < spixelw) ? c00 + stepx : c00;
+			c10 = c00 + stepy;
+			c11 = c01 + stepy;
+			sx = job->sax[x + 1] >> 16;
+			ex1 = job->sax[x + 1] & 0xffff;
+			d00 = srow + (job->flipx ? spixelw - sx : sx);
+			d01 = (sx < spixelw) ? d00 + stepx : d00;
+			d10 = d00 + stepy;
+			d11 = d01 + stepy;
+
+			a = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128((int) _loadPixel(c00)), _mm_cvtsi32_si128((int) _loadPixel(d00))), zero);
+			b = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128((int) _loadPixel(c01)), _mm_cvtsi32_si128((int) _loadPixel(d01))), zero);
+			c = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128((int) _loadPixel(c10)), _mm_cvtsi32_si128((int) _loadPixel(d10))), zero);
+			d = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128((int) _loadPixel(c11)), _mm_cvtsi32_si128((int) _loadPixel(d11))), zero);
+			wx = _mm_set_epi16((short) ex1, (short) ex1, (short) ex1, (short) ex1, (short) ex, (short) ex, (short) ex, (short) ex);
+
+			top = _lerpEpi16(a, b, wx);
+			bottom = _lerpEpi16(c, d, wx);
+			top = _lerpEpi16(top, bottom, wy);
+			_mm_storel_epi64((__m128i *) (dp + x), _mm_packus_epi16(top, top));
+		}
+#endif
+		for (; x < dst->w; x++) {
+			sx = job->sax[x] >> 16;
+			ex = job->sax[x] & 0xffff;
+			c00 = srow + (job->flipx ? spixelw - sx : sx);
+			c01 = (sx < spixelw) ? c00 + stepx : c00;
+			c10 = c00 + stepy;
+			c11 = c01 + stepy;
+			_interpolateRGBA(c00, c01, c10, c11, ex, ey, dp + x);
+		}
+		stepy = job->flipy ? -spixelgap : spixelgap;
+	}
+}
+
 int _zoomSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy, int smooth)
 {
-	int x, y, sx, sy, ssx, ssy, *sax, *say, *csax, *csay, *salast, csx, csy, ex, ey, cx, cy, sstep, sstepx, sstepy;
-	tColorRGBA *c00, *c01, *c10, *c11;
-	tColorRGBA *sp, *csp, *dp;
-	int spixelgap, spixelw, spixelh, dgap, t1, t2;
+	int x, y, sx, sy, ssx, ssy, *sax, *say, *csax, *csay, csx, csy, spixelw, spixelh;
+	tZoomJob job;
 
 	/*
 	* Allocate memory for row/column increments 
@@ -337,151 +636,17 @@ int _zoomSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy,
 		}
 	}
 
-	sp = (tColorRGBA *) src->pixels;
-	dp = (tColorRGBA *) dst->pixels;
-	dgap = dst->pitch - dst->w * 4;
-	spixelgap = src->pitch/4;
-
-	if (flipx) sp += spixelw;
-	if (flipy) sp += (spixelgap * spixelh);
-
 	/*
-	* Switch between interpolating and non-interpolating code 
+	* Every destination row only depends on its own source rows, so they're split across threads
 	*/
-	if (smooth) {
-
-		/*
-		* Interpolating Zoom 
-		*/
-		csay = say;
-		for (y = 0; y < dst->h; y++) {
-			csp = sp;
-			csax = sax;
-			for (x = 0; x < dst->w; x++) {
-				/*
-				* Setup color source pointers 
-				*/
-				ex = (*csax & 0xffff);
-				ey = (*csay & 0xffff);
-				cx = (*csax >> 16);
-				cy = (*csay >> 16);
-				sstepx = cx < spixelw;
-				sstepy = cy < spixelh;
-				c00 = sp;
-				c01 = sp;
-				c10 = sp;
-				if (sstepy) {
-					if (flipy) {
-						c10 -= spixelgap;
-					} else {
-						c10 += spixelgap;
-					}
-				}
-				c11 = c10;
-				if (sstepx) {
-					if (flipx) {
-						c01--;
-						c11--;
-					} else {
-						c01++;
-						c11++;
-					}
-				}
-
-				/*
-				* Draw and interpolate colors 
-				*/
-				t1 = ((((c01->r - c00->r) * ex) >> 16) + c00->r) & 0xff;
-				t2 = ((((c11->r - c10->r) * ex) >> 16) + c10->r) & 0xff;
-				dp->r = (((t2 - t1) * ey) >> 16) + t1;
-				t1 = ((((c01->g - c00->g) * ex) >> 16) + c00->g) & 0xff;
-				t2 = ((((c11->g - c10->g) * ex) >> 16) + c10->g) & 0xff;
-				dp->g = (((t2 - t1) * ey) >> 16) + t1;
-				t1 = ((((c01->b - c00->b) * ex) >> 16) + c00->b) & 0xff;
-				t2 = ((((c11->b - c10->b) * ex) >> 16) + c10->b) & 0xff;
-				dp->b = (((t2 - t1) * ey) >> 16) + t1;
-				t1 = ((((c01->a - c00->a) * ex) >> 16) + c00->a) & 0xff;
-				t2 = ((((c11->a - c10->a) * ex) >> 16) + c10->a) & 0xff;
-				dp->a = (((t2 - t1) * ey) >> 16) + t1;				
-				/*
-				* Advance source pointer x
-				*/
-				salast = csax;
-				csax++;				
-				sstep = (*csax >> 16) - (*salast >> 16);
-				if (flipx) {
-					sp -= sstep;
-				} else {
-					sp += sstep;
-				}
-
-				/*
-				* Advance destination pointer x
-				*/
-				dp++;
-			}
-			/*
-			* Advance source pointer y
-			*/
-			salast = csay;
-			csay++;
-			sstep = (*csay >> 16) - (*salast >> 16);
-			sstep *= spixelgap;
-			if (flipy) { 
-				sp = csp - sstep;
-			} else {
-				sp = csp + sstep;
-			}
-
-			/*
-			* Advance destination pointer y
-			*/
-			dp = (tColorRGBA *) ((Uint8 *) dp + dgap);
-		}
-	} else {
-		/*
-		* Non-Interpolating Zoom 
-		*/		
-		csay = say;
-		for (y = 0; y < dst->h; y++) {
-			csp = sp;
-			csax = sax;
-			for (x = 0; x < dst->w; x++) {
-				/*
-				* Draw 
-				*/
-				*dp = *sp;
-
-				/*
-				* Advance source pointer x
-				*/
-				salast = csax;
-				csax++;				
-				sstep = (*csax >> 16) - (*salast >> 16);
-				if (flipx) sstep = -sstep;
-				sp += sstep;
-
-				/*
-				* Advance destination pointer x
-				*/
-				dp++;
-			}
-			/*
-			* Advance source pointer y
-			*/
-			salast = csay;
-			csay++;
-			sstep = (*csay >> 16) - (*salast >> 16);
-			sstep *= spixelgap;
-			if (flipy) sstep = -sstep;			
-			sp = csp + sstep;
-
-			/*
-			* Advance destination pointer y
-			*/
-			dp = (tColorRGBA *) ((Uint8 *) dp + dgap);
-		}
-	}
+	job.src = src;
+	job.dst = dst;
+	job.sax = sax;
+	job.say = say;
+	job.flipx = flipx;
+	job.flipy = flipy;
+	job.smooth = smooth;
+	_forEachRowBand(dst->w, dst->h, _zoomRowsRGBA, &job);
 
 	/*
 	* Remove temp arrays 
@@ -592,199 +757,967 @@ int _zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy)
 		csp += ((*csay) * src->pitch);
 		csay++;
 
-		/*
-		* Advance destination pointers 
-		*/
-		dp += dgap;
+		/*
+		* Advance destination pointers 
+		*/
+		dp += dgap;
+	}
+
+	/*
+	* Remove temp arrays 
+	*/
+	free(sax);
+	free(say);
+
+	return (0);
+}
+
+/*!
+\brief Everything a band of rows of the 32 bit transformer needs.
+*/
+typedef struct tTransformJob {
+	const tColorRGBA *src;
+	int sw;
+	int sh;
+	int spitch;
+	tColorRGBA *dst;
+	int dw;
+	int dpitch;
+	int ox;
+	int oy;
+	int ux;
+	int uy;
+	int vx;
+	int vy;
+	int flipx;
+	int flipy;
+	int smooth;
+} tTransformJob;
+
+/*!
+\brief Transforms the destination rows firstrow to endrow.
+*/
+static void _transformRowsRGBA(void *data, int firstrow, int endrow)
+{
+	const tTransformJob *job = (const tTransformJob *) data;
+	const tColorRGBA *src = job->src;
+	tColorRGBA *dst = job->dst;
+	int sw = job->sw, sh = job->sh, dw = job->dw, dpitch = job->dpitch;
+	int ox = job->ox, oy = job->oy, ux = job->ux, uy = job->uy, vx = job->vx, vy = job->vy;
+	int flipx = job->flipx, flipy = job->flipy;
+	int x, y, t1, t2, dx, dy, sdx, sdy, ex, ey, spixelgap;
+	tColorRGBA c00, c01, c10, c11, cswap;
+	const tColorRGBA *sp;
+	tColorRGBA *pc;
+
+	spixelgap = job->spitch / 4;
+
+	/*
+	* Switch between interpolating and non-interpolating code 
+	*/
+	if (job->smooth) {
+		for (y = firstrow; y < endrow; y++) {
+			pc = (tColorRGBA *) ((Uint8 *) dst + dpitch * y);
+			sdx = ox + vx * y;
+			sdy = oy + vy * y;
+			for (x = 0; x < dw; x++) {
+				dx = (sdx >> 16);
+				dy = (sdy >> 16);
+				if (flipx) dx = (sw - 1) - dx;
+				if (flipy) dy = (sh - 1) - dy;
+				if ((dx > -1) && (dy > -1) && (dx < (sw-1)) && (dy < (sh-1))) {
+					sp = src + spixelgap * dy + dx;
+					c00 = sp[0];
+					c01 = sp[1];
+					c10 = sp[spixelgap];
+					c11 = sp[spixelgap + 1];
+					if (flipx) {
+						cswap = c00; c00=c01; c01=cswap;
+						cswap = c10; c10=c11; c11=cswap;
+					}
+					if (flipy) {
+						cswap = c00; c00=c10; c10=cswap;
+						cswap = c01; c01=c11; c11=cswap;
+					}
+					/*
+					* Interpolate colors 
+					*/
+					ex = (sdx & 0xffff);
+					ey = (sdy & 0xffff);
+					t1 = ((((c01.r - c00.r) * ex) >> 16) + c00.r) & 0xff;
+					t2 = ((((c11.r - c10.r) * ex) >> 16) + c10.r) & 0xff;
+					pc->r = (((t2 - t1) * ey) >> 16) + t1;
+					t1 = ((((c01.g - c00.g) * ex) >> 16) + c00.g) & 0xff;
+					t2 = ((((c11.g - c10.g) * ex) >> 16) + c10.g) & 0xff;
+					pc->g = (((t2 - t1) * ey) >> 16) + t1;
+					t1 = ((((c01.b - c00.b) * ex) >> 16) + c00.b) & 0xff;
+					t2 = ((((c11.b - c10.b) * ex) >> 16) + c10.b) & 0xff;
+					pc->b = (((t2 - t1) * ey) >> 16) + t1;
+					t1 = ((((c01.a - c00.a) * ex) >> 16) + c00.a) & 0xff;
+					t2 = ((((c11.a - c10.a) * ex) >> 16) + c10.a) & 0xff;
+					pc->a = (((t2 - t1) * ey) >> 16) + t1;
+				}
+				sdx += ux;
+				sdy += uy;
+				pc++;
+			}
+		}
+	} else {
+		for (y = firstrow; y < endrow; y++) {
+			pc = (tColorRGBA *) ((Uint8 *) dst + dpitch * y);
+			sdx = ox + vx * y;
+			sdy = oy + vy * y;
+			for (x = 0; x < dw; x++) {
+				dx = (short) (sdx >> 16);
+				dy = (short) (sdy >> 16);
+				if (flipx) dx = (sw-1)-dx;
+				if (flipy) dy = (sh-1)-dy;
+				if ((dx >= 0) && (dy >= 0) && (dx < sw) && (dy < sh)) {
+					*pc = src[spixelgap * dy + dx];
+				}
+				sdx += ux;
+				sdy += uy;
+				pc++;
+			}
+		}
+	}
+}
+
+/*!
+\brief Internal 32 bit affine transformer working directly on pixel memory.
+
+Scans the destination pixels and maps each one back into the source with a general
+affine transform, so any combination of rotation, zoom, shear and flipping can be done.
+The source position of destination pixel (x, y), in 16.16 fixed point, is
+(ox + x * ux + y * vx, oy + x * uy + y * vy).
+Destination pixels that map outside of the source are left untouched.
+With anti-aliasing, source positions are taken relative to the top left source pixel's
+center, and pixels on the last source row or column are never sampled.
+
+\param src Source pixels, 32 bit RGBA/ABGR.
+\param sw Source width in pixels.
+\param sh Source height in pixels.
+\param spitch Length of a source row in bytes.
+\param dst Destination pixels, in the same format.
+\param dw Destination width in pixels.
+\param dh Destination height in pixels.
+\param dpitch Length of a destination row in bytes.
+\param ox Source x of the top left destination pixel.
+\param oy Source y of the top left destination pixel.
+\param ux Source x step per destination column.
+\param uy Source y step per destination column.
+\param vx Source x step per destination row.
+\param vy Source y step per destination row.
+\param flipx Flag indicating horizontal mirroring should be applied.
+\param flipy Flag indicating vertical mirroring should be applied.
+\param smooth Flag indicating anti-aliasing should be used.
+*/
+void _transformPixelsRGBA(const tColorRGBA * src, int sw, int sh, int spitch, tColorRGBA * dst, int dw, int dh, int dpitch,
+	int ox, int oy, int ux, int uy, int vx, int vy, int flipx, int flipy, int smooth)
+{
+	tTransformJob job;
+
+	/*
+	* Every destination row is mapped on its own, so they're split across threads
+	*/
+	job.src = src;
+	job.sw = sw;
+	job.sh = sh;
+	job.spitch = spitch;
+	job.dst = dst;
+	job.dw = dw;
+	job.dpitch = dpitch;
+	job.ox = ox;
+	job.oy = oy;
+	job.ux = ux;
+	job.uy = uy;
+	job.vx = vx;
+	job.vy = vy;
+	job.flipx = flipx;
+	job.flipy = flipy;
+	job.smooth = smooth;
+	_forEachRowBand(dw, dh, _transformRowsRGBA, &job);
+}
+
+/*! 
+\brief Internal 32 bit rotozoomer with optional anti-aliasing.
+
+Rotates and zooms 32 bit RGBA/ABGR 'src' surface to 'dst' surface based on the control 
+parameters by scanning the destination surface and applying optionally anti-aliasing
+by bilinear interpolation.
+Assumes src and dst surfaces are of 32 bit depth.
+Assumes dst surface was allocated with the correct dimensions.
+
+\param src Source surface.
+\param dst Destination surface.
+\param cx Horizontal center coordinate.
+\param cy Vertical center coordinate.
+\param isin Integer version of sine of angle.
+\param icos Integer version of cosine of angle.
+\param flipx Flag indicating horizontal mirroring should be applied.
+\param flipy Flag indicating vertical mirroring should be applied.
+\param smooth Flag indicating anti-aliasing should be used.
+*/
+void _transformSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int cx, int cy, int isin, int icos, int flipx, int flipy, int smooth)
+{
+	int xd, yd, ax, ay;
+
+	/*
+	* Variable setup 
+	*/
+	xd = ((src->w - dst->w) << 15);
+	yd = ((src->h - dst->h) << 15);
+	ax = (cx << 16) - (icos * cx);
+	ay = (cy << 16) - (isin * cx);
+
+	/*
+	* Rotation about (cx, cy): each row starts isin further left and icos further down in the source
+	*/
+	_transformPixelsRGBA((const tColorRGBA *) src->pixels, src->w, src->h, src->pitch,
+		(tColorRGBA *) dst->pixels, dst->w, dst->h, dst->pitch,
+		ax + (isin * cy) + xd, ay - (icos * cy) + yd, icos, isin, -isin, icos,
+		flipx, flipy, smooth);
+}
+
+/*!
+
+\brief Rotates and zooms 8 bit palette/Y 'src' surface to 'dst' surface without smoothing.
+
+Rotates and zooms 8 bit RGBA/ABGR 'src' surface to 'dst' surface based on the control 
+parameters by scanning the destination surface.
+Assumes src and dst surfaces are of 8 bit depth.
+Assumes dst surface was allocated with the correct dimensions.
+
+\param src Source surface.
+\param dst Destination surface.
+\param cx Horizontal center coordinate.
+\param cy Vertical center coordinate.
+\param isin Integer version of sine of angle.
+\param icos Integer version of cosine of angle.
+\param flipx Flag indicating horizontal mirroring should be applied.
+\param flipy Flag indicating vertical mirroring should be applied.
+*/
+void transformSurfaceY(SDL_Surface * src, SDL_Surface * dst, int cx, int cy, int isin, int icos, int flipx, int flipy)
+{
+	int x, y, dx, dy, xd, yd, sdx, sdy, ax, ay;
+	tColorY *pc, *sp;
+	int gap;
+
+	/*
+	* Variable setup 
+	*/
+	xd = ((src->w - dst->w) << 15);
+	yd = ((src->h - dst->h) << 15);
+	ax = (cx << 16) - (icos * cx);
+	ay = (cy << 16) - (isin * cx);
+	pc = (tColorY*) dst->pixels;
+	gap = dst->pitch - dst->w;
+	/*
+	* Clear surface to colorkey 
+	*/ 	
+	memset(pc, (int)(_colorkey(src) & 0xff), dst->pitch * dst->h);
+	/*
+	* Iterate through destination surface 
+	*/
+	for (y = 0; y < dst->h; y++) {
+		dy = cy - y;
+		sdx = (ax + (isin * dy)) + xd;
+		sdy = (ay - (icos * dy)) + yd;
+		for (x = 0; x < dst->w; x++) {
+			dx = (short) (sdx >> 16);
+			dy = (short) (sdy >> 16);
+			if (flipx) dx = (src->w-1)-dx;
+			if (flipy) dy = (src->h-1)-dy;
+			if ((dx >= 0) && (dy >= 0) && (dx < src->w) && (dy < src->h)) {
+				sp = (tColorY *) (src->pixels);
+				sp += (src->pitch * dy + dx);
+				*pc = *sp;
+			}
+			sdx += icos;
+			sdy += isin;
+			pc++;
+		}
+		pc += gap;
+	}
+}
+
+/* ---- Pixel art scaling */
+
+/*!
+\brief Pixels of the source's edges repeated around it for the pixel art scalers, enough for the xBR neighbourhood.
+*/
+#define PIXELART_PADDING 2
+
+/*!
+\brief Weighted YUVA distance under which xBR treats two colors as the same (xBR's usual threshold of 15 for 0 to 1 colors).
+*/
+#define XBR_EQUAL_DISTANCE (15 * 255)
+
+/*!
+\brief Samples per side of an output pixel used to work out how much of it an xBR edge covers.
+*/
+#define XBR_SUBSAMPLES 16
+
+/*!
+\brief The kinds of edge xBR can find at a corner of a source pixel.
+*/
+#define XBR_EDGE_NONE		0
+#define XBR_EDGE_WEAK		1	/* not sure it's an edge, blends half of the output pixel in the corner */
+#define XBR_EDGE_DIAGONAL	2	/* 45 degree edge across the corner */
+#define XBR_EDGE_SHALLOW	3	/* edge rising 1 for every 2 along, running out along the bottom */
+#define XBR_EDGE_STEEP		4	/* edge rising 2 for every 1 along, running up the side */
+#define XBR_EDGE_BOTH		5	/* shallow and steep together */
+#define XBR_EDGE_TYPES		6
+
+/*!
+\brief The neighbours xBR looks at for the bottom right corner of pixel E, turned for the other corners.
+<pre>
+   A  B  C
+   D  E  F  F4
+   G  H  I  I4
+      H5 I5
+</pre>
+*/
+#define XBR_E	0
+#define XBR_B	1
+#define XBR_C	2
+#define XBR_D	3
+#define XBR_F	4
+#define XBR_G	5
+#define XBR_H	6
+#define XBR_I	7
+#define XBR_F4	8
+#define XBR_I4	9
+#define XBR_H5	10
+#define XBR_I5	11
+#define XBR_NEIGHBOURS	12
+
+static const int _xbrNeighbourX[XBR_NEIGHBOURS] = {0, 0, 1, -1, 1, -1, 0, 1, 2, 2, 0, 1};
+static const int _xbrNeighbourY[XBR_NEIGHBOURS] = {0, -1, -1, 0, 0, 1, 1, 1, 0, 1, 2, 2};
+
+/*!
+\brief A 32 bit image with its edge pixels repeated PIXELART_PADDING times around it.
+Fully transparent pixels are all made 0, so they compare as the same color.
+*/
+typedef struct tPaddedPixels {
+	Uint32 *pixels;
+	Uint32 *origin;
+	int w;
+	int h;
+	int pitch;
+} tPaddedPixels;
+
+/*!
+\brief Everything a band of rows of a pixel art scaler needs.
+*/
+typedef struct tPixelArtJob {
+	const tPaddedPixels *src;
+	Uint32 *dst;
+	int dpitch;
+	int factor;
+	const Uint32 *yuv;
+	const Uint16 *weights;
+	int offsets[4][XBR_NEIGHBOURS];
+} tPixelArtJob;
+
+/*!
+\brief Copies 32 bit pixels into a new padded image.
+
+\param src Source pixels.
+\param w Source width in pixels.
+\param h Source height in pixels.
+\param spitch Length of a source row in bytes.
+\param padded Set to the padded image, to be freed with free(padded->pixels).
+
+\return 0 on success, -1 if it couldn't be allocated.
+*/
+static int _padPixelArt(const void *src, int w, int h, int spitch, tPaddedPixels *padded)
+{
+	int x, y;
+	const tColorRGBA *sp;
+	Uint32 *dp;
+
+	padded->pitch = w + PIXELART_PADDING * 2;
+	padded->pixels = (Uint32 *) malloc(sizeof(Uint32) * padded->pitch * (h + PIXELART_PADDING * 2));
+	if (padded->pixels == NULL) {
+		return (-1);
+	}
+	padded->origin = padded->pixels + padded->pitch * PIXELART_PADDING + PIXELART_PADDING;
+	padded->w = w;
+	padded->h = h;
+
+	for (y = 0; y < h; y++) {
+		sp = (const tColorRGBA *) ((const Uint8 *) src + spitch * y);
+		dp = padded->origin + padded->pitch * y;
+		for (x = 0; x < w; x++) {
+			dp[x] = (sp[x].a == 0) ? 0 : _loadPixel(sp + x);
+		}
+		for (x = 1; x <= PIXELART_PADDING; x++) {
+			dp[-x] = dp[0];
+			dp[w - 1 + x] = dp[w - 1];
+		}
+	}
+	for (y = 1; y <= PIXELART_PADDING; y++) {
+		memcpy(padded->origin - padded->pitch * y - PIXELART_PADDING, padded->origin - PIXELART_PADDING,
+			sizeof(Uint32) * padded->pitch);
+		memcpy(padded->origin + padded->pitch * (h - 1 + y) - PIXELART_PADDING, padded->origin + padded->pitch * (h - 1) - PIXELART_PADDING,
+			sizeof(Uint32) * padded->pitch);
+	}
+	return (0);
+}
+
+#ifdef ROTOZOOM_SSE2
+/*!
+\brief Picks a where mask is set and b everywhere else.
+*/
+static __m128i _selectPixels(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/*!
+\brief Stores the 4 pixels of p, q and r interleaved, p0 q0 r0 p1 q1 r1 and so on, as 12 pixels.
+*/
+static void _storeInterleaved3(Uint32 *dst, __m128i p, __m128i q, __m128i r)
+{
+	__m128i pq, qr, rp;
+
+	pq = _mm_unpacklo_epi32(p, q);
+	qr = _mm_unpacklo_epi32(q, r);
+	rp = _mm_unpacklo_epi32(r, _mm_srli_si128(p, 4));
+	/* p0 q0 r0 p1, q1 r1 p2 q2, r2 p3 q3 r3 */
+	_mm_storeu_si128((__m128i *) dst, _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(pq), _mm_castsi128_ps(rp), _MM_SHUFFLE(1, 0, 1, 0))));
+	pq = _mm_unpackhi_epi32(p, q);
+	_mm_storeu_si128((__m128i *) (dst + 4), _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(qr), _mm_castsi128_ps(pq), _MM_SHUFFLE(1, 0, 3, 2))));
+	qr = _mm_unpackhi_epi32(q, r);
+	rp = _mm_unpackhi_epi32(r, _mm_srli_si128(p, 4));
+	_mm_storeu_si128((__m128i *) (dst + 8), _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(rp), _mm_castsi128_ps(qr), _MM_SHUFFLE(3, 2, 1, 0))));
+}
+#endif
+
+/*!
+\brief Scale2x (EPX) on the source rows firstrow to endrow.
+
+Each pixel E becomes 4, which take the color of a neighbour when two neighbours
+next to that corner match each other and not the other two:
+<pre>
+   B        E0 E1
+ D E F  ->  E2 E3
+   H
+</pre>
+*/
+static void _scale2xRows(void *data, int firstrow, int endrow)
+{
+	tPixelArtJob *job = (tPixelArtJob *) data;
+	const tPaddedPixels *src = job->src;
+	int x, y;
+	Uint32 b, d, e, f, h;
+	const Uint32 *up, *mid, *down;
+	Uint32 *dst0, *dst1;
+#ifdef ROTOZOOM_SSE2
+	__m128i vb, vd, ve, vf, vh, bd, bf, dh, hf, e0, e1, e2, e3;
+#endif
+
+	for (y = firstrow; y < endrow; y++) {
+		mid = src->origin + src->pitch * y;
+		up = mid - src->pitch;
+		down = mid + src->pitch;
+		dst0 = job->dst + job->dpitch * y * 2;
+		dst1 = dst0 + job->dpitch;
+		x = 0;
+#ifdef ROTOZOOM_SSE2
+		/* four source pixels at a time, the same rules as below as compare masks */
+		for (; _useSIMD && x + 3 < src->w; x += 4) {
+			vb = _mm_loadu_si128((const __m128i *) (up + x));
+			vd = _mm_loadu_si128((const __m128i *) (mid + x - 1));
+			ve = _mm_loadu_si128((const __m128i *) (mid + x));
+			vf = _mm_loadu_si128((const __m128i *) (mid + x + 1));
+			vh = _mm_loadu_si128((const __m128i *) (down + x));
+			bd = _mm_cmpeq_epi32(vb, vd);
+			bf = _mm_cmpeq_epi32(vb, vf);
+			dh = _mm_cmpeq_epi32(vd, vh);
+			hf = _mm_cmpeq_epi32(vh, vf);
+			e0 = _selectPixels(_mm_andnot_si128(_mm_or_si128(bf, dh), bd), vd, ve);
+			e1 = _selectPixels(_mm_andnot_si128(_mm_or_si128(bd, hf), bf), vf, ve);
+			e2 = _selectPixels(_mm_andnot_si128(_mm_or_si128(bd, hf), dh), vd, ve);
+			e3 = _selectPixels(_mm_andnot_si128(_mm_or_si128(dh, bf), hf), vf, ve);
+			_mm_storeu_si128((__m128i *) (dst0 + x * 2), _mm_unpacklo_epi32(e0, e1));
+			_mm_storeu_si128((__m128i *) (dst0 + x * 2 + 4), _mm_unpackhi_epi32(e0, e1));
+			_mm_storeu_si128((__m128i *) (dst1 + x * 2), _mm_unpacklo_epi32(e2, e3));
+			_mm_storeu_si128((__m128i *) (dst1 + x * 2 + 4), _mm_unpackhi_epi32(e2, e3));
+		}
+#endif
+		for (; x < src->w; x++) {
+			b = up[x];
+			d = mid[x - 1];
+			e = mid[x];
+			f = mid[x + 1];
+			h = down[x];
+			dst0[x * 2] = (d == b && b != f && d != h) ? d : e;
+			dst0[x * 2 + 1] = (b == f && b != d && f != h) ? f : e;
+			dst1[x * 2] = (d == h && d != b && h != f) ? d : e;
+			dst1[x * 2 + 1] = (h == f && d != h && b != f) ? f : e;
+		}
+	}
+}
+
+/*!
+\brief Scale3x on the source rows firstrow to endrow.
+
+Each pixel E becomes 9, using the same matching rules as Scale2x for the corners,
+and the edges also taking a neighbour's color when it would continue a diagonal line:
+<pre>
+ A B C      E0 E1 E2
+ D E F  ->  E3 E4 E5
+ G H I      E6 E7 E8
+</pre>
+*/
+static void _scale3xRows(void *data, int firstrow, int endrow)
+{
+	tPixelArtJob *job = (tPixelArtJob *) data;
+	const tPaddedPixels *src = job->src;
+	int x, y;
+	Uint32 a, b, c, d, e, f, g, h, i;
+	const Uint32 *up, *mid, *down;
+	Uint32 *dst0, *dst1, *dst2;
+#ifdef ROTOZOOM_SSE2
+	__m128i va, vb, vc, vd, ve, vf, vg, vh, vi, same, db, bf, dh, hf, ea, ec, eg, ei;
+#endif
+
+	for (y = firstrow; y < endrow; y++) {
+		mid = src->origin + src->pitch * y;
+		up = mid - src->pitch;
+		down = mid + src->pitch;
+		dst0 = job->dst + job->dpitch * y * 3;
+		dst1 = dst0 + job->dpitch;
+		dst2 = dst1 + job->dpitch;
+		x = 0;
+#ifdef ROTOZOOM_SSE2
+		/* four source pixels at a time, the same rules as below as compare masks */
+		for (; _useSIMD && x + 3 < src->w; x += 4) {
+			va = _mm_loadu_si128((const __m128i *) (up + x - 1));
+			vb = _mm_loadu_si128((const __m128i *) (up + x));
+			vc = _mm_loadu_si128((const __m128i *) (up + x + 1));
+			vd = _mm_loadu_si128((const __m128i *) (mid + x - 1));
+			ve = _mm_loadu_si128((const __m128i *) (mid + x));
+			vf = _mm_loadu_si128((const __m128i *) (mid + x + 1));
+			vg = _mm_loadu_si128((const __m128i *) (down + x - 1));
+			vh = _mm_loadu_si128((const __m128i *) (down + x));
+			vi = _mm_loadu_si128((const __m128i *) (down + x + 1));
+			/* set where every output pixel is just E */
+			same = _mm_or_si128(_mm_cmpeq_epi32(vb, vh), _mm_cmpeq_epi32(vd, vf));
+			db = _mm_andnot_si128(same, _mm_cmpeq_epi32(vd, vb));
+			bf = _mm_andnot_si128(same, _mm_cmpeq_epi32(vb, vf));
+			dh = _mm_andnot_si128(same, _mm_cmpeq_epi32(vd, vh));
+			hf = _mm_andnot_si128(same, _mm_cmpeq_epi32(vh, vf));
+			ea = _mm_cmpeq_epi32(ve, va);
+			ec = _mm_cmpeq_epi32(ve, vc);
+			eg = _mm_cmpeq_epi32(ve, vg);
+			ei = _mm_cmpeq_epi32(ve, vi);
+			_storeInterleaved3(dst0 + x * 3,
+				_selectPixels(db, vd, ve),
+				_selectPixels(_mm_or_si128(_mm_andnot_si128(ec, db), _mm_andnot_si128(ea, bf)), vb, ve),
+				_selectPixels(bf, vf, ve));
+			_storeInterleaved3(dst1 + x * 3,
+				_selectPixels(_mm_or_si128(_mm_andnot_si128(eg, db), _mm_andnot_si128(ea, dh)), vd, ve),
+				ve,
+				_selectPixels(_mm_or_si128(_mm_andnot_si128(ei, bf), _mm_andnot_si128(ec, hf)), vf, ve));
+			_storeInterleaved3(dst2 + x * 3,
+				_selectPixels(dh, vd, ve),
+				_selectPixels(_mm_or_si128(_mm_andnot_si128(ei, dh), _mm_andnot_si128(eg, hf)), vh, ve),
+				_selectPixels(hf, vf, ve));
+		}
+#endif
+		for (; x < src->w; x++) {
+			a = up[x - 1];
+			b = up[x];
+			c = up[x + 1];
+			d = mid[x - 1];
+			e = mid[x];
+			f = mid[x + 1];
+			g = down[x - 1];
+			h = down[x];
+			i = down[x + 1];
+			if (b != h && d != f) {
+				dst0[x * 3] = (d == b) ? d : e;
+				dst0[x * 3 + 1] = ((d == b && e != c) || (b == f && e != a)) ? b : e;
+				dst0[x * 3 + 2] = (b == f) ? f : e;
+				dst1[x * 3] = ((d == b && e != g) || (d == h && e != a)) ? d : e;
+				dst1[x * 3 + 1] = e;
+				dst1[x * 3 + 2] = ((b == f && e != i) || (h == f && e != c)) ? f : e;
+				dst2[x * 3] = (d == h) ? d : e;
+				dst2[x * 3 + 1] = ((d == h && e != i) || (h == f && e != g)) ? h : e;
+				dst2[x * 3 + 2] = (h == f) ? f : e;
+			} else {
+				dst0[x * 3] = dst0[x * 3 + 1] = dst0[x * 3 + 2] = e;
+				dst1[x * 3] = dst1[x * 3 + 1] = dst1[x * 3 + 2] = e;
+				dst2[x * 3] = dst2[x * 3 + 1] = dst2[x * 3 + 2] = e;
+			}
+		}
+	}
+}
+
+/*!
+\brief Converts padded rows firstrow to endrow to YUVA for xBR's color distances, in the r, g, b and a bytes.
+*/
+static void _xbrYUVRows(void *data, int firstrow, int endrow)
+{
+	tPixelArtJob *job = (tPixelArtJob *) data;
+	const tPaddedPixels *src = job->src;
+	int x, y, luma, u, v;
+	const tColorRGBA *sp;
+	tColorRGBA *dp;
+
+	for (y = firstrow; y < endrow; y++) {
+		sp = (const tColorRGBA *) (src->pixels + src->pitch * y);
+		dp = (tColorRGBA *) (job->yuv + src->pitch * y);
+		for (x = 0; x < src->pitch; x++) {
+			luma = (77 * sp[x].r + 150 * sp[x].g + 29 * sp[x].b + 128) >> 8;
+			u = (((sp[x].b - luma) * 144) >> 8) + 128;
+			v = (((sp[x].r - luma) * 183) >> 8) + 128;
+			dp[x].r = luma;
+			dp[x].g = MAX(0, MIN(u, 255));
+			dp[x].b = MAX(0, MIN(v, 255));
+			dp[x].a = sp[x].a;
+		}
+	}
+}
+
+/*!
+\brief Perceptual distance between two YUVA colors, weighted towards brightness and alpha.
+*/
+static int _xbrDistance(const Uint32 *yuv, int a, int b)
+{
+	tColorRGBA ca, cb;
+	memcpy(&ca, yuv + a, sizeof(ca));
+	memcpy(&cb, yuv + b, sizeof(cb));
+	return 48 * abs(ca.r - cb.r) + 7 * abs(ca.g - cb.g) + 6 * abs(ca.b - cb.b) + 48 * abs(ca.a - cb.a);
+}
+
+/*!
+\brief Finds the edge, if any, xBR blends into one corner of a pixel.
+
+Compares how much the colors change along each diagonal around the corner. If they change less
+along the one away from E, there's an edge between E and I, and the corner gets the color of F or H,
+whichever is closer to E. The slope of the edge is told from whether F matches G or H matches C better.
+
+\param pixels The padded source at pixel E.
+\param yuv The YUVA colors at pixel E.
+\param offsets Offsets from E to each XBR_ neighbour, turned to the corner.
+\param color Set to the color to blend in when there's an edge.
+
+\return One of the XBR_EDGE_ kinds.
+*/
+static int _xbrCornerEdge(const Uint32 *pixels, const Uint32 *yuv, const int *offsets, Uint32 *color)
+{
+	Uint32 e, f, h;
+	int edge, interior, ke, ki, shallow, steep;
+
+#define XBR_PIXEL(n) (pixels[offsets[n]])
+#define XBR_DISTANCE(n, m) _xbrDistance(yuv, offsets[n], offsets[m])
+#define XBR_SAME(n, m) (XBR_DISTANCE(n, m) < XBR_EQUAL_DISTANCE)
+
+	e = XBR_PIXEL(XBR_E);
+	f = XBR_PIXEL(XBR_F);
+	h = XBR_PIXEL(XBR_H);
+	if (e == f || e == h) {
+		return (XBR_EDGE_NONE);
+	}
+
+	edge = XBR_DISTANCE(XBR_E, XBR_C) + XBR_DISTANCE(XBR_E, XBR_G) + XBR_DISTANCE(XBR_I, XBR_H5) + XBR_DISTANCE(XBR_I, XBR_F4)
+		+ 4 * XBR_DISTANCE(XBR_H, XBR_F);
+	interior = XBR_DISTANCE(XBR_H, XBR_D) + XBR_DISTANCE(XBR_H, XBR_I5) + XBR_DISTANCE(XBR_F, XBR_I4) + XBR_DISTANCE(XBR_F, XBR_B)
+		+ 4 * XBR_DISTANCE(XBR_E, XBR_I);
+	if (edge > interior) {
+		return (XBR_EDGE_NONE);
+	}
+	*color = (XBR_DISTANCE(XBR_E, XBR_F) <= XBR_DISTANCE(XBR_E, XBR_H)) ? f : h;
+
+	if (edge == interior ||
+		!((!XBR_SAME(XBR_F, XBR_B) && !XBR_SAME(XBR_H, XBR_D)) ||
+		(XBR_SAME(XBR_E, XBR_I) && !XBR_SAME(XBR_F, XBR_I4) && !XBR_SAME(XBR_H, XBR_I5)) ||
+		XBR_SAME(XBR_E, XBR_G) || XBR_SAME(XBR_E, XBR_C))) {
+		return (XBR_EDGE_WEAK);
+	}
+
+	ke = XBR_DISTANCE(XBR_F, XBR_G);
+	ki = XBR_DISTANCE(XBR_H, XBR_C);
+	shallow = (ke * 2 <= ki) && (e != XBR_PIXEL(XBR_G)) && (XBR_PIXEL(XBR_D) != XBR_PIXEL(XBR_G));
+	steep = (ke >= ki * 2) && (e != XBR_PIXEL(XBR_C)) && (XBR_PIXEL(XBR_B) != XBR_PIXEL(XBR_C));
+
+#undef XBR_PIXEL
+#undef XBR_DISTANCE
+#undef XBR_SAME
+
+	if (shallow && steep) {
+		return (XBR_EDGE_BOTH);
+	} else if (shallow) {
+		return (XBR_EDGE_SHALLOW);
+	} else if (steep) {
+		return (XBR_EDGE_STEEP);
 	}
+	return (XBR_EDGE_DIAGONAL);
+}
 
-	/*
-	* Remove temp arrays 
-	*/
-	free(sax);
-	free(say);
+/*!
+\brief Tells how far past the edge one side of a line is a point, from 0 to 1 across the pixel.
+\return 2 past it, 1 right on it, 0 before it.
+*/
+static int _xbrSide(double past)
+{
+	return (past > 0.0) ? 2 : (past == 0.0) ? 1 : 0;
+}
 
+/*!
+\brief Tells if a point of a pixel, 0 to 1 from its top left, is past an edge in its bottom right corner.
+\return 2 past it, 1 right on it, so points on the line count half, 0 otherwise.
+*/
+static int _xbrCovers(int edge, double u, double v, int factor)
+{
+	switch (edge) {
+	case XBR_EDGE_WEAK:
+		return _xbrSide(u + v - (2.0 - 1.0 / factor));
+	case XBR_EDGE_DIAGONAL:
+		return _xbrSide(u + v - 1.5);
+	case XBR_EDGE_SHALLOW:
+		return _xbrSide(v - (1.0 - u / 2.0));
+	case XBR_EDGE_STEEP:
+		return _xbrSide(u - (1.0 - v / 2.0));
+	case XBR_EDGE_BOTH:
+		return MAX(_xbrSide(v - (1.0 - u / 2.0)), _xbrSide(u - (1.0 - v / 2.0)));
+	}
 	return (0);
 }
 
-/*! 
-\brief Internal 32 bit rotozoomer with optional anti-aliasing.
+/*!
+\brief Works out how much each kind of edge covers each output pixel of a scaled up pixel.
 
-Rotates and zooms 32 bit RGBA/ABGR 'src' surface to 'dst' surface based on the control 
-parameters by scanning the destination surface and applying optionally anti-aliasing
-by bilinear interpolation.
-Assumes src and dst surfaces are of 32 bit depth.
-Assumes dst surface was allocated with the correct dimensions.
+At 2x and 3x this comes out as the blends of the original xBR filters, and it carries
+the same edges on to any other factor without scaling more than once.
 
-\param src Source surface.
-\param dst Destination surface.
-\param cx Horizontal center coordinate.
-\param cy Vertical center coordinate.
-\param isin Integer version of sine of angle.
-\param icos Integer version of cosine of angle.
-\param flipx Flag indicating horizontal mirroring should be applied.
-\param flipy Flag indicating vertical mirroring should be applied.
-\param smooth Flag indicating anti-aliasing should be used.
+\param factor The scaling factor.
+
+\return weights[(edge * 4 + corner) * factor * factor + y * factor + x] from 0 to 256, for the corners
+bottom right, bottom left, top left and top right, or NULL if it couldn't be allocated. Free with free().
 */
-void _transformSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int cx, int cy, int isin, int icos, int flipx, int flipy, int smooth)
+static Uint16 *_xbrWeights(int factor)
 {
-	int x, y, t1, t2, dx, dy, xd, yd, sdx, sdy, ax, ay, ex, ey, sw, sh;
-	tColorRGBA c00, c01, c10, c11, cswap;
-	tColorRGBA *pc, *sp;
-	int gap;
-
-	/*
-	* Variable setup 
-	*/
-	xd = ((src->w - dst->w) << 15);
-	yd = ((src->h - dst->h) << 15);
-	ax = (cx << 16) - (icos * cx);
-	ay = (cy << 16) - (isin * cx);
-	sw = src->w - 1;
-	sh = src->h - 1;
-	pc = (tColorRGBA*) dst->pixels;
-	gap = dst->pitch - dst->w * 4;
+	Uint16 *weights;
+	int edge, corner, x, y, sx, sy, tx, ty, turn, covered;
+	int size = factor * factor;
 
-	/*
-	* Switch between interpolating and non-interpolating code 
-	*/
-	if (smooth) {
-		for (y = 0; y < dst->h; y++) {
-			dy = cy - y;
-			sdx = (ax + (isin * dy)) + xd;
-			sdy = (ay - (icos * dy)) + yd;
-			for (x = 0; x < dst->w; x++) {
-				dx = (sdx >> 16);
-				dy = (sdy >> 16);
-				if (flipx) dx = sw - dx;
-				if (flipy) dy = sh - dy;
-				if ((dx > -1) && (dy > -1) && (dx < (src->w-1)) && (dy < (src->h-1))) {
-					sp = (tColorRGBA *)src->pixels;;
-					sp += ((src->pitch/4) * dy);
-					sp += dx;
-					c00 = *sp;
-					sp += 1;
-					c01 = *sp;
-					sp += (src->pitch/4);
-					c11 = *sp;
-					sp -= 1;
-					c10 = *sp;
-					if (flipx) {
-						cswap = c00; c00=c01; c01=cswap;
-						cswap = c10; c10=c11; c11=cswap;
-					}
-					if (flipy) {
-						cswap = c00; c00=c10; c10=cswap;
-						cswap = c01; c01=c11; c11=cswap;
+	weights = (Uint16 *) malloc(sizeof(Uint16) * XBR_EDGE_TYPES * 4 * size);
+	if (weights == NULL) {
+		return (NULL);
+	}
+	for (edge = 0; edge < XBR_EDGE_TYPES; edge++) {
+		for (y = 0; y < factor; y++) {
+			for (x = 0; x < factor; x++) {
+				covered = 0;
+				for (sy = 0; sy < XBR_SUBSAMPLES; sy++) {
+					for (sx = 0; sx < XBR_SUBSAMPLES; sx++) {
+						covered += _xbrCovers(edge,
+							(x + (sx + 0.5) / XBR_SUBSAMPLES) / factor, (y + (sy + 0.5) / XBR_SUBSAMPLES) / factor, factor);
 					}
-					/*
-					* Interpolate colors 
-					*/
-					ex = (sdx & 0xffff);
-					ey = (sdy & 0xffff);
-					t1 = ((((c01.r - c00.r) * ex) >> 16) + c00.r) & 0xff;
-					t2 = ((((c11.r - c10.r) * ex) >> 16) + c10.r) & 0xff;
-					pc->r = (((t2 - t1) * ey) >> 16) + t1;
-					t1 = ((((c01.g - c00.g) * ex) >> 16) + c00.g) & 0xff;
-					t2 = ((((c11.g - c10.g) * ex) >> 16) + c10.g) & 0xff;
-					pc->g = (((t2 - t1) * ey) >> 16) + t1;
-					t1 = ((((c01.b - c00.b) * ex) >> 16) + c00.b) & 0xff;
-					t2 = ((((c11.b - c10.b) * ex) >> 16) + c10.b) & 0xff;
-					pc->b = (((t2 - t1) * ey) >> 16) + t1;
-					t1 = ((((c01.a - c00.a) * ex) >> 16) + c00.a) & 0xff;
-					t2 = ((((c11.a - c10.a) * ex) >> 16) + c10.a) & 0xff;
-					pc->a = (((t2 - t1) * ey) >> 16) + t1;
 				}
-				sdx += icos;
-				sdy += isin;
-				pc++;
+				/* turn the output pixel about the center for the other corners, doubled so it stays whole */
+				tx = x * 2 - (factor - 1);
+				ty = y * 2 - (factor - 1);
+				for (corner = 0; corner < 4; corner++) {
+					weights[(edge * 4 + corner) * size + ((ty + factor - 1) / 2) * factor + (tx + factor - 1) / 2] =
+						(Uint16) ((covered * 128) / (XBR_SUBSAMPLES * XBR_SUBSAMPLES));
+					turn = tx;
+					tx = -ty;
+					ty = turn;
+				}
 			}
-			pc = (tColorRGBA *) ((Uint8 *) pc + gap);
 		}
-	} else {
-		for (y = 0; y < dst->h; y++) {
-			dy = cy - y;
-			sdx = (ax + (isin * dy)) + xd;
-			sdy = (ay - (icos * dy)) + yd;
-			for (x = 0; x < dst->w; x++) {
-				dx = (short) (sdx >> 16);
-				dy = (short) (sdy >> 16);
-				if (flipx) dx = (src->w-1)-dx;
-				if (flipy) dy = (src->h-1)-dy;
-				if ((dx >= 0) && (dy >= 0) && (dx < src->w) && (dy < src->h)) {
-					sp = (tColorRGBA *) ((Uint8 *) src->pixels + src->pitch * dy);
-					sp += dx;
-					*pc = *sp;
+	}
+	return (weights);
+}
+
+/*!
+\brief Blends color over a pixel by weight out of 256, with alpha, so transparent pixels don't bleed in as black.
+*/
+static Uint32 _xbrBlend(Uint32 pixel, Uint32 color, int weight)
+{
+	tColorRGBA p, c;
+	int alpha, pw, cw;
+
+	memcpy(&p, &pixel, sizeof(p));
+	memcpy(&c, &color, sizeof(c));
+	pw = p.a * (256 - weight);
+	cw = c.a * weight;
+	alpha = pw + cw;
+	if (alpha == 0) {
+		return (0);
+	}
+	p.r = (p.r * pw + c.r * cw + alpha / 2) / alpha;
+	p.g = (p.g * pw + c.g * cw + alpha / 2) / alpha;
+	p.b = (p.b * pw + c.b * cw + alpha / 2) / alpha;
+	p.a = (alpha + 128) >> 8;
+	memcpy(&pixel, &p, sizeof(pixel));
+	return (pixel);
+}
+
+/*!
+\brief xBR on the source rows firstrow to endrow.
+
+Each pixel is filled in with its own color, then each of its corners where an edge is found
+gets the color on the other side of the edge blended in, as much as the edge covers each output pixel.
+
+This stays scalar: which neighbours get compared, and whether anything is blended at all, depends on each
+corner's own edge, so there's little for SIMD lanes to share. Row bands still run in parallel.
+*/
+static void _xbrRows(void *data, int firstrow, int endrow)
+{
+	tPixelArtJob *job = (tPixelArtJob *) data;
+	const tPaddedPixels *src = job->src;
+	int x, y, i, j, corner, edge, factor, size, index;
+	const Uint32 *sp, *yp;
+	const Uint16 *weights;
+	Uint32 color;
+	Uint32 *dp;
+
+	factor = job->factor;
+	size = factor * factor;
+	for (y = firstrow; y < endrow; y++) {
+		for (x = 0; x < src->w; x++) {
+			index = (int) (src->origin - src->pixels) + src->pitch * y + x;
+			sp = src->pixels + index;
+			yp = job->yuv + index;
+			dp = job->dst + job->dpitch * y * factor + x * factor;
+			for (j = 0; j < factor; j++) {
+				for (i = 0; i < factor; i++) {
+					dp[job->dpitch * j + i] = *sp;
+				}
+			}
+			for (corner = 0; corner < 4; corner++) {
+				edge = _xbrCornerEdge(sp, yp, job->offsets[corner], &color);
+				if (edge == XBR_EDGE_NONE) {
+					continue;
+				}
+				weights = job->weights + (edge * 4 + corner) * size;
+				for (j = 0; j < factor; j++) {
+					for (i = 0; i < factor; i++) {
+						if (weights[j * factor + i]) {
+							dp[job->dpitch * j + i] = _xbrBlend(dp[job->dpitch * j + i], color, weights[j * factor + i]);
+						}
+					}
 				}
-				sdx += icos;
-				sdy += isin;
-				pc++;
 			}
-			pc = (tColorRGBA *) ((Uint8 *) pc + gap);
 		}
 	}
 }
 
 /*!
+\brief Internal 32 bit pixel art scaler.
 
-\brief Rotates and zooms 8 bit palette/Y 'src' surface to 'dst' surface without smoothing.
-
-Rotates and zooms 8 bit RGBA/ABGR 'src' surface to 'dst' surface based on the control 
-parameters by scanning the destination surface.
-Assumes src and dst surfaces are of 8 bit depth.
-Assumes dst surface was allocated with the correct dimensions.
+\param src The source pixels.
+\param w Source width in pixels.
+\param h Source height in pixels.
+\param spitch Length of a source row in bytes.
+\param dst The destination pixels, w * factor by h * factor.
+\param dpitch Length of a destination row in bytes.
+\param factor The scaling factor. Scale2x/Scale3x take products of 2 and 3 only.
+\param scaler PIXELART_SCALENX or PIXELART_XBR.
 
-\param src Source surface.
-\param dst Destination surface.
-\param cx Horizontal center coordinate.
-\param cy Vertical center coordinate.
-\param isin Integer version of sine of angle.
-\param icos Integer version of cosine of angle.
-\param flipx Flag indicating horizontal mirroring should be applied.
-\param flipy Flag indicating vertical mirroring should be applied.
+\return 0 for success or -1 for error.
 */
-void transformSurfaceY(SDL_Surface * src, SDL_Surface * dst, int cx, int cy, int isin, int icos, int flipx, int flipy)
+static int _scalePixelArtRGBA(const void *src, int w, int h, int spitch, void *dst, int dpitch, int factor, int scaler)
 {
-	int x, y, dx, dy, xd, yd, sdx, sdy, ax, ay;
-	tColorY *pc, *sp;
-	int gap;
+	tPaddedPixels padded;
+	tPixelArtJob job;
+	Uint32 *yuv, *pass, *last;
+	int y, n, corner, turn, dx, dy, step, remaining;
+	const void *passsrc;
+	int passpitch;
+
+	if (factor == 1) {
+		for (y = 0; y < h; y++) {
+			memcpy((Uint8 *) dst + dpitch * y, (const Uint8 *) src + spitch * y, w * 4);
+		}
+		return (0);
+	}
+
+	if (scaler == PIXELART_XBR) {
+		if (_padPixelArt(src, w, h, spitch, &padded)) {
+			return (-1);
+		}
+		yuv = (Uint32 *) malloc(sizeof(Uint32) * padded.pitch * (h + PIXELART_PADDING * 2));
+		job.weights = _xbrWeights(factor);
+		if ((yuv == NULL) || (job.weights == NULL)) {
+			free(yuv);
+			free((void *) job.weights);
+			free(padded.pixels);
+			return (-1);
+		}
+		job.src = &padded;
+		job.yuv = yuv;
+		job.dst = (Uint32 *) dst;
+		job.dpitch = dpitch / 4;
+		job.factor = factor;
+		for (corner = 0; corner < 4; corner++) {
+			for (n = 0; n < XBR_NEIGHBOURS; n++) {
+				dx = _xbrNeighbourX[n];
+				dy = _xbrNeighbourY[n];
+				/* a quarter turn clockwise per corner: bottom right, bottom left, top left, top right */
+				for (turn = 0; turn < corner; turn++) {
+					step = dx;
+					dx = -dy;
+					dy = step;
+				}
+				job.offsets[corner][n] = dy * padded.pitch + dx;
+			}
+		}
+		_forEachRowBand(padded.pitch, h + PIXELART_PADDING * 2, _xbrYUVRows, &job);
+		/* each source pixel is about as much work as 4 scaled ones */
+		_forEachRowBand(w * factor * factor * 4, h, _xbrRows, &job);
+		free(yuv);
+		free((void *) job.weights);
+		free(padded.pixels);
+		return (0);
+	}
 
 	/*
-	* Variable setup 
-	*/
-	xd = ((src->w - dst->w) << 15);
-	yd = ((src->h - dst->h) << 15);
-	ax = (cx << 16) - (icos * cx);
-	ay = (cy << 16) - (isin * cx);
-	pc = (tColorY*) dst->pixels;
-	gap = dst->pitch - dst->w;
-	/*
-	* Clear surface to colorkey 
-	*/ 	
-	memset(pc, (int)(_colorkey(src) & 0xff), dst->pitch * dst->h);
-	/*
-	* Iterate through destination surface 
+	* Scale2x and Scale3x, one after the other until the whole factor is done
 	*/
-	for (y = 0; y < dst->h; y++) {
-		dy = cy - y;
-		sdx = (ax + (isin * dy)) + xd;
-		sdy = (ay - (icos * dy)) + yd;
-		for (x = 0; x < dst->w; x++) {
-			dx = (short) (sdx >> 16);
-			dy = (short) (sdy >> 16);
-			if (flipx) dx = (src->w-1)-dx;
-			if (flipy) dy = (src->h-1)-dy;
-			if ((dx >= 0) && (dy >= 0) && (dx < src->w) && (dy < src->h)) {
-				sp = (tColorY *) (src->pixels);
-				sp += (src->pitch * dy + dx);
-				*pc = *sp;
+	passsrc = src;
+	passpitch = spitch;
+	last = NULL;
+	remaining = factor;
+	while (remaining > 1) {
+		step = (remaining % 2 == 0) ? 2 : 3;
+		remaining /= step;
+		if (_padPixelArt(passsrc, w, h, passpitch, &padded)) {
+			free(last);
+			return (-1);
+		}
+		if (remaining == 1) {
+			pass = (Uint32 *) dst;
+			job.dpitch = dpitch / 4;
+		} else {
+			pass = (Uint32 *) malloc(sizeof(Uint32) * w * step * h * step);
+			if (pass == NULL) {
+				free(padded.pixels);
+				free(last);
+				return (-1);
 			}
-			sdx += icos;
-			sdy += isin;
-			pc++;
+			job.dpitch = w * step;
 		}
-		pc += gap;
+		job.src = &padded;
+		job.dst = pass;
+		job.factor = step;
+		_forEachRowBand(w * step * step, h, (step == 2) ? _scale2xRows : _scale3xRows, &job);
+		free(padded.pixels);
+		free(last);
+		last = (remaining == 1) ? NULL : pass;
+		passsrc = pass;
+		passpitch = job.dpitch * 4;
+		w *= step;
+		h *= step;
 	}
+	return (0);
 }
 
 /*!
@@ -1296,6 +2229,77 @@ SDL_Surface *rotozoomSurfaceXY(SDL_Surface * src, double angle, double zoomx, do
 	return (rz_dst);
 }
 
+/*!
+\brief Rotates and zooms 32 bit pixels in memory into another buffer, without any surfaces.
+
+Rotates 'src' by 'angle' degrees and scales it by 'zoomx' and 'zoomy' about its center,
+and draws it into 'dst' with that center at ('dstcx', 'dstcy'). The destination can be any
+size: the transformed pixels are clipped to it, and destination pixels outside of them are left
+untouched. Unlike rotozoomSurfaceXY, 'zoomx' and 'zoomy' can differ while rotating, and
+negative zoom factors flip. Nothing is allocated, so this can be called every frame on a
+reused buffer. Both buffers have to be 32 bit RGBA/ABGR in the same order.
+
+\param src The pixels to rotozoom.
+\param srcwidth The width of src in pixels.
+\param srcheight The height of src in pixels.
+\param srcpitch The length of a row of src in bytes.
+\param dst The pixels to draw into.
+\param dstwidth The width of dst in pixels.
+\param dstheight The height of dst in pixels.
+\param dstpitch The length of a row of dst in bytes.
+\param dstcx Horizontal position in dst, in pixels, where the center of src ends up.
+\param dstcy Vertical position in dst, in pixels, where the center of src ends up.
+\param angle The angle to rotate in degrees, counterclockwise.
+\param zoomx The horizontal scaling factor.
+\param zoomy The vertical scaling factor.
+\param smooth Antialiasing flag; set to SMOOTHING_ON to enable. Pixels on the edges of src are
+only blended with their neighbors inside src, so give src a transparent border for soft edges.
+*/
+void rotozoomPixelsXY(const void *src, int srcwidth, int srcheight, int srcpitch,
+	void *dst, int dstwidth, int dstheight, int dstpitch, double dstcx, double dstcy,
+	double angle, double zoomx, double zoomy, int smooth)
+{
+	double radangle, sangle, cangle, ux, uy, vx, vy, sx, sy;
+
+	/*
+	* Sanity check 
+	*/
+	if ((src == NULL) || (dst == NULL) || (srcwidth <= 0) || (srcheight <= 0)) {
+		return;
+	}
+	if (fabs(zoomx) < VALUE_LIMIT) zoomx = (zoomx < 0.0) ? -VALUE_LIMIT : VALUE_LIMIT;
+	if (fabs(zoomy) < VALUE_LIMIT) zoomy = (zoomy < 0.0) ? -VALUE_LIMIT : VALUE_LIMIT;
+
+	/*
+	* Source steps per destination pixel: the inverse of rotating, then zooming
+	*/
+	radangle = angle * (M_PI / 180.0);
+	sangle = sin(radangle);
+	cangle = cos(radangle);
+	ux = cangle / zoomx;
+	vx = -sangle / zoomx;
+	uy = sangle / zoomy;
+	vy = cangle / zoomy;
+
+	/*
+	* Source position of the center of the top left destination pixel 
+	*/
+	sx = ux * (0.5 - dstcx) + vx * (0.5 - dstcy) + srcwidth / 2.0;
+	sy = uy * (0.5 - dstcx) + vy * (0.5 - dstcy) + srcheight / 2.0;
+	if (smooth) {
+		/* interpolate between source pixel centers */
+		sx -= 0.5;
+		sy -= 0.5;
+	}
+
+	_transformPixelsRGBA((const tColorRGBA *) src, srcwidth, srcheight, srcpitch,
+		(tColorRGBA *) dst, dstwidth, dstheight, dstpitch,
+		(int) floor(sx * 65536.0), (int) floor(sy * 65536.0),
+		(int) floor(ux * 65536.0 + 0.5), (int) floor(uy * 65536.0 + 0.5),
+		(int) floor(vx * 65536.0 + 0.5), (int) floor(vy * 65536.0 + 0.5),
+		0, 0, smooth);
+}
+
 /*!
 \brief Calculates the size of the target surface for a zoomSurface() call.
 
@@ -1492,6 +2496,113 @@ SDL_Surface *zoomSurface(SDL_Surface * src, double zoomx, double zoomy, int smoo
 	return (rz_dst);
 }
 
+/*! 
+\brief Scale a surface up by a whole number with a pixel art scaler.
+
+Scales a 32bit 'src' surface up to a newly created 'dst' surface 'factor' times as
+wide and high, keeping hard pixel edges sharp and smoothing out the stairs of diagonal
+lines, where zoomSurface would either make blocks or blur everything. If the surface is
+not 32bit RGBA/ABGR it will be converted into a 32bit RGBA format on the fly.
+
+PIXELART_SCALENX uses Scale2x (EPX) and Scale3x, which only ever copy source colors,
+applying them repeatedly for factors like 4, 6 or 8. PIXELART_XBR uses xBR, which also
+blends colors along edges, in one pass for any factor.
+
+\param src The surface to scale.
+\param factor The scaling factor, 1 or more. PIXELART_SCALENX only takes products of 2 and 3.
+\param scaler PIXELART_SCALENX or PIXELART_XBR.
+
+\return The new, scaled surface; or NULL on error.
+*/
+SDL_Surface *scalePixelArtSurface(SDL_Surface * src, int factor, int scaler)
+{
+	SDL_Surface *rz_src;
+	SDL_Surface *rz_dst;
+	int src_converted;
+	int remaining;
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+	Uint32 amask = 0xff000000;
+#else
+	Uint32 amask = 0x000000ff;
+#endif
+
+	/*
+	* Sanity check 
+	*/
+	if (src == NULL) {
+		return (NULL);
+	}
+	if (factor < 1) {
+		SDL_SetError("Invalid scaling factor");
+		return (NULL);
+	}
+	if (scaler == PIXELART_SCALENX) {
+		remaining = factor;
+		while (remaining % 2 == 0) remaining /= 2;
+		while (remaining % 3 == 0) remaining /= 3;
+		if (remaining != 1) {
+			SDL_SetError("Scale2x/Scale3x can only scale by products of 2 and 3");
+			return (NULL);
+		}
+	} else if (scaler != PIXELART_XBR) {
+		SDL_SetError("Invalid pixel art scaler");
+		return (NULL);
+	}
+
+	/*
+	* The scalers need the alpha in the last byte of each pixel, like tColorRGBA
+	*/
+	if ((src->format->BitsPerPixel == 32) && (src->format->Amask == amask)) {
+		rz_src = src;
+		src_converted = 0;
+	} else {
+		rz_src =
+			SDL_CreateRGBSurface(SDL_SWSURFACE, src->w, src->h, 32, 
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+			0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000
+#else
+			0xff000000,  0x00ff0000, 0x0000ff00, 0x000000ff
+#endif
+			);
+		if (rz_src == NULL) {
+			return NULL;
+		}
+		SDL_BlitSurface(src, NULL, rz_src, NULL);
+		src_converted = 1;
+	}
+
+	/*
+	* Target surface is 32bit with source RGBA/ABGR ordering 
+	*/
+	rz_dst =
+		SDL_CreateRGBSurface(SDL_SWSURFACE, rz_src->w * factor, rz_src->h * factor, 32,
+		rz_src->format->Rmask, rz_src->format->Gmask,
+		rz_src->format->Bmask, rz_src->format->Amask);
+	if (rz_dst != NULL) {
+		if (SDL_MUSTLOCK(rz_src)) {
+			SDL_LockSurface(rz_src);
+		}
+		if (_scalePixelArtRGBA(rz_src->pixels, rz_src->w, rz_src->h, rz_src->pitch,
+			rz_dst->pixels, rz_dst->pitch, factor, scaler)) {
+			SDL_SetError("Could not allocate pixel art scaling buffers");
+			SDL_FreeSurface(rz_dst);
+			rz_dst = NULL;
+		}
+		if (SDL_MUSTLOCK(rz_src)) {
+			SDL_UnlockSurface(rz_src);
+		}
+	}
+
+	/*
+	* Cleanup temp surface 
+	*/
+	if (src_converted) {
+		SDL_FreeSurface(rz_src);
+	}
+
+	return (rz_dst);
+}
+
 /*! 
 \brief Shrink a surface by an integer ratio using averaging.
 
@@ -55,6 +55,16 @@ extern "C" {
 	*/
 #define SMOOTHING_ON		1
 
+	/*!
+	\brief Pixel art scaling with Scale2x (EPX) and Scale3x.
+	*/
+#define PIXELART_SCALENX	0
+
+	/*!
+	\brief Pixel art scaling with xBR.
+	*/
+#define PIXELART_XBR		1
+
 	/* ---- Function Prototypes */
 
 #ifdef _MSC_VER
@@ -91,6 +101,37 @@ extern "C" {
 
 	/* 
 
+	Threading
+
+	*/
+
+	/*!
+	\brief A parallel for loop: calls job(data, i) for every i from 0 to count - 1, on any threads, and returns once they're all done.
+	*/
+	typedef void (*RotozoomParallelFor)(int count, void (*job)(void *data, int index), void *data);
+
+	SDL2_ROTOZOOM_SCOPE void rotozoomSetParallelFor(RotozoomParallelFor parallelFor);
+
+	/* 
+
+	SIMD
+
+	*/
+
+	SDL2_ROTOZOOM_SCOPE void rotozoomSetSIMD(int enabled);
+
+	/* 
+
+	Pixel buffer functions
+
+	*/
+
+	SDL2_ROTOZOOM_SCOPE void rotozoomPixelsXY(const void *src, int srcwidth, int srcheight, int srcpitch,
+		void *dst, int dstwidth, int dstheight, int dstpitch, double dstcx, double dstcy,
+		double angle, double zoomx, double zoomy, int smooth);
+
+	/* 
+
 	Zooming functions
 
 	*/
@@ -99,6 +140,8 @@ extern "C" {
 
 	SDL2_ROTOZOOM_SCOPE void zoomSurfaceSize(int width, int height, double zoomx, double zoomy, int *dstwidth, int *dstheight);
 
+	SDL2_ROTOZOOM_SCOPE SDL_Surface *scalePixelArtSurface(SDL_Surface * src, int factor, int scaler);
+
 	/* 
 
 	Shrinking functions
@@ -10,6 +10,7 @@ See SDL_FontCache.h for license info.
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 
 // Visual C does not support static inline
 #ifndef static_inline
@@ -31,6 +32,11 @@ See SDL_FontCache.h for license info.
     #define ENABLE_SDL_CLIPPING
 #endif
 
+// Need SDL_RenderGeometry() to draw a batch of glyphs in one call
+#if !defined(FC_USE_SDL_GPU) && SDL_VERSION_ATLEAST(2,0,18)
+    #define FC_USE_RENDER_GEOMETRY
+#endif
+
 #define FC_MIN(a,b) ((a) < (b)? (a) : (b))
 #define FC_MAX(a,b) ((a) > (b)? (a) : (b))
 
@@ -69,14 +75,51 @@ __inline int c99_snprintf(char *outBuf, size_t size, const char *format, ...)
 #endif
 
 
-#define FC_EXTRACT_VARARGS(buffer, start_args) \
-{ \
-    va_list lst; \
-    va_start(lst, start_args); \
-    vsnprintf(buffer, fc_buffer_size, start_args, lst); \
-    va_end(lst); \
+// Variadic text is formatted into a buffer on the stack of the calling function, so any thread can do it at once.
+// Text that doesn't fit gets a buffer on the heap instead of being cut off.
+#define FC_FORMAT_BUFFER_SIZE 1024
+
+static char* FC_VFormat(char* stack_buffer, int stack_size, const char* format, va_list args)
+{
+    char* heap_buffer;
+    va_list args_copy;
+    int size;
+
+    va_copy(args_copy, args);
+    size = vsnprintf(stack_buffer, stack_size, format, args_copy);
+    va_end(args_copy);
+
+    if(size < 0)
+    {
+        stack_buffer[0] = '\0';
+        return stack_buffer;
+    }
+    if(size < stack_size)
+        return stack_buffer;
+
+    heap_buffer = (char*)malloc(size + 1);
+    if(heap_buffer == NULL)
+        return stack_buffer;  // Better cut off than nothing
+
+    vsnprintf(heap_buffer, size + 1, format, args);
+    return heap_buffer;
 }
 
+// Declares 'buffer' and formats the variadic text into it.  It has to be released with FC_FREE_VARARGS(buffer).
+#define FC_EXTRACT_VARARGS(buffer, start_args) \
+    char buffer##_stack[FC_FORMAT_BUFFER_SIZE]; \
+    char* buffer; \
+    { \
+        va_list lst; \
+        va_start(lst, start_args); \
+        buffer = FC_VFormat(buffer##_stack, FC_FORMAT_BUFFER_SIZE, start_args, lst); \
+        va_end(lst); \
+    }
+
+#define FC_FREE_VARARGS(buffer) \
+    if(buffer != buffer##_stack) \
+        free(buffer)
+
 // Extra pixels of padding around each glyph to avoid linear filtering artifacts
 #define FC_CACHE_PADDING 1
 
@@ -156,12 +199,14 @@ static char* replace_concat(char** a, const char* b)
 // Width of a tab in units of the space width (sorry, no tab alignment!)
 static unsigned int fc_tab_width = 4;
 
-// Shared buffer for variadic text
-static char* fc_buffer = NULL;
-static unsigned int fc_buffer_size = 1024;
+// Only reported back by FC_GetBufferSize() now that variadic text isn't limited to a shared buffer
+static unsigned int fc_buffer_size = FC_FORMAT_BUFFER_SIZE;
 
 static Uint8 fc_has_render_target_support = 0;
 
+// Source of FC_Font::layout_version, so a font never gets a version another font had
+static Uint32 fc_layout_version = 0;
+
 // The number of fonts that has been created but not freed
 static int NUM_EXISTING_FONTS = 0;
 
@@ -278,143 +323,172 @@ FC_GlyphData FC_MakeGlyphData(int cache_level, Sint16 x, Sint16 y, Uint16 w, Uin
     return gd;
 }
 
-// Enough to hold all of the ascii characters and some.
-#define FC_DEFAULT_NUM_BUCKETS 300
+// Codepoints below U+0800 (one or two UTF-8 bytes, so Latin, Greek, Cyrillic, Hebrew and Arabic) are looked up directly
+// instead of hashed: keys below 256 by themselves, two byte keys after them by the 11 bits they encode.
+#define FC_MAP_DIRECT_SIZE (256 + 0x800)
+
+// Starting number of slots for the other codepoints. Always a power of two.
+#define FC_MAP_INITIAL_CAPACITY 64
 
-typedef struct FC_MapNode
+// Marks an unused slot. Keys below 256 are never hashed, so 0 is free.
+#define FC_MAP_EMPTY_KEY 0
+
+typedef struct FC_MapEntry
 {
     Uint32 key;
     FC_GlyphData value;
-    struct FC_MapNode* next;
 
-} FC_MapNode;
+} FC_MapEntry;
 
+// Glyphs by codepoint: a direct table for the small codepoints and a flat, open addressed (linear probing) table
+// for the rest, which doubles whenever it gets half full so the probes stay short.
 typedef struct FC_Map
 {
-    int num_buckets;
-    FC_MapNode** buckets;
+    FC_GlyphData direct[FC_MAP_DIRECT_SIZE];
+    Uint8 direct_used[FC_MAP_DIRECT_SIZE];
+    int num_direct;
+
+    FC_MapEntry* entries;
+    Uint32 capacity;
+    Uint32 count;
+    int shift;  // 32 - log2(capacity), for the hash
 } FC_Map;
 
 
 
-static FC_Map* FC_MapCreate(int num_buckets)
+static FC_Map* FC_MapCreate(void)
 {
-    int i;
-    FC_Map* map = (FC_Map*)malloc(sizeof(FC_Map));
+    return (FC_Map*)calloc(1, sizeof(FC_Map));
+}
 
-    map->num_buckets = num_buckets;
-    map->buckets = (FC_MapNode**)malloc(num_buckets * sizeof(FC_MapNode*));
+static void FC_MapFree(FC_Map* map)
+{
+    if(map == NULL)
+        return;
 
-    for(i = 0; i < num_buckets; ++i)
-    {
-        map->buckets[i] = NULL;
-    }
+    free(map->entries);
+    free(map);
+}
+
+// The direct table slot of a codepoint, or -1 if it's hashed.
+static_inline int FC_MapDirectIndex(Uint32 codepoint)
+{
+    if(codepoint < 256)
+        return (int)codepoint;
 
-    return map;
+    // 110xxxxx 10xxxxxx
+    if((codepoint & 0xFFFFE0C0) == 0xC080)
+        return 256 + (int)(((codepoint >> 2) & 0x7C0) | (codepoint & 0x3F));
+
+    return -1;
 }
 
-/*static void FC_MapClear(FC_Map* map)
+static Uint32 FC_MapDirectKey(int index)
 {
-    int i;
-    if(map == NULL)
-        return;
+    if(index < 256)
+        return (Uint32)index;
 
-    // Go through each bucket
-    for(i = 0; i < map->num_buckets; ++i)
-    {
-        // Delete the nodes in order
-        FC_MapNode* node = map->buckets[i];
-        while(node != NULL)
-        {
-            FC_MapNode* last = node;
-            node = node->next;
-            free(last);
-        }
-        // Set the bucket to empty
-        map->buckets[i] = NULL;
-    }
-}*/
+    index -= 256;
+    return 0xC080 | ((Uint32)(index & 0x7C0) << 2) | (Uint32)(index & 0x3F);
+}
 
-static void FC_MapFree(FC_Map* map)
+// Fibonacci hashing, which spreads the packed UTF-8 bytes of nearby codepoints over the whole table.
+static Uint32 FC_MapHash(FC_Map* map, Uint32 codepoint)
 {
-    int i;
-    if(map == NULL)
-        return;
+    return (Uint32)(codepoint * 2654435769u) >> map->shift;
+}
 
-    // Go through each bucket
-    for(i = 0; i < map->num_buckets; ++i)
+static FC_MapEntry* FC_MapProbe(FC_Map* map, Uint32 codepoint)
+{
+    Uint32 mask = map->capacity - 1;
+    Uint32 index = FC_MapHash(map, codepoint);
+
+    // Never full, so this finds the key or an empty slot
+    while(map->entries[index].key != codepoint && map->entries[index].key != FC_MAP_EMPTY_KEY)
+        index = (index + 1) & mask;
+
+    return &map->entries[index];
+}
+
+static Uint8 FC_MapGrow(FC_Map* map)
+{
+    FC_MapEntry* old_entries = map->entries;
+    Uint32 old_capacity = map->capacity;
+    Uint32 capacity = (old_capacity == 0? FC_MAP_INITIAL_CAPACITY : old_capacity*2);
+    Uint32 i;
+    int shift = 32;
+
+    FC_MapEntry* entries = (FC_MapEntry*)calloc(capacity, sizeof(FC_MapEntry));
+    if(entries == NULL)
+        return 0;
+
+    while((1u << (32 - shift)) < capacity)
+        shift--;
+
+    map->entries = entries;
+    map->capacity = capacity;
+    map->shift = shift;
+    for(i = 0; i < old_capacity; ++i)
     {
-        // Delete the nodes in order
-        FC_MapNode* node = map->buckets[i];
-        while(node != NULL)
-        {
-            FC_MapNode* last = node;
-            node = node->next;
-            free(last);
-        }
+        if(old_entries[i].key != FC_MAP_EMPTY_KEY)
+            *FC_MapProbe(map, old_entries[i].key) = old_entries[i];
     }
 
-    free(map->buckets);
-    free(map);
+    free(old_entries);
+    return 1;
 }
 
-// Note: Does not handle duplicates in any special way.
+// Replaces the glyph if the codepoint already has one.
+// The returned pointer is only good until the next insert, which can move the table.
 static FC_GlyphData* FC_MapInsert(FC_Map* map, Uint32 codepoint, FC_GlyphData glyph)
 {
-    Uint32 index;
-    FC_MapNode* node;
+    FC_MapEntry* entry;
+    int direct;
     if(map == NULL)
         return NULL;
 
-    // Get index for bucket
-    index = codepoint % map->num_buckets;
-
-    // If this bucket is empty, create a node and return its value
-    if(map->buckets[index] == NULL)
-    {
-        node = map->buckets[index] = (FC_MapNode*)malloc(sizeof(FC_MapNode));
-        node->key = codepoint;
-        node->value = glyph;
-        node->next = NULL;
-        return &node->value;
-    }
-
-    for(node = map->buckets[index]; node != NULL; node = node->next)
+    direct = FC_MapDirectIndex(codepoint);
+    if(direct >= 0)
     {
-        // Find empty node and add a new one on.
-        if(node->next == NULL)
+        if(!map->direct_used[direct])
         {
-            node->next = (FC_MapNode*)malloc(sizeof(FC_MapNode));
-            node = node->next;
-
-            node->key = codepoint;
-            node->value = glyph;
-            node->next = NULL;
-            return &node->value;
+            map->direct_used[direct] = 1;
+            map->num_direct++;
         }
+        map->direct[direct] = glyph;
+        return &map->direct[direct];
     }
 
-    return NULL;
+    // Keep it at most half full
+    if((map->count + 1)*2 > map->capacity && !FC_MapGrow(map))
+        return NULL;
+
+    entry = FC_MapProbe(map, codepoint);
+    if(entry->key == FC_MAP_EMPTY_KEY)
+    {
+        entry->key = codepoint;
+        map->count++;
+    }
+    entry->value = glyph;
+    return &entry->value;
 }
 
-static FC_GlyphData* FC_MapFind(FC_Map* map, Uint32 codepoint)
+static_inline FC_GlyphData* FC_MapFind(FC_Map* map, Uint32 codepoint)
 {
-    Uint32 index;
-    FC_MapNode* node;
+    FC_MapEntry* entry;
+    int direct;
     if(map == NULL)
         return NULL;
 
-    // Get index for bucket
-    index = codepoint % map->num_buckets;
+    direct = FC_MapDirectIndex(codepoint);
+    if(direct >= 0)
+        return (map->direct_used[direct]? &map->direct[direct] : NULL);
 
-    // Go through list until we find a match
-    for(node = map->buckets[index]; node != NULL; node = node->next)
-    {
-        if(node->key == codepoint)
-            return &node->value;
-    }
+    if(map->count == 0)
+        return NULL;
 
-    return NULL;
+    entry = FC_MapProbe(map, codepoint);
+    return (entry->key == codepoint? &entry->value : NULL);
 }
 
 
@@ -452,6 +526,11 @@ struct FC_Font
 
     char* loading_string;
 
+    Uint32 layout_version;  // Changes whenever text laid out with this font has to be laid out again
+
+    SDL_threadID render_thread;  // The only thread that can add glyphs to the cache
+    SDL_mutex* glyphs_lock;  // Held to change glyphs or use ttf_source, and by other threads to read glyphs
+
 };
 
 // Private
@@ -462,6 +541,8 @@ static FC_Rect FC_RenderLeft(FC_Font* font, FC_Target* dest, float x, float y, F
 static FC_Rect FC_RenderCenter(FC_Font* font, FC_Target* dest, float x, float y, FC_Scale scale, const char* text);
 static FC_Rect FC_RenderRight(FC_Font* font, FC_Target* dest, float x, float y, FC_Scale scale, const char* text);
 
+static Uint16 FC_MeasureWidth(FC_Font* font, const char* text);
+
 
 static_inline SDL_Surface* FC_CreateSurface32(Uint32 width, Uint32 height)
 {
@@ -711,6 +792,309 @@ void FC_SetRenderCallback(FC_Rect (*callback)(FC_Image* src, FC_Rect* srcrect, F
         fc_render_callback = callback;
 }
 
+
+// Batched rendering
+// With the default render callback, glyphs are queued per cache texture instead of being copied one at a time,
+// then each texture's glyphs are drawn with a single SDL_RenderGeometry() call.
+
+#ifdef FC_USE_RENDER_GEOMETRY
+
+typedef struct FC_BatchGlyph
+{
+    FC_Rect srcrect;
+    float x, y;
+    float xscale, yscale;
+    SDL_Color color;  // The texture's color mod when it was queued
+} FC_BatchGlyph;
+
+typedef struct FC_GlyphBatch
+{
+    FC_Image* image;
+    FC_BatchGlyph* glyphs;
+    int count;
+    int capacity;
+} FC_GlyphBatch;
+
+// Batches are kept around between flushes so their glyph arrays get reused
+static FC_GlyphBatch* fc_batches = NULL;
+static int fc_num_batches = 0;
+static int fc_batches_size = 0;
+static FC_Target* fc_batch_dest = NULL;
+
+// Scratch buffers for building the geometry of a batch
+static SDL_Vertex* fc_batch_vertices = NULL;
+static int* fc_batch_indices = NULL;
+static int fc_batch_quads_size = 0;
+
+// Set once the renderer has turned down geometry, so everything goes through the render callback after that
+static Uint8 fc_batch_geometry_failed = 0;
+
+#endif
+
+// Nesting depth of FC_BeginBatch()
+static int fc_batch_depth = 0;
+
+static void FC_FlushBatches(void);
+
+#ifdef FC_USE_RENDER_GEOMETRY
+
+static Uint8 FC_ReserveBatchQuads(int num_quads)
+{
+    SDL_Vertex* new_vertices;
+    int* new_indices;
+    int new_size;
+
+    if(num_quads <= fc_batch_quads_size)
+        return 1;
+
+    new_size = (fc_batch_quads_size == 0? 64 : fc_batch_quads_size);
+    while(new_size < num_quads)
+        new_size *= 2;
+
+    new_vertices = (SDL_Vertex*)realloc(fc_batch_vertices, 4 * new_size * sizeof(SDL_Vertex));
+    if(new_vertices == NULL)
+        return 0;
+    fc_batch_vertices = new_vertices;
+
+    new_indices = (int*)realloc(fc_batch_indices, 6 * new_size * sizeof(int));
+    if(new_indices == NULL)
+        return 0;
+    fc_batch_indices = new_indices;
+
+    fc_batch_quads_size = new_size;
+    return 1;
+}
+
+static void FC_DrawBatchWithCallback(FC_GlyphBatch* batch)
+{
+    int i;
+    Uint8 r, g, b, a;
+    SDL_Color* color;
+
+    SDL_GetTextureColorMod(batch->image, &r, &g, &b);
+    SDL_GetTextureAlphaMod(batch->image, &a);
+
+    for(i = 0; i < batch->count; ++i)
+    {
+        FC_BatchGlyph* glyph = &batch->glyphs[i];
+        color = &glyph->color;
+        set_color(batch->image, color->r, color->g, color->b, color->a);
+        FC_DefaultRenderCallback(batch->image, &glyph->srcrect, fc_batch_dest, glyph->x, glyph->y, glyph->xscale, glyph->yscale);
+    }
+
+    set_color(batch->image, r, g, b, a);
+}
+
+static Uint8 FC_DrawBatchWithGeometry(FC_GlyphBatch* batch)
+{
+    int i, w, h, result;
+    Uint8 r, g, b, a;
+    SDL_Vertex* vertex;
+    int* index;
+
+    if(!FC_ReserveBatchQuads(batch->count) || SDL_QueryTexture(batch->image, NULL, NULL, &w, &h) < 0)
+        return 0;
+
+    vertex = fc_batch_vertices;
+    index = fc_batch_indices;
+    for(i = 0; i < batch->count; ++i)
+    {
+        FC_BatchGlyph* glyph = &batch->glyphs[i];
+        FC_Rect* srcrect = &glyph->srcrect;
+
+        // Same destination rect as FC_DefaultRenderCallback, flips just swap the texture coordinates
+        float x1 = (int)glyph->x;
+        float y1 = (int)glyph->y;
+        float x2 = x1 + (int)((glyph->xscale < 0? -glyph->xscale : glyph->xscale)*srcrect->w);
+        float y2 = y1 + (int)((glyph->yscale < 0? -glyph->yscale : glyph->yscale)*srcrect->h);
+        float u1 = srcrect->x / (float)w;
+        float v1 = srcrect->y / (float)h;
+        float u2 = (srcrect->x + srcrect->w) / (float)w;
+        float v2 = (srcrect->y + srcrect->h) / (float)h;
+        float swap;
+        int first = 4*i;
+
+        if(glyph->xscale < 0)
+        {
+            swap = u1;
+            u1 = u2;
+            u2 = swap;
+        }
+        if(glyph->yscale < 0)
+        {
+            swap = v1;
+            v1 = v2;
+            v2 = swap;
+        }
+
+        vertex[0].position.x = x1; vertex[0].position.y = y1; vertex[0].tex_coord.x = u1; vertex[0].tex_coord.y = v1;
+        vertex[1].position.x = x2; vertex[1].position.y = y1; vertex[1].tex_coord.x = u2; vertex[1].tex_coord.y = v1;
+        vertex[2].position.x = x2; vertex[2].position.y = y2; vertex[2].tex_coord.x = u2; vertex[2].tex_coord.y = v2;
+        vertex[3].position.x = x1; vertex[3].position.y = y2; vertex[3].tex_coord.x = u1; vertex[3].tex_coord.y = v2;
+        vertex[0].color = vertex[1].color = vertex[2].color = vertex[3].color = glyph->color;
+        vertex += 4;
+
+        index[0] = first;
+        index[1] = first + 1;
+        index[2] = first + 2;
+        index[3] = first;
+        index[4] = first + 2;
+        index[5] = first + 3;
+        index += 6;
+    }
+
+    // The vertex colors carry the color mod, so it can't be applied again on top of them
+    SDL_GetTextureColorMod(batch->image, &r, &g, &b);
+    SDL_GetTextureAlphaMod(batch->image, &a);
+    set_color(batch->image, 255, 255, 255, 255);
+
+    result = SDL_RenderGeometry(fc_batch_dest, batch->image, fc_batch_vertices, 4*batch->count, fc_batch_indices, 6*batch->count);
+
+    set_color(batch->image, r, g, b, a);
+
+    if(result < 0)
+    {
+        fc_batch_geometry_failed = 1;
+        return 0;
+    }
+    return 1;
+}
+
+// Queues a glyph the way fc_render_callback would draw it.  Returns 0 if it has to be drawn right away instead.
+static Uint8 FC_QueueGlyph(FC_Image* src, FC_Rect* srcrect, FC_Target* dest, float x, float y, float xscale, float yscale, FC_Rect* result)
+{
+    int i;
+    FC_GlyphBatch* batch = NULL;
+    FC_BatchGlyph* glyph;
+
+    if(fc_render_callback != &FC_DefaultRenderCallback || fc_batch_geometry_failed || src == NULL)
+        return 0;
+
+    if(dest != fc_batch_dest)
+    {
+        FC_FlushBatches();
+        fc_batch_dest = dest;
+    }
+
+    for(i = 0; i < fc_num_batches; ++i)
+    {
+        if(fc_batches[i].image == src)
+        {
+            batch = &fc_batches[i];
+            break;
+        }
+    }
+
+    if(batch == NULL)
+    {
+        if(fc_num_batches == fc_batches_size)
+        {
+            int new_size = (fc_batches_size == 0? 4 : 2*fc_batches_size);
+            FC_GlyphBatch* new_batches = (FC_GlyphBatch*)realloc(fc_batches, new_size * sizeof(FC_GlyphBatch));
+            if(new_batches == NULL)
+                return 0;
+            memset(new_batches + fc_batches_size, 0, (new_size - fc_batches_size) * sizeof(FC_GlyphBatch));
+            fc_batches = new_batches;
+            fc_batches_size = new_size;
+        }
+
+        batch = &fc_batches[fc_num_batches++];
+        batch->image = src;
+        batch->count = 0;
+    }
+
+    if(batch->count == batch->capacity)
+    {
+        int new_capacity = (batch->capacity == 0? 64 : 2*batch->capacity);
+        FC_BatchGlyph* new_glyphs = (FC_BatchGlyph*)realloc(batch->glyphs, new_capacity * sizeof(FC_BatchGlyph));
+        if(new_glyphs == NULL)
+            return 0;
+        batch->glyphs = new_glyphs;
+        batch->capacity = new_capacity;
+    }
+
+    glyph = &batch->glyphs[batch->count++];
+    glyph->srcrect = *srcrect;
+    glyph->x = x;
+    glyph->y = y;
+    glyph->xscale = xscale;
+    glyph->yscale = yscale;
+    SDL_GetTextureColorMod(src, &glyph->color.r, &glyph->color.g, &glyph->color.b);
+    SDL_GetTextureAlphaMod(src, &glyph->color.a);
+
+    result->x = x;
+    result->y = y;
+    result->w = srcrect->w * xscale;
+    result->h = srcrect->h * yscale;
+    return 1;
+}
+
+#endif
+
+static void FC_FlushBatches(void)
+{
+    #ifdef FC_USE_RENDER_GEOMETRY
+    int i;
+    for(i = 0; i < fc_num_batches; ++i)
+    {
+        FC_GlyphBatch* batch = &fc_batches[i];
+        if(batch->count == 0)
+            continue;
+
+        if(fc_batch_geometry_failed || !FC_DrawBatchWithGeometry(batch))
+            FC_DrawBatchWithCallback(batch);
+        batch->count = 0;
+    }
+    fc_num_batches = 0;
+    fc_batch_dest = NULL;
+    #endif
+}
+
+static void FC_FreeBatches(void)
+{
+    #ifdef FC_USE_RENDER_GEOMETRY
+    int i;
+    FC_FlushBatches();
+    for(i = 0; i < fc_batches_size; ++i)
+        free(fc_batches[i].glyphs);
+    free(fc_batches);
+    fc_batches = NULL;
+    fc_batches_size = 0;
+
+    free(fc_batch_vertices);
+    fc_batch_vertices = NULL;
+    free(fc_batch_indices);
+    fc_batch_indices = NULL;
+    fc_batch_quads_size = 0;
+    #endif
+}
+
+void FC_BeginBatch(void)
+{
+    ++fc_batch_depth;
+}
+
+void FC_EndBatch(void)
+{
+    if(fc_batch_depth == 0)
+        return;
+
+    if(--fc_batch_depth == 0)
+        FC_FlushBatches();
+}
+
+// Draws a glyph with fc_render_callback, or queues it to be drawn with the rest of its batch
+static FC_Rect FC_RenderGlyph(FC_Image* src, FC_Rect* srcrect, FC_Target* dest, float x, float y, float xscale, float yscale)
+{
+    #ifdef FC_USE_RENDER_GEOMETRY
+    FC_Rect result;
+    if(FC_QueueGlyph(src, srcrect, dest, x, y, xscale, yscale, &result))
+        return result;
+    #endif
+
+    return fc_render_callback(src, srcrect, dest, x, y, xscale, yscale);
+}
+
 void FC_GetUTF8FromCodepoint(char* result, Uint32 codepoint)
 {
     char a, b, c, d;
@@ -812,14 +1196,8 @@ unsigned int FC_GetBufferSize(void)
 
 void FC_SetBufferSize(unsigned int size)
 {
-    free(fc_buffer);
     if(size > 0)
-    {
         fc_buffer_size = size;
-        fc_buffer = (char*)malloc(fc_buffer_size);
-    }
-    else
-        fc_buffer = (char*)malloc(fc_buffer_size);
 }
 
 
@@ -868,6 +1246,13 @@ static void FC_Init(FC_Font* font)
     font->lineSpacing = 0;
     font->letterSpacing = 0;
 
+    font->layout_version = ++fc_layout_version;
+
+    font->render_thread = SDL_ThreadID();
+
+    if(font->glyphs_lock == NULL)
+        font->glyphs_lock = SDL_CreateMutex();
+
     // Give a little offset for when filtering/mipmaps are used.  Depending on mipmap level, this will still not be enough.
     font->last_glyph.rect.x = FC_CACHE_PADDING;
     font->last_glyph.rect.y = FC_CACHE_PADDING;
@@ -875,10 +1260,12 @@ static void FC_Init(FC_Font* font)
     font->last_glyph.rect.h = 0;
     font->last_glyph.cache_level = 0;
 
+    SDL_LockMutex(font->glyphs_lock);
     if(font->glyphs != NULL)
         FC_MapFree(font->glyphs);
 
-    font->glyphs = FC_MapCreate(FC_DEFAULT_NUM_BUCKETS);
+    font->glyphs = FC_MapCreate();
+    SDL_UnlockMutex(font->glyphs_lock);
 
     font->glyph_cache_size = 3;
     font->glyph_cache_count = 0;
@@ -888,9 +1275,6 @@ static void FC_Init(FC_Font* font)
 
 	if (font->loading_string == NULL)
 		font->loading_string = FC_GetStringASCII();
-
-    if(fc_buffer == NULL)
-        fc_buffer = (char*)malloc(fc_buffer_size);
 }
 
 static Uint8 FC_GrowGlyphCache(FC_Font* font)
@@ -1364,6 +1748,468 @@ Uint8 FC_LoadFont_RW(FC_Font* font, FC_Target* renderer, SDL_RWops* file_rwops_t
 }
 
 
+// Glyph atlases
+// A baked font is stored as:
+//   "FCA1"
+//   Uint16 height, max width, baseline; Sint32 ascent, descent
+//   Uint32 number of cache levels, then for each: Uint32 width, height, size of the packed alpha; the alpha
+//   Uint32 number of glyphs, then for each: Uint32 codepoint; Uint16 x, y, w, h, cache level
+//   Uint16 x, y, w, h, cache level of the packing cursor
+// all little endian.  Glyphs are always rendered white, so only the alpha of the cache textures is kept,
+// PackBits compressed since most of a cache level is empty.
+
+#define FC_ATLAS_MAGIC "FCA1"
+#define FC_ATLAS_MAX_SIZE 16384
+#define FC_ATLAS_HEADER_SIZE 22
+#define FC_ATLAS_GLYPH_SIZE 14
+
+// SDL_ReadLE* can't report a short read, so the atlas is read in whole records and decoded with these
+static_inline Uint16 FC_GetLE16(const Uint8* data)
+{
+    return (Uint16)(data[0] | (data[1] << 8));
+}
+
+static_inline Uint32 FC_GetLE32(const Uint8* data)
+{
+    return (Uint32)data[0] | ((Uint32)data[1] << 8) | ((Uint32)data[2] << 16) | ((Uint32)data[3] << 24);
+}
+
+static int FC_PackBits(const Uint8* src, int size, Uint8* dest)
+{
+    int i = 0;
+    int out = 0;
+    while(i < size)
+    {
+        int run = 1;
+        while(i + run < size && run < 128 && src[i + run] == src[i])
+            ++run;
+
+        if(run >= 3)
+        {
+            dest[out++] = (Uint8)(257 - run);
+            dest[out++] = src[i];
+            i += run;
+        }
+        else
+        {
+            // Literal bytes until the next run worth packing
+            int start = i;
+            int count = 0;
+            while(i < size && count < 128)
+            {
+                if(i + 2 < size && src[i] == src[i + 1] && src[i] == src[i + 2])
+                    break;
+                ++i;
+                ++count;
+            }
+            dest[out++] = (Uint8)(count - 1);
+            memcpy(dest + out, src + start, count);
+            out += count;
+        }
+    }
+    return out;
+}
+
+static Uint8 FC_UnpackBits(const Uint8* src, int size, Uint8* dest, int dest_size)
+{
+    int i = 0;
+    int out = 0;
+    while(i < size)
+    {
+        int n = src[i++];
+        if(n < 128)
+        {
+            int count = n + 1;
+            if(i + count > size || out + count > dest_size)
+                return 0;
+            memcpy(dest + out, src + i, count);
+            i += count;
+            out += count;
+        }
+        else if(n > 128)
+        {
+            int count = 257 - n;
+            if(i >= size || out + count > dest_size)
+                return 0;
+            memset(dest + out, src[i++], count);
+            out += count;
+        }
+    }
+    return (out == dest_size);
+}
+
+// Copies a cache level back from the renderer
+static SDL_Surface* FC_ReadGlyphCache(FC_Font* font, int cache_level)
+{
+    FC_Image* img = FC_GetGlyphCacheLevel(font, cache_level);
+    if(img == NULL)
+        return NULL;
+
+    #ifdef FC_USE_SDL_GPU
+    return GPU_CopySurfaceFromImage(img);
+    #else
+    {
+        SDL_Renderer* renderer = font->renderer;
+        SDL_Surface* surface;
+        int w, h, result;
+        SDL_Texture* prev_target;
+        SDL_Rect prev_clip, prev_viewport;
+        int prev_logicalw, prev_logicalh;
+        Uint8 prev_clip_enabled;
+        float prev_scalex, prev_scaley;
+
+        // The cache textures can only be read back when they're render targets
+        if(!fc_has_render_target_support || SDL_QueryTexture(img, NULL, NULL, &w, &h) < 0)
+            return NULL;
+
+        surface = FC_CreateSurface32(w, h);
+        if(surface == NULL)
+            return NULL;
+
+        // Anything queued for this cache has to be drawn before the renderer switches targets
+        FC_FlushBatches();
+
+        prev_target = SDL_GetRenderTarget(renderer);
+        // only backup if previous target existed (SDL will preserve them for the default target)
+        if (prev_target) {
+            prev_clip_enabled = has_clip(renderer);
+            if (prev_clip_enabled)
+                prev_clip = get_clip(renderer);
+            SDL_RenderGetViewport(renderer, &prev_viewport);
+            SDL_RenderGetScale(renderer, &prev_scalex, &prev_scaley);
+            SDL_RenderGetLogicalSize(renderer, &prev_logicalw, &prev_logicalh);
+        }
+        SDL_SetRenderTarget(renderer, img);
+        result = SDL_RenderReadPixels(renderer, NULL, surface->format->format, surface->pixels, surface->pitch);
+        SDL_SetRenderTarget(renderer, prev_target);
+        if (prev_target) {
+            if (prev_clip_enabled)
+                set_clip(renderer, &prev_clip);
+            if (prev_logicalw && prev_logicalh)
+                SDL_RenderSetLogicalSize(renderer, prev_logicalw, prev_logicalh);
+            else {
+                SDL_RenderSetViewport(renderer, &prev_viewport);
+                SDL_RenderSetScale(renderer, prev_scalex, prev_scaley);
+            }
+        }
+
+        if(result < 0)
+        {
+            SDL_FreeSurface(surface);
+            return NULL;
+        }
+        return surface;
+    }
+    #endif
+}
+
+static Uint8 FC_WriteGlyphCache(FC_Font* font, int cache_level, SDL_RWops* rwops)
+{
+    SDL_Surface* surface;
+    Uint8* alpha;
+    Uint8* packed;
+    int x, y, size, packed_size;
+    Uint8 result;
+
+    surface = FC_ReadGlyphCache(font, cache_level);
+    if(surface == NULL)
+    {
+        FC_Log("SDL_FontCache: Could not read back cache level %d for the atlas.\n", cache_level);
+        return 0;
+    }
+
+    size = surface->w * surface->h;
+    alpha = (Uint8*)malloc(size);
+    // Worst case for PackBits is one extra byte for every 128
+    packed = (Uint8*)malloc(size + size/128 + 1);
+    if(alpha == NULL || packed == NULL)
+    {
+        free(alpha);
+        free(packed);
+        SDL_FreeSurface(surface);
+        return 0;
+    }
+
+    SDL_LockSurface(surface);
+    for(y = 0; y < surface->h; ++y)
+    {
+        Uint32* row = (Uint32*)((Uint8*)surface->pixels + y*surface->pitch);
+        for(x = 0; x < surface->w; ++x)
+            alpha[y*surface->w + x] = (Uint8)((row[x] & surface->format->Amask) >> surface->format->Ashift);
+    }
+    SDL_UnlockSurface(surface);
+
+    packed_size = FC_PackBits(alpha, size, packed);
+
+    result = (SDL_WriteLE32(rwops, surface->w) && SDL_WriteLE32(rwops, surface->h) && SDL_WriteLE32(rwops, packed_size)
+              && SDL_RWwrite(rwops, packed, packed_size, 1) == 1);
+
+    free(alpha);
+    free(packed);
+    SDL_FreeSurface(surface);
+    return result;
+}
+
+static Uint8 FC_WriteAtlasGlyph(SDL_RWops* rwops, Uint32 codepoint, FC_GlyphData* glyph)
+{
+    return (SDL_WriteLE32(rwops, codepoint)
+            && SDL_WriteLE16(rwops, (Uint16)glyph->rect.x) && SDL_WriteLE16(rwops, (Uint16)glyph->rect.y)
+            && SDL_WriteLE16(rwops, (Uint16)glyph->rect.w) && SDL_WriteLE16(rwops, (Uint16)glyph->rect.h)
+            && SDL_WriteLE16(rwops, (Uint16)glyph->cache_level));
+}
+
+Uint8 FC_SaveGlyphAtlas_RW(FC_Font* font, SDL_RWops* rwops, Uint8 own_rwops)
+{
+    Uint8 result;
+    Uint32* codepoints;
+    unsigned int num_codepoints, i;
+    int level;
+
+    if(rwops == NULL)
+        return 0;
+    if(font == NULL || font->glyph_cache_count == 0)
+    {
+        if(own_rwops)
+            SDL_RWclose(rwops);
+        return 0;
+    }
+
+    num_codepoints = FC_GetNumCodepoints(font);
+    codepoints = (Uint32*)malloc(num_codepoints * sizeof(Uint32) + 1);
+    if(codepoints == NULL)
+    {
+        if(own_rwops)
+            SDL_RWclose(rwops);
+        return 0;
+    }
+    FC_GetCodepoints(font, codepoints);
+
+    result = (SDL_RWwrite(rwops, FC_ATLAS_MAGIC, 4, 1) == 1
+              && SDL_WriteLE16(rwops, font->height) && SDL_WriteLE16(rwops, font->maxWidth) && SDL_WriteLE16(rwops, font->baseline)
+              && SDL_WriteLE32(rwops, (Uint32)font->ascent) && SDL_WriteLE32(rwops, (Uint32)font->descent)
+              && SDL_WriteLE32(rwops, font->glyph_cache_count));
+
+    for(level = 0; result && level < font->glyph_cache_count; ++level)
+        result = FC_WriteGlyphCache(font, level, rwops);
+
+    if(result)
+        result = SDL_WriteLE32(rwops, num_codepoints);
+    for(i = 0; result && i < num_codepoints; ++i)
+    {
+        FC_GlyphData* glyph = FC_MapFind(font->glyphs, codepoints[i]);
+        result = (glyph != NULL && FC_WriteAtlasGlyph(rwops, codepoints[i], glyph));
+    }
+
+    // The packing cursor, so glyphs cached later go after the baked ones
+    if(result)
+        result = FC_WriteAtlasGlyph(rwops, 0, &font->last_glyph);
+
+    free(codepoints);
+    if(own_rwops)
+        SDL_RWclose(rwops);
+
+    if(!result)
+        FC_Log("SDL_FontCache: Failed to write the glyph atlas: %s\n", SDL_GetError());
+    return result;
+}
+
+Uint8 FC_SaveGlyphAtlas(FC_Font* font, const char* filename)
+{
+    SDL_RWops* rwops = SDL_RWFromFile(filename, "wb");
+    if(rwops == NULL)
+    {
+        FC_Log("Unable to open file for writing: %s \n", SDL_GetError());
+        return 0;
+    }
+
+    return FC_SaveGlyphAtlas_RW(font, rwops, 1);
+}
+
+static Uint8 FC_ReadGlyphCacheLevel(FC_Font* font, int cache_level, SDL_RWops* rwops)
+{
+    Uint8 data[12];
+    Uint32 w, h, packed_size;
+    Uint8* packed;
+    Uint8* alpha;
+    SDL_Surface* surface;
+    Uint32 white[256];
+    Uint32 x, y;
+    int i;
+    Uint8 result;
+
+    if(SDL_RWread(rwops, data, sizeof(data), 1) != 1)
+        return 0;
+    w = FC_GetLE32(data);
+    h = FC_GetLE32(data + 4);
+    packed_size = FC_GetLE32(data + 8);
+    if(w == 0 || h == 0 || w > FC_ATLAS_MAX_SIZE || h > FC_ATLAS_MAX_SIZE || packed_size > 2*w*h)
+        return 0;
+
+    packed = (Uint8*)malloc(packed_size + 1);
+    alpha = (Uint8*)malloc(w*h);
+    surface = FC_CreateSurface32(w, h);
+    result = (packed != NULL && alpha != NULL && surface != NULL
+              && SDL_RWread(rwops, packed, 1, packed_size) == packed_size
+              && FC_UnpackBits(packed, packed_size, alpha, w*h));
+
+    if(result)
+    {
+        // White glyphs, like SDL_ttf renders them for the cache
+        for(i = 0; i < 256; ++i)
+            white[i] = SDL_MapRGBA(surface->format, 255, 255, 255, i);
+
+        SDL_LockSurface(surface);
+        for(y = 0; y < h; ++y)
+        {
+            Uint32* row = (Uint32*)((Uint8*)surface->pixels + y*surface->pitch);
+            for(x = 0; x < w; ++x)
+                row[x] = white[alpha[y*w + x]];
+        }
+        SDL_UnlockSurface(surface);
+
+        result = FC_UploadGlyphCache(font, cache_level, surface);
+        #ifndef FC_USE_SDL_GPU
+        if(result)
+            SDL_SetTextureBlendMode(font->glyph_cache[cache_level], SDL_BLENDMODE_BLEND);
+        #endif
+    }
+
+    free(packed);
+    free(alpha);
+    if(surface != NULL)
+        SDL_FreeSurface(surface);
+    return result;
+}
+
+static Uint8 FC_ReadAtlasGlyph(SDL_RWops* rwops, Uint32* codepoint, FC_GlyphData* glyph)
+{
+    Uint8 data[FC_ATLAS_GLYPH_SIZE];
+    if(SDL_RWread(rwops, data, sizeof(data), 1) != 1)
+        return 0;
+
+    *codepoint = FC_GetLE32(data);
+    glyph->rect.x = (Sint16)FC_GetLE16(data + 4);
+    glyph->rect.y = (Sint16)FC_GetLE16(data + 6);
+    glyph->rect.w = FC_GetLE16(data + 8);
+    glyph->rect.h = FC_GetLE16(data + 10);
+    glyph->cache_level = FC_GetLE16(data + 12);
+    return 1;
+}
+
+#ifdef FC_USE_SDL_GPU
+Uint8 FC_LoadFontFromAtlas_RW(FC_Font* font, SDL_RWops* rwops, Uint8 own_rwops, TTF_Font* ttf, SDL_Color color)
+#else
+Uint8 FC_LoadFontFromAtlas_RW(FC_Font* font, SDL_Renderer* renderer, SDL_RWops* rwops, Uint8 own_rwops, TTF_Font* ttf, SDL_Color color)
+#endif
+{
+    Uint8 header[FC_ATLAS_HEADER_SIZE];
+    Uint8 count[4];
+    Uint32 num_levels, num_glyphs, i;
+    Uint32 codepoint;
+    FC_GlyphData glyph;
+    Uint8 result;
+
+    if(rwops == NULL)
+        return 0;
+    #ifdef FC_USE_SDL_GPU
+    if(font == NULL)
+    #else
+    if(font == NULL || renderer == NULL)
+    #endif
+    {
+        if(own_rwops)
+            SDL_RWclose(rwops);
+        return 0;
+    }
+
+    FC_ClearFont(font);
+
+    #ifdef FC_USE_SDL_GPU
+    fc_has_render_target_support = GPU_IsFeatureEnabled(GPU_FEATURE_RENDER_TARGETS);
+    #else
+    SDL_RendererInfo info;
+    SDL_GetRendererInfo(renderer, &info);
+    fc_has_render_target_support = (info.flags & SDL_RENDERER_TARGETTEXTURE);
+
+    font->renderer = renderer;
+    #endif
+
+    result = (SDL_RWread(rwops, header, sizeof(header), 1) == 1 && memcmp(header, FC_ATLAS_MAGIC, 4) == 0);
+    if(result)
+    {
+        font->height = FC_GetLE16(header + 4);
+        font->maxWidth = FC_GetLE16(header + 6);
+        font->baseline = FC_GetLE16(header + 8);
+        font->ascent = (Sint32)FC_GetLE32(header + 10);
+        font->descent = (Sint32)FC_GetLE32(header + 14);
+        num_levels = FC_GetLE32(header + 18);
+        result = (num_levels > 0 && num_levels <= FC_LOAD_MAX_SURFACES*16);
+    }
+
+    for(i = 0; result && i < num_levels; ++i)
+        result = FC_ReadGlyphCacheLevel(font, i, rwops);
+
+    if(result)
+        result = (SDL_RWread(rwops, count, sizeof(count), 1) == 1);
+    if(result)
+    {
+        num_glyphs = FC_GetLE32(count);
+        // No more glyphs than there are UTF-8 codepoints
+        result = (num_glyphs <= 0x110000);
+        for(i = 0; result && i < num_glyphs; ++i)
+        {
+            result = (FC_ReadAtlasGlyph(rwops, &codepoint, &glyph) && glyph.cache_level < (int)num_levels);
+            if(result)
+                FC_SetGlyphData(font, codepoint, glyph);
+        }
+    }
+
+    if(result)
+        result = (FC_ReadAtlasGlyph(rwops, &codepoint, &glyph) && glyph.cache_level < (int)num_levels);
+    if(result)
+        font->last_glyph = glyph;
+
+    if(own_rwops)
+        SDL_RWclose(rwops);
+
+    if(!result)
+    {
+        FC_Log("SDL_FontCache: Invalid glyph atlas.\n");
+        FC_ClearFont(font);
+        return 0;
+    }
+
+    // Glyphs that weren't baked get cached from the TTF as usual, or are missing without one
+    font->ttf_source = ttf;
+    font->default_color = color;
+    return 1;
+}
+
+#ifdef FC_USE_SDL_GPU
+Uint8 FC_LoadFontFromAtlas(FC_Font* font, const char* filename_atlas, TTF_Font* ttf, SDL_Color color)
+#else
+Uint8 FC_LoadFontFromAtlas(FC_Font* font, SDL_Renderer* renderer, const char* filename_atlas, TTF_Font* ttf, SDL_Color color)
+#endif
+{
+    SDL_RWops* rwops;
+
+    if(font == NULL)
+        return 0;
+
+    rwops = SDL_RWFromFile(filename_atlas, "rb");
+    if(rwops == NULL)
+    {
+        FC_Log("Unable to open file for reading: %s \n", SDL_GetError());
+        return 0;
+    }
+
+    #ifdef FC_USE_SDL_GPU
+    return FC_LoadFontFromAtlas_RW(font, rwops, 1, ttf, color);
+    #else
+    return FC_LoadFontFromAtlas_RW(font, renderer, rwops, 1, ttf, color);
+    #endif
+}
+
 #ifndef FC_USE_SDL_GPU
 void FC_ResetFontFromRendererReset(FC_Font* font, SDL_Renderer* renderer, Uint32 evType)
 {
@@ -1373,6 +2219,8 @@ void FC_ResetFontFromRendererReset(FC_Font* font, SDL_Renderer* renderer, Uint32
     if (font == NULL)
         return;
 
+    FC_FlushBatches();
+
     // Destroy glyph cache
     if (evType == SDL_RENDER_TARGETS_RESET) {
         int i;
@@ -1399,6 +2247,11 @@ void FC_ClearFont(FC_Font* font)
     if(font == NULL)
         return;
 
+    // Queued glyphs might be from this font's cache
+    FC_FlushBatches();
+
+    SDL_LockMutex(font->glyphs_lock);
+
     // Release resources
     if(font->owns_ttf_source)
         TTF_CloseFont(font->ttf_source);
@@ -1410,6 +2263,8 @@ void FC_ClearFont(FC_Font* font)
     FC_MapFree(font->glyphs);
     font->glyphs = NULL;
 
+    SDL_UnlockMutex(font->glyphs_lock);
+
     // Delete glyph cache
     for(i = 0; i < font->glyph_cache_count; ++i)
     {
@@ -1433,6 +2288,9 @@ void FC_FreeFont(FC_Font* font)
     if(font == NULL)
         return;
 
+    // Queued glyphs might be from this font's cache
+    FC_FlushBatches();
+
     // Release resources
     if(font->owns_ttf_source)
         TTF_CloseFont(font->ttf_source);
@@ -1453,6 +2311,8 @@ void FC_FreeFont(FC_Font* font)
 
     free(font->loading_string);
 
+    SDL_DestroyMutex(font->glyphs_lock);
+
     free(font);
 
     // If the last font has been freed; assume shutdown and free the global variables
@@ -1467,8 +2327,7 @@ void FC_FreeFont(FC_Font* font)
         free(ASCII_LATIN_1_STRING);
         ASCII_LATIN_1_STRING = NULL;
 
-        free(fc_buffer);
-        fc_buffer = NULL;
+        FC_FreeBatches();
     }
 }
 
@@ -1550,50 +2409,106 @@ Uint8 FC_AddGlyphToCache(FC_Font* font, SDL_Surface* glyph_surface)
 
 unsigned int FC_GetNumCodepoints(FC_Font* font)
 {
-    FC_Map* glyphs;
-    int i;
     unsigned int result = 0;
-    if(font == NULL || font->glyphs == NULL)
+    if(font == NULL)
         return 0;
 
+    SDL_LockMutex(font->glyphs_lock);
+    if(font->glyphs != NULL)
+        result = font->glyphs->num_direct + font->glyphs->count;
+    SDL_UnlockMutex(font->glyphs_lock);
+    return result;
+}
+
+void FC_GetCodepoints(FC_Font* font, Uint32* result)
+{
+    FC_Map* glyphs;
+    Uint32 i;
+    unsigned int count = 0;
+    if(font == NULL)
+        return;
+
+    SDL_LockMutex(font->glyphs_lock);
     glyphs = font->glyphs;
+    if(glyphs == NULL)
+    {
+        SDL_UnlockMutex(font->glyphs_lock);
+        return;
+    }
 
-    for(i = 0; i < glyphs->num_buckets; ++i)
+    for(i = 0; i < FC_MAP_DIRECT_SIZE; ++i)
     {
-        FC_MapNode* node;
-        for(node = glyphs->buckets[i]; node != NULL; node = node->next)
+        if(glyphs->direct_used[i])
         {
-            result++;
+            result[count] = FC_MapDirectKey((int)i);
+            count++;
+        }
+    }
+
+    for(i = 0; i < glyphs->capacity; ++i)
+    {
+        if(glyphs->entries[i].key != FC_MAP_EMPTY_KEY)
+        {
+            result[count] = glyphs->entries[i].key;
+            count++;
         }
     }
+    SDL_UnlockMutex(font->glyphs_lock);
+}
+
+// Measures a glyph that isn't cached, for threads that can't cache it.  It can't be drawn, so its cache_level is -1.
+// Call with glyphs_lock held, since it uses ttf_source.
+static Uint8 FC_MeasureUncachedGlyph(FC_Font* font, FC_GlyphData* result, Uint32 codepoint)
+{
+    char buff[5];
+    int w, h;
+
+    if(font->ttf_source == NULL)
+        return 0;
+
+    // TAB is special!  Same width as FC_PackGlyphData gives it.
+    if(codepoint == '\t')
+    {
+        FC_GlyphData spaceGlyph;
+        if(!FC_GetGlyphData(font, &spaceGlyph, ' '))
+            return 0;
+        w = fc_tab_width * spaceGlyph.rect.w;
+    }
+    else
+    {
+        // The size of the surface caching it would render, so it measures the same before and after
+        FC_GetUTF8FromCodepoint(buff, codepoint);
+        if(TTF_SizeUTF8(font->ttf_source, buff, &w, &h) < 0)
+            return 0;
+    }
 
-    return result;
+    if(result != NULL)
+        *result = FC_MakeGlyphData(-1, 0, 0, w, font->height);
+    return 1;
 }
 
-void FC_GetCodepoints(FC_Font* font, Uint32* result)
+Uint8 FC_GetGlyphData(FC_Font* font, FC_GlyphData* result, Uint32 codepoint)
 {
-    FC_Map* glyphs;
-    int i;
-    unsigned int count = 0;
-    if(font == NULL || font->glyphs == NULL)
-        return;
-
-    glyphs = font->glyphs;
+    FC_GlyphData* e;
 
-    for(i = 0; i < glyphs->num_buckets; ++i)
+    // Other threads read the map under the lock, since the render thread might be adding to it
+    if(SDL_ThreadID() != font->render_thread)
     {
-        FC_MapNode* node;
-        for(node = glyphs->buckets[i]; node != NULL; node = node->next)
-        {
-            result[count] = node->key;
-            count++;
-        }
+        Uint8 found = 1;
+
+        SDL_LockMutex(font->glyphs_lock);
+        e = FC_MapFind(font->glyphs, codepoint);
+        if(e == NULL)
+            found = FC_MeasureUncachedGlyph(font, result, codepoint);
+        else if(result != NULL)
+            *result = *e;
+        SDL_UnlockMutex(font->glyphs_lock);
+
+        return found;
     }
-}
 
-Uint8 FC_GetGlyphData(FC_Font* font, FC_GlyphData* result, Uint32 codepoint)
-{
-    FC_GlyphData* e = FC_MapFind(font->glyphs, codepoint);
+    // The render thread is the only one that changes the map, so it can read it without the lock
+    e = FC_MapFind(font->glyphs, codepoint);
     if(e == NULL)
     {
         char buff[5];
@@ -1621,9 +2536,11 @@ Uint8 FC_GetGlyphData(FC_Font* font, FC_GlyphData* result, Uint32 codepoint)
         SDL_QueryTexture(cache_image, NULL, NULL, &w, &h);
         #endif
 
+        SDL_LockMutex(font->glyphs_lock);
         surf = TTF_RenderUTF8_Blended(font->ttf_source, buff, white);
         if(surf == NULL)
         {
+            SDL_UnlockMutex(font->glyphs_lock);
             return 0;
         }
 
@@ -1637,10 +2554,12 @@ Uint8 FC_GetGlyphData(FC_Font* font, FC_GlyphData* result, Uint32 codepoint)
             e = FC_PackGlyphData(font, codepoint, surf->w, w, h);
             if(e == NULL)
             {
+                SDL_UnlockMutex(font->glyphs_lock);
                 SDL_FreeSurface(surf);
                 return 0;
             }
         }
+        SDL_UnlockMutex(font->glyphs_lock);
 
         // Render onto the cache texture
         FC_AddGlyphToCache(font, surf);
@@ -1657,7 +2576,18 @@ Uint8 FC_GetGlyphData(FC_Font* font, FC_GlyphData* result, Uint32 codepoint)
 
 FC_GlyphData* FC_SetGlyphData(FC_Font* font, Uint32 codepoint, FC_GlyphData glyph_data)
 {
-    return FC_MapInsert(font->glyphs, codepoint, glyph_data);
+    FC_GlyphData* result;
+
+    SDL_LockMutex(font->glyphs_lock);
+
+    // Text that already used this glyph has to be laid out again
+    if(FC_MapFind(font->glyphs, codepoint) != NULL)
+        font->layout_version = ++fc_layout_version;
+
+    result = FC_MapInsert(font->glyphs, codepoint, glyph_data);
+
+    SDL_UnlockMutex(font->glyphs_lock);
+    return result;
 }
 
 
@@ -1726,7 +2656,7 @@ static FC_Rect FC_RenderLeft(FC_Font* font, FC_Target* dest, float x, float y, F
         #else
         srcRect = glyph.rect;
         #endif
-        dstRect = fc_render_callback(FC_GetGlyphCacheLevel(font, glyph.cache_level), &srcRect, dest, destX, destY, scale.x, scale.y);
+        dstRect = FC_RenderGlyph(FC_GetGlyphCacheLevel(font, glyph.cache_level), &srcRect, dest, destX, destY, scale.x, scale.y);
         if(dirtyRect.w == 0 || dirtyRect.h == 0)
             dirtyRect = dstRect;
         else
@@ -1735,6 +2665,9 @@ static FC_Rect FC_RenderLeft(FC_Font* font, FC_Target* dest, float x, float y, F
         destX += glyph.rect.w*scale.x + destLetterSpacing;
     }
 
+    if(fc_batch_depth == 0)
+        FC_FlushBatches();
+
     return dirtyRect;
 }
 
@@ -1753,26 +2686,29 @@ static void set_color_for_all_caches(FC_Font* font, SDL_Color color)
 
 FC_Rect FC_Draw(FC_Font* font, FC_Target* dest, float x, float y, const char* formatted_text, ...)
 {
+    FC_Rect result;
+
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(x, y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     set_color_for_all_caches(font, font->default_color);
 
-    return FC_RenderLeft(font, dest, x, y, FC_MakeScale(1,1), fc_buffer);
+    result = FC_RenderLeft(font, dest, x, y, FC_MakeScale(1,1), buffer);
+
+    FC_FREE_VARARGS(buffer);
+    return result;
 }
 
 FC_Rect FC_VA_Draw(FC_Font* font, FC_Target* dest, float x, float y, const char* text)
 {
-    if(formatted_text == NULL || font == NULL)
+    if(text == NULL || font == NULL)
         return FC_MakeRect(x, y, 0, 0);
 
-    strcpy(fc_buffer, text);
-
     set_color_for_all_caches(font, font->default_color);
 
-    return FC_RenderLeft(font, dest, x, y, FC_MakeScale(1,1), fc_buffer);
+    return FC_RenderLeft(font, dest, x, y, FC_MakeScale(1,1), text);
 }
 
 
@@ -1982,20 +2918,21 @@ static void FC_RenderAlign(FC_Font* font, FC_Target* dest, float x, float y, int
     }
 }
 
-static FC_StringList* FC_GetBufferFitToColumn(FC_Font* font, int width, FC_Scale scale, Uint8 keep_newlines)
+// Splits text into lines no wider than width once drawn at the given scale
+static FC_StringList* FC_GetBufferFitToColumn(FC_Font* font, const char* text, int width, FC_Scale scale, Uint8 keep_newlines)
 {
     FC_StringList* result = NULL;
     FC_StringList** current = &result;
 
     FC_StringList *ls, *iter;
 
-    ls = (keep_newlines? FC_ExplodeAndKeep(fc_buffer, '\n') : FC_Explode(fc_buffer, '\n'));
+    ls = (keep_newlines? FC_ExplodeAndKeep(text, '\n') : FC_Explode(text, '\n'));
     for(iter = ls; iter != NULL; iter = iter->next)
     {
         char* line = iter->value;
 
         // If line is too long, then add words one at a time until we go over.
-        if(width > 0 && FC_GetWidth(font, "%s", line) > width)
+        if(width > 0 && FC_MeasureWidth(font, line)*scale.x > width)
         {
             FC_StringList *words, *word_iter, *spaces, *spaces_iter;
 
@@ -2006,7 +2943,7 @@ static FC_StringList* FC_GetBufferFitToColumn(FC_Font* font, int width, FC_Scale
             {
                 char* line_plus_word = new_concat(line, word_iter->value);
                 char* word_plus_space = new_concat(word_iter->value, spaces_iter->value);
-                if(FC_GetWidth(font, "%s", line_plus_word) > width)
+                if(FC_MeasureWidth(font, line_plus_word)*scale.x > width)
                 {
                     current = FC_StringListPushBack(current, line, 0);
 
@@ -2034,17 +2971,19 @@ static FC_StringList* FC_GetBufferFitToColumn(FC_Font* font, int width, FC_Scale
     return result;
 }
 
-static void FC_DrawColumnFromBuffer(FC_Font* font, FC_Target* dest, FC_Rect box, int* total_height, FC_Scale scale, FC_AlignEnum align)
+static void FC_DrawColumnFromBuffer(FC_Font* font, FC_Target* dest, const char* text, FC_Rect box, int* total_height, FC_Scale scale, FC_AlignEnum align)
 {
     int y = box.y;
     FC_StringList *ls, *iter;
 
-    ls = FC_GetBufferFitToColumn(font, box.w, scale, 0);
+    ls = FC_GetBufferFitToColumn(font, text, box.w, scale, 0);
+    FC_BeginBatch();
     for(iter = ls; iter != NULL; iter = iter->next)
     {
         FC_RenderAlign(font, dest, box.x, y, box.w, scale, align, iter->value);
         y += FC_GetLineHeight(font);
     }
+    FC_EndBatch();
     FC_StringListFree(ls);
 
     if(total_height != NULL)
@@ -2057,7 +2996,7 @@ FC_Rect FC_DrawBox(FC_Font* font, FC_Target* dest, FC_Rect box, const char* form
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(box.x, box.y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     useClip = has_clip(dest);
     FC_Rect oldclip, newclip;
@@ -2069,17 +3008,22 @@ FC_Rect FC_DrawBox(FC_Font* font, FC_Target* dest, FC_Rect box, const char* form
     else
         newclip = box;
 
+    // Queued glyphs have to be drawn with the clip they were queued under
+    FC_FlushBatches();
     set_clip(dest, &newclip);
 
     set_color_for_all_caches(font, font->default_color);
 
-    FC_DrawColumnFromBuffer(font, dest, box, NULL, FC_MakeScale(1,1), FC_ALIGN_LEFT);
+    FC_DrawColumnFromBuffer(font, dest, buffer, box, NULL, FC_MakeScale(1,1), FC_ALIGN_LEFT);
+
+    FC_FlushBatches();
 
     if(useClip)
         set_clip(dest, &oldclip);
     else
         set_clip(dest, NULL);
 
+    FC_FREE_VARARGS(buffer);
     return box;
 }
 
@@ -2089,7 +3033,7 @@ FC_Rect FC_DrawBoxAlign(FC_Font* font, FC_Target* dest, FC_Rect box, FC_AlignEnu
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(box.x, box.y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     useClip = has_clip(dest);
     FC_Rect oldclip, newclip;
@@ -2100,17 +3044,22 @@ FC_Rect FC_DrawBoxAlign(FC_Font* font, FC_Target* dest, FC_Rect box, FC_AlignEnu
     }
     else
         newclip = box;
+    // Queued glyphs have to be drawn with the clip they were queued under
+    FC_FlushBatches();
     set_clip(dest, &newclip);
 
     set_color_for_all_caches(font, font->default_color);
 
-    FC_DrawColumnFromBuffer(font, dest, box, NULL, FC_MakeScale(1,1), align);
+    FC_DrawColumnFromBuffer(font, dest, buffer, box, NULL, FC_MakeScale(1,1), align);
+
+    FC_FlushBatches();
 
     if(useClip)
         set_clip(dest, &oldclip);
     else
         set_clip(dest, NULL);
 
+    FC_FREE_VARARGS(buffer);
     return box;
 }
 
@@ -2120,7 +3069,7 @@ FC_Rect FC_DrawBoxScale(FC_Font* font, FC_Target* dest, FC_Rect box, FC_Scale sc
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(box.x, box.y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     useClip = has_clip(dest);
     FC_Rect oldclip, newclip;
@@ -2131,17 +3080,22 @@ FC_Rect FC_DrawBoxScale(FC_Font* font, FC_Target* dest, FC_Rect box, FC_Scale sc
     }
     else
         newclip = box;
+    // Queued glyphs have to be drawn with the clip they were queued under
+    FC_FlushBatches();
     set_clip(dest, &newclip);
 
     set_color_for_all_caches(font, font->default_color);
 
-    FC_DrawColumnFromBuffer(font, dest, box, NULL, scale, FC_ALIGN_LEFT);
+    FC_DrawColumnFromBuffer(font, dest, buffer, box, NULL, scale, FC_ALIGN_LEFT);
+
+    FC_FlushBatches();
 
     if(useClip)
         set_clip(dest, &oldclip);
     else
         set_clip(dest, NULL);
 
+    FC_FREE_VARARGS(buffer);
     return box;
 }
 
@@ -2151,7 +3105,7 @@ FC_Rect FC_DrawBoxColor(FC_Font* font, FC_Target* dest, FC_Rect box, SDL_Color c
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(box.x, box.y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     useClip = has_clip(dest);
     FC_Rect oldclip, newclip;
@@ -2162,17 +3116,22 @@ FC_Rect FC_DrawBoxColor(FC_Font* font, FC_Target* dest, FC_Rect box, SDL_Color c
     }
     else
         newclip = box;
+    // Queued glyphs have to be drawn with the clip they were queued under
+    FC_FlushBatches();
     set_clip(dest, &newclip);
 
     set_color_for_all_caches(font, color);
 
-    FC_DrawColumnFromBuffer(font, dest, box, NULL, FC_MakeScale(1,1), FC_ALIGN_LEFT);
+    FC_DrawColumnFromBuffer(font, dest, buffer, box, NULL, FC_MakeScale(1,1), FC_ALIGN_LEFT);
+
+    FC_FlushBatches();
 
     if(useClip)
         set_clip(dest, &oldclip);
     else
         set_clip(dest, NULL);
 
+    FC_FREE_VARARGS(buffer);
     return box;
 }
 
@@ -2182,7 +3141,7 @@ FC_Rect FC_DrawBoxEffect(FC_Font* font, FC_Target* dest, FC_Rect box, FC_Effect
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(box.x, box.y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     useClip = has_clip(dest);
     FC_Rect oldclip, newclip;
@@ -2193,17 +3152,22 @@ FC_Rect FC_DrawBoxEffect(FC_Font* font, FC_Target* dest, FC_Rect box, FC_Effect
     }
     else
         newclip = box;
+    // Queued glyphs have to be drawn with the clip they were queued under
+    FC_FlushBatches();
     set_clip(dest, &newclip);
 
     set_color_for_all_caches(font, effect.color);
 
-    FC_DrawColumnFromBuffer(font, dest, box, NULL, effect.scale, effect.alignment);
+    FC_DrawColumnFromBuffer(font, dest, buffer, box, NULL, effect.scale, effect.alignment);
+
+    FC_FlushBatches();
 
     if(useClip)
         set_clip(dest, &oldclip);
     else
         set_clip(dest, NULL);
 
+    FC_FREE_VARARGS(buffer);
     return box;
 }
 
@@ -2215,12 +3179,13 @@ FC_Rect FC_DrawColumn(FC_Font* font, FC_Target* dest, float x, float y, Uint16 w
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(x, y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     set_color_for_all_caches(font, font->default_color);
 
-    FC_DrawColumnFromBuffer(font, dest, box, &total_height, FC_MakeScale(1,1), FC_ALIGN_LEFT);
+    FC_DrawColumnFromBuffer(font, dest, buffer, box, &total_height, FC_MakeScale(1,1), FC_ALIGN_LEFT);
 
+    FC_FREE_VARARGS(buffer);
     return FC_MakeRect(box.x, box.y, width, total_height);
 }
 
@@ -2232,7 +3197,7 @@ FC_Rect FC_DrawColumnAlign(FC_Font* font, FC_Target* dest, float x, float y, Uin
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(x, y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     set_color_for_all_caches(font, font->default_color);
 
@@ -2248,8 +3213,9 @@ FC_Rect FC_DrawColumnAlign(FC_Font* font, FC_Target* dest, float x, float y, Uin
         break;
     }
 
-    FC_DrawColumnFromBuffer(font, dest, box, &total_height, FC_MakeScale(1,1), align);
+    FC_DrawColumnFromBuffer(font, dest, buffer, box, &total_height, FC_MakeScale(1,1), align);
 
+    FC_FREE_VARARGS(buffer);
     return FC_MakeRect(box.x, box.y, width, total_height);
 }
 
@@ -2261,12 +3227,13 @@ FC_Rect FC_DrawColumnScale(FC_Font* font, FC_Target* dest, float x, float y, Uin
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(x, y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     set_color_for_all_caches(font, font->default_color);
 
-    FC_DrawColumnFromBuffer(font, dest, box, &total_height, scale, FC_ALIGN_LEFT);
+    FC_DrawColumnFromBuffer(font, dest, buffer, box, &total_height, scale, FC_ALIGN_LEFT);
 
+    FC_FREE_VARARGS(buffer);
     return FC_MakeRect(box.x, box.y, width, total_height);
 }
 
@@ -2278,12 +3245,13 @@ FC_Rect FC_DrawColumnColor(FC_Font* font, FC_Target* dest, float x, float y, Uin
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(x, y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     set_color_for_all_caches(font, color);
 
-    FC_DrawColumnFromBuffer(font, dest, box, &total_height, FC_MakeScale(1,1), FC_ALIGN_LEFT);
+    FC_DrawColumnFromBuffer(font, dest, buffer, box, &total_height, FC_MakeScale(1,1), FC_ALIGN_LEFT);
 
+    FC_FREE_VARARGS(buffer);
     return FC_MakeRect(box.x, box.y, width, total_height);
 }
 
@@ -2295,7 +3263,7 @@ FC_Rect FC_DrawColumnEffect(FC_Font* font, FC_Target* dest, float x, float y, Ui
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(x, y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     set_color_for_all_caches(font, effect.color);
 
@@ -2311,8 +3279,9 @@ FC_Rect FC_DrawColumnEffect(FC_Font* font, FC_Target* dest, float x, float y, Ui
         break;
     }
 
-    FC_DrawColumnFromBuffer(font, dest, box, &total_height, effect.scale, effect.alignment);
+    FC_DrawColumnFromBuffer(font, dest, buffer, box, &total_height, effect.scale, effect.alignment);
 
+    FC_FREE_VARARGS(buffer);
     return FC_MakeRect(box.x, box.y, width, total_height);
 }
 
@@ -2326,6 +3295,8 @@ static FC_Rect FC_RenderCenter(FC_Font* font, FC_Target* dest, float x, float y,
     char* del = str;
     char* c;
 
+    FC_BeginBatch();
+
     // Go through str, when you find a \n, replace it with \0 and print it
     // then move down, back, and continue.
     for(c = str; *c != '\0';)
@@ -2333,7 +3304,7 @@ static FC_Rect FC_RenderCenter(FC_Font* font, FC_Target* dest, float x, float y,
         if(*c == '\n')
         {
             *c = '\0';
-            result = FC_RectUnion(FC_RenderLeft(font, dest, x - scale.x*FC_GetWidth(font, "%s", str)/2.0f, y, scale, str), result);
+            result = FC_RectUnion(FC_RenderLeft(font, dest, x - scale.x*FC_MeasureWidth(font, str)/2.0f, y, scale, str), result);
             *c = '\n';
             c++;
             str = c;
@@ -2343,7 +3314,9 @@ static FC_Rect FC_RenderCenter(FC_Font* font, FC_Target* dest, float x, float y,
             c++;
     }
 
-    result = FC_RectUnion(FC_RenderLeft(font, dest, x - scale.x*FC_GetWidth(font, "%s", str)/2.0f, y, scale, str), result);
+    result = FC_RectUnion(FC_RenderLeft(font, dest, x - scale.x*FC_MeasureWidth(font, str)/2.0f, y, scale, str), result);
+
+    FC_EndBatch();
 
     free(del);
     return result;
@@ -2359,12 +3332,14 @@ static FC_Rect FC_RenderRight(FC_Font* font, FC_Target* dest, float x, float y,
     char* del = str;
     char* c;
 
+    FC_BeginBatch();
+
     for(c = str; *c != '\0';)
     {
         if(*c == '\n')
         {
             *c = '\0';
-            result = FC_RectUnion(FC_RenderLeft(font, dest, x - scale.x*FC_GetWidth(font, "%s", str), y, scale, str), result);
+            result = FC_RectUnion(FC_RenderLeft(font, dest, x - scale.x*FC_MeasureWidth(font, str), y, scale, str), result);
             *c = '\n';
             c++;
             str = c;
@@ -2374,7 +3349,9 @@ static FC_Rect FC_RenderRight(FC_Font* font, FC_Target* dest, float x, float y,
             c++;
     }
 
-    result = FC_RectUnion(FC_RenderLeft(font, dest, x - scale.x*FC_GetWidth(font, "%s", str), y, scale, str), result);
+    result = FC_RectUnion(FC_RenderLeft(font, dest, x - scale.x*FC_MeasureWidth(font, str), y, scale, str), result);
+
+    FC_EndBatch();
 
     free(del);
     return result;
@@ -2384,14 +3361,19 @@ static FC_Rect FC_RenderRight(FC_Font* font, FC_Target* dest, float x, float y,
 
 FC_Rect FC_DrawScale(FC_Font* font, FC_Target* dest, float x, float y, FC_Scale scale, const char* formatted_text, ...)
 {
+    FC_Rect result;
+
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(x, y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     set_color_for_all_caches(font, font->default_color);
 
-    return FC_RenderLeft(font, dest, x, y, scale, fc_buffer);
+    result = FC_RenderLeft(font, dest, x, y, scale, buffer);
+
+    FC_FREE_VARARGS(buffer);
+    return result;
 }
 
 FC_Rect FC_DrawAlign(FC_Font* font, FC_Target* dest, float x, float y, FC_AlignEnum align, const char* formatted_text, ...)
@@ -2399,7 +3381,7 @@ FC_Rect FC_DrawAlign(FC_Font* font, FC_Target* dest, float x, float y, FC_AlignE
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(x, y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     set_color_for_all_caches(font, font->default_color);
 
@@ -2407,32 +3389,38 @@ FC_Rect FC_DrawAlign(FC_Font* font, FC_Target* dest, float x, float y, FC_AlignE
     switch(align)
     {
         case FC_ALIGN_LEFT:
-            result = FC_RenderLeft(font, dest, x, y, FC_MakeScale(1,1), fc_buffer);
+            result = FC_RenderLeft(font, dest, x, y, FC_MakeScale(1,1), buffer);
             break;
         case FC_ALIGN_CENTER:
-            result = FC_RenderCenter(font, dest, x, y, FC_MakeScale(1,1), fc_buffer);
+            result = FC_RenderCenter(font, dest, x, y, FC_MakeScale(1,1), buffer);
             break;
         case FC_ALIGN_RIGHT:
-            result = FC_RenderRight(font, dest, x, y, FC_MakeScale(1,1), fc_buffer);
+            result = FC_RenderRight(font, dest, x, y, FC_MakeScale(1,1), buffer);
             break;
         default:
             result = FC_MakeRect(x, y, 0, 0);
             break;
     }
 
+    FC_FREE_VARARGS(buffer);
     return result;
 }
 
 FC_Rect FC_DrawColor(FC_Font* font, FC_Target* dest, float x, float y, SDL_Color color, const char* formatted_text, ...)
 {
+    FC_Rect result;
+
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(x, y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     set_color_for_all_caches(font, color);
 
-    return FC_RenderLeft(font, dest, x, y, FC_MakeScale(1,1), fc_buffer);
+    result = FC_RenderLeft(font, dest, x, y, FC_MakeScale(1,1), buffer);
+
+    FC_FREE_VARARGS(buffer);
+    return result;
 }
 
 
@@ -2441,7 +3429,7 @@ FC_Rect FC_DrawEffect(FC_Font* font, FC_Target* dest, float x, float y, FC_Effec
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(x, y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     set_color_for_all_caches(font, effect.color);
 
@@ -2449,22 +3437,301 @@ FC_Rect FC_DrawEffect(FC_Font* font, FC_Target* dest, float x, float y, FC_Effec
     switch(effect.alignment)
     {
         case FC_ALIGN_LEFT:
-            result = FC_RenderLeft(font, dest, x, y, effect.scale, fc_buffer);
+            result = FC_RenderLeft(font, dest, x, y, effect.scale, buffer);
             break;
         case FC_ALIGN_CENTER:
-            result = FC_RenderCenter(font, dest, x, y, effect.scale, fc_buffer);
+            result = FC_RenderCenter(font, dest, x, y, effect.scale, buffer);
             break;
         case FC_ALIGN_RIGHT:
-            result = FC_RenderRight(font, dest, x, y, effect.scale, fc_buffer);
+            result = FC_RenderRight(font, dest, x, y, effect.scale, buffer);
             break;
         default:
             result = FC_MakeRect(x, y, 0, 0);
             break;
     }
 
+    FC_FREE_VARARGS(buffer);
+    return result;
+}
+
+
+
+// Retained text
+
+typedef struct FC_TextGlyph
+{
+    int cache_level;
+    FC_Rect srcrect;
+    float x, y;  // Relative to where the text is drawn
+} FC_TextGlyph;
+
+struct FC_Text
+{
+    FC_Font* font;
+    char* string;
+    FC_Scale scale;
+    Uint16 width;
+    FC_AlignEnum align;
+
+    // The layout, valid while dirty is unset and the font's layout_version matches
+    Uint8 dirty;
+    Uint32 font_version;
+    FC_TextGlyph* glyphs;
+    int num_glyphs;
+    int glyphs_size;
+    FC_Rect bounds;
+};
+
+FC_Text* FC_CreateText(FC_Font* font)
+{
+    FC_Text* text = (FC_Text*)malloc(sizeof(FC_Text));
+    if(text == NULL)
+        return NULL;
+
+    memset(text, 0, sizeof(FC_Text));
+    text->font = font;
+    text->scale = FC_MakeScale(1,1);
+    text->align = FC_ALIGN_LEFT;
+    text->dirty = 1;
+    return text;
+}
+
+void FC_FreeText(FC_Text* text)
+{
+    if(text == NULL)
+        return;
+
+    free(text->string);
+    free(text->glyphs);
+    free(text);
+}
+
+void FC_SetTextString(FC_Text* text, const char* formatted_text, ...)
+{
+    if(text == NULL)
+        return;
+
+    if(formatted_text == NULL)
+    {
+        text->dirty |= (text->string != NULL);
+        free(text->string);
+        text->string = NULL;
+        return;
+    }
+
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
+
+    if(text->string == NULL || strcmp(text->string, buffer) != 0)
+    {
+        free(text->string);
+        text->string = U8_strdup(buffer);
+        text->dirty = 1;
+    }
+
+    FC_FREE_VARARGS(buffer);
+}
+
+void FC_SetTextFont(FC_Text* text, FC_Font* font)
+{
+    if(text == NULL || text->font == font)
+        return;
+
+    text->font = font;
+    text->dirty = 1;
+}
+
+void FC_SetTextScale(FC_Text* text, FC_Scale scale)
+{
+    if(text == NULL || (text->scale.x == scale.x && text->scale.y == scale.y))
+        return;
+
+    text->scale = scale;
+    text->dirty = 1;
+}
+
+void FC_SetTextWidth(FC_Text* text, Uint16 width)
+{
+    if(text == NULL || text->width == width)
+        return;
+
+    text->width = width;
+    text->dirty = 1;
+}
+
+void FC_SetTextAlign(FC_Text* text, FC_AlignEnum align)
+{
+    if(text == NULL || text->align == align)
+        return;
+
+    text->align = align;
+    text->dirty = 1;
+}
+
+static Uint8 FC_PushTextGlyph(FC_Text* text, FC_GlyphData* glyph, float x, float y)
+{
+    FC_TextGlyph* result;
+
+    if(text->num_glyphs == text->glyphs_size)
+    {
+        int new_size = (text->glyphs_size == 0? 32 : 2*text->glyphs_size);
+        FC_TextGlyph* new_glyphs = (FC_TextGlyph*)realloc(text->glyphs, new_size * sizeof(FC_TextGlyph));
+        if(new_glyphs == NULL)
+            return 0;
+        text->glyphs = new_glyphs;
+        text->glyphs_size = new_size;
+    }
+
+    result = &text->glyphs[text->num_glyphs++];
+    result->cache_level = glyph->cache_level;
+    #ifdef FC_USE_SDL_GPU
+    result->srcrect.x = glyph->rect.x;
+    result->srcrect.y = glyph->rect.y;
+    result->srcrect.w = glyph->rect.w;
+    result->srcrect.h = glyph->rect.h;
+    #else
+    result->srcrect = glyph->rect;
+    #endif
+    result->x = x;
+    result->y = y;
+    return 1;
+}
+
+// Lays out a line without newlines the same way FC_RenderLeft draws it, starting at 0,y.  Returns the width of the line.
+static float FC_LayoutTextLine(FC_Text* text, const char* line, float y)
+{
+    FC_Font* font = text->font;
+    FC_GlyphData glyph;
+    Uint32 codepoint;
+    const char* c;
+    float destX = 0;
+    float destLetterSpacing = font->letterSpacing*text->scale.x;
+
+    if(line == NULL || *line == '\0')
+        return 0;
+
+    for(c = line; *c != '\0'; c++)
+    {
+        codepoint = FC_GetCodepointFromUTF8(&c, 1);
+        if(!FC_GetGlyphData(font, &glyph, codepoint))
+        {
+            codepoint = ' ';
+            if(!FC_GetGlyphData(font, &glyph, codepoint))
+                continue;
+        }
+
+        // Only measured on another thread, so it gets laid out again before it's drawn
+        if(glyph.cache_level < 0)
+            text->dirty = 1;
+
+        if(codepoint != ' ')
+            FC_PushTextGlyph(text, &glyph, destX, y);
+
+        destX += glyph.rect.w*text->scale.x + destLetterSpacing;
+    }
+
+    return destX - destLetterSpacing;
+}
+
+static void FC_LayoutText(FC_Text* text)
+{
+    FC_Font* font = text->font;
+    FC_StringList *ls, *iter;
+    float y = 0;
+    int i;
+
+    text->num_glyphs = 0;
+    text->bounds = FC_MakeRect(0, 0, 0, 0);
+    text->dirty = 0;
+    text->font_version = font->layout_version;
+
+    if(text->string == NULL)
+        return;
+
+    if(text->width > 0)
+        ls = FC_GetBufferFitToColumn(font, text->string, text->width, text->scale, 0);
+    else
+        ls = FC_Explode(text->string, '\n');
+
+    for(iter = ls; iter != NULL; iter = iter->next)
+    {
+        int first = text->num_glyphs;
+        float width = FC_LayoutTextLine(text, iter->value, y);
+        float offset = 0;
+
+        // Same as the FC_ALIGN_* draws: x is the left edge, center or right edge of every line
+        if(text->align == FC_ALIGN_CENTER)
+            offset = -width/2.0f;
+        else if(text->align == FC_ALIGN_RIGHT)
+            offset = -width;
+
+        for(i = first; i < text->num_glyphs; ++i)
+            text->glyphs[i].x += offset;
+
+        y += (font->height + font->lineSpacing)*text->scale.y;
+    }
+    FC_StringListFree(ls);
+
+    for(i = 0; i < text->num_glyphs; ++i)
+    {
+        FC_TextGlyph* glyph = &text->glyphs[i];
+        FC_Rect rect = FC_MakeRect(glyph->x, glyph->y, glyph->srcrect.w*text->scale.x, glyph->srcrect.h*text->scale.y);
+        if(i == 0)
+            text->bounds = rect;
+        else
+            text->bounds = FC_RectUnion(text->bounds, rect);
+    }
+}
+
+static void FC_UpdateText(FC_Text* text)
+{
+    if(text->dirty || text->font_version != text->font->layout_version)
+        FC_LayoutText(text);
+}
+
+FC_Rect FC_GetTextBounds(FC_Text* text)
+{
+    if(text == NULL || text->font == NULL)
+        return FC_MakeRect(0, 0, 0, 0);
+
+    FC_UpdateText(text);
+    return text->bounds;
+}
+
+FC_Rect FC_DrawTextColor(FC_Text* text, FC_Target* dest, float x, float y, SDL_Color color)
+{
+    FC_Rect result;
+    int i;
+
+    if(text == NULL || text->font == NULL || dest == NULL)
+        return FC_MakeRect(x, y, 0, 0);
+
+    FC_UpdateText(text);
+
+    set_color_for_all_caches(text->font, color);
+
+    FC_BeginBatch();
+    for(i = 0; i < text->num_glyphs; ++i)
+    {
+        FC_TextGlyph* glyph = &text->glyphs[i];
+        FC_Rect srcrect = glyph->srcrect;
+        FC_RenderGlyph(FC_GetGlyphCacheLevel(text->font, glyph->cache_level), &srcrect, dest, x + glyph->x, y + glyph->y, text->scale.x, text->scale.y);
+    }
+    FC_EndBatch();
+
+    result = text->bounds;
+    result.x += x;
+    result.y += y;
     return result;
 }
 
+FC_Rect FC_DrawText(FC_Text* text, FC_Target* dest, float x, float y)
+{
+    if(text == NULL || text->font == NULL)
+        return FC_MakeRect(x, y, 0, 0);
+
+    return FC_DrawTextColor(text, dest, x, y, text->font->default_color);
+}
+
 
 
 
@@ -2487,17 +3754,12 @@ Uint16 FC_GetLineHeight(FC_Font* font)
     return font->height;
 }
 
-Uint16 FC_GetHeight(FC_Font* font, const char* formatted_text, ...)
+static Uint16 FC_MeasureHeight(FC_Font* font, const char* text)
 {
-    if(formatted_text == NULL || font == NULL)
-        return 0;
-
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
-
     Uint16 numLines = 1;
     const char* c;
 
-    for (c = fc_buffer; *c != '\0'; c++)
+    for (c = text; *c != '\0'; c++)
     {
         if(*c == '\n')
             numLines++;
@@ -2507,18 +3769,28 @@ Uint16 FC_GetHeight(FC_Font* font, const char* formatted_text, ...)
     return font->height*numLines + font->lineSpacing*(numLines - 1);  //height*numLines;
 }
 
-Uint16 FC_GetWidth(FC_Font* font, const char* formatted_text, ...)
+Uint16 FC_GetHeight(FC_Font* font, const char* formatted_text, ...)
 {
+    Uint16 result;
+
     if(formatted_text == NULL || font == NULL)
         return 0;
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
+
+    result = FC_MeasureHeight(font, buffer);
+
+    FC_FREE_VARARGS(buffer);
+    return result;
+}
 
+static Uint16 FC_MeasureWidth(FC_Font* font, const char* text)
+{
     const char* c;
     Uint16 width = 0;
     Uint16 bigWidth = 0;  // Allows for multi-line strings
 
-    for (c = fc_buffer; *c != '\0'; c++)
+    for (c = text; *c != '\0'; c++)
     {
         if(*c == '\n')
         {
@@ -2537,6 +3809,21 @@ Uint16 FC_GetWidth(FC_Font* font, const char* formatted_text, ...)
     return bigWidth;
 }
 
+Uint16 FC_GetWidth(FC_Font* font, const char* formatted_text, ...)
+{
+    Uint16 result;
+
+    if(formatted_text == NULL || font == NULL)
+        return 0;
+
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
+
+    result = FC_MeasureWidth(font, buffer);
+
+    FC_FREE_VARARGS(buffer);
+    return result;
+}
+
 // If width == -1, use no width limit
 FC_Rect FC_GetCharacterOffset(FC_Font* font, Uint16 position_index, int column_width, const char* formatted_text, ...)
 {
@@ -2548,9 +3835,9 @@ FC_Rect FC_GetCharacterOffset(FC_Font* font, Uint16 position_index, int column_w
     if(formatted_text == NULL || column_width == 0 || position_index == 0 || font == NULL)
         return result;
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
-    ls = FC_GetBufferFitToColumn(font, column_width, FC_MakeScale(1,1), 1);
+    ls = FC_GetBufferFitToColumn(font, buffer, column_width, FC_MakeScale(1,1), 1);
     for(iter = ls; iter != NULL;)
     {
         char* line;
@@ -2567,7 +3854,7 @@ FC_Rect FC_GetCharacterOffset(FC_Font* font, Uint16 position_index, int column_w
                 // FIXME: Doesn't handle box-wrapped newlines correctly
                 line = (char*)U8_next(line);
                 line[0] = '\0';
-                result.x = FC_GetWidth(font, "%s", iter->value);
+                result.x = FC_MeasureWidth(font, iter->value);
                 done = 1;
                 break;
             }
@@ -2577,7 +3864,7 @@ FC_Rect FC_GetCharacterOffset(FC_Font* font, Uint16 position_index, int column_w
 
         // Prevent line wrapping if there are no more lines
         if(next_iter == NULL && !done)
-            result.x = FC_GetWidth(font, "%s", iter->value);
+            result.x = FC_MeasureWidth(font, iter->value);
         iter = next_iter;
     }
     FC_StringListFree(ls);
@@ -2587,6 +3874,7 @@ FC_Rect FC_GetCharacterOffset(FC_Font* font, Uint16 position_index, int column_w
         result.y = (num_lines - 1) * FC_GetLineHeight(font);
     }
 
+    FC_FREE_VARARGS(buffer);
     return result;
 }
 
@@ -2603,15 +3891,16 @@ Uint16 FC_GetColumnHeight(FC_Font* font, Uint16 width, const char* formatted_tex
     if(formatted_text == NULL || width == 0)
         return font->height;
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
-    ls = FC_GetBufferFitToColumn(font, width, FC_MakeScale(1,1), 0);
+    ls = FC_GetBufferFitToColumn(font, buffer, width, FC_MakeScale(1,1), 0);
     for(iter = ls; iter != NULL; iter = iter->next)
     {
         y += FC_GetLineHeight(font);
     }
     FC_StringListFree(ls);
 
+    FC_FREE_VARARGS(buffer);
     return y;
 }
 
@@ -2651,10 +3940,10 @@ int FC_GetAscent(FC_Font* font, const char* formatted_text, ...)
     if(formatted_text == NULL)
         return font->ascent;
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     max = 0;
-    c = fc_buffer;
+    c = buffer;
 
     while(*c != '\0')
     {
@@ -2667,6 +3956,8 @@ int FC_GetAscent(FC_Font* font, const char* formatted_text, ...)
         }
         ++c;
     }
+
+    FC_FREE_VARARGS(buffer);
     return max;
 }
 
@@ -2682,10 +3973,10 @@ int FC_GetDescent(FC_Font* font, const char* formatted_text, ...)
     if(formatted_text == NULL)
         return font->descent;
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     max = 0;
-    c = fc_buffer;
+    c = buffer;
 
     while(*c != '\0')
     {
@@ -2698,6 +3989,8 @@ int FC_GetDescent(FC_Font* font, const char* formatted_text, ...)
         }
         ++c;
     }
+
+    FC_FREE_VARARGS(buffer);
     return max;
 }
 
@@ -2748,15 +4041,13 @@ FC_Rect FC_GetBounds(FC_Font* font, float x, float y, FC_AlignEnum align, FC_Sca
 {
     FC_Rect result = {x, y, 0, 0};
 
-    if(formatted_text == NULL)
+    if(formatted_text == NULL || font == NULL)
         return result;
 
-    // Create a temp buffer while GetWidth and GetHeight use fc_buffer.
-    char* temp = (char*)malloc(fc_buffer_size);
-    FC_EXTRACT_VARARGS(temp, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
-    result.w = FC_GetWidth(font, "%s", temp) * scale.x;
-    result.h = FC_GetHeight(font, "%s", temp) * scale.y;
+    result.w = FC_MeasureWidth(font, buffer) * scale.x;
+    result.h = FC_MeasureHeight(font, buffer) * scale.y;
 
     switch(align)
     {
@@ -2772,8 +4063,7 @@ FC_Rect FC_GetBounds(FC_Font* font, float x, float y, FC_AlignEnum align, FC_Sca
             break;
     }
 
-    free(temp);
-
+    FC_FREE_VARARGS(buffer);
     return result;
 }
 
@@ -2796,9 +4086,9 @@ Uint16 FC_GetPositionFromOffset(FC_Font* font, float x, float y, int column_widt
     if(formatted_text == NULL || column_width == 0 || font == NULL)
         return 0;
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
-    ls = FC_GetBufferFitToColumn(font, column_width, FC_MakeScale(1,1), 1);
+    ls = FC_GetBufferFitToColumn(font, buffer, column_width, FC_MakeScale(1,1), 1);
     for(iter = ls; iter != NULL; iter = iter->next)
     {
         char* line;
@@ -2827,6 +4117,7 @@ Uint16 FC_GetPositionFromOffset(FC_Font* font, float x, float y, int column_widt
     }
     FC_StringListFree(ls);
 
+    FC_FREE_VARARGS(buffer);
     return position;
 }
 
@@ -2840,9 +4131,9 @@ int FC_GetWrappedText(FC_Font* font, char* result, int max_result_size, Uint16 w
     if(formatted_text == NULL || width == 0)
         return 0;
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
-    ls = FC_GetBufferFitToColumn(font, width, FC_MakeScale(1,1), 0);
+    ls = FC_GetBufferFitToColumn(font, buffer, width, FC_MakeScale(1,1), 0);
     int size_so_far = 0;
     int size_remaining = max_result_size-1; // reserve for \0
     for(iter = ls; iter != NULL && size_remaining > 0; iter = iter->next)
@@ -2865,6 +4156,7 @@ int FC_GetWrappedText(FC_Font* font, char* result, int max_result_size, Uint16 w
 
     result[size_so_far] = '\0';
 
+    FC_FREE_VARARGS(buffer);
     return size_so_far;
 }
 
@@ -2905,6 +4197,9 @@ void FC_SetSpacing(FC_Font* font, int LetterSpacing)
     if(font == NULL)
         return;
 
+    if(font->letterSpacing != LetterSpacing)
+        font->layout_version = ++fc_layout_version;
+
     font->letterSpacing = LetterSpacing;
 }
 
@@ -2913,6 +4208,9 @@ void FC_SetLineSpacing(FC_Font* font, int LineSpacing)
     if(font == NULL)
         return;
 
+    if(font->lineSpacing != LineSpacing)
+        font->layout_version = ++fc_layout_version;
+
     font->lineSpacing = LineSpacing;
 }
 
@@ -2971,7 +4269,7 @@ FC_Rect FC_DrawAlignV(FC_Font* font, FC_Target* dest, float x, float y, FC_Align
     if(formatted_text == NULL || font == NULL)
         return FC_MakeRect(x, y, 0, 0);
 
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
 
     set_color_for_all_caches(font, font->default_color);
 
@@ -2994,18 +4292,62 @@ FC_Rect FC_DrawAlignV(FC_Font* font, FC_Target* dest, float x, float y, FC_Align
     switch(alignHorizontal)
     {
         case FC_ALIGN_LEFT:
-            result = FC_RenderLeft(font, dest, x, y, FC_MakeScale(1,1), fc_buffer);
+            result = FC_RenderLeft(font, dest, x, y, FC_MakeScale(1,1), buffer);
+            break;
+        case FC_ALIGN_CENTER:
+            result = FC_RenderCenter(font, dest, x, y, FC_MakeScale(1,1), buffer);
+            break;
+        case FC_ALIGN_RIGHT:
+            result = FC_RenderRight(font, dest, x, y, FC_MakeScale(1,1), buffer);
+            break;
+        default:
+            result = FC_MakeRect(x, y, 0, 0);
+            break;
+    }
+
+    FC_FREE_VARARGS(buffer);
+    return result;
+}
+FC_Rect FC_DrawAny(FC_Font* font, FC_Target* dest, float x, float y, FC_AlignEnum alignHorizontal, FC_VerticalAlignEnum alignVertical, FC_Scale scale, SDL_Color color, const char* formatted_text, ...)
+{
+    if(formatted_text == NULL || font == NULL)
+        return FC_MakeRect(x, y, 0, 0);
+
+    FC_EXTRACT_VARARGS(buffer, formatted_text);
+
+    set_color_for_all_caches(font, color);
+
+    FC_Rect result;
+    switch(alignVertical)
+    {
+        case FC_V_ALIGN_TOP:
+            break;
+        case FC_V_ALIGN_CENTER:
+            y = y - FC_MeasureHeight(font, buffer)*scale.y/2;
+            break;
+        case FC_V_ALIGN_BOTTOM:
+            y = y - FC_MeasureHeight(font, buffer)*scale.y;
+            break;
+        default:
+            break;
+    }
+
+    switch(alignHorizontal)
+    {
+        case FC_ALIGN_LEFT:
+            result = FC_RenderLeft(font, dest, x, y, scale, buffer);
             break;
         case FC_ALIGN_CENTER:
-            result = FC_RenderCenter(font, dest, x, y, FC_MakeScale(1,1), fc_buffer);
+            result = FC_RenderCenter(font, dest, x, y, scale, buffer);
             break;
         case FC_ALIGN_RIGHT:
-            result = FC_RenderRight(font, dest, x, y, FC_MakeScale(1,1), fc_buffer);
+            result = FC_RenderRight(font, dest, x, y, scale, buffer);
             break;
         default:
             result = FC_MakeRect(x, y, 0, 0);
             break;
     }
 
+    FC_FREE_VARARGS(buffer);
     return result;
-}
\ No newline at end of file
+}
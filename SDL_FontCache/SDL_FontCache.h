@@ -100,6 +100,7 @@ typedef struct FC_Effect
 
 // Opaque type
 typedef struct FC_Font FC_Font;
+typedef struct FC_Text FC_Text;
 
 
 typedef struct FC_GlyphData
@@ -154,6 +155,29 @@ void FC_ClearFont(FC_Font* font);
 void FC_FreeFont(FC_Font* font);
 
 
+// Glyph atlases
+// A font's glyph cache can be baked into a file once, then loaded without rasterizing anything with SDL_ttf.
+// Baking reads the cache back from the renderer, so it needs render target support.
+
+/*! Writes the font's glyph cache and glyph data, e.g. after loading it with the loading string it should start with. */
+Uint8 FC_SaveGlyphAtlas(FC_Font* font, const char* filename);
+
+Uint8 FC_SaveGlyphAtlas_RW(FC_Font* font, SDL_RWops* rwops, Uint8 own_rwops);
+
+#ifdef FC_USE_SDL_GPU
+/*! Loads a baked atlas into the font.  ttf (not owned, may be NULL) caches any glyph the atlas doesn't have. */
+Uint8 FC_LoadFontFromAtlas(FC_Font* font, const char* filename_atlas, TTF_Font* ttf, SDL_Color color);
+
+Uint8 FC_LoadFontFromAtlas_RW(FC_Font* font, SDL_RWops* rwops, Uint8 own_rwops, TTF_Font* ttf, SDL_Color color);
+#else
+/*! Loads a baked atlas into the font.  ttf (not owned, may be NULL) caches any glyph the atlas doesn't have.
+    Like fonts loaded with FC_LoadFontFromTTF, it has to be loaded again after a renderer reset. */
+Uint8 FC_LoadFontFromAtlas(FC_Font* font, SDL_Renderer* renderer, const char* filename_atlas, TTF_Font* ttf, SDL_Color color);
+
+Uint8 FC_LoadFontFromAtlas_RW(FC_Font* font, SDL_Renderer* renderer, SDL_RWops* rwops, Uint8 own_rwops, TTF_Font* ttf, SDL_Color color);
+#endif
+
+
 
 // Built-in loading strings
 
@@ -216,10 +240,10 @@ void U8_strdel(char* string, int position);
 /*! Sets the string from which to load the initial glyphs.  Use this if you need upfront loading for any reason (such as lack of render-target support). */
 void FC_SetLoadingString(FC_Font* font, const char* string);
 
-/*! Returns the size of the internal buffer which is used for unpacking variadic text data.  This buffer is shared by all FC_Fonts. */
+/*! Returns the size last given to FC_SetBufferSize().  Variadic text is formatted into a buffer for each call now, however long it is, so this has no effect. */
 unsigned int FC_GetBufferSize(void);
 
-/*! Changes the size of the internal buffer which is used for unpacking variadic text data.  This buffer is shared by all FC_Fonts. */
+/*! Kept for compatibility.  Variadic text is no longer formatted into a shared buffer or cut off at its size. */
 void FC_SetBufferSize(unsigned int size);
 
 /*! Returns the width of a single horizontal tab in multiples of the width of a space (default: 4) */
@@ -255,15 +279,22 @@ unsigned int FC_GetNumCodepoints(FC_Font* font);
 /*! Copies the stored codepoints into the given array. */
 void FC_GetCodepoints(FC_Font* font, Uint32* result);
 
-/*! Stores the glyph data for the given codepoint in 'result'.  Returns 0 if the codepoint was not found in the cache. */
+/*! Stores the glyph data for the given codepoint in 'result', caching the glyph if it isn't yet.  Returns 0 if the font has no such glyph.
+ * On threads other than the one that loaded the font, an uncached glyph is only measured: its cache_level is -1 and it can't be drawn. */
 Uint8 FC_GetGlyphData(FC_Font* font, FC_GlyphData* result, Uint32 codepoint);
 
-/*! Sets the glyph data for the given codepoint.  Duplicates are not checked.  Returns a pointer to the stored data. */
+/*! Sets the glyph data for the given codepoint, replacing any it had.  Returns a pointer to the stored data, which is only valid until more glyph data is added, so only use it on the thread that loaded the font. */
 FC_GlyphData* FC_SetGlyphData(FC_Font* font, Uint32 codepoint, FC_GlyphData glyph_data);
 
 
 // Rendering
 
+/*! Holds back the glyphs of every draw until the matching FC_EndBatch(), so all the text drawn from the same glyph cache texture goes out in one draw call.  Text drawn in a batch isn't ordered against other drawing, so it ends up on top of anything drawn before FC_EndBatch(), and the renderer's target and clip rect have to stay the same until then.  Batches can be nested.  Without SDL_RenderGeometry() (SDL 2.0.18) or with a custom render callback, glyphs are drawn right away as usual. */
+void FC_BeginBatch(void);
+
+/*! Draws everything held back since the outermost FC_BeginBatch(). */
+void FC_EndBatch(void);
+
 FC_Rect FC_Draw(FC_Font* font, FC_Target* dest, float x, float y, const char* formatted_text, ...);
 FC_Rect FC_DrawAlign(FC_Font* font, FC_Target* dest, float x, float y, FC_AlignEnum align, const char* formatted_text, ...);
 FC_Rect FC_DrawScale(FC_Font* font, FC_Target* dest, float x, float y, FC_Scale scale, const char* formatted_text, ...);
@@ -283,7 +314,33 @@ FC_Rect FC_DrawColumnColor(FC_Font* font, FC_Target* dest, float x, float y, Uin
 FC_Rect FC_DrawColumnEffect(FC_Font* font, FC_Target* dest, float x, float y, Uint16 width, FC_Effect effect, const char* formatted_text, ...);
 
 
+// Retained text
+
+/*! Creates text that keeps its glyphs laid out between draws, for strings that don't change every frame.  It's only laid out again when its string, font, scale, width or alignment changes, or when the font's glyphs or spacing do.  The font has to outlive the text, or be swapped out with FC_SetTextFont() first. */
+FC_Text* FC_CreateText(FC_Font* font);
+void FC_FreeText(FC_Text* text);
+
+/*! Sets the string.  Setting the same string again keeps the layout. */
+void FC_SetTextString(FC_Text* text, const char* formatted_text, ...);
+void FC_SetTextFont(FC_Text* text, FC_Font* font);
+void FC_SetTextScale(FC_Text* text, FC_Scale scale);
+/*! Sets the width to wrap lines at, or 0 to only break lines at newlines (default: 0) */
+void FC_SetTextWidth(FC_Text* text, Uint16 width);
+/*! Sets which part of each line is at the x the text is drawn at (default: FC_ALIGN_LEFT) */
+void FC_SetTextAlign(FC_Text* text, FC_AlignEnum align);
+
+/*! Returns the area the text covers, relative to where it's drawn. */
+FC_Rect FC_GetTextBounds(FC_Text* text);
+
+/*! Draws the text in the font's default color in one batch.  Returns the area it covers. */
+FC_Rect FC_DrawText(FC_Text* text, FC_Target* dest, float x, float y);
+FC_Rect FC_DrawTextColor(FC_Text* text, FC_Target* dest, float x, float y, SDL_Color color);
+
+
 // Getters
+// Measuring and wrapping text can be done from any thread while the thread that loaded the font draws with it.
+// Only that thread caches new glyphs; other threads measure glyphs that aren't cached yet with the TTF font instead.
+// Clearing or freeing the font must not overlap with measuring it.
 
 FC_FilterEnum FC_GetFilterMode(FC_Font* font);
 Uint16 FC_GetLineHeight(FC_Font* font);
@@ -348,6 +405,12 @@ typedef enum FC_VerticalAlignEnum {
 */
 FC_Rect FC_DrawAlignV(FC_Font* font, FC_Target* dest, float x, float y, FC_AlignEnum alignHorizontal, FC_VerticalAlignEnum alignVertical, const char* formatted_text, ...);
 
+/*
+* Draw with the font on the target with horizontal and vertical alignment, a scale and a color.
+* Vertical alignment goes by the height of all the lines of the text.
+*/
+FC_Rect FC_DrawAny(FC_Font* font, FC_Target* dest, float x, float y, FC_AlignEnum alignHorizontal, FC_VerticalAlignEnum alignVertical, FC_Scale scale, SDL_Color color, const char* formatted_text, ...);
+
 /*
 * FC_Draw but with input as already concatenated text ( no var args ).
 */
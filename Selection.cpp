@@ -0,0 +1,327 @@
+#include "Selection.hpp"
+
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+static_assert(TILE_SIZE == 64, "selection masks use one Uint64 per tile row");
+
+// bits for the columns below column, which can be 0 to 64
+static inline Uint64 getColumnBitsBelow(int column) {
+    return column >= 64 ? ~(Uint64)0 : (((Uint64)1 << column) - 1);
+}
+
+// bits for the columns of a tile that are inside the selection, since tiles on the edge get cut off
+static inline Uint64 getTileColumnBits(const SelectionMask* mask, int tileX) {
+    return getColumnBitsBelow(mask->width - (tileX << TILE_SHIFT));
+}
+
+static inline int getTileRowCount(const SelectionMask* mask, int tileY) {
+    return std::min(TILE_SIZE, mask->height - (tileY << TILE_SHIFT));
+}
+
+/*
+* Get a tile's rows to write to, allocating them if nothing was selected in the tile.
+* @return The rows, or NULL if they couldn't be allocated
+*/
+static Uint64* getWritableSelectionRows(SelectionMask* mask, int tileIndex) {
+    Uint64* rows = mask->tileRows[tileIndex];
+    if (!rows) {
+        rows = (Uint64*)calloc(TILE_SIZE, sizeof(Uint64));
+        if (!rows) {
+            SDL_Log("Error: Failed to allocate selection mask.");
+            return NULL;
+        }
+        mask->tileRows[tileIndex] = rows;
+    }
+    return rows;
+}
+
+static void releaseSelectionTile(SelectionMask* mask, int tileIndex) {
+    free(mask->tileRows[tileIndex]);
+    mask->tileRows[tileIndex] = NULL;
+}
+
+/*
+* Free the tiles that ended up with nothing selected, so empty tiles are always NULL.
+*/
+static void trimSelection(SelectionMask* mask) {
+    for (size_t i = 0; i < mask->tileRows.size(); i++) {
+        const Uint64* rows = mask->tileRows[i];
+        if (!rows) continue;
+        Uint64 any = 0;
+        for (int row = 0; row < TILE_SIZE; row++) {
+            any |= rows[row];
+        }
+        if (!any) {
+            releaseSelectionTile(mask, (int)i);
+        }
+    }
+}
+
+/*
+* Select length pixels on row y starting at x. The span has to be inside the selection.
+*/
+static void selectSpan(SelectionMask* mask, int x, int y, int length) {
+    int endX = x + length;
+    int tileRow = (y >> TILE_SHIFT) * mask->tilesX;
+    while (x < endX) {
+        int chunkEnd = std::min((x | TILE_MASK) + 1, endX);
+        Uint64* rows = getWritableSelectionRows(mask, tileRow + (x >> TILE_SHIFT));
+        if (rows) {
+            rows[y & TILE_MASK] |= getColumnBitsBelow(chunkEnd - x) << (x & TILE_MASK);
+        }
+        x = chunkEnd;
+    }
+}
+
+void initSelection(SelectionMask* mask, int width, int height) {
+    mask->width = width;
+    mask->height = height;
+    mask->tilesX = (width + TILE_MASK) >> TILE_SHIFT;
+    mask->tilesY = (height + TILE_MASK) >> TILE_SHIFT;
+    mask->tileRows.assign((size_t)mask->tilesX * mask->tilesY, NULL);
+}
+
+void destroySelection(SelectionMask* mask) {
+    clearSelection(mask);
+    mask->tileRows.clear();
+}
+
+void clearSelection(SelectionMask* mask) {
+    for (size_t i = 0; i < mask->tileRows.size(); i++) {
+        releaseSelectionTile(mask, (int)i);
+    }
+}
+
+bool isSelectionEmpty(const SelectionMask* mask) {
+    for (size_t i = 0; i < mask->tileRows.size(); i++) {
+        if (mask->tileRows[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool getSelectionBounds(const SelectionMask* mask, SDL_Rect* bounds) {
+    int minX = mask->width, minY = mask->height, maxX = 0, maxY = 0;
+    for (int tileY = 0; tileY < mask->tilesY; tileY++) {
+        for (int tileX = 0; tileX < mask->tilesX; tileX++) {
+            const Uint64* rows = mask->tileRows[tileX + tileY * mask->tilesX];
+            if (!rows) continue;
+            Uint64 columns = 0;
+            for (int row = 0; row < TILE_SIZE; row++) {
+                if (!rows[row]) continue;
+                columns |= rows[row];
+                minY = std::min(minY, (tileY << TILE_SHIFT) + row);
+                maxY = std::max(maxY, (tileY << TILE_SHIFT) + row + 1);
+            }
+            // empty tiles are never allocated, so columns has a bit set
+            minX = std::min(minX, (tileX << TILE_SHIFT) + __builtin_ctzll(columns));
+            maxX = std::max(maxX, (tileX << TILE_SHIFT) + 64 - __builtin_clzll(columns));
+        }
+    }
+    if (minX >= maxX) {
+        *bounds = (SDL_Rect){0, 0, 0, 0};
+        return false;
+    }
+    *bounds = (SDL_Rect){minX, minY, maxX - minX, maxY - minY};
+    return true;
+}
+
+void selectAll(SelectionMask* mask) {
+    clearSelection(mask);
+    invertSelection(mask);
+}
+
+void invertSelection(SelectionMask* mask) {
+    for (int tileY = 0; tileY < mask->tilesY; tileY++) {
+        int rowCount = getTileRowCount(mask, tileY);
+        for (int tileX = 0; tileX < mask->tilesX; tileX++) {
+            Uint64* rows = getWritableSelectionRows(mask, tileX + tileY * mask->tilesX);
+            if (!rows) continue;
+            Uint64 columns = getTileColumnBits(mask, tileX);
+            for (int row = 0; row < TILE_SIZE; row++) {
+                rows[row] = row < rowCount ? ~rows[row] & columns : 0;
+            }
+        }
+    }
+    trimSelection(mask);
+}
+
+void combineSelection(SelectionMask* dst, const SelectionMask* src, SelectionOp op) {
+    if (op == SELECTION_REPLACE) {
+        clearSelection(dst);
+        op = SELECTION_ADD;
+    }
+    for (size_t i = 0; i < dst->tileRows.size(); i++) {
+        const Uint64* srcRows = src->tileRows[i];
+        Uint64* dstRows = dst->tileRows[i];
+        switch (op) {
+            case SELECTION_ADD:
+                if (!srcRows) break;
+                dstRows = getWritableSelectionRows(dst, (int)i);
+                if (!dstRows) break;
+                for (int row = 0; row < TILE_SIZE; row++) {
+                    dstRows[row] |= srcRows[row];
+                }
+                break;
+            case SELECTION_SUBTRACT:
+                if (!srcRows || !dstRows) break;
+                for (int row = 0; row < TILE_SIZE; row++) {
+                    dstRows[row] &= ~srcRows[row];
+                }
+                break;
+            case SELECTION_INTERSECT:
+                if (!dstRows) break;
+                if (!srcRows) {
+                    releaseSelectionTile(dst, (int)i);
+                    break;
+                }
+                for (int row = 0; row < TILE_SIZE; row++) {
+                    dstRows[row] &= srcRows[row];
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    trimSelection(dst);
+}
+
+void selectRect(SelectionMask* mask, SDL_Rect rect) {
+    int x0 = std::max(rect.x, 0);
+    int y0 = std::max(rect.y, 0);
+    int x1 = std::min(rect.x + rect.w, mask->width);
+    int y1 = std::min(rect.y + rect.h, mask->height);
+    if (x0 >= x1) return;
+    for (int y = y0; y < y1; y++) {
+        selectSpan(mask, x0, y, x1 - x0);
+    }
+}
+
+void selectPolygon(SelectionMask* mask, const std::vector<SDL_FPoint>& points) {
+    size_t numPoints = points.size();
+    if (numPoints < 3) {
+        return;
+    }
+    float minY = points[0].y, maxY = points[0].y;
+    for (size_t i = 1; i < numPoints; i++) {
+        minY = std::min(minY, points[i].y);
+        maxY = std::max(maxY, points[i].y);
+    }
+    int y0 = std::max((int)floorf(minY), 0);
+    int y1 = std::min((int)ceilf(maxY), mask->height);
+
+    // scanline through the pixel centers of each row, selecting between every other crossing of the outline
+    std::vector<float> crossings;
+    for (int y = y0; y < y1; y++) {
+        float centerY = y + 0.5f;
+        crossings.clear();
+        for (size_t i = 0; i < numPoints; i++) {
+            SDL_FPoint a = points[i];
+            SDL_FPoint b = points[(i + 1) % numPoints];
+            // counting the top end of an edge but not the bottom one, so corners aren't crossed twice
+            if ((a.y <= centerY) != (b.y <= centerY)) {
+                crossings.push_back(a.x + (centerY - a.y) * (b.x - a.x) / (b.y - a.y));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+        for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+            // pixels with centers from the first crossing up to the second
+            int start = std::max((int)ceilf(crossings[i] - 0.5f), 0);
+            int end = std::min((int)ceilf(crossings[i + 1] - 0.5f), mask->width);
+            if (start < end) {
+                selectSpan(mask, start, y, end - start);
+            }
+        }
+    }
+}
+
+void selectFillRegion(SelectionMask* mask, const FillRegion* region) {
+    for (size_t row = 0; row < region->tileRowSpans.size(); row++) {
+        const std::vector<FillSpan>& spans = region->tileRowSpans[row];
+        for (size_t i = 0; i < spans.size(); i++) {
+            selectSpan(mask, spans[i].x, spans[i].y, spans[i].length);
+        }
+    }
+}
+
+void fillSelectedSpan(TileGrid* tiles, const SelectionMask* selection, int x, int y, int length, BrushPaint paint) {
+    if (!selection) {
+        fillTileGridSpan(tiles, x, y, length, paint);
+        return;
+    }
+    int endX = x + length;
+    int tileRow = (y >> TILE_SHIFT) * selection->tilesX;
+    while (x < endX) {
+        int chunkEnd = std::min((x | TILE_MASK) + 1, endX);
+        int tileX = x >> TILE_SHIFT;
+        Uint64 selected = getSelectedRowBits(selection, tileRow + tileX, y)
+            & (getColumnBitsBelow(chunkEnd - x) << (x & TILE_MASK));
+        // fill each selected run
+        while (selected) {
+            int runStart = __builtin_ctzll(selected);
+            Uint64 rest = ~(selected >> runStart);
+            int runLength = rest ? __builtin_ctzll(rest) : 64 - runStart;
+            fillTileGridSpan(tiles, (tileX << TILE_SHIFT) + runStart, y, runLength, paint);
+            if (runStart + runLength >= 64) break;
+            selected &= ~(Uint64)0 << (runStart + runLength);
+        }
+        x = chunkEnd;
+    }
+}
+
+/*
+* Add a horizontal edge for each run of set bits.
+*/
+static void addHorizontalEdges(std::vector<SDL_Rect>* edges, Uint64 bits, int tileStartX, int y) {
+    while (bits) {
+        int runStart = __builtin_ctzll(bits);
+        Uint64 rest = ~(bits >> runStart);
+        int runLength = rest ? __builtin_ctzll(rest) : 64 - runStart;
+        edges->push_back((SDL_Rect){tileStartX + runStart, y, runLength, 0});
+        if (runStart + runLength >= 64) break;
+        bits &= ~(Uint64)0 << (runStart + runLength);
+    }
+}
+
+static void addVerticalEdges(std::vector<SDL_Rect>* edges, Uint64 bits, int x, int y) {
+    while (bits) {
+        edges->push_back((SDL_Rect){x + __builtin_ctzll(bits), y, 0, 1});
+        bits &= bits - 1;
+    }
+}
+
+void getSelectionOutline(const SelectionMask* mask, std::vector<SDL_Rect>* edges) {
+    edges->clear();
+    int tilesX = mask->tilesX;
+    for (int tileY = 0; tileY < mask->tilesY; tileY++) {
+        for (int tileX = 0; tileX < tilesX; tileX++) {
+            int index = tileX + tileY * tilesX;
+            const Uint64* rows = mask->tileRows[index];
+            if (!rows) continue;
+            const Uint64* above = tileY > 0 ? mask->tileRows[index - tilesX] : NULL;
+            const Uint64* below = tileY + 1 < mask->tilesY ? mask->tileRows[index + tilesX] : NULL;
+            const Uint64* left = tileX > 0 ? mask->tileRows[index - 1] : NULL;
+            const Uint64* right = tileX + 1 < tilesX ? mask->tileRows[index + 1] : NULL;
+            int startX = tileX << TILE_SHIFT;
+            int startY = tileY << TILE_SHIFT;
+            // edges are only added from the selected side, so each one comes up once
+            for (int row = 0; row < TILE_SIZE; row++) {
+                Uint64 bits = rows[row];
+                if (!bits) continue;
+                Uint64 rowAbove = row > 0 ? rows[row - 1] : (above ? above[TILE_MASK] : 0);
+                Uint64 rowBelow = row < TILE_MASK ? rows[row + 1] : (below ? below[0] : 0);
+                // the neighbor of each pixel on the left, and on the right
+                Uint64 leftNeighbors = (bits << 1) | (left ? left[row] >> 63 : 0);
+                Uint64 rightNeighbors = (bits >> 1) | (right ? right[row] << 63 : 0);
+                int y = startY + row;
+                addHorizontalEdges(edges, bits & ~rowAbove, startX, y);
+                addHorizontalEdges(edges, bits & ~rowBelow, startX, y + 1);
+                addVerticalEdges(edges, bits & ~leftNeighbors, startX, y);
+                addVerticalEdges(edges, bits & ~rightNeighbors, startX + 1, y);
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef SELECTION_INCLUDED
+#define SELECTION_INCLUDED
+
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "Tiles.hpp"
+#include "Brush.hpp"
+#include "Fill.hpp"
+
+/*
+* A set of selected pixels, one bit per pixel. Kept per tile as TILE_SIZE row masks with bit n for column n,
+* so it lines up with TileGrid tiles and a tile's row can be tested or combined a whole word at a time.
+* Tiles with nothing selected aren't allocated.
+*/
+struct SelectionMask {
+    int width; // in pixels
+    int height;
+    int tilesX;
+    int tilesY;
+    std::vector<Uint64*> tileRows; // per tile, NULL if nothing in the tile is selected
+};
+
+// how a new selection combines with the current one
+enum SelectionOp {
+    SELECTION_REPLACE,
+    SELECTION_ADD,
+    SELECTION_SUBTRACT,
+    SELECTION_INTERSECT
+};
+
+/*
+* Initialize an empty selection for a canvas of the given size.
+*/
+void initSelection(SelectionMask* mask, int width, int height);
+void destroySelection(SelectionMask* mask);
+
+/*
+* Deselect everything.
+*/
+void clearSelection(SelectionMask* mask);
+bool isSelectionEmpty(const SelectionMask* mask);
+
+/*
+* Get the smallest rect around every selected pixel.
+* @return false if nothing is selected
+*/
+bool getSelectionBounds(const SelectionMask* mask, SDL_Rect* bounds);
+
+void selectAll(SelectionMask* mask);
+void invertSelection(SelectionMask* mask);
+
+/*
+* Combine src into dst word by word. Both have to be the same size.
+*/
+void combineSelection(SelectionMask* dst, const SelectionMask* src, SelectionOp op);
+
+/*
+* Add the pixels in rect to the selection. The rect is clipped to the selection.
+*/
+void selectRect(SelectionMask* mask, SDL_Rect rect);
+
+/*
+* Add the pixels whose centers are inside a polygon (even-odd rule), like a lasso.
+* @param points The corners of the polygon in canvas coordinates, the last one connects back to the first
+*/
+void selectPolygon(SelectionMask* mask, const std::vector<SDL_FPoint>& points);
+
+/*
+* Add every pixel of a fill region, like a magic wand.
+*/
+void selectFillRegion(SelectionMask* mask, const FillRegion* region);
+
+/*
+* Get which columns of a tile are selected on row y, bit n for column n of the tile.
+*/
+inline Uint64 getSelectedRowBits(const SelectionMask* mask, int tileIndex, int y) {
+    const Uint64* rows = mask->tileRows[tileIndex];
+    return rows ? rows[y & TILE_MASK] : 0;
+}
+
+/*
+* Blend paint into the selected pixels of a span, the same as fillTileGridSpan otherwise.
+* The selection is tested a tile's row at a time, not pixel by pixel.
+* @param selection NULL to paint the whole span
+*/
+void fillSelectedSpan(TileGrid* tiles, const SelectionMask* selection, int x, int y, int length, BrushPaint paint);
+
+/*
+* Get the edges between selected and unselected pixels, to draw the outline of the selection.
+* Edges are in canvas coordinates, horizontal ones as rects with a height of 0 and vertical ones with a width of 0.
+*/
+void getSelectionOutline(const SelectionMask* mask, std::vector<SDL_Rect>* edges);
+
+#endif
@@ -0,0 +1,44 @@
+#include "Spans.hpp"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPANS_SSE2
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define SPANS_WASM_SIMD
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SPANS_NEON
+#endif
+
+void fillPixelSpan(Pixel* dst, Pixel value, int count) {
+    Uint32 packed;
+    memcpy(&packed, &value, sizeof(packed));
+
+    int i = 0;
+#if defined(SPANS_SSE2)
+    __m128i vector = _mm_set1_epi32((int)packed);
+    for (; i + 8 <= count; i += 8) {
+        _mm_storeu_si128((__m128i*)&dst[i], vector);
+        _mm_storeu_si128((__m128i*)&dst[i + 4], vector);
+    }
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)&dst[i], vector);
+    }
+#elif defined(SPANS_WASM_SIMD)
+    v128_t vector = wasm_i32x4_splat((int)packed);
+    for (; i + 4 <= count; i += 4) {
+        wasm_v128_store(&dst[i], vector);
+    }
+#elif defined(SPANS_NEON)
+    uint32x4_t vector = vdupq_n_u32(packed);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u32((uint32_t*)&dst[i], vector);
+    }
+#endif
+    for (; i < count; i++) {
+        memcpy(&dst[i], &packed, sizeof(packed));
+    }
+}
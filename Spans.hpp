@@ -0,0 +1,11 @@
+#ifndef SPANS_INCLUDED
+#define SPANS_INCLUDED
+
+#include "Pixel.hpp"
+
+/*
+* Set count pixels starting at dst to value, using vector stores where available.
+*/
+void fillPixelSpan(Pixel* dst, Pixel value, int count);
+
+#endif
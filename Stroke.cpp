@@ -0,0 +1,310 @@
+#include "Stroke.hpp"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+// points further apart in time than this (in ms) aren't smoothed into each other,
+// since the mouse probably stopped and changed direction in between
+#define STROKE_SMOOTH_MAX_GAP 100
+// length of the straight pieces smoothed curves are drawn with, in canvas pixels
+#define STROKE_CURVE_STEP 2.0f
+
+static_assert(TILE_SIZE == 64, "stroke masks use one Uint64 per tile row");
+
+// slack for pixel centers landing exactly on the edge of a round brush,
+// so they're counted the same way as in getBrushRowSpan's exact integer test
+#define STROKE_EDGE_EPSILON 1e-7
+
+static void clearStrokeMask(StrokeMask* mask) {
+    for (size_t i = 0; i < mask->touchedTiles.size(); i++) {
+        int tileIndex = mask->touchedTiles[i];
+        free(mask->tileRows[tileIndex]);
+        mask->tileRows[tileIndex] = NULL;
+    }
+    mask->touchedTiles.clear();
+}
+
+void beginStrokeMask(StrokeMask* mask, const TileGrid* tiles, const SelectionMask* selection) {
+    clearStrokeMask(mask);
+    // a selection for a different size of canvas doesn't mean anything here
+    bool selectionFits = selection && selection->tilesX == tiles->tilesX && selection->tilesY == tiles->tilesY;
+    mask->selection = selectionFits ? selection : NULL;
+    mask->tilesX = tiles->tilesX;
+    mask->tilesY = tiles->tilesY;
+    mask->tileRows.assign((size_t)tiles->tilesX * tiles->tilesY, NULL);
+}
+
+void destroyStrokeMask(StrokeMask* mask) {
+    clearStrokeMask(mask);
+    mask->tileRows.clear();
+    mask->tilesX = 0;
+    mask->tilesY = 0;
+    mask->selection = NULL;
+}
+
+SDL_Rect getStrokeSegmentBounds(int size, int x0, int y0, int x1, int y1) {
+    int minX = std::min(x0, x1);
+    int minY = std::min(y0, y1);
+    return (SDL_Rect){minX, minY, std::max(x0, x1) + size - minX, std::max(y0, y1) + size - minY};
+}
+
+/*
+* Narrow [*tMin, *tMax] to the values of t where lo <= a*t + b <= hi.
+* @return false if nothing is left
+*/
+static bool clipLinear(double a, double b, double lo, double hi, double* tMin, double* tMax) {
+    if (a == 0.0) {
+        return b >= lo && b <= hi && *tMin <= *tMax;
+    }
+    double t0 = (lo - b) / a;
+    double t1 = (hi - b) / a;
+    if (t0 > t1) std::swap(t0, t1);
+    *tMin = std::max(*tMin, t0);
+    *tMax = std::min(*tMax, t1);
+    return *tMin <= *tMax;
+}
+
+/*
+* Get the x range of a circle on the horizontal line y.
+*/
+static bool getCircleRowRange(double centerX, double centerY, double radius, double y, double* minX, double* maxX) {
+    double dy = y - centerY;
+    double remaining = radius * radius - dy * dy;
+    if (remaining < 0) {
+        return false;
+    }
+    double halfWidth = sqrt(remaining);
+    *minX = centerX - halfWidth;
+    *maxX = centerX + halfWidth;
+    return true;
+}
+
+/*
+* Get the pixel columns of the swept area on the row of pixels at y.
+* @param start Set to the first covered column
+* @param end Set to one past the last covered column
+* @return false if the row isn't covered at all
+*/
+static bool getSweptRowSpan(BrushShape shape, int size, int x0, int y0, int x1, int y1, int y, int* start, int* end) {
+    double dx = x1 - x0;
+    double dy = y1 - y0;
+    double centerY = y + 0.5; // pixels are covered if their center is
+
+    if (shape == BRUSH_SQUARE || size <= 2) {
+        // the brush covers [x, x+size) x [y, y+size) with x,y moving along the segment at t from 0 to 1.
+        // find when it covers this row, then the row span is everywhere the brush was in that time
+        double tMin = 0.0, tMax = 1.0;
+        if (!clipLinear(dy, y0, centerY - size, centerY, &tMin, &tMax)) {
+            return false;
+        }
+        double leftX = std::min(x0 + dx * tMin, x0 + dx * tMax);
+        double rightX = std::max(x0 + dx * tMin, x0 + dx * tMax) + size;
+        *start = (int)ceil(leftX - 0.5);
+        *end = (int)ceil(rightX - 0.5);
+        return *start < *end;
+    }
+
+    // capsule: the two end circles plus the band between them.
+    // all three are convex and so is their union, so the row span is just the hull of each one's range
+    double radius = size / 2.0;
+    double ax = x0 + radius, ay = y0 + radius;
+    double bx = x1 + radius, by = y1 + radius;
+    double minX = INFINITY, maxX = -INFINITY;
+    double rangeMin, rangeMax;
+    if (getCircleRowRange(ax, ay, radius, centerY, &rangeMin, &rangeMax)) {
+        minX = std::min(minX, rangeMin);
+        maxX = std::max(maxX, rangeMax);
+    }
+    if (getCircleRowRange(bx, by, radius, centerY, &rangeMin, &rangeMax)) {
+        minX = std::min(minX, rangeMin);
+        maxX = std::max(maxX, rangeMax);
+    }
+    double lengthSquared = dx * dx + dy * dy;
+    if (lengthSquared > 0) {
+        // points in the band project onto the segment between its ends (0 <= t <= 1)
+        // and are at most radius away from the line. both of those are linear in x along the row
+        double length = sqrt(lengthSquared);
+        rangeMin = -INFINITY;
+        rangeMax = INFINITY;
+        if (clipLinear(dx / lengthSquared, (dy * (centerY - ay) - dx * ax) / lengthSquared, 0.0, 1.0, &rangeMin, &rangeMax) &&
+            clipLinear(-dy / length, (dx * (centerY - ay) + dy * ax) / length, -radius, radius, &rangeMin, &rangeMax)) {
+            minX = std::min(minX, rangeMin);
+            maxX = std::max(maxX, rangeMax);
+        }
+    }
+    if (minX > maxX) {
+        return false;
+    }
+    *start = (int)ceil(minX - 0.5 - STROKE_EDGE_EPSILON);
+    *end = (int)floor(maxX - 0.5 + STROKE_EDGE_EPSILON) + 1;
+    return *start < *end;
+}
+
+/*
+* Fill the parts of a span that are selected and not painted yet this stroke, and mark the whole span painted.
+* The span has to be inside one tile row.
+* @return The number of pixels written
+*/
+static int fillUnpaintedSpan(StrokeMask* mask, TileGrid* tiles, int x, int y, int length, BrushPaint paint) {
+    int tileIndex = (x >> TILE_SHIFT) + (y >> TILE_SHIFT) * mask->tilesX;
+    Uint64* rows = mask->tileRows[tileIndex];
+    if (!rows) {
+        rows = (Uint64*)calloc(TILE_SIZE, sizeof(Uint64));
+        if (!rows) {
+            SDL_Log("Error: Failed to allocate stroke mask.");
+            return 0;
+        }
+        mask->tileRows[tileIndex] = rows;
+        mask->touchedTiles.push_back(tileIndex);
+    }
+
+    int column = x & TILE_MASK;
+    Uint64 spanBits = (length == 64 ? ~(Uint64)0 : (((Uint64)1 << length) - 1)) << column;
+    Uint64* row = &rows[y & TILE_MASK];
+    Uint64 unpainted = spanBits & ~*row;
+    if (mask->selection) {
+        // a whole row of the tile gets checked at once
+        unpainted &= getSelectedRowBits(mask->selection, tileIndex, y);
+    }
+    *row |= spanBits;
+
+    // fill each run of unpainted pixels
+    int pixelsDrawn = 0;
+    while (unpainted) {
+        int runStart = __builtin_ctzll(unpainted);
+        Uint64 rest = ~(unpainted >> runStart);
+        int runLength = rest ? __builtin_ctzll(rest) : 64 - runStart;
+        fillTileGridSpan(tiles, (x & ~TILE_MASK) + runStart, y, runLength, paint);
+        pixelsDrawn += runLength;
+        if (runStart + runLength >= 64) break;
+        unpainted &= ~(Uint64)0 << (runStart + runLength);
+    }
+    return pixelsDrawn;
+}
+
+int drawStrokeSegment(StrokeMask* mask, TileGrid* tiles, BrushShape shape, int size, int x0, int y0, int x1, int y1, BrushPaint paint) {
+    if (mask->tilesX != tiles->tilesX || mask->tilesY != tiles->tilesY) {
+        // the canvas changed under the stroke
+        beginStrokeMask(mask, tiles, mask->selection);
+    }
+
+    SDL_Rect bounds = getStrokeSegmentBounds(size, x0, y0, x1, y1);
+    int clipX0 = std::max(bounds.x, 0);
+    int clipY0 = std::max(bounds.y, 0);
+    int clipX1 = std::min(bounds.x + bounds.w, tiles->width);
+    int clipY1 = std::min(bounds.y + bounds.h, tiles->height);
+
+    int pixelsDrawn = 0;
+    for (int y = clipY0; y < clipY1; y++) {
+        int spanStart, spanEnd;
+        if (!getSweptRowSpan(shape, size, x0, y0, x1, y1, y, &spanStart, &spanEnd)) continue;
+        spanStart = std::max(spanStart, clipX0);
+        spanEnd = std::min(spanEnd, clipX1);
+        // split at tile edges since the mask is per tile
+        int x = spanStart;
+        while (x < spanEnd) {
+            int tileSpanEnd = std::min((x | TILE_MASK) + 1, spanEnd);
+            pixelsDrawn += fillUnpaintedSpan(mask, tiles, x, y, tileSpanEnd - x, paint);
+            x = tileSpanEnd;
+        }
+    }
+    return pixelsDrawn;
+}
+
+void beginStrokePath(StrokePath* path, bool smooth) {
+    path->smooth = smooth;
+    path->numPoints = 0;
+    path->caughtUp = true;
+}
+
+static void drawStraight(StrokePoint from, StrokePoint to, const StrokeSegmentDrawer& drawSegment) {
+    drawSegment((int)floor(from.x), (int)floor(from.y), (int)floor(to.x), (int)floor(to.y));
+}
+
+/*
+* Draw the curve from p1 to p2, with p0 and p3 being the points before and after them.
+*/
+static void drawCatmullRom(StrokePoint p0, StrokePoint p1, StrokePoint p2, StrokePoint p3, const StrokeSegmentDrawer& drawSegment) {
+    float length = sqrtf((p2.x - p1.x) * (p2.x - p1.x) + (p2.y - p1.y) * (p2.y - p1.y));
+    int steps = std::max((int)ceilf(length / STROKE_CURVE_STEP), 1);
+    int lastX = (int)floor(p1.x);
+    int lastY = (int)floor(p1.y);
+    for (int i = 1; i <= steps; i++) {
+        float t = (float)i / steps;
+        float t2 = t * t;
+        float t3 = t2 * t;
+        // uniform Catmull-Rom basis
+        float w0 = -0.5f*t3 + t2 - 0.5f*t;
+        float w1 = 1.5f*t3 - 2.5f*t2 + 1.0f;
+        float w2 = -1.5f*t3 + 2.0f*t2 + 0.5f*t;
+        float w3 = 0.5f*t3 - 0.5f*t2;
+        int x = (int)floor(w0*p0.x + w1*p1.x + w2*p2.x + w3*p3.x);
+        int y = (int)floor(w0*p0.y + w1*p1.y + w2*p2.y + w3*p3.y);
+        if (x != lastX || y != lastY) {
+            drawSegment(lastX, lastY, x, y);
+            lastX = x;
+            lastY = y;
+        }
+    }
+}
+
+/*
+* Draw the segment between the two newest points, using next as the point after it.
+*/
+static void drawNewestSegment(StrokePath* path, StrokePoint next, const StrokeSegmentDrawer& drawSegment) {
+    StrokePoint from = path->points[path->numPoints - 2];
+    StrokePoint to = path->points[path->numPoints - 1];
+    StrokePoint before = path->numPoints >= 3 ? path->points[0] : from;
+    drawCatmullRom(before, from, to, next, drawSegment);
+    path->caughtUp = true;
+}
+
+void addStrokePoint(StrokePath* path, StrokePoint point, const StrokeSegmentDrawer& drawSegment) {
+    if (path->numPoints == 0) {
+        drawStraight(point, point, drawSegment);
+        path->points[0] = point;
+        path->numPoints = 1;
+        return;
+    }
+
+    StrokePoint last = path->points[path->numPoints - 1];
+    if (floor(point.x) == floor(last.x) && floor(point.y) == floor(last.y)) {
+        // didn't move to a new pixel, nothing to draw
+        return;
+    }
+
+    if (!path->smooth) {
+        drawStraight(last, point, drawSegment);
+        path->points[0] = point;
+        path->numPoints = 1;
+        return;
+    }
+
+    if (point.timestamp - last.timestamp > STROKE_SMOOTH_MAX_GAP) {
+        // start the curve over from the last point
+        flushStrokePath(path, drawSegment);
+        path->points[0] = last;
+        path->numPoints = 1;
+    } else if (!path->caughtUp) {
+        // now that the point after it is known, the waiting segment can be drawn
+        drawNewestSegment(path, point, drawSegment);
+    }
+
+    if (path->numPoints == 3) {
+        path->points[0] = path->points[1];
+        path->points[1] = path->points[2];
+        path->numPoints = 2;
+    }
+    path->points[path->numPoints++] = point;
+    path->caughtUp = false;
+}
+
+void flushStrokePath(StrokePath* path, const StrokeSegmentDrawer& drawSegment) {
+    if (path->caughtUp || path->numPoints < 2) {
+        return;
+    }
+    // no point after the end, so the curve just comes straight in to it
+    drawNewestSegment(path, path->points[path->numPoints - 1], drawSegment);
+}
@@ -0,0 +1,84 @@
+#ifndef STROKE_INCLUDED
+#define STROKE_INCLUDED
+
+#include <vector>
+#include <functional>
+
+#include <SDL2/SDL.h>
+
+#include "Pixel.hpp"
+#include "Tiles.hpp"
+#include "Brush.hpp"
+#include "Selection.hpp"
+
+/*
+* Which pixels a stroke has already painted, so overlapping segments of the same stroke
+* blend into each pixel exactly once, and translucent strokes don't build up where they cross themselves.
+* One bit per pixel, kept per tile and only allocated for tiles the stroke touches.
+*/
+struct StrokeMask {
+    int tilesX;
+    int tilesY;
+    std::vector<Uint64*> tileRows; // per tile, TILE_SIZE row bitmasks with bit n for column n. NULL if the tile hasn't been touched
+    std::vector<int> touchedTiles; // indices of the allocated entries in tileRows, so clearing is cheap
+    const SelectionMask* selection; // the stroke only paints pixels in it, NULL to paint anywhere
+};
+
+/*
+* Start a new stroke on tiles, forgetting everything painted by the last one.
+* @param selection Limits the stroke to the selected pixels, NULL if nothing's selected. Has to stay around until the stroke ends
+*/
+void beginStrokeMask(StrokeMask* mask, const TileGrid* tiles, const SelectionMask* selection);
+void destroyStrokeMask(StrokeMask* mask);
+
+/*
+* Get the rect a brush sweeps moving from x0,y0 to x1,y1. Positions are the brush's top left corner.
+*/
+SDL_Rect getStrokeSegmentBounds(int size, int x0, int y0, int x1, int y1);
+
+/*
+* Paint the area a brush sweeps moving in a straight line from x0,y0 to x1,y1 (a capsule for round brushes,
+* a swept rectangle for square ones), skipping pixels already painted in this stroke and pixels outside the selection.
+* Every row of the swept area is worked out directly and filled as one span, instead of stamping the brush along the line.
+* A segment from a point to itself covers just the brush, the pixels getBrushRowSpan gives for each of its rows.
+* @return The number of pixels written
+*/
+int drawStrokeSegment(StrokeMask* mask, TileGrid* tiles, BrushShape shape, int size, int x0, int y0, int x1, int y1, BrushPaint paint);
+
+/*
+* A point on a stroke, in canvas coordinates, with the time it was input (SDL ticks).
+*/
+struct StrokePoint {
+    float x;
+    float y;
+    Uint32 timestamp;
+};
+
+// draws a straight line of the stroke between two brush positions
+typedef std::function<void(int fromX, int fromY, int toX, int toY)> StrokeSegmentDrawer;
+
+/*
+* Turns the points of a stroke into straight segments to draw, optionally smoothing them into a Catmull-Rom curve.
+* A smoothed segment can't be drawn until the point after it is known, so the newest segment waits
+* for the next point or for flushStrokePath.
+*/
+struct StrokePath {
+    bool smooth;
+    StrokePoint points[3]; // the newest points, oldest first
+    int numPoints;
+    bool caughtUp; // whether everything up to the newest point has been drawn
+};
+
+void beginStrokePath(StrokePath* path, bool smooth);
+
+/*
+* Add the next point of the stroke, drawing whatever segments can be drawn now.
+*/
+void addStrokePoint(StrokePath* path, StrokePoint point, const StrokeSegmentDrawer& drawSegment);
+
+/*
+* Draw up to the newest point without waiting for the next one, like when the mouse stops or the stroke ends.
+*/
+void flushStrokePath(StrokePath* path, const StrokeSegmentDrawer& drawSegment);
+
+#endif
@@ -0,0 +1,111 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(int numWorkers) {
+    mutex = SDL_CreateMutex();
+    workAvailable = SDL_CreateCond();
+    workFinished = SDL_CreateCond();
+    job = NULL;
+    jobCount = 0;
+    nextIndex = 0;
+    indicesDone = 0;
+    jobGeneration = 0;
+    quitting = false;
+
+    if (numWorkers < 0) {
+        numWorkers = SDL_GetCPUCount() - 1;
+    }
+    if (!mutex || !workAvailable || !workFinished) {
+        // no way to synchronize, stay single threaded
+        numWorkers = 0;
+    }
+    for (int i = 0; i < numWorkers; i++) {
+        SDL_Thread* thread = SDL_CreateThread(workerMain, "pool worker", this);
+        if (!thread) {
+            // probably a build without thread support, just use what we got
+            break;
+        }
+        workers.push_back(thread);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    if (mutex) {
+        SDL_LockMutex(mutex);
+        quitting = true;
+        SDL_CondBroadcast(workAvailable);
+        SDL_UnlockMutex(mutex);
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        SDL_WaitThread(workers[i], NULL);
+    }
+    if (workFinished) SDL_DestroyCond(workFinished);
+    if (workAvailable) SDL_DestroyCond(workAvailable);
+    if (mutex) SDL_DestroyMutex(mutex);
+}
+
+void ThreadPool::runJobIndices() {
+    while (job && nextIndex < jobCount) {
+        int index = nextIndex++;
+        const std::function<void(int)>* func = job;
+        SDL_UnlockMutex(mutex);
+        (*func)(index);
+        SDL_LockMutex(mutex);
+        indicesDone++;
+        if (indicesDone == jobCount) {
+            SDL_CondBroadcast(workFinished);
+        }
+    }
+}
+
+int ThreadPool::workerMain(void* param) {
+    ThreadPool* pool = (ThreadPool*)param;
+    Uint32 lastGeneration = 0;
+
+    SDL_LockMutex(pool->mutex);
+    while (!pool->quitting) {
+        if (pool->jobGeneration == lastGeneration) {
+            SDL_CondWait(pool->workAvailable, pool->mutex);
+            continue;
+        }
+        lastGeneration = pool->jobGeneration;
+        pool->runJobIndices();
+    }
+    SDL_UnlockMutex(pool->mutex);
+    return 0;
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& func) {
+    if (count <= 0) {
+        return;
+    }
+    if (workers.empty() || count == 1) {
+        for (int i = 0; i < count; i++) {
+            func(i);
+        }
+        return;
+    }
+
+    SDL_LockMutex(mutex);
+    job = &func;
+    jobCount = count;
+    nextIndex = 0;
+    indicesDone = 0;
+    jobGeneration++;
+    SDL_CondBroadcast(workAvailable);
+
+    // help out instead of just waiting
+    runJobIndices();
+    while (indicesDone < jobCount) {
+        SDL_CondWait(workFinished, mutex);
+    }
+    job = NULL;
+    SDL_UnlockMutex(mutex);
+}
+
+ThreadPool* getThreadPool() {
+    static ThreadPool* pool = NULL;
+    if (!pool) {
+        pool = new ThreadPool();
+    }
+    return pool;
+}
@@ -0,0 +1,56 @@
+#ifndef THREAD_POOL_INCLUDED
+#define THREAD_POOL_INCLUDED
+
+#include <vector>
+#include <functional>
+
+#include <SDL2/SDL.h>
+
+/*
+* A fixed set of worker threads for splitting big loops (pixel conversion, compositing, etc.) into parallel chunks.
+* Uses SDL threads so it builds everywhere SDL does. If threads can't be created (e.g. emscripten without pthreads),
+* the pool just has no workers and everything runs on the calling thread.
+*/
+class ThreadPool {
+public:
+    /*
+    * @param numWorkers The number of worker threads to start. Negative means one less than the CPU count,
+    * since the calling thread also does work in parallelFor.
+    */
+    ThreadPool(int numWorkers = -1);
+    ~ThreadPool();
+
+    /*
+    * Call func(i) for every i in [0, count), spread over the worker threads and the calling thread.
+    * Blocks until every call has returned. Not reentrant, don't call parallelFor from inside func.
+    */
+    void parallelFor(int count, const std::function<void(int)>& func);
+
+    int numWorkers() const {
+        return (int)workers.size();
+    }
+
+private:
+    std::vector<SDL_Thread*> workers;
+    SDL_mutex* mutex;
+    SDL_cond* workAvailable;
+    SDL_cond* workFinished;
+
+    // current job, guarded by mutex
+    const std::function<void(int)>* job;
+    int jobCount;
+    int nextIndex;
+    int indicesDone;
+    Uint32 jobGeneration;
+    bool quitting;
+
+    void runJobIndices(); // expects mutex to be locked, returns with it locked
+    static int workerMain(void* pool);
+};
+
+/*
+* The thread pool shared by the whole app, created on first use.
+*/
+ThreadPool* getThreadPool();
+
+#endif
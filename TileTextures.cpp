@@ -0,0 +1,235 @@
+#include "TileTextures.hpp"
+
+#include <stdlib.h>
+#include <vector>
+
+#include "Pixel.hpp"
+#include "ThreadPool.hpp"
+
+// don't bother with the thread pool for converting fewer tiles than this in a frame
+#define PARALLEL_UPLOAD_MIN_TILES 16
+// max tiles to convert ahead of time per frame, limits the size of the staging buffer
+#define MAX_STAGED_TILES 256
+
+int initTileTextureCache(TileTextureCache* cache, SDL_Renderer* renderer, const TileGrid* tiles, size_t vramBudget) {
+    cache->renderer = renderer;
+    cache->tilesX = tiles->tilesX;
+    cache->tilesY = tiles->tilesY;
+    cache->lruHead = -1;
+    cache->lruTail = -1;
+    cache->vramBudget = vramBudget;
+    cache->vramUsed = 0;
+
+    int numTiles = tiles->tilesX * tiles->tilesY;
+    cache->entries = (TileTextureEntry*)malloc(numTiles * sizeof(TileTextureEntry));
+    if (!cache->entries) {
+        SDL_Log("Error: Failed to allocate tile texture cache.");
+        return -1;
+    }
+    for (int i = 0; i < numTiles; i++) {
+        cache->entries[i].texture = NULL;
+        cache->entries[i].dirty = true;
+        cache->entries[i].lruPrev = -1;
+        cache->entries[i].lruNext = -1;
+    }
+    return 0;
+}
+
+void destroyTileTextureCache(TileTextureCache* cache) {
+    if (!cache->entries) {
+        return;
+    }
+    int numTiles = cache->tilesX * cache->tilesY;
+    for (int i = 0; i < numTiles; i++) {
+        if (cache->entries[i].texture) {
+            SDL_DestroyTexture(cache->entries[i].texture);
+        }
+    }
+    free(cache->entries);
+    cache->entries = NULL;
+    cache->vramUsed = 0;
+}
+
+static void lruRemove(TileTextureCache* cache, int index) {
+    TileTextureEntry* entry = &cache->entries[index];
+    if (entry->lruPrev != -1) {
+        cache->entries[entry->lruPrev].lruNext = entry->lruNext;
+    } else {
+        cache->lruHead = entry->lruNext;
+    }
+    if (entry->lruNext != -1) {
+        cache->entries[entry->lruNext].lruPrev = entry->lruPrev;
+    } else {
+        cache->lruTail = entry->lruPrev;
+    }
+    entry->lruPrev = -1;
+    entry->lruNext = -1;
+}
+
+static void lruPushFront(TileTextureCache* cache, int index) {
+    TileTextureEntry* entry = &cache->entries[index];
+    entry->lruPrev = -1;
+    entry->lruNext = cache->lruHead;
+    if (cache->lruHead != -1) {
+        cache->entries[cache->lruHead].lruPrev = index;
+    } else {
+        cache->lruTail = index;
+    }
+    cache->lruHead = index;
+}
+
+/*
+* Take the texture away from a tile, either to destroy it or give it to another tile.
+*/
+static SDL_Texture* takeTexture(TileTextureCache* cache, int index) {
+    TileTextureEntry* entry = &cache->entries[index];
+    SDL_Texture* texture = entry->texture;
+    if (texture) {
+        lruRemove(cache, index);
+        entry->texture = NULL;
+        entry->dirty = true;
+    }
+    return texture;
+}
+
+static void freeTexture(TileTextureCache* cache, int index) {
+    SDL_Texture* texture = takeTexture(cache, index);
+    if (texture) {
+        SDL_DestroyTexture(texture);
+        cache->vramUsed -= TILE_TEXTURE_BYTES;
+    }
+}
+
+void setTileTextureBudget(TileTextureCache* cache, size_t vramBudget) {
+    cache->vramBudget = vramBudget;
+    while (cache->vramUsed > cache->vramBudget && cache->lruTail != -1) {
+        freeTexture(cache, cache->lruTail);
+    }
+}
+
+void invalidateTileTextures(TileTextureCache* cache, const TileGrid* tiles, SDL_Rect rect) {
+    int firstTileX, firstTileY, lastTileX, lastTileY;
+    if (!getTileRange(tiles, rect, &firstTileX, &firstTileY, &lastTileX, &lastTileY)) {
+        return;
+    }
+    for (int tileY = firstTileY; tileY <= lastTileY; tileY++) {
+        for (int tileX = firstTileX; tileX <= lastTileX; tileX++) {
+            cache->entries[tileX + tileY * cache->tilesX].dirty = true;
+        }
+    }
+}
+
+/*
+* Get a texture for the tile at index, creating one if there's room in the budget,
+* otherwise taking the one of the least recently used tile.
+* Taking a texture that was already drawn this frame is fine, SDL flushes queued
+* draws using a texture before it gets updated.
+*/
+static SDL_Texture* acquireTexture(TileTextureCache* cache, int index) {
+    TileTextureEntry* entry = &cache->entries[index];
+    if (entry->texture) {
+        // move to the front of the LRU list
+        lruRemove(cache, index);
+        lruPushFront(cache, index);
+        return entry->texture;
+    }
+
+    SDL_Texture* texture = NULL;
+    if (cache->vramUsed + TILE_TEXTURE_BYTES > cache->vramBudget && cache->lruTail != -1) {
+        texture = takeTexture(cache, cache->lruTail);
+    } else {
+        texture = SDL_CreateTexture(cache->renderer, SDL_PIXELFORMAT, SDL_TEXTUREACCESS_STREAMING, TILE_SIZE, TILE_SIZE);
+        if (!texture) {
+            SDL_Log("Error: Failed to create tile texture. SDL_Error: %s", SDL_GetError());
+            return NULL;
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        cache->vramUsed += TILE_TEXTURE_BYTES;
+    }
+
+    entry->texture = texture;
+    entry->dirty = true;
+    lruPushFront(cache, index);
+    return texture;
+}
+
+static void convertTile(const Tile* tile, Uint32* dst) {
+    convertPixelsToRGBA8888(tile->pixels, dst, TILE_PIXELS);
+}
+
+void renderTileGrid(TileTextureCache* cache, const TileGrid* tiles, SDL_Rect srcRect, SDL_Rect dstRect) {
+    int firstTileX, firstTileY, lastTileX, lastTileY;
+    if (srcRect.w <= 0 || srcRect.h <= 0 || !getTileRange(tiles, srcRect, &firstTileX, &firstTileY, &lastTileX, &lastTileY)) {
+        return;
+    }
+
+    // find the visible tiles that will need uploading, so they can be converted in parallel up front
+    std::vector<int> staged;
+    for (int tileY = firstTileY; tileY <= lastTileY && staged.size() < MAX_STAGED_TILES; tileY++) {
+        for (int tileX = firstTileX; tileX <= lastTileX && staged.size() < MAX_STAGED_TILES; tileX++) {
+            int index = tileX + tileY * cache->tilesX;
+            // getting the tile also loads it if it's still pending, so only visible tiles get loaded
+            if (getTileAtIndex(tiles, index) && (!cache->entries[index].texture || cache->entries[index].dirty)) {
+                staged.push_back(index);
+            }
+        }
+    }
+    std::vector<Uint32> staging;
+    if (staged.size() >= PARALLEL_UPLOAD_MIN_TILES) {
+        staging.resize(staged.size() * TILE_PIXELS);
+        getThreadPool()->parallelFor((int)staged.size(), [&](int i) {
+            convertTile(tiles->tiles[staged[i]], &staging[i * TILE_PIXELS]);
+        });
+    } else {
+        staged.clear();
+    }
+    size_t nextStaged = 0;
+
+    Uint32 tileBuffer[TILE_PIXELS];
+    for (int tileY = firstTileY; tileY <= lastTileY; tileY++) {
+        for (int tileX = firstTileX; tileX <= lastTileX; tileX++) {
+            int index = tileX + tileY * cache->tilesX;
+            const Tile* tile = getTileAtIndex(tiles, index);
+            if (!tile) {
+                // nothing to draw, and the texture isn't needed anymore if it had one
+                freeTexture(cache, index);
+                continue;
+            }
+
+            const Uint32* stagedPixels = NULL;
+            if (nextStaged < staged.size() && staged[nextStaged] == index) {
+                stagedPixels = &staging[nextStaged * TILE_PIXELS];
+                nextStaged++;
+            }
+
+            SDL_Texture* texture = acquireTexture(cache, index);
+            if (!texture) {
+                continue;
+            }
+            TileTextureEntry* entry = &cache->entries[index];
+            if (entry->dirty) {
+                if (!stagedPixels) {
+                    convertTile(tile, tileBuffer);
+                    stagedPixels = tileBuffer;
+                }
+                SDL_UpdateTexture(texture, NULL, stagedPixels, TILE_SIZE * sizeof(Uint32));
+                entry->dirty = false;
+            }
+
+            // visible part of the tile in canvas pixels
+            SDL_Rect tileRect = {tileX << TILE_SHIFT, tileY << TILE_SHIFT, TILE_SIZE, TILE_SIZE};
+            SDL_Rect area;
+            SDL_IntersectRect(&tileRect, &srcRect, &area);
+
+            // map the edges separately so neighbouring tiles meet exactly, without gaps
+            int dstX0 = dstRect.x + (int)((long long)(area.x - srcRect.x) * dstRect.w / srcRect.w);
+            int dstX1 = dstRect.x + (int)((long long)(area.x + area.w - srcRect.x) * dstRect.w / srcRect.w);
+            int dstY0 = dstRect.y + (int)((long long)(area.y - srcRect.y) * dstRect.h / srcRect.h);
+            int dstY1 = dstRect.y + (int)((long long)(area.y + area.h - srcRect.y) * dstRect.h / srcRect.h);
+
+            SDL_Rect src = {area.x - tileRect.x, area.y - tileRect.y, area.w, area.h};
+            SDL_Rect dst = {dstX0, dstY0, dstX1 - dstX0, dstY1 - dstY0};
+            SDL_RenderCopy(cache->renderer, texture, &src, &dst);
+        }
+    }
+}
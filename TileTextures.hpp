@@ -0,0 +1,60 @@
+#ifndef TILE_TEXTURES_INCLUDED
+#define TILE_TEXTURES_INCLUDED
+
+#include <stddef.h>
+#include <SDL2/SDL.h>
+
+#include "Tiles.hpp"
+
+// bytes of video memory used by one tile texture
+#define TILE_TEXTURE_BYTES (TILE_PIXELS * 4)
+
+struct TileTextureEntry {
+    SDL_Texture* texture; // NULL if the tile doesn't have a texture right now
+    bool dirty; // the tile changed since the texture was last uploaded
+    int lruPrev; // neighbours in the LRU list, -1 for none
+    int lruNext;
+};
+
+/*
+* GPU textures for the tiles of a TileGrid, one TILE_SIZE texture per tile.
+* Textures are only created for tiles that actually get drawn, and once the VRAM budget is used up
+* the least recently drawn tile gives up its texture. Transparent tiles never get a texture.
+*/
+struct TileTextureCache {
+    SDL_Renderer* renderer;
+    int tilesX;
+    int tilesY;
+    TileTextureEntry* entries; // one per tile, same layout as TileGrid::tiles
+
+    // only tiles with a texture are in the LRU list
+    int lruHead; // most recently used
+    int lruTail; // least recently used
+
+    size_t vramBudget; // max bytes worth of textures to keep around
+    size_t vramUsed;
+};
+
+/*
+* @return 0 on success, -1 on allocation failure
+*/
+int initTileTextureCache(TileTextureCache* cache, SDL_Renderer* renderer, const TileGrid* tiles, size_t vramBudget);
+void destroyTileTextureCache(TileTextureCache* cache);
+
+/*
+* Change the VRAM budget, evicting textures right away if the cache is over the new budget.
+*/
+void setTileTextureBudget(TileTextureCache* cache, size_t vramBudget);
+
+/*
+* Mark the textures of the tiles touching rect (in pixels) as needing to be re-uploaded.
+*/
+void invalidateTileTextures(TileTextureCache* cache, const TileGrid* tiles, SDL_Rect rect);
+
+/*
+* Draw the part of the grid inside srcRect (in pixels) to dstRect on the current render target.
+* Only tiles intersecting srcRect are touched, getting a texture and uploading if needed.
+*/
+void renderTileGrid(TileTextureCache* cache, const TileGrid* tiles, SDL_Rect srcRect, SDL_Rect dstRect);
+
+#endif
@@ -0,0 +1,278 @@
+#include "Tiles.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+Tile* createTile() {
+    Tile* tile = (Tile*)calloc(1, sizeof(Tile));
+    if (!tile) {
+        SDL_Log("Error: Failed to allocate canvas tile.");
+        return NULL;
+    }
+    SDL_AtomicSet(&tile->refCount, 1);
+    return tile;
+}
+
+Tile* retainTile(Tile* tile) {
+    if (tile) {
+        SDL_AtomicIncRef(&tile->refCount);
+    }
+    return tile;
+}
+
+void releaseTile(Tile* tile) {
+    if (tile && SDL_AtomicDecRef(&tile->refCount)) {
+        free(tile);
+    }
+}
+
+int initTileGrid(TileGrid* grid, int width, int height) {
+    grid->width = width;
+    grid->height = height;
+    grid->tilesX = (width + TILE_SIZE - 1) >> TILE_SHIFT;
+    grid->tilesY = (height + TILE_SIZE - 1) >> TILE_SHIFT;
+    grid->source = NULL;
+    grid->pending = NULL;
+    // all NULL, so everything starts out transparent
+    grid->tiles = (Tile**)calloc((size_t)grid->tilesX * grid->tilesY, sizeof(Tile*));
+    if (!grid->tiles) {
+        SDL_Log("Error: Failed to allocate tile grid of %dx%d tiles.", grid->tilesX, grid->tilesY);
+        grid->tilesX = 0;
+        grid->tilesY = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void destroyTileGrid(TileGrid* grid) {
+    if (!grid->tiles) {
+        return;
+    }
+    int numTiles = grid->tilesX * grid->tilesY;
+    for (int i = 0; i < numTiles; i++) {
+        releaseTile(grid->tiles[i]);
+    }
+    free(grid->tiles);
+    grid->tiles = NULL;
+    free(grid->pending);
+    grid->pending = NULL;
+    if (grid->source) {
+        grid->source->release();
+        grid->source = NULL;
+    }
+}
+
+int setTileGridSource(TileGrid* grid, TileSource* source, const Uint8* pendingTiles) {
+    size_t numTiles = (size_t)grid->tilesX * grid->tilesY;
+    Uint8* pending = (Uint8*)malloc(numTiles);
+    if (!pending) {
+        source->release();
+        return -1;
+    }
+    memcpy(pending, pendingTiles, numTiles);
+
+    free(grid->pending);
+    if (grid->source) {
+        grid->source->release();
+    }
+    grid->source = source;
+    grid->pending = pending;
+    return 0;
+}
+
+Tile* loadPendingTile(const TileGrid* grid, int index) {
+    // the tile counts as loaded even if this fails, so a broken tile is transparent instead of retried forever
+    grid->pending[index] = 0;
+    Tile* tile = createTile();
+    if (!tile) {
+        return NULL;
+    }
+    if (!grid->source->loadTile(index, tile->pixels)) {
+        SDL_Log("Error: Failed to load tile %d.", index);
+        releaseTile(tile);
+        return NULL;
+    }
+    grid->tiles[index] = tile;
+    return tile;
+}
+
+void loadAllPendingTiles(TileGrid* grid) {
+    if (!grid->pending) {
+        return;
+    }
+    int numTiles = grid->tilesX * grid->tilesY;
+    for (int i = 0; i < numTiles; i++) {
+        getTileAtIndex(grid, i);
+    }
+    free(grid->pending);
+    grid->pending = NULL;
+    grid->source->release();
+    grid->source = NULL;
+}
+
+int copyTileGrid(TileGrid* dst, const TileGrid* src) {
+    if (initTileGrid(dst, src->width, src->height)) {
+        return -1;
+    }
+    int numTiles = src->tilesX * src->tilesY;
+    for (int i = 0; i < numTiles; i++) {
+        dst->tiles[i] = retainTile(src->tiles[i]);
+    }
+    // tiles that haven't been loaded yet are shared too, each copy loads them on its own
+    if (src->pending && setTileGridSource(dst, src->source->retain(), src->pending)) {
+        destroyTileGrid(dst);
+        return -1;
+    }
+    return 0;
+}
+
+Pixel* getWritableTilePixels(TileGrid* grid, int tileX, int tileY) {
+    int index = tileX + tileY * grid->tilesX;
+    Tile* tile = getTileAtIndex(grid, index);
+    Tile** slot = &grid->tiles[index];
+    if (!tile) {
+        tile = createTile();
+        if (!tile) return NULL;
+        *slot = tile;
+    } else if (SDL_AtomicGet(&tile->refCount) > 1) {
+        // shared with another grid, so make our own copy before changing it
+        Tile* copy = createTile();
+        if (!copy) return NULL;
+        memcpy(copy->pixels, tile->pixels, sizeof(copy->pixels));
+        releaseTile(tile);
+        tile = copy;
+        *slot = tile;
+    }
+    return tile->pixels;
+}
+
+void setPixel(TileGrid* grid, int x, int y, Pixel pixel) {
+    Pixel* tilePixels;
+    if (pixel.a == 0 && !getTile(grid, x >> TILE_SHIFT, y >> TILE_SHIFT)) {
+        // already transparent, don't allocate a tile for nothing
+        return;
+    }
+    tilePixels = getWritableTilePixels(grid, x >> TILE_SHIFT, y >> TILE_SHIFT);
+    if (!tilePixels) {
+        return;
+    }
+    tilePixels[(x & TILE_MASK) + (y & TILE_MASK) * TILE_SIZE] = pixel;
+}
+
+bool getTileRange(const TileGrid* grid, SDL_Rect rect, int* firstTileX, int* firstTileY, int* lastTileX, int* lastTileY) {
+    SDL_Rect bounds = {0, 0, grid->width, grid->height};
+    SDL_Rect clipped;
+    if (!SDL_IntersectRect(&rect, &bounds, &clipped)) {
+        return false;
+    }
+    *firstTileX = clipped.x >> TILE_SHIFT;
+    *firstTileY = clipped.y >> TILE_SHIFT;
+    *lastTileX = (clipped.x + clipped.w - 1) >> TILE_SHIFT;
+    *lastTileY = (clipped.y + clipped.h - 1) >> TILE_SHIFT;
+    return true;
+}
+
+void readTileGridRect(const TileGrid* grid, SDL_Rect rect, Pixel* dst, int dstPitch) {
+    for (int y = rect.y; y < rect.y + rect.h; y++) {
+        Pixel* dstRow = (Pixel*)((Uint8*)dst + (y - rect.y) * dstPitch);
+        int x = rect.x;
+        while (x < rect.x + rect.w) {
+            // copy up to the end of the tile or the rect, whichever comes first
+            int spanEnd = std::min((x | TILE_MASK) + 1, rect.x + rect.w);
+            int spanLength = spanEnd - x;
+            const Tile* tile = getTile(grid, x >> TILE_SHIFT, y >> TILE_SHIFT);
+            if (tile) {
+                memcpy(&dstRow[x - rect.x], &tile->pixels[(x & TILE_MASK) + (y & TILE_MASK) * TILE_SIZE], spanLength * sizeof(Pixel));
+            } else {
+                memset(&dstRow[x - rect.x], 0, spanLength * sizeof(Pixel));
+            }
+            x = spanEnd;
+        }
+    }
+}
+
+static bool isSpanTransparent(const Pixel* pixels, int count) {
+    for (int i = 0; i < count; i++) {
+        if (pixels[i].a != 0) return false;
+    }
+    return true;
+}
+
+static bool isSpanZero(const Pixel* pixels, int count) {
+    for (int i = 0; i < count; i++) {
+        if (pixels[i].r | pixels[i].g | pixels[i].b | pixels[i].a) return false;
+    }
+    return true;
+}
+
+void writeTileGridRect(TileGrid* grid, SDL_Rect rect, const Pixel* src, int srcPitch) {
+    int firstTileX, firstTileY, lastTileX, lastTileY;
+    if (!getTileRange(grid, rect, &firstTileX, &firstTileY, &lastTileX, &lastTileY)) {
+        return;
+    }
+    // go tile by tile so we can tell whether a tile would be all transparent before allocating it
+    for (int tileY = firstTileY; tileY <= lastTileY; tileY++) {
+        for (int tileX = firstTileX; tileX <= lastTileX; tileX++) {
+            SDL_Rect tileRect = {tileX << TILE_SHIFT, tileY << TILE_SHIFT, TILE_SIZE, TILE_SIZE};
+            SDL_Rect area;
+            SDL_IntersectRect(&tileRect, &rect, &area);
+
+            const Pixel* areaSrc = (const Pixel*)((const Uint8*)src + (area.y - rect.y) * srcPitch) + (area.x - rect.x);
+            if (!getTile(grid, tileX, tileY)) {
+                bool transparent = true;
+                for (int y = 0; y < area.h && transparent; y++) {
+                    transparent = isSpanTransparent((const Pixel*)((const Uint8*)areaSrc + y * srcPitch), area.w);
+                }
+                if (transparent) continue;
+            }
+
+            Pixel* tilePixels = getWritableTilePixels(grid, tileX, tileY);
+            if (!tilePixels) continue;
+            for (int y = 0; y < area.h; y++) {
+                memcpy(&tilePixels[(area.x & TILE_MASK) + ((area.y + y) & TILE_MASK) * TILE_SIZE],
+                    (const Uint8*)areaSrc + y * srcPitch, area.w * sizeof(Pixel));
+            }
+        }
+    }
+}
+
+void shareTileGridRect(TileGrid* dst, const TileGrid* src, SDL_Rect rect) {
+    int firstTileX, firstTileY, lastTileX, lastTileY;
+    if (!getTileRange(dst, rect, &firstTileX, &firstTileY, &lastTileX, &lastTileY)) {
+        return;
+    }
+    for (int tileY = firstTileY; tileY <= lastTileY; tileY++) {
+        for (int tileX = firstTileX; tileX <= lastTileX; tileX++) {
+            int index = tileX + tileY * dst->tilesX;
+            Tile* tile = retainTile(getTileAtIndex(src, index));
+            if (dst->pending) {
+                // replaced before it was ever loaded
+                dst->pending[index] = 0;
+            }
+            releaseTile(dst->tiles[index]);
+            dst->tiles[index] = tile;
+        }
+    }
+}
+
+int releaseTransparentTiles(TileGrid* grid, SDL_Rect rect) {
+    int firstTileX, firstTileY, lastTileX, lastTileY;
+    if (!getTileRange(grid, rect, &firstTileX, &firstTileY, &lastTileX, &lastTileY)) {
+        return 0;
+    }
+    int tilesFreed = 0;
+    for (int tileY = firstTileY; tileY <= lastTileY; tileY++) {
+        for (int tileX = firstTileX; tileX <= lastTileX; tileX++) {
+            int index = tileX + tileY * grid->tilesX;
+            Tile** slot = &grid->tiles[index];
+            // only completely zeroed tiles are freed, so that freeing never changes what a tile reads back as
+            if (getTileAtIndex(grid, index) && isSpanZero((*slot)->pixels, TILE_PIXELS)) {
+                releaseTile(*slot);
+                *slot = NULL;
+                tilesFreed++;
+            }
+        }
+    }
+    return tilesFreed;
+}
@@ -0,0 +1,180 @@
+#ifndef TILES_INCLUDED
+#define TILES_INCLUDED
+
+#include <SDL2/SDL.h>
+
+#include "Pixel.hpp"
+
+#define TILE_SHIFT 6
+#define TILE_SIZE (1 << TILE_SHIFT) // width and height of a tile in pixels
+#define TILE_MASK (TILE_SIZE - 1)
+#define TILE_PIXELS (TILE_SIZE * TILE_SIZE)
+
+/*
+* A TILE_SIZE x TILE_SIZE block of pixels. Tiles are reference counted so that copies of a grid
+* (for saving, undo history, etc.) can share them, and are copied on write when shared.
+*/
+struct Tile {
+    SDL_atomic_t refCount;
+    Pixel pixels[TILE_PIXELS]; // row major, TILE_SIZE pixels per row
+};
+
+/*
+* Somewhere tiles can be loaded from on demand, like a project file.
+* Shared between grids copied from the same grid, so it's reference counted.
+*/
+class TileSource {
+public:
+    TileSource() {
+        SDL_AtomicSet(&refCount, 1);
+    }
+    virtual ~TileSource() {}
+
+    /*
+    * Load the tile at index into pixels. Called from whatever thread first needs the tile,
+    * so this must be safe to call from multiple threads at once.
+    * @return false if the tile couldn't be loaded
+    */
+    virtual bool loadTile(int tileIndex, Pixel* pixels) = 0;
+
+    TileSource* retain() {
+        SDL_AtomicIncRef(&refCount);
+        return this;
+    }
+    void release() {
+        if (SDL_AtomicDecRef(&refCount)) {
+            delete this;
+        }
+    }
+
+private:
+    SDL_atomic_t refCount;
+};
+
+/*
+* Sparse pixel storage split into tiles. Tiles that are fully transparent don't need to be allocated,
+* they're just NULL in the tiles array. So memory only grows with the area that's actually been drawn on.
+*/
+struct TileGrid {
+    int width; // in pixels
+    int height;
+    int tilesX; // number of tile columns
+    int tilesY; // number of tile rows
+    Tile** tiles; // tilesX * tilesY tile pointers, row major, NULL for a transparent tile
+
+    // tiles not loaded yet, they get loaded from source the first time they're accessed.
+    // both NULL if every tile is loaded
+    TileSource* source;
+    Uint8* pending; // one flag per tile, nonzero if the tile still has to be loaded from source
+};
+
+Tile* createTile();
+Tile* retainTile(Tile* tile);
+/*
+* Drop a reference to the tile, freeing it if it was the last one. Safe to call from any thread.
+*/
+void releaseTile(Tile* tile);
+
+/*
+* Initialize an empty (fully transparent) grid. No tiles are allocated.
+* @return 0 on success, -1 if the tile array couldn't be allocated
+*/
+int initTileGrid(TileGrid* grid, int width, int height);
+void destroyTileGrid(TileGrid* grid);
+
+/*
+* Make the grid load its tiles lazily from source. Every tile with a nonzero entry in pendingTiles will be loaded
+* the first time it's accessed, the rest stay transparent. Takes over the reference to source.
+* @param pendingTiles One flag per tile, copied
+* @return 0 on success, -1 on allocation failure
+*/
+int setTileGridSource(TileGrid* grid, TileSource* source, const Uint8* pendingTiles);
+
+/*
+* Load a tile that hasn't been loaded from the grid's source yet. Use getTile instead of calling this directly.
+*/
+Tile* loadPendingTile(const TileGrid* grid, int index);
+
+/*
+* Load every tile that hasn't been loaded yet, so the grid no longer depends on its source.
+*/
+void loadAllPendingTiles(TileGrid* grid);
+
+/*
+* Make dst a copy of src, sharing all of its tiles. Tiles will be copied once either grid writes to them.
+* dst should not be initialized already.
+* @return 0 on success, -1 on allocation failure
+*/
+int copyTileGrid(TileGrid* dst, const TileGrid* src);
+
+/*
+* Get a tile by its index in the tiles array, loading it first if it's pending.
+* @return The tile, or NULL if it's transparent
+*/
+inline Tile* getTileAtIndex(const TileGrid* grid, int index) {
+    if (grid->pending && grid->pending[index]) {
+        return loadPendingTile(grid, index);
+    }
+    return grid->tiles[index];
+}
+
+inline Tile* getTile(const TileGrid* grid, int tileX, int tileY) {
+    return getTileAtIndex(grid, tileX + tileY * grid->tilesX);
+}
+
+/*
+* Get the pixels of a tile to write to, allocating the tile if it was transparent
+* and copying it if it's shared with another grid.
+* @return The tile pixels or NULL if a tile couldn't be allocated.
+*/
+Pixel* getWritableTilePixels(TileGrid* grid, int tileX, int tileY);
+
+/*
+* Get a pixel. Coordinates must be in bounds.
+*/
+inline Pixel getPixel(const TileGrid* grid, int x, int y) {
+    const Tile* tile = getTile(grid, x >> TILE_SHIFT, y >> TILE_SHIFT);
+    if (!tile) {
+        return (Pixel){0, 0, 0, 0};
+    }
+    return tile->pixels[(x & TILE_MASK) + (y & TILE_MASK) * TILE_SIZE];
+}
+
+/*
+* Set a pixel. Coordinates must be in bounds.
+*/
+void setPixel(TileGrid* grid, int x, int y, Pixel pixel);
+
+/*
+* Copy a rectangle of pixels out of the grid into a flat buffer. The rect must be inside the grid.
+* @param dstPitch The length of a row of dst in bytes
+*/
+void readTileGridRect(const TileGrid* grid, SDL_Rect rect, Pixel* dst, int dstPitch);
+
+/*
+* Copy a flat buffer of pixels into a rectangle of the grid. The rect must be inside the grid.
+* Fully transparent areas of src don't allocate new tiles.
+* @param srcPitch The length of a row of src in bytes
+*/
+void writeTileGridRect(TileGrid* grid, SDL_Rect rect, const Pixel* src, int srcPitch);
+
+/*
+* Make the tiles of dst touching rect the same as src's, sharing them. Both grids have to be the same size.
+* Cheap, since no pixels are copied, so it can be used to put back a saved copy of part of a grid.
+*/
+void shareTileGridRect(TileGrid* dst, const TileGrid* src, SDL_Rect rect);
+
+/*
+* Free the tiles touching rect that have become fully transparent black (all zeros),
+* e.g. after erasing.
+* @return The number of tiles freed
+*/
+int releaseTransparentTiles(TileGrid* grid, SDL_Rect rect);
+
+/*
+* Get the range of tiles touching a rect of pixels. The rect is clipped to the grid first.
+* @return false if the rect doesn't touch the grid at all
+*/
+bool getTileRange(const TileGrid* grid, SDL_Rect rect, int* firstTileX, int* firstTileY, int* lastTileX, int* lastTileY);
+
+#endif
@@ -0,0 +1,259 @@
+#include "Transform.hpp"
+
+#include <math.h>
+#include <algorithm>
+
+#include "SDL2_gfx/SDL2_rotozoom.h"
+#include "Blend.hpp"
+#include "ThreadPool.hpp"
+
+// drawing fewer pixels than this isn't worth waking up the thread pool for
+#define PARALLEL_TRANSFORM_MIN_PIXELS (TILE_PIXELS * 4)
+
+static inline bool isPixelSelected(const SelectionMask* selection, int x, int y) {
+    int tileIndex = (x >> TILE_SHIFT) + (y >> TILE_SHIFT) * selection->tilesX;
+    return (getSelectedRowBits(selection, tileIndex, y) >> (x & TILE_MASK)) & 1;
+}
+
+/*
+* Composite a flat buffer of pixels over a rect of the grid, with normal blending. The rect must be inside the grid.
+* Tiles that only get transparent pixels are left alone, so they don't get allocated or copied.
+*/
+static void drawPixelsOverTiles(TileGrid* tiles, SDL_Rect rect, const Pixel* src) {
+    int firstTileX, firstTileY, lastTileX, lastTileY;
+    if (!getTileRange(tiles, rect, &firstTileX, &firstTileY, &lastTileX, &lastTileY)) {
+        return;
+    }
+    // each row of tiles only touches its own tiles
+    auto drawTileRow = [&](int tileY) {
+        for (int tileX = firstTileX; tileX <= lastTileX; tileX++) {
+            SDL_Rect tileRect = {tileX << TILE_SHIFT, tileY << TILE_SHIFT, TILE_SIZE, TILE_SIZE};
+            SDL_Rect area;
+            SDL_IntersectRect(&tileRect, &rect, &area);
+            const Pixel* areaSrc = &src[(area.x - rect.x) + (area.y - rect.y) * rect.w];
+
+            bool transparent = true;
+            for (int y = 0; y < area.h && transparent; y++) {
+                const Pixel* row = &areaSrc[y * rect.w];
+                for (int x = 0; x < area.w; x++) {
+                    if (row[x].a) {
+                        transparent = false;
+                        break;
+                    }
+                }
+            }
+            if (transparent) continue;
+
+            Pixel* tilePixels = getWritableTilePixels(tiles, tileX, tileY);
+            if (!tilePixels) continue;
+            for (int y = 0; y < area.h; y++) {
+                Pixel* dst = &tilePixels[(area.x & TILE_MASK) + ((area.y + y) & TILE_MASK) * TILE_SIZE];
+                blendPixelSpan(dst, dst, &areaSrc[y * rect.w], area.w, BLEND_NORMAL, 1.0f);
+            }
+        }
+    };
+    if (rect.w * rect.h >= PARALLEL_TRANSFORM_MIN_PIXELS) {
+        getThreadPool()->parallelFor(lastTileY - firstTileY + 1, [&](int i) {
+            drawTileRow(firstTileY + i);
+        });
+    } else {
+        for (int tileY = firstTileY; tileY <= lastTileY; tileY++) {
+            drawTileRow(tileY);
+        }
+    }
+}
+
+/*
+* Transform floating pixels (or anything else the same size) into a buffer covering rect of the canvas.
+* @param dst rect.w * rect.h pixels. Pixels nothing gets transformed onto are left alone
+*/
+static void transformPixels(const FloatingPixels* floating, const Pixel* src, SDL_Rect rect, Pixel* dst, bool smooth) {
+    const PixelTransform& transform = floating->transform;
+    rotozoomPixelsXY(src, floating->width, floating->height, floating->width * sizeof(Pixel),
+        dst, rect.w, rect.h, rect.w * sizeof(Pixel), transform.centerX - rect.x, transform.centerY - rect.y,
+        transform.angle, transform.zoomX, transform.zoomY, smooth ? SMOOTHING_ON : SMOOTHING_OFF);
+}
+
+bool liftPixels(FloatingPixels* floating, const TileGrid* tiles, const SelectionMask* selection) {
+    SDL_Rect rect = {0, 0, tiles->width, tiles->height};
+    if (selection && !getSelectionBounds(selection, &rect)) {
+        return false;
+    }
+    if (copyTileGrid(&floating->original, tiles)) {
+        return false;
+    }
+    // cut out, so there's nothing left under the pixels once they move
+    if (selection) {
+        if (copyTileGrid(&floating->base, tiles)) {
+            destroyTileGrid(&floating->original);
+            return false;
+        }
+        for (int y = rect.y; y < rect.y + rect.h; y++) {
+            fillSelectedSpan(&floating->base, selection, rect.x, y, rect.w, (BrushPaint){(Pixel){0, 0, 0, 255}, BLEND_ERASE});
+        }
+        releaseTransparentTiles(&floating->base, rect);
+    } else if (initTileGrid(&floating->base, tiles->width, tiles->height)) {
+        destroyTileGrid(&floating->original);
+        return false;
+    }
+
+    // the border gives smoothing something transparent to blend the edges with
+    floating->width = rect.w + 2;
+    floating->height = rect.h + 2;
+    floating->pixels.assign((size_t)floating->width * floating->height, (Pixel){0, 0, 0, 0});
+    Pixel* inside = &floating->pixels[floating->width + 1];
+    readTileGridRect(tiles, rect, inside, floating->width * sizeof(Pixel));
+    if (selection) {
+        for (int y = 0; y < rect.h; y++) {
+            for (int x = 0; x < rect.w; x++) {
+                if (!isPixelSelected(selection, rect.x + x, rect.y + y)) {
+                    inside[x + y * floating->width] = (Pixel){0, 0, 0, 0};
+                }
+            }
+        }
+    }
+
+    floating->sourceRect = rect;
+    floating->transform = (PixelTransform){rect.x + rect.w / 2.0f, rect.y + rect.h / 2.0f, 0.0f, 1.0f, 1.0f};
+    // the pixels haven't been cut out of the layer yet
+    floating->drawnRect = rect;
+    floating->transformed.clear();
+    return true;
+}
+
+void destroyFloatingPixels(FloatingPixels* floating) {
+    destroyTileGrid(&floating->original);
+    destroyTileGrid(&floating->base);
+    floating->pixels.clear();
+    floating->transformed.clear();
+}
+
+void getFloatingPixelsCorners(const FloatingPixels* floating, SDL_FPoint corners[4]) {
+    const PixelTransform& transform = floating->transform;
+    float halfWidth = floating->sourceRect.w / 2.0f * transform.zoomX;
+    float halfHeight = floating->sourceRect.h / 2.0f * transform.zoomY;
+    float radians = transform.angle * (float)M_PI / 180.0f;
+    float s = sinf(radians);
+    float c = cosf(radians);
+    const float cornerX[4] = {-halfWidth, halfWidth, halfWidth, -halfWidth};
+    const float cornerY[4] = {-halfHeight, -halfHeight, halfHeight, halfHeight};
+    for (int i = 0; i < 4; i++) {
+        // counterclockwise on screen, where y goes down
+        corners[i].x = transform.centerX + cornerX[i] * c + cornerY[i] * s;
+        corners[i].y = transform.centerY - cornerX[i] * s + cornerY[i] * c;
+    }
+}
+
+SDL_Rect getFloatingPixelsRect(const FloatingPixels* floating) {
+    SDL_FPoint corners[4];
+    getFloatingPixelsCorners(floating, corners);
+    float minX = corners[0].x, maxX = corners[0].x, minY = corners[0].y, maxY = corners[0].y;
+    for (int i = 1; i < 4; i++) {
+        minX = std::min(minX, corners[i].x);
+        maxX = std::max(maxX, corners[i].x);
+        minY = std::min(minY, corners[i].y);
+        maxY = std::max(maxY, corners[i].y);
+    }
+    // an extra pixel around it for the edges smoothing blends with the border
+    SDL_Rect rect;
+    rect.x = (int)floorf(minX) - 1;
+    rect.y = (int)floorf(minY) - 1;
+    rect.w = (int)ceilf(maxX) + 1 - rect.x;
+    rect.h = (int)ceilf(maxY) + 1 - rect.y;
+    SDL_Rect bounds = {0, 0, floating->base.width, floating->base.height};
+    SDL_Rect clipped;
+    if (!SDL_IntersectRect(&rect, &bounds, &clipped)) {
+        return (SDL_Rect){0, 0, 0, 0};
+    }
+    return clipped;
+}
+
+SDL_Rect drawFloatingPixels(FloatingPixels* floating, TileGrid* tiles, bool smooth) {
+    SDL_Rect changed = floating->drawnRect;
+    shareTileGridRect(tiles, &floating->base, floating->drawnRect);
+
+    SDL_Rect rect = getFloatingPixelsRect(floating);
+    floating->drawnRect = rect;
+    if (SDL_RectEmpty(&rect)) {
+        // moved off the canvas
+        return changed;
+    }
+    std::vector<Pixel>& transformed = floating->transformed;
+    transformed.assign((size_t)rect.w * rect.h, (Pixel){0, 0, 0, 0});
+    const PixelTransform& transform = floating->transform;
+    if (fmodf(transform.angle, 90.0f) == 0.0f && fabsf(transform.zoomX) == 1.0f && fabsf(transform.zoomY) == 1.0f) {
+        // every pixel lands on a whole pixel, so there's nothing to smooth
+        smooth = false;
+    }
+    if (smooth) {
+        // filtered in premultiplied alpha, so transparent pixels don't darken the edges
+        std::vector<Pixel> premultiplied(floating->pixels);
+        for (size_t i = 0; i < premultiplied.size(); i++) {
+            Pixel& pixel = premultiplied[i];
+            pixel.r = (pixel.r * pixel.a + 127) / 255;
+            pixel.g = (pixel.g * pixel.a + 127) / 255;
+            pixel.b = (pixel.b * pixel.a + 127) / 255;
+        }
+        transformPixels(floating, premultiplied.data(), rect, transformed.data(), true);
+        for (size_t i = 0; i < transformed.size(); i++) {
+            Pixel& pixel = transformed[i];
+            if (pixel.a == 0) {
+                pixel = (Pixel){0, 0, 0, 0};
+                continue;
+            }
+            pixel.r = std::min(255, (pixel.r * 255 + pixel.a / 2) / pixel.a);
+            pixel.g = std::min(255, (pixel.g * 255 + pixel.a / 2) / pixel.a);
+            pixel.b = std::min(255, (pixel.b * 255 + pixel.a / 2) / pixel.a);
+        }
+    } else {
+        transformPixels(floating, floating->pixels.data(), rect, transformed.data(), false);
+    }
+    drawPixelsOverTiles(tiles, rect, transformed.data());
+
+    // SDL_UnionRect just takes the other rect if one of them is empty
+    SDL_UnionRect(&changed, &rect, &changed);
+    return changed;
+}
+
+SDL_Rect restoreFloatingPixels(FloatingPixels* floating, TileGrid* tiles) {
+    SDL_Rect changed;
+    SDL_UnionRect(&floating->drawnRect, &floating->sourceRect, &changed);
+    shareTileGridRect(tiles, &floating->original, changed);
+    floating->drawnRect = floating->sourceRect;
+    return changed;
+}
+
+void transformSelection(FloatingPixels* floating, SelectionMask* selection) {
+    // the selection as opaque pixels where it's selected, laid out like the lifted pixels
+    const SDL_Rect& source = floating->sourceRect;
+    std::vector<Pixel> selected((size_t)floating->width * floating->height, (Pixel){0, 0, 0, 0});
+    for (int y = 0; y < source.h; y++) {
+        for (int x = 0; x < source.w; x++) {
+            if (isPixelSelected(selection, source.x + x, source.y + y)) {
+                selected[(x + 1) + (y + 1) * floating->width] = (Pixel){255, 255, 255, 255};
+            }
+        }
+    }
+    clearSelection(selection);
+
+    SDL_Rect rect = getFloatingPixelsRect(floating);
+    if (SDL_RectEmpty(&rect)) {
+        return;
+    }
+    // nearest neighbor, so it lines up with the pixels how they were previewed
+    std::vector<Pixel> transformed((size_t)rect.w * rect.h, (Pixel){0, 0, 0, 0});
+    transformPixels(floating, selected.data(), rect, transformed.data(), false);
+    for (int y = 0; y < rect.h; y++) {
+        const Pixel* row = &transformed[(size_t)y * rect.w];
+        int x = 0;
+        while (x < rect.w) {
+            if (!row[x].a) {
+                x++;
+                continue;
+            }
+            int runStart = x;
+            while (x < rect.w && row[x].a) x++;
+            selectRect(selection, (SDL_Rect){rect.x + runStart, rect.y + y, x - runStart, 1});
+        }
+    }
+}
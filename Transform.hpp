@@ -0,0 +1,80 @@
+#ifndef TRANSFORM_INCLUDED
+#define TRANSFORM_INCLUDED
+
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "Pixel.hpp"
+#include "Tiles.hpp"
+#include "Selection.hpp"
+
+/*
+* How floating pixels are placed: scaled, then rotated about their center, then moved so the center is at centerX,centerY.
+*/
+struct PixelTransform {
+    float centerX; // in canvas coordinates
+    float centerY;
+    float angle; // in degrees, counterclockwise
+    float zoomX; // negative to flip
+    float zoomY;
+};
+
+/*
+* Pixels lifted off a layer to be moved, scaled and rotated, then put back down.
+* While they float, the layer shows them drawn over what was under them, so the layer's tiles are changed
+* like they would be by a stroke, but every preview starts again from the layer as it was with the pixels cut out.
+*/
+struct FloatingPixels {
+    std::vector<Pixel> pixels; // the lifted pixels with a 1 pixel transparent border, unselected pixels are transparent
+    int width; // of pixels, including the border
+    int height;
+    SDL_Rect sourceRect; // where the pixels were lifted from, without the border
+    PixelTransform transform;
+    TileGrid original; // the layer before anything was lifted, to cancel
+    TileGrid base; // the layer with the lifted pixels cut out, which they're drawn over
+    SDL_Rect drawnRect; // area of the layer changed from base by the last draw
+    std::vector<Pixel> transformed; // the transformed pixels, reused from draw to draw
+};
+
+/*
+* Lift pixels off a layer. The layer isn't changed until the pixels are drawn.
+* @param selection The pixels to lift, NULL to lift the whole layer
+* @return false if there's nothing to lift or it couldn't be allocated. floating is left uninitialized then
+*/
+bool liftPixels(FloatingPixels* floating, const TileGrid* tiles, const SelectionMask* selection);
+void destroyFloatingPixels(FloatingPixels* floating);
+
+/*
+* Get the area of the layer the pixels would cover with their current transform, clipped to the layer.
+* Anything drawing them has to record history for this first.
+*/
+SDL_Rect getFloatingPixelsRect(const FloatingPixels* floating);
+
+/*
+* Get where the corners of the lifted pixels end up, in canvas coordinates. Clockwise from the top left before rotating.
+*/
+void getFloatingPixelsCorners(const FloatingPixels* floating, SDL_FPoint corners[4]);
+
+/*
+* Put the pixels the last draw covered back to how they were with the pixels lifted, then draw the pixels over them
+* with their current transform. Nearest neighbor is fast enough for every frame while the transform is changing,
+* smoothing resamples them with bilinear filtering for putting them down for good.
+* @param tiles The layer the pixels were lifted from
+* @return The area of the layer that changed
+*/
+SDL_Rect drawFloatingPixels(FloatingPixels* floating, TileGrid* tiles, bool smooth);
+
+/*
+* Put the layer back to how it was before the pixels were lifted.
+* @return The area of the layer that changed
+*/
+SDL_Rect restoreFloatingPixels(FloatingPixels* floating, TileGrid* tiles);
+
+/*
+* Transform the selection the pixels were lifted with the same way as them, so it stays around them.
+* The selection has to be the same one they were lifted with.
+*/
+void transformSelection(FloatingPixels* floating, SelectionMask* selection);
+
+#endif
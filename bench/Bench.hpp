@@ -0,0 +1,57 @@
+#ifndef BENCH_INCLUDED
+#define BENCH_INCLUDED
+
+#include <stdio.h>
+#include <functional>
+
+#include <SDL2/SDL.h>
+
+// how long each measurement keeps calling the benchmarked function, in seconds
+#define BENCH_MIN_SECONDS 0.5
+
+/*
+* Call func over and over for at least minSeconds, after one untimed call to warm up caches and lazy allocations.
+* @return How many times per second func ran
+*/
+inline double measureCallsPerSecond(const std::function<void(void)>& func, double minSeconds = BENCH_MIN_SECONDS) {
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 minTicks = (Uint64)(minSeconds * frequency);
+    func();
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 elapsed;
+    long long calls = 0;
+    do {
+        func();
+        calls++;
+        elapsed = SDL_GetPerformanceCounter() - start;
+    } while (elapsed < minTicks);
+    return calls * (double)frequency / elapsed;
+}
+
+/*
+* Print a rate with a metric prefix, like "12.3 M pixels/s".
+*/
+inline void printRate(double rate, const char* unit) {
+    const char* prefixes[] = {"", "k", "M", "G"};
+    int prefix = 0;
+    while (rate >= 1000.0 && prefix < 3) {
+        rate /= 1000.0;
+        prefix++;
+    }
+    printf("%8.2f %s%s/s", rate, prefixes[prefix], unit);
+}
+
+/*
+* Deterministic random numbers, so every run benchmarks the same data.
+*/
+inline Uint32 nextBenchRandom(Uint32* state) {
+    // xorshift32
+    Uint32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+#endif
@@ -0,0 +1,128 @@
+/*
+* Checks that every blend kernel set gives exactly the same pixels as the scalar kernels, over random spans
+* in every mode at every opacity, then measures how many pixels per second each set blends.
+* Pass --check to only run the check. Exits with 1 if any kernel doesn't match.
+*/
+#include <string.h>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "Bench.hpp"
+#include "../Pixel.hpp"
+#include "../Blend.hpp"
+
+// longest random span checked, long enough to cover every vector width plus a leftover tail
+#define CHECK_MAX_SPAN 37
+#define CHECK_SPANS_PER_OPACITY 16
+#define BENCH_SPAN_LENGTH 4096
+
+/*
+* Random pixels, with alphas of 0 and 255 and equal colors more likely than they'd be by chance,
+* since those are where the edge cases are.
+*/
+static Pixel getRandomPixel(Uint32* random) {
+    Uint32 bits = nextBenchRandom(random);
+    Pixel pixel = {(Uint8)bits, (Uint8)(bits >> 8), (Uint8)(bits >> 16), (Uint8)(bits >> 24)};
+    switch (nextBenchRandom(random) % 8) {
+        case 0: pixel.a = 0; break;
+        case 1: pixel.a = 255; break;
+        case 2: pixel.g = pixel.b = pixel.r; break;
+        case 3: pixel = (Pixel){0, 0, 0, 0}; break;
+        default: break;
+    }
+    return pixel;
+}
+
+static void printPixel(Pixel pixel) {
+    printf("%d,%d,%d,%d", pixel.r, pixel.g, pixel.b, pixel.a);
+}
+
+/*
+* Compare a kernel set against the scalar kernels for every mode and every opacity a layer can have.
+* @return The number of spans that came out different
+*/
+static int checkKernelSet(BlendKernelSet set) {
+    Uint32 random = 12345;
+    int mismatches = 0;
+    Pixel backdrop[CHECK_MAX_SPAN], src[CHECK_MAX_SPAN], expected[CHECK_MAX_SPAN], actual[CHECK_MAX_SPAN];
+    for (int mode = 0; mode < BLEND_MODE_COUNT; mode++) {
+        for (int opacityStep = 0; opacityStep <= 255; opacityStep++) {
+            float opacity = opacityStep / 255.0f;
+            for (int span = 0; span < CHECK_SPANS_PER_OPACITY; span++) {
+                int count = (int)(nextBenchRandom(&random) % (CHECK_MAX_SPAN + 1));
+                bool solid = span % 2 == 1;
+                for (int i = 0; i < CHECK_MAX_SPAN; i++) {
+                    backdrop[i] = getRandomPixel(&random);
+                    src[i] = getRandomPixel(&random);
+                }
+                blendPixelSpanWithKernels(BLEND_KERNELS_SCALAR, expected, backdrop, src, count, (BlendMode)mode, opacity, solid);
+                blendPixelSpanWithKernels(set, actual, backdrop, src, count, (BlendMode)mode, opacity, solid);
+                for (int i = 0; i < count; i++) {
+                    if (memcmp(&expected[i], &actual[i], sizeof(Pixel)) == 0) continue;
+                    if (mismatches < 10) {
+                        printf("  %s, opacity %d/255%s: ", getBlendModeName((BlendMode)mode), opacityStep, solid ? ", solid" : "");
+                        printPixel(src[solid ? 0 : i]);
+                        printf(" over ");
+                        printPixel(backdrop[i]);
+                        printf(" gave ");
+                        printPixel(actual[i]);
+                        printf(" instead of ");
+                        printPixel(expected[i]);
+                        printf("\n");
+                    }
+                    mismatches++;
+                    break;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+int main(int argc, char** argv) {
+    bool checkOnly = argc > 1 && strcmp(argv[1], "--check") == 0;
+
+    int failed = 0;
+    for (int set = 0; set < BLEND_KERNEL_SET_COUNT; set++) {
+        if (set == BLEND_KERNELS_SCALAR || !isBlendKernelSetAvailable((BlendKernelSet)set)) continue;
+        int mismatches = checkKernelSet((BlendKernelSet)set);
+        printf("blend kernels %s: %s", getBlendKernelSetName((BlendKernelSet)set), mismatches ? "MISMATCH" : "match scalar");
+        if (mismatches) {
+            printf(" in %d spans", mismatches);
+            failed = 1;
+        }
+        printf("\n");
+    }
+    if (checkOnly || failed) {
+        return failed;
+    }
+
+    Uint32 random = 1;
+    std::vector<Pixel> backdrop(BENCH_SPAN_LENGTH), src(BENCH_SPAN_LENGTH), dst(BENCH_SPAN_LENGTH);
+    for (int i = 0; i < BENCH_SPAN_LENGTH; i++) {
+        backdrop[i] = getRandomPixel(&random);
+        src[i] = getRandomPixel(&random);
+    }
+    printf("\nblending %d pixel spans at 50%% opacity\n%-10s", BENCH_SPAN_LENGTH, "mode");
+    for (int set = 0; set < BLEND_KERNEL_SET_COUNT; set++) {
+        if (isBlendKernelSetAvailable((BlendKernelSet)set)) {
+            printf(" %-20s", getBlendKernelSetName((BlendKernelSet)set));
+        }
+    }
+    printf("\n");
+    for (int mode = 0; mode < BLEND_MODE_COUNT; mode++) {
+        printf("%-10s", getBlendModeName((BlendMode)mode));
+        for (int set = 0; set < BLEND_KERNEL_SET_COUNT; set++) {
+            if (!isBlendKernelSetAvailable((BlendKernelSet)set)) continue;
+            double rate = BENCH_SPAN_LENGTH * measureCallsPerSecond([&]() {
+                blendPixelSpanWithKernels((BlendKernelSet)set, dst.data(), backdrop.data(), src.data(), BENCH_SPAN_LENGTH,
+                    (BlendMode)mode, 0.5f, false);
+            });
+            printf(" ");
+            printRate(rate, "pixels");
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+/*
+* Glyph lookups per second in the font cache's codepoint map, the way every string drawn or measured looks up each of
+* its characters: ASCII text, Latin-1 text, and text from a large CJK set. Compares the chained buckets glyphs used to
+* be kept in against the current map.
+*/
+#include <string.h>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "Bench.hpp"
+// the map is private to the font cache, so its source is built into the bench
+#include "../SDL_FontCache/SDL_FontCache.c"
+
+// characters of text looked up per measured call
+#define TEXT_LENGTH 65536
+#define OLD_NUM_BUCKETS 300
+
+/*
+* How glyphs were looked up before: 300 buckets of linked lists, by codepoint % 300.
+*/
+struct ChainedGlyphMap {
+    struct Node {
+        Uint32 key;
+        FC_GlyphData value;
+        Node* next;
+    };
+    Node* buckets[OLD_NUM_BUCKETS] = {};
+
+    ~ChainedGlyphMap() {
+        for (int i = 0; i < OLD_NUM_BUCKETS; i++) {
+            while (buckets[i]) {
+                Node* next = buckets[i]->next;
+                delete buckets[i];
+                buckets[i] = next;
+            }
+        }
+    }
+
+    void insert(Uint32 codepoint, FC_GlyphData glyph) {
+        Node** node = &buckets[codepoint % OLD_NUM_BUCKETS];
+        while (*node) {
+            node = &(*node)->next;
+        }
+        *node = new Node{codepoint, glyph, NULL};
+    }
+
+    FC_GlyphData* find(Uint32 codepoint) const {
+        for (Node* node = buckets[codepoint % OLD_NUM_BUCKETS]; node; node = node->next) {
+            if (node->key == codepoint) {
+                return &node->value;
+            }
+        }
+        return NULL;
+    }
+};
+
+/*
+* The font cache key of a Unicode codepoint: its UTF-8 bytes packed into a Uint32, as the cache reads them from text.
+*/
+static Uint32 getGlyphKey(Uint32 codepoint) {
+    char utf8[5] = {};
+    if (codepoint < 0x80) {
+        utf8[0] = (char)codepoint;
+    } else if (codepoint < 0x800) {
+        utf8[0] = (char)(0xc0 | (codepoint >> 6));
+        utf8[1] = (char)(0x80 | (codepoint & 0x3f));
+    } else {
+        utf8[0] = (char)(0xe0 | (codepoint >> 12));
+        utf8[1] = (char)(0x80 | ((codepoint >> 6) & 0x3f));
+        utf8[2] = (char)(0x80 | (codepoint & 0x3f));
+    }
+    const char* c = utf8;
+    return FC_GetCodepointFromUTF8(&c, 0);
+}
+
+int main() {
+    struct {
+        const char* name;
+        Uint32 first, count;
+    } sets[] = {
+        {"ASCII", 0x20, 95},
+        {"Latin-1", 0xa0, 96},
+        {"CJK", 0x4e00, 20000},
+    };
+
+    printf("glyph lookups, %d characters of random text from each set\n", TEXT_LENGTH);
+    printf("%-10s %-8s %-24s %-24s %s\n", "text", "glyphs", "chained buckets (before)", "FC_Map", "speedup");
+    for (size_t s = 0; s < sizeof(sets) / sizeof(sets[0]); s++) {
+        FC_Map* map = FC_MapCreate();
+        ChainedGlyphMap chained;
+        for (Uint32 i = 0; i < sets[s].count; i++) {
+            FC_GlyphData glyph = FC_MakeGlyphData(0, (Sint16)(i % 256), (Sint16)(i / 256), 8, 12);
+            FC_MapInsert(map, getGlyphKey(sets[s].first + i), glyph);
+            chained.insert(getGlyphKey(sets[s].first + i), glyph);
+        }
+        Uint32 random = 1;
+        std::vector<Uint32> text(TEXT_LENGTH);
+        for (int i = 0; i < TEXT_LENGTH; i++) {
+            text[i] = getGlyphKey(sets[s].first + nextBenchRandom(&random) % sets[s].count);
+        }
+
+        // summing the widths keeps the lookups from being optimized away
+        volatile int width = 0;
+        double before = TEXT_LENGTH * measureCallsPerSecond([&]() {
+            int sum = 0;
+            for (int i = 0; i < TEXT_LENGTH; i++) {
+                sum += chained.find(text[i])->rect.w;
+            }
+            width = sum;
+        });
+        double after = TEXT_LENGTH * measureCallsPerSecond([&]() {
+            int sum = 0;
+            for (int i = 0; i < TEXT_LENGTH; i++) {
+                sum += FC_MapFind(map, text[i])->rect.w;
+            }
+            width = sum;
+        });
+        printf("%-10s %-8u ", sets[s].name, sets[s].count);
+        printRate(before, "lookups");
+        printf("   ");
+        printRate(after, "lookups");
+        printf("   %.1fx\n", after / before);
+        FC_MapFree(map);
+    }
+    return 0;
+}
@@ -0,0 +1,218 @@
+/*
+* Checks that every SIMD instruction set of the byte image filters gives exactly the same bytes as plain C,
+* for every filter including the convolutions and Sobel, over odd sizes and random constants.
+* Then measures megabytes per second of each filter on a 1024x1024 image, in C and with each instruction set.
+* Pass --check to only run the check. Exits with 1 if anything doesn't match.
+*/
+#include <string.h>
+#include <functional>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "Bench.hpp"
+#include "../SDL2_gfx/SDL2_imageFilter.h"
+
+#define BENCH_IMAGE_SIZE 1024
+#define CHECK_RUNS_PER_FILTER 64
+// largest random image checked, wide enough to cover every vector width, a leftover tail and every kernel size
+#define CHECK_MAX_SIZE 80
+
+/*
+* Runs a filter over a rows x columns image, picking its constants from seed.
+* Filters of byte arrays take the whole image as one array.
+*/
+typedef std::function<int(Uint8* src1, Uint8* src2, Uint8* dest, int rows, int columns, Uint32 seed)> RunFilter;
+
+struct FilterCase {
+    const char* name;
+    RunFilter run;
+};
+
+/*
+* A kernel of mostly small weights, with a few at the ends of the range so the sums go far past 0..255.
+*/
+static std::vector<signed short> getRandomKernel(int size, Uint32* random) {
+    std::vector<signed short> kernel(size * size);
+    for (size_t i = 0; i < kernel.size(); i++) {
+        Uint32 bits = nextBenchRandom(random);
+        switch (bits % 16) {
+            case 0: kernel[i] = 32767; break;
+            case 1: kernel[i] = -32768; break;
+            default: kernel[i] = (signed short)((int)(bits >> 8) % 33 - 16); break;
+        }
+    }
+    return kernel;
+}
+
+static RunFilter convolveDivide(int (*filter)(Uint8*, Uint8*, int, int, signed short*, Uint8), int size) {
+    return [=](Uint8* src1, Uint8*, Uint8* dest, int rows, int columns, Uint32 seed) {
+        std::vector<signed short> kernel = getRandomKernel(size, &seed);
+        return filter(src1, dest, rows, columns, kernel.data(), (Uint8)(nextBenchRandom(&seed) % 255 + 1));
+    };
+}
+
+static RunFilter convolveShiftRight(int (*filter)(Uint8*, Uint8*, int, int, signed short*, Uint8), int size) {
+    return [=](Uint8* src1, Uint8*, Uint8* dest, int rows, int columns, Uint32 seed) {
+        std::vector<signed short> kernel = getRandomKernel(size, &seed);
+        return filter(src1, dest, rows, columns, kernel.data(), (Uint8)(nextBenchRandom(&seed) % 8));
+    };
+}
+
+/*
+* Every filter, with constants covering their whole range.
+*/
+static std::vector<FilterCase> getFilterCases() {
+    #define TWO_SOURCES(filter) {#filter, [](Uint8* a, Uint8* b, Uint8* d, int rows, int columns, Uint32) { \
+        return SDL_imageFilter##filter(a, b, d, rows * columns); }}
+    #define ONE_SOURCE(filter, ...) {#filter, [](Uint8* a, Uint8*, Uint8* d, int rows, int columns, Uint32 seed) { \
+        (void)seed; return SDL_imageFilter##filter(a, d, rows * columns, ##__VA_ARGS__); }}
+    #define RANDOM (nextBenchRandom(&seed))
+    std::vector<FilterCase> cases = {
+        TWO_SOURCES(Add), TWO_SOURCES(Mean), TWO_SOURCES(Sub), TWO_SOURCES(AbsDiff), TWO_SOURCES(Mult),
+        TWO_SOURCES(MultNor), TWO_SOURCES(MultDivby2), TWO_SOURCES(MultDivby4), TWO_SOURCES(BitAnd),
+        TWO_SOURCES(BitOr), TWO_SOURCES(Div),
+        ONE_SOURCE(BitNegation),
+        ONE_SOURCE(AddByte, (Uint8)RANDOM),
+        ONE_SOURCE(AddUint, RANDOM),
+        ONE_SOURCE(AddByteToHalf, (Uint8)RANDOM),
+        ONE_SOURCE(SubByte, (Uint8)RANDOM),
+        ONE_SOURCE(SubUint, RANDOM),
+        ONE_SOURCE(ShiftRight, (Uint8)(RANDOM % 9)),
+        ONE_SOURCE(ShiftRightUint, (Uint8)(RANDOM % 33)),
+        ONE_SOURCE(MultByByte, (Uint8)RANDOM),
+        ONE_SOURCE(ShiftRightAndMultByByte, (Uint8)(RANDOM % 9), (Uint8)RANDOM),
+        ONE_SOURCE(ShiftLeftByte, (Uint8)(RANDOM % 9)),
+        ONE_SOURCE(ShiftLeftUint, (Uint8)(RANDOM % 33)),
+        ONE_SOURCE(ShiftLeft, (Uint8)(RANDOM % 9)),
+        ONE_SOURCE(BinarizeUsingThreshold, (Uint8)RANDOM),
+        ONE_SOURCE(ClipToRange, (Uint8)RANDOM, (Uint8)RANDOM),
+        ONE_SOURCE(NormalizeLinear, (int)(RANDOM % 300) - 20, (int)(RANDOM % 300) - 20, (int)(RANDOM % 600) - 300,
+            (int)(RANDOM % 600) - 300),
+        {"Convolve3x3Divide", convolveDivide(SDL_imageFilterConvolveKernel3x3Divide, 3)},
+        {"Convolve5x5Divide", convolveDivide(SDL_imageFilterConvolveKernel5x5Divide, 5)},
+        {"Convolve7x7Divide", convolveDivide(SDL_imageFilterConvolveKernel7x7Divide, 7)},
+        {"Convolve9x9Divide", convolveDivide(SDL_imageFilterConvolveKernel9x9Divide, 9)},
+        {"Convolve3x3ShiftRight", convolveShiftRight(SDL_imageFilterConvolveKernel3x3ShiftRight, 3)},
+        {"Convolve5x5ShiftRight", convolveShiftRight(SDL_imageFilterConvolveKernel5x5ShiftRight, 5)},
+        {"Convolve7x7ShiftRight", convolveShiftRight(SDL_imageFilterConvolveKernel7x7ShiftRight, 7)},
+        {"Convolve9x9ShiftRight", convolveShiftRight(SDL_imageFilterConvolveKernel9x9ShiftRight, 9)},
+        {"SobelX", [](Uint8* a, Uint8*, Uint8* d, int rows, int columns, Uint32) {
+            return SDL_imageFilterSobelX(a, d, rows, columns); }},
+        {"SobelXShiftRight", [](Uint8* a, Uint8*, Uint8* d, int rows, int columns, Uint32 seed) {
+            return SDL_imageFilterSobelXShiftRight(a, d, rows, columns, (Uint8)(nextBenchRandom(&seed) % 8)); }},
+    };
+    #undef TWO_SOURCES
+    #undef ONE_SOURCE
+    #undef RANDOM
+    return cases;
+}
+
+/*
+* Random bytes, with 0 and 255 more likely than they'd be by chance, since those are where the edge cases are.
+*/
+static void fillRandomBytes(std::vector<Uint8>* bytes, Uint32* random) {
+    for (size_t i = 0; i < bytes->size(); i++) {
+        Uint32 bits = nextBenchRandom(random);
+        switch (bits % 8) {
+            case 0: (*bytes)[i] = 0; break;
+            case 1: (*bytes)[i] = 255; break;
+            default: (*bytes)[i] = (Uint8)(bits >> 8); break;
+        }
+    }
+}
+
+/*
+* Run every filter with SIMD off and with the picked instruction set, on random images with random constants.
+* @return The number of runs that came out different
+*/
+static int checkSIMD(const std::vector<FilterCase>& cases) {
+    Uint32 random = 12345;
+    int mismatches = 0;
+    std::vector<Uint8> src1(CHECK_MAX_SIZE * CHECK_MAX_SIZE), src2(src1.size()), expected(src1.size()), actual(src1.size());
+    for (size_t c = 0; c < cases.size(); c++) {
+        for (int run = 0; run < CHECK_RUNS_PER_FILTER; run++) {
+            // sizes from the smallest every filter takes up
+            int rows = 9 + nextBenchRandom(&random) % (CHECK_MAX_SIZE - 8);
+            int columns = 9 + nextBenchRandom(&random) % (CHECK_MAX_SIZE - 8);
+            Uint32 seed = nextBenchRandom(&random);
+            fillRandomBytes(&src1, &random);
+            fillRandomBytes(&src2, &random);
+            // the convolutions leave the border, so it has to start out the same
+            fillRandomBytes(&expected, &random);
+            actual = expected;
+
+            SDL_imageFilterMMXoff();
+            int expectedResult = cases[c].run(src1.data(), src2.data(), expected.data(), rows, columns, seed);
+            SDL_imageFilterMMXon();
+            int actualResult = cases[c].run(src1.data(), src2.data(), actual.data(), rows, columns, seed);
+            if (expectedResult != actualResult || memcmp(expected.data(), actual.data(), rows * columns) != 0) {
+                if (mismatches < 10) {
+                    printf("  %s on %dx%d differs\n", cases[c].name, columns, rows);
+                }
+                mismatches++;
+            }
+        }
+    }
+    return mismatches;
+}
+
+int main(int argc, char** argv) {
+    bool checkOnly = argc > 1 && strcmp(argv[1], "--check") == 0;
+    std::vector<FilterCase> cases = getFilterCases();
+    const char* simdNames[] = {"SSE2", "AVX2", "NEON", "WASM"};
+    std::vector<const char*> simds;
+
+    int failed = 0;
+    for (size_t s = 0; s < sizeof(simdNames) / sizeof(simdNames[0]); s++) {
+        if (SDL_imageFilterSelectSIMD(simdNames[s])) continue;
+        simds.push_back(simdNames[s]);
+        int mismatches = checkSIMD(cases);
+        printf("image filters %s: %s", simdNames[s], mismatches ? "MISMATCH" : "match C");
+        if (mismatches) {
+            printf(" in %d runs", mismatches);
+            failed = 1;
+        }
+        printf("\n");
+    }
+    if (checkOnly || failed) {
+        SDL_imageFilterSelectSIMD(NULL);
+        return failed;
+    }
+
+    Uint32 random = 1;
+    std::vector<Uint8> src1(BENCH_IMAGE_SIZE * BENCH_IMAGE_SIZE), src2(src1.size()), dest(src1.size());
+    fillRandomBytes(&src1, &random);
+    fillRandomBytes(&src2, &random);
+    double bytes = (double)src1.size();
+    printf("\nfiltering a %dx%d image, 1 thread\n%-24s %-16s", BENCH_IMAGE_SIZE, BENCH_IMAGE_SIZE, "filter", "C");
+    for (size_t s = 0; s < simds.size(); s++) {
+        printf(" %-16s", simds[s]);
+    }
+    printf(" speedup\n");
+    for (size_t c = 0; c < cases.size(); c++) {
+        printf("%-24s ", cases[c].name);
+        SDL_imageFilterMMXoff();
+        double before = bytes * measureCallsPerSecond([&]() {
+            cases[c].run(src1.data(), src2.data(), dest.data(), BENCH_IMAGE_SIZE, BENCH_IMAGE_SIZE, 1);
+        });
+        SDL_imageFilterMMXon();
+        printRate(before, "B");
+        double best = before;
+        for (size_t s = 0; s < simds.size(); s++) {
+            SDL_imageFilterSelectSIMD(simds[s]);
+            double rate = bytes * measureCallsPerSecond([&]() {
+                cases[c].run(src1.data(), src2.data(), dest.data(), BENCH_IMAGE_SIZE, BENCH_IMAGE_SIZE, 1);
+            });
+            printf("   ");
+            printRate(rate, "B");
+            if (rate > best) {
+                best = rate;
+            }
+        }
+        printf("   %.1fx\n", best / before);
+    }
+
+    SDL_imageFilterSelectSIMD(NULL);
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+* Pen stamps per second for every pen size, drawn by the pen's old per-point stamp loop
+* against the clipped row spans drawStrokeSegment fills now. A stamp is a stroke segment from a point to itself,
+* which is what every click and every stroke start draws. The old pen was always square, so round pens only
+* have an after column.
+*/
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "Bench.hpp"
+#include "../Pixel.hpp"
+#include "../Tiles.hpp"
+#include "../Brush.hpp"
+#include "../Stroke.hpp"
+
+#define CANVAS_SIZE 4096
+// stamps drawn per measured call. they're spread out so none of them overlap and get skipped by the stroke mask
+#define STAMPS_PER_BATCH 1024
+#define BENCH_MAX_PEN_SIZE 128
+
+/*
+* The pixel loop of penDrawOnCanvas from before the pen was rasterized as row spans, copied as it was:
+* column by column, bounds checking and writing every covered pixel on its own.
+* History recording and dirty marking are left out on both sides of the bench.
+*/
+static int penDrawOnCanvasBefore(TileGrid* tiles, int penSize, Pixel penPixel, int canvasX, int canvasY) {
+    // go through pixels selected by pen based on pen size
+    int pixelsDrawn = 0;
+    for (int pixelX = canvasX; pixelX < canvasX+penSize; pixelX++) {
+        for (int pixelY = canvasY; pixelY < canvasY+penSize; pixelY++) {
+            // we only check for the bottom and right edges as the pen size expansion
+            // only goes down and right, never up or left
+            if (pixelX < 0 || pixelX >= tiles->width || pixelY < 0 || pixelY >= tiles->height) {
+                // selected area went over the border, dont draw
+                continue;
+            }
+            setPixel(tiles, pixelX, pixelY, penPixel);
+
+            pixelsDrawn++;
+        }
+    }
+    return pixelsDrawn;
+}
+
+/*
+* Get the top left corners of a batch of stamps that don't overlap, on a grid that doesn't line up with the tiles.
+*/
+static std::vector<SDL_Point> getStampPositions(int size) {
+    std::vector<SDL_Point> positions;
+    int spacing = size + 1;
+    for (int y = 3; y + size <= CANVAS_SIZE && positions.size() < STAMPS_PER_BATCH; y += spacing) {
+        for (int x = 3; x + size <= CANVAS_SIZE && positions.size() < STAMPS_PER_BATCH; x += spacing) {
+            positions.push_back((SDL_Point){x, y});
+        }
+    }
+    return positions;
+}
+
+int main() {
+    TileGrid tiles;
+    if (initTileGrid(&tiles, CANVAS_SIZE, CANVAS_SIZE)) {
+        return 1;
+    }
+    StrokeMask mask;
+    BrushPaint paint = {(Pixel){200, 40, 90, 255}, BLEND_NORMAL};
+
+    printf("pen stamps, opaque paint\n");
+    printf("%-6s %-7s %-22s %-22s %s\n", "size", "shape", "per point (before)", "row spans", "speedup");
+    const BrushShape shapes[] = {BRUSH_SQUARE, BRUSH_ROUND};
+    const char* shapeNames[] = {"square", "round"};
+    for (int size = 1; size <= BENCH_MAX_PEN_SIZE; size *= 2) {
+        std::vector<SDL_Point> positions = getStampPositions(size);
+        for (int shapeIndex = 0; shapeIndex < 2; shapeIndex++) {
+            BrushShape shape = shapes[shapeIndex];
+            double before = 0.0;
+            if (shape == BRUSH_SQUARE) {
+                before = positions.size() * measureCallsPerSecond([&]() {
+                    for (size_t i = 0; i < positions.size(); i++) {
+                        penDrawOnCanvasBefore(&tiles, size, paint.pixel, positions[i].x, positions[i].y);
+                    }
+                });
+            }
+            double after = positions.size() * measureCallsPerSecond([&]() {
+                beginStrokeMask(&mask, &tiles, NULL);
+                for (size_t i = 0; i < positions.size(); i++) {
+                    SDL_Point point = positions[i];
+                    drawStrokeSegment(&mask, &tiles, shape, size, point.x, point.y, point.x, point.y, paint);
+                }
+            });
+            printf("%-6d %-7s ", size, shapeNames[shapeIndex]);
+            if (before > 0.0) {
+                printRate(before, "stamps");
+            } else {
+                printf("%8s%10s", "-", "");
+            }
+            printf("   ");
+            printRate(after, "stamps");
+            if (before > 0.0) {
+                printf("   %.1fx", after / before);
+            }
+            printf("\n");
+        }
+    }
+
+    destroyStrokeMask(&mask);
+    destroyTileGrid(&tiles);
+    return 0;
+}
@@ -0,0 +1,124 @@
+/*
+* Pixels per second of getting changed canvas pixels onto the screen, the way it used to be done
+* (one SDL_RenderDrawPoint per pixel into a target texture) against the tile texture cache.
+* Uses a software renderer by default so it runs anywhere, pass --window to use the default renderer of a hidden window.
+*/
+#include <string.h>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "Bench.hpp"
+#include "../Pixel.hpp"
+#include "../Tiles.hpp"
+#include "../TileTextures.hpp"
+
+#define CANVAS_SIZE 2048
+
+/*
+* How changed pixels were drawn before: a draw call per pixel, into a texture mirroring the canvas.
+*/
+static void drawPixelsOneByOne(SDL_Renderer* ren, SDL_Texture* canvasTexture, const TileGrid* tiles, SDL_Rect rect) {
+    SDL_SetRenderTarget(ren, canvasTexture);
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+    for (int y = rect.y; y < rect.y + rect.h; y++) {
+        for (int x = rect.x; x < rect.x + rect.w; x++) {
+            Pixel pixel = getPixel(tiles, x, y);
+            SDL_SetRenderDrawColor(ren, pixel.r, pixel.g, pixel.b, pixel.a);
+            SDL_RenderDrawPoint(ren, x, y);
+        }
+    }
+    SDL_SetRenderTarget(ren, NULL);
+    SDL_RenderCopy(ren, canvasTexture, &rect, &rect);
+    SDL_RenderFlush(ren);
+}
+
+/*
+* How they're drawn now: flag the touched tiles, then draw them, which re-uploads the flagged ones.
+*/
+static void drawPixelsByTile(SDL_Renderer* ren, TileTextureCache* cache, const TileGrid* tiles, SDL_Rect rect) {
+    invalidateTileTextures(cache, tiles, rect);
+    renderTileGrid(cache, tiles, rect, rect);
+    SDL_RenderFlush(ren);
+}
+
+int main(int argc, char** argv) {
+    bool useWindow = argc > 1 && strcmp(argv[1], "--window") == 0;
+    SDL_Window* window = NULL;
+    SDL_Surface* screen = NULL;
+    SDL_Renderer* ren;
+    if (useWindow) {
+        if (SDL_Init(SDL_INIT_VIDEO)) {
+            SDL_Log("Error: Failed to init SDL. SDL_Error: %s", SDL_GetError());
+            return 1;
+        }
+        window = SDL_CreateWindow("bench", 0, 0, CANVAS_SIZE, CANVAS_SIZE, SDL_WINDOW_HIDDEN);
+        ren = window ? SDL_CreateRenderer(window, -1, SDL_RENDERER_TARGETTEXTURE) : NULL;
+    } else {
+        screen = SDL_CreateRGBSurfaceWithFormat(0, CANVAS_SIZE, CANVAS_SIZE, 32, SDL_PIXELFORMAT);
+        ren = screen ? SDL_CreateSoftwareRenderer(screen) : NULL;
+    }
+    if (!ren) {
+        SDL_Log("Error: Failed to create renderer. SDL_Error: %s", SDL_GetError());
+        return 1;
+    }
+
+    TileGrid tiles;
+    if (initTileGrid(&tiles, CANVAS_SIZE, CANVAS_SIZE)) {
+        return 1;
+    }
+    // noise, so no tile is transparent and skipped
+    Uint32 random = 1;
+    std::vector<Pixel> row(CANVAS_SIZE);
+    for (int y = 0; y < CANVAS_SIZE; y++) {
+        for (int x = 0; x < CANVAS_SIZE; x++) {
+            Uint32 bits = nextBenchRandom(&random);
+            row[x] = (Pixel){(Uint8)bits, (Uint8)(bits >> 8), (Uint8)(bits >> 16), 255};
+        }
+        writeTileGridRect(&tiles, (SDL_Rect){0, y, CANVAS_SIZE, 1}, row.data(), CANVAS_SIZE * sizeof(Pixel));
+    }
+
+    SDL_Texture* canvasTexture = SDL_CreateTexture(ren, SDL_PIXELFORMAT, SDL_TEXTUREACCESS_TARGET, CANVAS_SIZE, CANVAS_SIZE);
+    TileTextureCache cache;
+    if (!canvasTexture || initTileTextureCache(&cache, ren, &tiles, (size_t)CANVAS_SIZE * CANVAS_SIZE * 4)) {
+        SDL_Log("Error: Failed to create canvas textures. SDL_Error: %s", SDL_GetError());
+        return 1;
+    }
+
+    SDL_RendererInfo info;
+    SDL_GetRendererInfo(ren, &info);
+    printf("canvas upload, %s renderer\n", info.name);
+    printf("%-12s %-22s %-22s %s\n", "changed", "per pixel (before)", "tile textures", "speedup");
+    // a small pen stamp, a big brush stroke, a fill, the whole canvas
+    const int sizes[] = {8, 64, 512, CANVAS_SIZE};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        // off the tile grid, like most changes are
+        int offset = sizes[i] < CANVAS_SIZE ? 37 : 0;
+        SDL_Rect rect = {offset, offset, sizes[i], sizes[i]};
+        double pixels = (double)rect.w * rect.h;
+        double before = pixels * measureCallsPerSecond([&]() {
+            drawPixelsOneByOne(ren, canvasTexture, &tiles, rect);
+        });
+        double after = pixels * measureCallsPerSecond([&]() {
+            drawPixelsByTile(ren, &cache, &tiles, rect);
+        });
+        printf("%5dx%-6d ", rect.w, rect.h);
+        printRate(before, "pixels");
+        printf("   ");
+        printRate(after, "pixels");
+        printf("   %.1fx\n", after / before);
+    }
+
+    destroyTileTextureCache(&cache);
+    SDL_DestroyTexture(canvasTexture);
+    destroyTileGrid(&tiles);
+    SDL_DestroyRenderer(ren);
+    if (window) {
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+    }
+    if (screen) {
+        SDL_FreeSurface(screen);
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*
+* Checks that the SIMD paths of the 32 bit zoomer, shrinker and Scale2x/Scale3x give exactly the same pixels
+* as plain C, then measures source pixels per second on 256x256, 2k x 2k and 8k x 8k images: plain C on one thread
+* (how they used to run), SIMD on one thread, and SIMD with rows split across the thread pool.
+* Pixel art is measured on a 1024x1024 sheet scaled by 2, 3, 4, 6 and 8, where 4 and 8 chain Scale2x.
+* Pass --check to only run the check. Exits with 1 if anything doesn't match.
+*/
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "Bench.hpp"
+#include "../ThreadPool.hpp"
+#include "../SDL2_gfx/SDL2_rotozoom.h"
+
+/*
+* A surface of random pixels.
+*/
+static SDL_Surface* createNoiseSurface(int width, int height, Uint32 seed) {
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!surface) {
+        return NULL;
+    }
+    for (int y = 0; y < height; y++) {
+        Uint32* row = (Uint32*)((Uint8*)surface->pixels + surface->pitch * y);
+        for (int x = 0; x < width; x++) {
+            row[x] = nextBenchRandom(&seed);
+        }
+    }
+    return surface;
+}
+
+/*
+* A surface of pixels picked at random from a few colors, so neighbours often match like they do in pixel art.
+*/
+static SDL_Surface* createPixelArtSurface(int width, int height, Uint32 seed) {
+    const Uint32 colors[] = {0xff000000, 0xffffffff, 0xff3070e0, 0x00000000};
+    SDL_Surface* surface = createNoiseSurface(width, height, seed);
+    if (!surface) {
+        return NULL;
+    }
+    for (int y = 0; y < height; y++) {
+        Uint32* row = (Uint32*)((Uint8*)surface->pixels + surface->pitch * y);
+        for (int x = 0; x < width; x++) {
+            row[x] = colors[row[x] % 4];
+        }
+    }
+    return surface;
+}
+
+static void parallelForOnPool(int count, void (*job)(void* data, int index), void* data) {
+    getThreadPool()->parallelFor(count, [&](int i) {
+        job(data, i);
+    });
+}
+
+/*
+* Zoom, or shrink when the factors are integers above 1, the way the thumbnails and exports do.
+*/
+static SDL_Surface* resize(SDL_Surface* src, double zoomx, double zoomy, int shrinkFactor) {
+    if (shrinkFactor > 1) {
+        return shrinkSurface(src, shrinkFactor, shrinkFactor);
+    }
+    return zoomSurface(src, zoomx, zoomy, SMOOTHING_ON);
+}
+
+static bool areSurfacesEqual(const SDL_Surface* a, const SDL_Surface* b) {
+    if (!a || !b || a->w != b->w || a->h != b->h) {
+        return false;
+    }
+    for (int y = 0; y < a->h; y++) {
+        if (memcmp((Uint8*)a->pixels + a->pitch * y, (Uint8*)b->pixels + b->pitch * y, a->w * 4) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+* Resize odd sized images every way the export pipeline does with SIMD off and on.
+* @return The number of resizes that came out different
+*/
+static int checkSIMD() {
+    struct {
+        double zoomx, zoomy;
+        int shrinkFactor;
+    } cases[] = {
+        {0.75, 0.75, 0}, {1.37, 2.9, 0}, {3.0, 3.0, 0}, {-0.6, 0.8, 0}, {0.45, -1.2, 0}, {-2.1, -0.33, 0},
+        {0, 0, 2}, {0, 0, 3}, {0, 0, 7},
+    };
+    const int sizes[][2] = {{1, 1}, {2, 3}, {37, 19}, {255, 256}, {301, 127}};
+    int mismatches = 0;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        SDL_Surface* src = createNoiseSurface(sizes[s][0], sizes[s][1], 12345 + s);
+        for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+            rotozoomSetSIMD(0);
+            SDL_Surface* expected = resize(src, cases[c].zoomx, cases[c].zoomy, cases[c].shrinkFactor);
+            rotozoomSetSIMD(1);
+            SDL_Surface* actual = resize(src, cases[c].zoomx, cases[c].zoomy, cases[c].shrinkFactor);
+            if (!areSurfacesEqual(expected, actual)) {
+                if (cases[c].shrinkFactor > 1) {
+                    printf("  %dx%d shrunk by %d differs\n", src->w, src->h, cases[c].shrinkFactor);
+                } else {
+                    printf("  %dx%d zoomed by %gx%g differs\n", src->w, src->h, cases[c].zoomx, cases[c].zoomy);
+                }
+                mismatches++;
+            }
+            SDL_FreeSurface(expected);
+            SDL_FreeSurface(actual);
+        }
+        SDL_FreeSurface(src);
+
+        // Scale2x and Scale3x, and chained one after the other
+        src = createPixelArtSurface(sizes[s][0], sizes[s][1], 54321 + s);
+        const int factors[] = {2, 3, 4, 6, 8};
+        for (size_t f = 0; f < sizeof(factors) / sizeof(factors[0]); f++) {
+            rotozoomSetSIMD(0);
+            SDL_Surface* expected = scalePixelArtSurface(src, factors[f], PIXELART_SCALENX);
+            rotozoomSetSIMD(1);
+            SDL_Surface* actual = scalePixelArtSurface(src, factors[f], PIXELART_SCALENX);
+            if (!areSurfacesEqual(expected, actual)) {
+                printf("  %dx%d pixel art scaled by %d differs\n", src->w, src->h, factors[f]);
+                mismatches++;
+            }
+            SDL_FreeSurface(expected);
+            SDL_FreeSurface(actual);
+        }
+        SDL_FreeSurface(src);
+    }
+    return mismatches;
+}
+
+int main(int argc, char** argv) {
+    bool checkOnly = argc > 1 && strcmp(argv[1], "--check") == 0;
+
+    int mismatches = checkSIMD();
+    printf("rotozoom SIMD: %s", mismatches ? "MISMATCH" : "matches C");
+    if (mismatches) {
+        printf(" in %d resizes", mismatches);
+    }
+    printf("\n");
+    if (checkOnly || mismatches) {
+        return mismatches ? 1 : 0;
+    }
+
+    printf("\nsmooth zoom by 0.75 and shrink by 2, %d worker threads\n", getThreadPool()->numWorkers());
+    printf("%-12s %-9s %-22s %-22s %-22s %s\n", "source", "resize", "C, 1 thread (before)", "SIMD, 1 thread",
+        "SIMD, thread pool", "speedup");
+    const int sizes[] = {256, 2048, 8192};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        SDL_Surface* src = createNoiseSurface(sizes[i], sizes[i], 1);
+        if (!src) {
+            SDL_Log("Error: Failed to create a %dx%d surface", sizes[i], sizes[i]);
+            return 1;
+        }
+        double pixels = (double)src->w * src->h;
+        for (int shrinkFactor = 0; shrinkFactor <= 2; shrinkFactor += 2) {
+            auto measure = [&](bool simd, bool threads) {
+                rotozoomSetSIMD(simd);
+                rotozoomSetParallelFor(threads ? parallelForOnPool : NULL);
+                return pixels * measureCallsPerSecond([&]() {
+                    SDL_FreeSurface(resize(src, 0.75, 0.75, shrinkFactor));
+                });
+            };
+            double before = measure(false, false);
+            double simd = measure(true, false);
+            double after = measure(true, true);
+            printf("%5dx%-6d %-9s ", src->w, src->h, shrinkFactor ? "shrink" : "zoom");
+            printRate(before, "pixels");
+            printf("   ");
+            printRate(simd, "pixels");
+            printf("   ");
+            printRate(after, "pixels");
+            printf("   %.1fx\n", after / before);
+        }
+        SDL_FreeSurface(src);
+    }
+
+    // a sprite sheet exported at 2x, 3x, 4x, 6x and 8x
+    SDL_Surface* sheet = createPixelArtSurface(1024, 1024, 1);
+    if (!sheet) {
+        SDL_Log("Error: Failed to create a 1024x1024 surface");
+        return 1;
+    }
+    printf("\n%-12s %-9s %-22s %-22s %-22s %s\n", "pixel art", "factor", "C, 1 thread", "SIMD, 1 thread",
+        "SIMD, thread pool", "speedup");
+    const int factors[] = {2, 3, 4, 6, 8};
+    for (size_t i = 0; i < sizeof(factors) / sizeof(factors[0]); i++) {
+        double pixels = (double)sheet->w * sheet->h;
+        auto measure = [&](bool simd, bool threads) {
+            rotozoomSetSIMD(simd);
+            rotozoomSetParallelFor(threads ? parallelForOnPool : NULL);
+            return pixels * measureCallsPerSecond([&]() {
+                SDL_FreeSurface(scalePixelArtSurface(sheet, factors[i], PIXELART_SCALENX));
+            });
+        };
+        double before = measure(false, false);
+        double simd = measure(true, false);
+        double after = measure(true, true);
+        printf("%5dx%-6d %-9d ", sheet->w, sheet->h, factors[i]);
+        printRate(before, "pixels");
+        printf("   ");
+        printRate(simd, "pixels");
+        printf("   ");
+        printRate(after, "pixels");
+        printf("   %.1fx\n", after / before);
+    }
+    SDL_FreeSurface(sheet);
+
+    rotozoomSetSIMD(1);
+    rotozoomSetParallelFor(NULL);
+    return 0;
+}
@@ -6,7 +6,9 @@
 #include <SDL2/SDL_image.h>
 
 #include "SDL2_gfx/SDL2_gfxPrimitives.h"
-#include "SDL_FontCache_Fork/SDL_FontCache.h"
+#include "SDL2_gfx/SDL2_rotozoom.h"
+#include "SDL2_gfx/SDL2_imageFilter.h"
+#include "SDL_FontCache/SDL_FontCache.h"
 
 #include "NC/cpp-vectors.hpp"
 #include "NC/SDLContext.h"
@@ -14,23 +16,80 @@
 #include "NC/SDLBuild.h"
 #include "NC/colors.h"
 
+#include "Pixel.hpp"
+#include "Tiles.hpp"
+#include "TileTextures.hpp"
+#include "History.hpp"
+#include "CanvasSave.hpp"
+#include "ProjectFile.hpp"
+#include "Brush.hpp"
+#include "Stroke.hpp"
+#include "Layers.hpp"
+#include "Fill.hpp"
+#include "Selection.hpp"
+#include "Transform.hpp"
+#include "ThreadPool.hpp"
+#include "FontAtlas.hpp"
+
+// max amount of video memory to use for canvas tile textures
+#define CANVAS_VRAM_BUDGET (256 * 1024 * 1024)
+// max amount of memory to use for undo history
+#define HISTORY_MEMORY_BUDGET (64 * 1024 * 1024)
+
 #define WINDOW_HIGH_DPI
 
 FC_Font *FreeSans;
 FC_Font *TitleFont;
 FC_Font* InfoFont;
+// the TTFs fonts loaded from baked atlases cache any other glyphs from, NULL for fonts that own their TTF
+TTF_Font* FreeSansTTF;
+TTF_Font* TitleFontTTF;
+TTF_Font* InfoFontTTF;
 SDL_Texture* tex;
 
-#define SDL_PIXELFORMAT SDL_PIXELFORMAT_RGBA8888 
-struct Pixel {
-    Uint8 r;
-    Uint8 g;
-    Uint8 b;
-    Uint8 a;
+// HUD text stays laid out between frames, and only gets laid out again when its string changes
+FC_Text* FpsText;
+FC_Text* SaveProgressText;
+FC_Text* TitleText;
+FC_Text* LayerText;
+FC_Text* ToolText;
+FC_Text* HelpText;
+
+// why the window has to be drawn again, as bit flags
+enum RedrawReason {
+    REDRAW_CANVAS = 1 << 0, // canvas pixels changed
+    REDRAW_VIEW = 1 << 1, // canvas was moved or zoomed
+    REDRAW_WINDOW = 1 << 2, // window was resized or needs its contents back
+    REDRAW_TEXT = 1 << 3, // fps or save progress text changed
+    REDRAW_ALL = REDRAW_CANVAS | REDRAW_VIEW | REDRAW_WINDOW | REDRAW_TEXT
 };
 
+// how often the fps text is allowed to change, in ms. otherwise it would force a redraw every frame
+#define FPS_TEXT_INTERVAL 500
+// longest to sleep waiting for events when there's nothing to draw, in ms
+#define IDLE_WAIT_TIMEOUT 500
+// same but while saving, so the progress text keeps moving
+#define IDLE_WAIT_TIMEOUT_SAVING 50
+
+/*
+* Keeps track of what changed since the last frame was drawn, so frames are only drawn when something would look different.
+*/
+struct FrameSchedule {
+    Uint32 redraw; // RedrawReason flags, 0 if the last frame is still up to date
+    float shownFps; // fps in the fps text
+    Uint32 shownFpsTime; // when the fps text was last updated
+    int shownSaveProgress; // percentage in the saving text, -1 if it isn't showing
+};
+
+FrameSchedule frameSchedule = {REDRAW_ALL, 0.0f, 0, -1};
+
+inline void invalidateFrame(Uint32 reasons) {
+    frameSchedule.redraw |= reasons;
+}
+
 struct Canvas {
-    Pixel* pixels; // pixel buffer
+    LayerStack layers; // pixel storage
+    int activeLayer; // index of the layer being drawn on
     int width;
     int height;
     int pixelSize; // pixel size before being scaled, usually just use scale instead of this.
@@ -43,12 +102,39 @@ struct Canvas {
     int windowOffsetX; // offset from window top left
     int windowOffsetY;
 
-    SDL_Texture* texture;
+    TileTextureCache tileTextures; // textures for the tiles that have been on screen
+    SDL_Rect dirtyRect; // area of the canvas changed since the last call to uploadCanvasChanges, empty if nothing changed
+
+    History history; // undo / redo of strokes
+    StrokeMask strokeMask; // pixels painted by the current stroke
+    SelectionMask selection; // pixels drawing is limited to. nothing selected means anything can be drawn on
+    std::vector<SDL_Rect> selectionOutline; // edges around the selection in canvas coordinates, see getSelectionOutline
+    FloatingPixels* floating; // pixels lifted off the active layer by the transform tool, NULL if not transforming
+    SaveJob* saveJob; // save in progress, NULL if not saving
+};
+
+// biggest pen size you can pick with [ and ]
+#define PEN_MAX_SIZE 128
+
+// what clicking on the canvas does
+enum PenTool {
+    PEN_TOOL_BRUSH, // draw strokes
+    PEN_TOOL_FILL, // bucket fill
+    PEN_TOOL_SELECT_RECT, // drag out a rectangle to select
+    PEN_TOOL_LASSO, // draw around an area to select it
+    PEN_TOOL_WAND, // select the area around a pixel that's the same color, like a fill
+    PEN_TOOL_TRANSFORM // move, scale and rotate the selected pixels
 };
 
 struct Pen {
+    PenTool tool;
     int size;
+    BrushShape shape;
+    bool smoothing; // smooth strokes into curves through the mouse positions instead of straight lines
     Pixel pixel;
+    BlendMode blendMode; // how the pen's color is blended onto the canvas
+    int fillTolerance; // how far colors can be from the clicked one and still get filled, 0 to 255
+    FillMode fillMode;
 };
 
 struct BasicButton {
@@ -90,10 +176,26 @@ class GUI {
     }
 };
 
-struct MouseState {
-    int mouseX;
-    int mouseY;
-    Uint32 mouseButtons;
+struct PenSample {
+    StrokePoint point; // in canvas coordinates
+    Uint32 buttons; // mouse buttons held at the time
+};
+
+/*
+* Mouse input collected from events, so strokes follow every position the mouse went through
+* instead of just where it was once per frame.
+*/
+struct PenInput {
+    std::vector<PenSample> samples; // collected since the last update, oldest first
+    Uint32 buttons; // mouse buttons held as of the newest event
+    Uint32 strokeButtons; // drawing buttons the current stroke was started with, 0 if not drawing
+    StrokePath path;
+    Uint32 toolButtons; // drawing buttons held with the fill and selection tools, so holding the mouse down only clicks once
+    SelectionOp selectionOp; // how the selection being dragged out will be combined with the current one
+    std::vector<SDL_FPoint> selectionPoints; // corners of the rect or points of the lasso being dragged out, in canvas coordinates
+    SDL_FPoint dragStart; // where the transform tool's drag started, in canvas coordinates
+    PixelTransform dragStartTransform; // the floating pixels' transform when the drag started
+    Uint16 dragMod; // modifier keys held when the drag started
 };
 
 struct Context {
@@ -103,16 +205,9 @@ struct Context {
     struct Canvas *canvas;
     Pen *pen;
     GUI *gui;
-    struct MouseState *mouseStateHistory;
-    int* mouseStateHistoryQueueIndex;
+    PenInput *penInput;
 };
 
-Pixel* createPixelBuffer(int width, int height) {
-    // initialize all pixels to all zeros, transparent black
-    Pixel* pixels = (Pixel*)calloc(width*height, sizeof(Pixel));
-    return pixels;
-}
-
 void renderPenSelectionButton(SDL_Renderer* ren, SDL_Rect* dst, SDL_Texture* texture) {
     SDL_SetRenderDrawColor(ren, 85, 85, 85, 255);
     SDL_RenderFillRect(ren, dst);
@@ -121,58 +216,169 @@ void renderPenSelectionButton(SDL_Renderer* ren, SDL_Rect* dst, SDL_Texture* tex
     SDL_RenderDrawRect(ren, dst);
 }
 
+inline TileGrid* getActiveTiles(Canvas* canvas) {
+    return &canvas->layers.layers[canvas->activeLayer].tiles;
+}
+
 /*
-* Draw on the canvas with the pen at the given coordinates.
-* @return The number of pixels drawn to the canvas
+* Grow the canvas dirty rect to include the given rect, clipped to the canvas bounds,
+* and mark it changed in the given layer so it gets composited again.
 */
-int penDrawOnCanvas(Canvas* canvas, Pen* pen, int canvasX, int canvasY, SDL_Renderer* ren) {
-    SDL_SetRenderTarget(ren, canvas->texture);
-    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+void markLayerDirty(Canvas* canvas, int layer, int x, int y, int w, int h) {
+    SDL_Rect canvasBounds = {0, 0, canvas->width, canvas->height};
+    SDL_Rect rect = {x, y, w, h};
+    SDL_Rect clipped;
+    if (!SDL_IntersectRect(&rect, &canvasBounds, &clipped)) {
+        return;
+    }
+    // SDL_UnionRect just takes the other rect if one of them is empty
+    SDL_UnionRect(&canvas->dirtyRect, &clipped, &canvas->dirtyRect);
+    invalidateLayerRect(&canvas->layers, layer, clipped);
+    invalidateFrame(REDRAW_CANVAS);
+}
 
-    // go through pixels selected by pen based on pen size
-    int pixelsDrawn = 0;
-    for (int pixelX = canvasX; pixelX < canvasX+pen->size; pixelX++) {
-        for (int pixelY = canvasY; pixelY < canvasY+pen->size; pixelY++) {
-            // we only check for the bottom and right edges as the pen size expansion
-            // only goes down and right, never up or left
-            if (pixelX < 0 || pixelX >= canvas->width || pixelY < 0 || pixelY >= canvas->height) {
-                // selected area went over the border, dont draw
-                continue;
-            }
-            Pixel* selectedPixel = &canvas->pixels[pixelX + pixelY * canvas->height];
-            // In the future, this might contain special tool stuff, for now just copy
-            *selectedPixel = pen->pixel;
-            Pixel pixel = *selectedPixel;
-
-            SDL_SetRenderDrawColor(ren, pixel.r, pixel.g, pixel.b, pixel.a);
-            SDL_RenderDrawPoint(ren, pixelX, pixelY);
-            
-            pixelsDrawn++;;
-        }
+/*
+* Same as markLayerDirty, for the active layer.
+*/
+void markCanvasDirty(Canvas* canvas, int x, int y, int w, int h) {
+    markLayerDirty(canvas, canvas->activeLayer, x, y, w, h);
+}
+
+/*
+* Flag the tile textures touching the dirty rect for re-upload, then clear the dirty rect.
+* Should be called once per frame, before rendering. Only tiles that are actually visible get uploaded, when they're drawn.
+*/
+void uploadCanvasChanges(Canvas* canvas) {
+    if (SDL_RectEmpty(&canvas->dirtyRect)) {
+        return;
     }
+    invalidateTileTextures(&canvas->tileTextures, &canvas->layers.composite, canvas->dirtyRect);
+    canvas->dirtyRect = (SDL_Rect){0, 0, 0, 0};
+}
 
-    SDL_SetRenderTarget(ren, NULL);
+/*
+* Draw a line on the canvas with the pen, from one pen position to another, as part of the current stroke.
+* Pixels already drawn by the stroke aren't drawn again.
+* @param paint What to draw, the pen's color blended with its mode, or erasing
+* Only the canvas tiles are written to, the changed tiles get re-uploaded to their textures later (see uploadCanvasChanges).
+* @return The number of pixels drawn to the canvas
+*/
+int penDrawOnCanvas(Canvas* canvas, Pen* pen, BrushPaint paint, int fromX, int fromY, int toX, int toY) {
+    SDL_Rect strokeRect = getStrokeSegmentBounds(pen->size, fromX, fromY, toX, toY);
+    recordTilesBeforeChange(&canvas->history, getActiveTiles(canvas), strokeRect);
+
+    // In the future, this might contain special tool stuff, for now just blend into the swept area
+    int pixelsDrawn = drawStrokeSegment(&canvas->strokeMask, getActiveTiles(canvas), pen->shape, pen->size,
+        fromX, fromY, toX, toY, paint);
+
+    markCanvasDirty(canvas, strokeRect.x, strokeRect.y, strokeRect.w, strokeRect.h);
 
     return pixelsDrawn;
 }
 
-void renderEntireCanvas(SDL_Renderer* ren, Canvas* canvas) {
-    SDL_SetRenderTarget(ren, canvas->texture);
-    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
-    SDL_SetRenderDrawColor(ren, 0, 0, 0, 0);
-    SDL_RenderClear(ren);
-    for (int x = 0; x < canvas->width; x++) {
-        for (int y = 0; y < canvas->height; y++) {
-            Pixel pixel = canvas->pixels[x + y*canvas->width];
+/*
+* Get the selection drawing should be limited to.
+* @return The canvas selection, or NULL if nothing is selected, so anything can be drawn on
+*/
+const SelectionMask* getDrawSelection(const Canvas* canvas) {
+    return isSelectionEmpty(&canvas->selection) ? NULL : &canvas->selection;
+}
 
-            SDL_SetRenderDrawColor(ren, pixel.r, pixel.g, pixel.b, pixel.a);
-            SDL_RenderDrawPoint(ren, x, y);
-        }
+/*
+* Bucket fill the active layer from a pixel, with the pen's fill tolerance and mode. Undone on its own.
+* Only selected pixels are filled, though the area to fill is found from the colors whether they're selected or not.
+* Only the filled area gets marked dirty.
+* @return The number of pixels filled
+*/
+int fillCanvas(Canvas* canvas, Pen* pen, BrushPaint paint, int x, int y) {
+    TileGrid* tiles = getActiveTiles(canvas);
+    FillRegion region;
+    if (!findFillRegion(tiles, x, y, pen->fillTolerance, pen->fillMode, &paint, &region)) {
+        return 0;
+    }
+    SDL_Rect bounds = region.bounds;
+    endHistoryStroke(&canvas->history, tiles);
+    beginHistoryStroke(&canvas->history, canvas->activeLayer);
+    recordTilesBeforeChange(&canvas->history, tiles, bounds);
+    paintFillRegion(tiles, &region, paint, getDrawSelection(canvas));
+    if (paint.mode == BLEND_ERASE) {
+        releaseTransparentTiles(tiles, bounds);
+    }
+    endHistoryStroke(&canvas->history, tiles);
+    markCanvasDirty(canvas, bounds.x, bounds.y, bounds.w, bounds.h);
+    return region.pixelCount;
+}
+
+/*
+* Draw the outline of a polygon in canvas coordinates, closing it back to the first point.
+* @param srcRect The part of the canvas in view
+* @param dstRect Where that part of the canvas is drawn on screen
+*/
+void renderCanvasPolygon(SDL_Renderer* ren, const std::vector<SDL_FPoint>& points, SDL_Rect srcRect, SDL_Rect dstRect) {
+    float scaleX = (float)dstRect.w / srcRect.w;
+    float scaleY = (float)dstRect.h / srcRect.h;
+    std::vector<SDL_Point> screenPoints;
+    for (size_t i = 0; i <= points.size(); i++) {
+        const SDL_FPoint& point = points[i % points.size()];
+        screenPoints.push_back((SDL_Point){
+            dstRect.x + (int)((point.x - srcRect.x) * scaleX),
+            dstRect.y + (int)((point.y - srcRect.y) * scaleY)
+        });
     }
-    SDL_SetRenderTarget(ren, NULL);
+    SDL_RenderDrawLines(ren, screenPoints.data(), (int)screenPoints.size());
 }
 
-void render(SDL_Renderer* ren, float scale, const Canvas* canvas, Pen *pen, GUI *gui, MetaData* metadata) {
+/*
+* Draw the selection outline and the selection being dragged out, if there is one, over the canvas.
+* While pixels are being transformed, their corners are drawn instead.
+* @param srcRect The part of the canvas in view
+* @param dstRect Where that part of the canvas is drawn on screen
+*/
+void renderSelection(SDL_Renderer* ren, const Canvas* canvas, const Pen* pen, const PenInput* input, SDL_Rect srcRect, SDL_Rect dstRect) {
+    SDL_SetRenderDrawColor(ren, 0, 120, 255, 255);
+    if (canvas->floating) {
+        // the selection only catches up with the pixels once they're put down
+        SDL_FPoint corners[4];
+        getFloatingPixelsCorners(canvas->floating, corners);
+        renderCanvasPolygon(ren, std::vector<SDL_FPoint>(corners, corners + 4), srcRect, dstRect);
+        return;
+    }
+
+    float scaleX = (float)dstRect.w / srcRect.w;
+    float scaleY = (float)dstRect.h / srcRect.h;
+    std::vector<SDL_Rect> screenEdges;
+    for (size_t i = 0; i < canvas->selectionOutline.size(); i++) {
+        const SDL_Rect& edge = canvas->selectionOutline[i];
+        if (edge.x + edge.w < srcRect.x || edge.x > srcRect.x + srcRect.w
+            || edge.y + edge.h < srcRect.y || edge.y > srcRect.y + srcRect.h) continue;
+        // edges are lines, so they get drawn 1 screen pixel thick
+        SDL_Rect screenEdge = {
+            dstRect.x + (int)((edge.x - srcRect.x) * scaleX),
+            dstRect.y + (int)((edge.y - srcRect.y) * scaleY),
+            edge.w ? (int)ceilf(edge.w * scaleX) : 1,
+            edge.h ? (int)ceilf(edge.h * scaleY) : 1
+        };
+        screenEdges.push_back(screenEdge);
+    }
+    if (!screenEdges.empty()) {
+        SDL_RenderFillRects(ren, screenEdges.data(), (int)screenEdges.size());
+    }
+
+    const std::vector<SDL_FPoint>& points = input->selectionPoints;
+    if (points.size() < 2) {
+        return;
+    }
+    std::vector<SDL_FPoint> shape;
+    if (pen->tool == PEN_TOOL_SELECT_RECT) {
+        SDL_FPoint a = points.front(), b = points.back();
+        shape = {a, {b.x, a.y}, b, {a.x, b.y}};
+    } else {
+        shape = points;
+    }
+    renderCanvasPolygon(ren, shape, srcRect, dstRect);
+}
+
+void render(SDL_Renderer* ren, float scale, Canvas* canvas, Pen *pen, const PenInput* input, GUI *gui, const FrameSchedule* frame) {
     // get window size in pixels
     int renWidth;
     int renHeight;
@@ -202,8 +408,10 @@ void render(SDL_Renderer* ren, float scale, const Canvas* canvas, Pen *pen, GUI
         visibleCanvasHeight
     };
 
-    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-    SDL_RenderCopy(ren, canvas->texture, &transformedCanvasRect, &canvasRect);
+    // only the tiles in view get composited and drawn
+    compositeLayerTiles(&canvas->layers, transformedCanvasRect, true);
+    renderTileGrid(&canvas->tileTextures, &canvas->layers.composite, transformedCanvasRect, canvasRect);
+    renderSelection(ren, canvas, pen, input, transformedCanvasRect, canvasRect);
 
     SDL_SetRenderDrawColor(ren, 255, 0, 255, 255);
     SDL_RenderDrawRect(ren, &canvasRect);
@@ -211,13 +419,57 @@ void render(SDL_Renderer* ren, float scale, const Canvas* canvas, Pen *pen, GUI
     /* Draw GUI */
     // gui->draw(ren);
 
-    FC_Draw(FreeSans, ren, 5*scale, 5*scale, "FPS: %.2f", metadata->fps);
+    // all the HUD text goes out in one draw call per glyph cache texture
+    FC_BeginBatch();
+    FC_SetTextString(FpsText, "FPS: %.2f", frame->shownFps);
+    FC_DrawText(FpsText, ren, 5*scale, 5*scale);
+
+    if (frame->shownSaveProgress >= 0) {
+        FC_SetTextString(SaveProgressText, "Saving... %d%% (Esc to cancel)", frame->shownSaveProgress);
+        FC_DrawText(SaveProgressText, ren, 5*scale, 32*scale);
+    }
 
-    FC_DrawAlign(TitleFont, ren, renWidth/2, 17*scale, FC_HALIGN_CENTER, "Pixel Art Maker");
+    FC_DrawText(TitleText, ren, renWidth/2, 17*scale);
+
+    const Layer* activeLayer = &canvas->layers.layers[canvas->activeLayer];
+    FC_SetTextString(LayerText, "Layer %d/%d: %s %d%%%s",
+        canvas->activeLayer + 1, getLayerCount(&canvas->layers), getBlendModeName(activeLayer->blendMode),
+        (int)(activeLayer->opacity * 100 + 0.5f), activeLayer->visible ? "" : " (hidden)");
+    FC_DrawText(LayerText, ren, renWidth - 5*scale, 5*scale);
+    switch (pen->tool) {
+        case PEN_TOOL_FILL:
+            FC_SetTextString(ToolText, "Fill: %s, tolerance %d%s",
+                getBlendModeName(pen->blendMode), pen->fillTolerance, pen->fillMode == FILL_GLOBAL ? ", global" : "");
+            break;
+        case PEN_TOOL_SELECT_RECT:
+            FC_SetTextString(ToolText, "Rectangle select");
+            break;
+        case PEN_TOOL_LASSO:
+            FC_SetTextString(ToolText, "Lasso select");
+            break;
+        case PEN_TOOL_WAND:
+            FC_SetTextString(ToolText, "Magic wand: tolerance %d%s",
+                pen->fillTolerance, pen->fillMode == FILL_GLOBAL ? ", global" : "");
+            break;
+        case PEN_TOOL_TRANSFORM:
+            if (canvas->floating) {
+                const PixelTransform& transform = canvas->floating->transform;
+                FC_SetTextString(ToolText, "Transform: %d%%, %d degrees",
+                    (int)(fabsf(transform.zoomX) * 100 + 0.5f), (int)floorf(transform.angle + 0.5f));
+            } else {
+                FC_SetTextString(ToolText, NULL);
+            }
+            break;
+        default:
+            FC_SetTextString(ToolText, "Pen: %s", getBlendModeName(pen->blendMode));
+            break;
+    }
+    FC_DrawText(ToolText, ren, renWidth - 5*scale, 32*scale);
 
-    FC_DrawAny(InfoFont, ren, 5, renHeight - 5, FC_HALIGN_LEFT, FC_VALIGN_BOTTOM, FC_MakeScale(1, 1), FC_MakeColor(0,0,0,255),
-    "Left mouse to draw, right mouse to erase.\n"
-    "Scroll with mouse to zoom in/out, arrow keys to move around when zoomed.");
+    // the help text is bottom aligned
+    FC_Rect helpBounds = FC_GetTextBounds(HelpText);
+    FC_DrawText(HelpText, ren, 5, renHeight - 5 - (helpBounds.y + helpBounds.h));
+    FC_EndBatch();
 
     SDL_RenderPresent(ren);
 }
@@ -252,6 +504,7 @@ inline void translateCanvas(Canvas* canvas, int translationX, int translationY)
 
     canvas->translateX = translateX;
     canvas->translateY = translateY;
+    invalidateFrame(REDRAW_VIEW);
 }
 
 void resizeCanvas(Canvas* canvas, int windowWidth, int windowHeight, float renderScale) {\
@@ -282,78 +535,629 @@ void resizeCanvas(Canvas* canvas, int windowWidth, int windowHeight, float rende
 
     canvas->pixelSize = pixelSize;
     canvas->scale = pixelSize * renderScale;
+    invalidateFrame(REDRAW_WINDOW);
 }
 
 /*
-* Reload the canvas with a new texture, pixel buffer, etc.
+* Reload the canvas with new empty tiles, tile textures, etc.
 * Does NOT change things like the pixel scale, window offset, etc. So it's most likely necessary to call resizeCanvas after calling this.
 */
 void reloadCanvas(Canvas* canvas, int width, int height, SDL_Renderer* renderer) {
     canvas->width = width;
     canvas->height = height;
-    if (canvas->pixels) {
-        free(canvas->pixels);
+    destroyLayerStack(&canvas->layers);
+    initLayerStack(&canvas->layers, width, height);
+    canvas->activeLayer = 0;
+    clearHistory(&canvas->history);
+    destroySelection(&canvas->selection);
+    initSelection(&canvas->selection, width, height);
+    canvas->selectionOutline.clear();
+    if (canvas->floating) {
+        // the layer they were lifted from is gone
+        destroyFloatingPixels(canvas->floating);
+        delete canvas->floating;
+        canvas->floating = NULL;
+    }
+    // tile textures start out dirty, so there's nothing else to upload
+    destroyTileTextureCache(&canvas->tileTextures);
+    initTileTextureCache(&canvas->tileTextures, renderer, &canvas->layers.composite, CANVAS_VRAM_BUDGET);
+    canvas->dirtyRect = (SDL_Rect){0, 0, 0, 0};
+    invalidateFrame(REDRAW_ALL);
+}
+
+#define SAVE_FILE "art.pxa"
+#define EXPORT_FILE "art.png"
+
+/*
+* Start saving the canvas in the background. If a save is already going, it's cancelled and replaced,
+* since the new one will have the latest changes anyway.
+* @param format SAVE_FORMAT_PROJECT to save the project, SAVE_FORMAT_PNG to export an image
+* @return 0 if the save was started, -1 on error
+*/
+int saveCanvas(Canvas* canvas, SaveFormat format) {
+    if (canvas->saveJob) {
+        cancelSave(canvas->saveJob);
+        finishSave(canvas->saveJob);
     }
-    canvas->pixels = createPixelBuffer(width, height);
-    if (canvas->texture) {
-        SDL_DestroyTexture(canvas->texture);
+    canvas->saveJob = startSave(&canvas->layers, format == SAVE_FORMAT_PROJECT ? SAVE_FILE : EXPORT_FILE, format);
+    if (!canvas->saveJob) {
+        SDL_Log("Error: Failed to save canvas.");
+        return -1;
     }
-    canvas->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT, SDL_TEXTUREACCESS_TARGET, width, height);
-    SDL_SetTextureBlendMode(canvas->texture, SDL_BLENDMODE_BLEND);
+    return 0;
 }
 
-int writePixelBufferToFile(Pixel *buffer, int width, int height, const char* file) {
-    if (!buffer) return -1;
-    if (!file) return -1;
+/*
+* Check in on the background save, cleaning it up once it's done.
+*/
+void updateCanvasSave(Canvas* canvas) {
+    if (!canvas->saveJob || getSaveState(canvas->saveJob) == SAVE_RUNNING) {
+        return;
+    }
+    SaveState state = finishSave(canvas->saveJob);
+    canvas->saveJob = NULL;
+    if (state == SAVE_DONE) {
+        SDL_Log("Saved canvas.");
+    } else if (state == SAVE_CANCELLED) {
+        SDL_Log("Canvas save cancelled.");
+    } else {
+        SDL_Log("Error: Failed to save canvas.");
+    }
+}
 
-    SDL_Surface* bufferSurface = SDL_CreateRGBSurfaceWithFormatFrom(buffer, width, height, 64, width * 4, SDL_PIXELFORMAT_RGBA8888);
-    if (!bufferSurface) {
-        SDL_Log("Error: Failed to create surface to save to file.");
+/*
+* Load the saved project. Only the tiles that end up on screen (or get drawn on) are decompressed.
+*/
+int loadCanvasFromSave(Canvas* canvas, SDL_Renderer* renderer) {
+    LayerStack loaded;
+    if (openProjectFile(SAVE_FILE, &loaded)) {
         return -1;
     }
-    ((Uint32*)bufferSurface->pixels)[0] = 0xFF0000FF;
-    IMG_SavePNG(bufferSurface, "ayooooo.png");
-    if (IMG_SavePNG(bufferSurface, file)) {
-        SDL_Log("Error saving pixel buffer to file, IMG_Error: %s", IMG_GetError());
-        SDL_FreeSurface(bufferSurface);
+    reloadCanvas(canvas, loaded.width, loaded.height, renderer);
+    destroyLayerStack(&canvas->layers);
+    canvas->layers = loaded;
+    canvas->activeLayer = getLayerCount(&canvas->layers) - 1;
+    return 0;
+}
+
+/*
+* Replace the canvas with an image file.
+*/
+int importCanvasImage(Canvas* canvas, SDL_Renderer* renderer) {
+    SDL_Surface* surface = IMG_Load(EXPORT_FILE);
+    if (!surface) {
+        SDL_Log("Error: Failed to load image to import.");
         return -1;
     }
 
-    SDL_FreeSurface(bufferSurface);
+    // get the surface in the same byte order as Pixel, whatever format the file was in
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(surface);
+    if (!converted) {
+        SDL_Log("Error: Failed to convert imported image surface. SDL_Error: %s", SDL_GetError());
+        return -1;
+    }
+
+    reloadCanvas(canvas, converted->w, converted->h, renderer);
+    SDL_Rect canvasRect = {0, 0, converted->w, converted->h};
+    writeTileGridRect(getActiveTiles(canvas), canvasRect, (Pixel*)converted->pixels, converted->pitch);
 
+    SDL_FreeSurface(converted);
     return 0;
 }
 
-#define SAVE_FILE "art.png"
+bool windowFocused = false;
+
+#define PEN_DRAW_BUTTONS (SDL_BUTTON_LMASK | SDL_BUTTON_RMASK)
 
-int saveCanvas(Canvas* canvas) {
-    return writePixelBufferToFile(canvas->pixels, canvas->width, canvas->height, SAVE_FILE);
+/*
+* Queue a mouse position for the pen to draw through on the next update.
+* @param mouseX Mouse x in window coordinates, scaled to actual pixels
+*/
+void addPenSample(PenInput* input, Canvas* canvas, int mouseX, int mouseY, Uint32 buttons, Uint32 timestamp) {
+    Vec2 canvasPos = screenToCanvasCoords(canvas, mouseX, mouseY);
+    PenSample sample;
+    sample.point = (StrokePoint){canvasPos.x, canvasPos.y, timestamp};
+    sample.buttons = buttons;
+    input->samples.push_back(sample);
+    input->buttons = buttons;
 }
 
-int loadCanvasFromSave(Canvas* canvas, SDL_Renderer* renderer) {
-    SDL_Surface* surface = IMG_Load(SAVE_FILE);
-    if (!surface) {
-        SDL_Log("Error: Failed to load saved canvas from file.");
-        SDL_FreeSurface(surface);
-        return -1;
+/*
+* Get what a stroke drawn with the given mouse buttons puts down: erasing completely with right mouse,
+* otherwise the pen's color blended with the pen's mode.
+*/
+BrushPaint getPenStrokePaint(Pen* pen, Uint32 buttons) {
+    if (buttons & SDL_BUTTON_RMASK) {
+        return (BrushPaint){(Pixel){0, 0, 0, 255}, BLEND_ERASE};
     }
+    return (BrushPaint){pen->pixel, pen->blendMode};
+}
 
+void endPenStroke(Canvas* canvas, Pen* pen, PenInput* input) {
+    BrushPaint paint = getPenStrokePaint(pen, input->strokeButtons);
+    flushStrokePath(&input->path, [&](int fromX, int fromY, int toX, int toY) {
+        penDrawOnCanvas(canvas, pen, paint, fromX, fromY, toX, toY);
+    });
+    if (paint.mode == BLEND_ERASE) {
+        // erasing might have cleared whole tiles, which don't need to stay allocated
+        releaseTransparentTiles(getActiveTiles(canvas), canvas->dirtyRect);
+    }
+    endHistoryStroke(&canvas->history, getActiveTiles(canvas));
+    destroyStrokeMask(&canvas->strokeMask);
+    input->strokeButtons = 0;
+}
 
+inline bool isSelectionTool(PenTool tool) {
+    return tool == PEN_TOOL_SELECT_RECT || tool == PEN_TOOL_LASSO || tool == PEN_TOOL_WAND;
+}
 
-    reloadCanvas(canvas, surface->w, surface->h, renderer);
-    int surfaceSize = surface->w * surface->h;
+/*
+* Call after the canvas selection changes to redraw its outline.
+*/
+void updateSelectionOutline(Canvas* canvas) {
+    getSelectionOutline(&canvas->selection, &canvas->selectionOutline);
+    invalidateFrame(REDRAW_CANVAS);
+}
 
-    memcpy(canvas->pixels, surface->pixels, surfaceSize * sizeof(Pixel));
-    
+/*
+* Replace the canvas selection, or combine a new selection into it.
+*/
+void changeCanvasSelection(Canvas* canvas, const SelectionMask* shape, SelectionOp op) {
+    combineSelection(&canvas->selection, shape, op);
+    updateSelectionOutline(canvas);
+}
 
-    SDL_FreeSurface(surface);
-    return 0;
+/*
+* Get how a new selection combines with the current one: right mouse or alt subtracts, shift adds,
+* shift and alt together intersect, and otherwise it replaces the selection.
+*/
+SelectionOp getSelectionOp(Uint32 buttons, Uint16 mod) {
+    bool shift = (mod & KMOD_SHIFT) != 0;
+    bool subtract = (mod & KMOD_ALT) || (buttons & SDL_BUTTON_RMASK);
+    if (shift && subtract) return SELECTION_INTERSECT;
+    if (shift) return SELECTION_ADD;
+    if (subtract) return SELECTION_SUBTRACT;
+    return SELECTION_REPLACE;
 }
 
-bool windowFocused = false;
+/*
+* Handle a pen sample with one of the selection tools. Rects and lassos are dragged out while the mouse is held
+* and applied when it's let go, the magic wand selects on click.
+*/
+void handleSelectionSample(Canvas* canvas, Pen* pen, PenInput* input, const PenSample& sample, Uint32 drawButtons) {
+    bool pressed = drawButtons && !input->toolButtons;
+    bool released = !drawButtons && input->toolButtons;
+    SDL_FPoint point = {sample.point.x, sample.point.y};
+    if (pressed) {
+        input->selectionOp = getSelectionOp(drawButtons, SDL_GetModState());
+        input->selectionPoints.clear();
+    }
+    input->toolButtons = drawButtons;
+
+    SelectionMask shape;
+    initSelection(&shape, canvas->width, canvas->height);
+    bool changed = false;
+    if (pen->tool == PEN_TOOL_WAND) {
+        if (pressed) {
+            FillRegion region;
+            findFillRegion(getActiveTiles(canvas), (int)floor(point.x), (int)floor(point.y),
+                pen->fillTolerance, pen->fillMode, NULL, &region);
+            selectFillRegion(&shape, &region);
+            changed = true;
+        }
+    } else if (drawButtons) {
+        std::vector<SDL_FPoint>& points = input->selectionPoints;
+        if (pen->tool == PEN_TOOL_SELECT_RECT && points.size() >= 2) {
+            // only the corners matter
+            points.back() = point;
+        } else if (points.empty() || fabsf(point.x - points.back().x) + fabsf(point.y - points.back().y) >= 1.0f) {
+            points.push_back(point);
+        }
+        // for the outline being dragged out
+        invalidateFrame(REDRAW_CANVAS);
+    } else if (released) {
+        const std::vector<SDL_FPoint>& points = input->selectionPoints;
+        if (pen->tool == PEN_TOOL_SELECT_RECT && !points.empty()) {
+            // every pixel the drag went over, so clicking without dragging selects nothing
+            SDL_FPoint a = points.front(), b = points.back();
+            int x0 = (int)floor(std::min(a.x, b.x)), y0 = (int)floor(std::min(a.y, b.y));
+            int x1 = (int)floor(std::max(a.x, b.x)), y1 = (int)floor(std::max(a.y, b.y));
+            if (x0 != x1 || y0 != y1) {
+                selectRect(&shape, (SDL_Rect){x0, y0, x1 - x0 + 1, y1 - y0 + 1});
+            }
+        } else {
+            selectPolygon(&shape, points);
+        }
+        input->selectionPoints.clear();
+        changed = true;
+    }
+    if (changed) {
+        changeCanvasSelection(canvas, &shape, input->selectionOp);
+    }
+    destroySelection(&shape);
+}
+
+// smallest and biggest the transform tool scales to
+#define TRANSFORM_MIN_ZOOM (1.0f / 64)
+#define TRANSFORM_MAX_ZOOM 64.0f
+// rotation steps with shift held
+#define TRANSFORM_ANGLE_SNAP 15.0f
+
+/*
+* Draw the floating pixels over the active layer with their current transform.
+* @param smooth Resample with bilinear filtering instead of nearest neighbor, for putting them down
+*/
+void drawCanvasTransform(Canvas* canvas, bool smooth) {
+    FloatingPixels* floating = canvas->floating;
+    TileGrid* tiles = getActiveTiles(canvas);
+    // what the last draw covered gets put back, and the new area drawn on
+    recordTilesBeforeChange(&canvas->history, tiles, floating->drawnRect);
+    recordTilesBeforeChange(&canvas->history, tiles, getFloatingPixelsRect(floating));
+    SDL_Rect changed = drawFloatingPixels(floating, tiles, smooth);
+    markCanvasDirty(canvas, changed.x, changed.y, changed.w, changed.h);
+}
+
+/*
+* Lift the selected pixels off the active layer (the whole layer if nothing's selected) to transform them.
+* Everything up to putting them down is recorded as one stroke, so it's undone in one go.
+*/
+void beginCanvasTransform(Canvas* canvas) {
+    FloatingPixels* floating = new FloatingPixels;
+    TileGrid* tiles = getActiveTiles(canvas);
+    if (!liftPixels(floating, tiles, getDrawSelection(canvas))) {
+        delete floating;
+        return;
+    }
+    endHistoryStroke(&canvas->history, tiles);
+    beginHistoryStroke(&canvas->history, canvas->activeLayer);
+    canvas->floating = floating;
+    drawCanvasTransform(canvas, false);
+}
+
+/*
+* Put the floating pixels down for good, resampling them smoothly, or put the layer back how it was before they were lifted.
+*/
+void endCanvasTransform(Canvas* canvas, bool apply) {
+    FloatingPixels* floating = canvas->floating;
+    if (!floating) {
+        return;
+    }
+    TileGrid* tiles = getActiveTiles(canvas);
+    if (apply) {
+        drawCanvasTransform(canvas, true);
+        if (!isSelectionEmpty(&canvas->selection)) {
+            transformSelection(floating, &canvas->selection);
+        }
+    } else {
+        SDL_Rect changed = restoreFloatingPixels(floating, tiles);
+        markCanvasDirty(canvas, changed.x, changed.y, changed.w, changed.h);
+    }
+    // where the pixels were cut out might be empty now
+    SDL_Rect touched;
+    SDL_UnionRect(&floating->drawnRect, &floating->sourceRect, &touched);
+    releaseTransparentTiles(tiles, touched);
+    endHistoryStroke(&canvas->history, tiles);
+
+    destroyFloatingPixels(floating);
+    delete floating;
+    canvas->floating = NULL;
+    updateSelectionOutline(canvas);
+    invalidateFrame(REDRAW_TEXT);
+}
+
+/*
+* Switch the pen to a tool, or back to the brush if it's already using it.
+*/
+void switchPenTool(Canvas* canvas, Pen* pen, PenInput* input, PenTool tool) {
+    if (input->strokeButtons) {
+        endPenStroke(canvas, pen, input);
+    }
+    endCanvasTransform(canvas, true);
+    // buttons already held don't count as clicks for the new tool, and a selection being dragged out is dropped
+    input->toolButtons = input->buttons & PEN_DRAW_BUTTONS;
+    input->selectionPoints.clear();
+    pen->tool = (pen->tool == tool) ? PEN_TOOL_BRUSH : tool;
+    if (pen->tool == PEN_TOOL_TRANSFORM) {
+        beginCanvasTransform(canvas);
+        if (!canvas->floating) {
+            // nothing to lift
+            pen->tool = PEN_TOOL_BRUSH;
+        }
+    }
+    invalidateFrame(REDRAW_CANVAS | REDRAW_TEXT);
+}
+
+/*
+* Put the floating pixels down for good if there are any. The transform tool is only ever used with pixels floating,
+* so it goes back to the brush too, the same as pressing Enter.
+*/
+void endPenTransform(Canvas* canvas, Pen* pen, PenInput* input) {
+    if (pen->tool == PEN_TOOL_TRANSFORM) {
+        switchPenTool(canvas, pen, input, PEN_TOOL_TRANSFORM);
+    } else {
+        endCanvasTransform(canvas, true);
+    }
+}
+
+/*
+* Handle a pen sample with the transform tool. Dragging with left mouse moves the floating pixels, with shift it scales them,
+* and dragging with right mouse rotates them around their center (in steps with shift).
+* @return true if the transform changed
+*/
+bool handleTransformSample(Canvas* canvas, PenInput* input, const PenSample& sample, Uint32 drawButtons) {
+    FloatingPixels* floating = canvas->floating;
+    bool pressed = drawButtons && !input->toolButtons;
+    input->toolButtons = drawButtons;
+    if (!floating || !drawButtons) {
+        return false;
+    }
+    SDL_FPoint point = {sample.point.x, sample.point.y};
+    if (pressed) {
+        input->dragStart = point;
+        input->dragStartTransform = floating->transform;
+        input->dragMod = SDL_GetModState();
+    }
+
+    const PixelTransform& start = input->dragStartTransform;
+    PixelTransform transform = start;
+    // from the center to where the drag started, and to where it is now
+    float startX = input->dragStart.x - start.centerX;
+    float startY = input->dragStart.y - start.centerY;
+    float currentX = point.x - start.centerX;
+    float currentY = point.y - start.centerY;
+    bool shift = (input->dragMod & KMOD_SHIFT) != 0;
+    if (drawButtons & SDL_BUTTON_RMASK) {
+        // y goes down, so it's flipped to turn counterclockwise like the angle
+        float turned = (atan2f(-currentY, currentX) - atan2f(-startY, startX)) * 180.0f / (float)M_PI;
+        float angle = start.angle + turned;
+        if (shift) {
+            angle = roundf(angle / TRANSFORM_ANGLE_SNAP) * TRANSFORM_ANGLE_SNAP;
+        }
+        transform.angle = fmodf(angle + 360.0f, 360.0f);
+    } else if (shift) {
+        float startDistance = hypotf(startX, startY);
+        if (startDistance < 1.0f) {
+            // too close to the center to tell how far it moved
+            return false;
+        }
+        float scale = hypotf(currentX, currentY) / startDistance;
+        float zoom = std::max(TRANSFORM_MIN_ZOOM, std::min(fabsf(start.zoomX) * scale, TRANSFORM_MAX_ZOOM));
+        scale = zoom / fabsf(start.zoomX);
+        transform.zoomX = start.zoomX * scale;
+        transform.zoomY = start.zoomY * scale;
+    } else {
+        // whole pixels, so moving doesn't change how the pixels get sampled
+        transform.centerX = start.centerX + roundf(point.x - input->dragStart.x);
+        transform.centerY = start.centerY + roundf(point.y - input->dragStart.y);
+    }
+    if (memcmp(&transform, &floating->transform, sizeof(PixelTransform)) == 0) {
+        return false;
+    }
+    floating->transform = transform;
+    invalidateFrame(REDRAW_TEXT);
+    return true;
+}
+
+/*
+* Draw strokes through all the pen samples collected since the last update, or fill or select with the other tools.
+* Left mouse draws with the pen, right mouse erases.
+*/
+void drawPenInput(Canvas* canvas, Pen* pen, PenInput* input) {
+    // the transform is only drawn once per update, however many samples changed it
+    bool transformChanged = false;
+    for (size_t i = 0; i < input->samples.size(); i++) {
+        const PenSample& sample = input->samples[i];
+        Uint32 drawButtons = sample.buttons & PEN_DRAW_BUTTONS;
+        if (pen->tool == PEN_TOOL_FILL) {
+            Uint32 pressed = drawButtons & ~input->toolButtons;
+            input->toolButtons = drawButtons;
+            if (pressed) {
+                fillCanvas(canvas, pen, getPenStrokePaint(pen, pressed),
+                    (int)floor(sample.point.x), (int)floor(sample.point.y));
+            }
+            continue;
+        }
+        if (isSelectionTool(pen->tool)) {
+            handleSelectionSample(canvas, pen, input, sample, drawButtons);
+            continue;
+        }
+        if (pen->tool == PEN_TOOL_TRANSFORM) {
+            transformChanged |= handleTransformSample(canvas, input, sample, drawButtons);
+            continue;
+        }
+        if (drawButtons != input->strokeButtons) {
+            // pressing or letting go of a button ends the stroke and maybe starts a new one
+            if (input->strokeButtons) {
+                endPenStroke(canvas, pen, input);
+            }
+            if (drawButtons) {
+                // everything drawn while the mouse is held down is painted as one stroke, so overlapping parts aren't drawn twice
+                beginStrokeMask(&canvas->strokeMask, getActiveTiles(canvas), getDrawSelection(canvas));
+                beginStrokePath(&input->path, pen->smoothing);
+                input->strokeButtons = drawButtons;
+            }
+        }
+        if (!drawButtons) continue;
+
+        // and undone together. undo ends the history stroke early, so this might need to start a new one in the middle of a stroke
+        if (!canvas->history.recording) {
+            beginHistoryStroke(&canvas->history, canvas->activeLayer);
+        }
+        BrushPaint paint = getPenStrokePaint(pen, drawButtons);
+        addStrokePoint(&input->path, sample.point, [&](int fromX, int fromY, int toX, int toY) {
+            penDrawOnCanvas(canvas, pen, paint, fromX, fromY, toX, toY);
+        });
+    }
+
+    if (input->strokeButtons && input->samples.empty()) {
+        // the mouse is being held still, so catch up to it instead of waiting for it to move
+        BrushPaint paint = getPenStrokePaint(pen, input->strokeButtons);
+        flushStrokePath(&input->path, [&](int fromX, int fromY, int toX, int toY) {
+            penDrawOnCanvas(canvas, pen, paint, fromX, fromY, toX, toY);
+        });
+    }
+    input->samples.clear();
+
+    if (transformChanged) {
+        drawCanvasTransform(canvas, false);
+    }
+
+    if (input->strokeButtons && getPenStrokePaint(pen, input->strokeButtons).mode == BLEND_ERASE
+        && !SDL_RectEmpty(&canvas->dirtyRect)) {
+        // the dirty rect covers everything erased since the last upload
+        releaseTransparentTiles(getActiveTiles(canvas), canvas->dirtyRect);
+    }
+}
+
+/*
+* Whether there's pen input left to draw even if no more events come in, so the next update shouldn't sleep.
+* The newest segment of a smoothed stroke waits for the next mouse position, and is only drawn once an update gets none.
+*/
+bool isPenInputPending(const PenInput* input) {
+    return input->strokeButtons && !input->path.caughtUp;
+}
+
+/*
+* Update the fps and save progress text, invalidating the frame if it changed.
+*/
+void updateFrameText(FrameSchedule* frame, MetaData* metadata, Canvas* canvas) {
+    Uint32 now = SDL_GetTicks();
+    if (now - frame->shownFpsTime >= FPS_TEXT_INTERVAL) {
+        frame->shownFpsTime = now;
+        // fps is shown with 2 decimals, so smaller changes don't matter
+        if ((int)(metadata->fps * 100) != (int)(frame->shownFps * 100)) {
+            frame->shownFps = metadata->fps;
+            invalidateFrame(REDRAW_TEXT);
+        }
+    }
+
+    int saveProgress = canvas->saveJob ? (int)(getSaveProgress(canvas->saveJob) * 100) : -1;
+    if (saveProgress != frame->shownSaveProgress) {
+        frame->shownSaveProgress = saveProgress;
+        invalidateFrame(REDRAW_TEXT);
+    }
+}
+
+/*
+* Undo or redo the last stroke, on whichever layer it was drawn.
+*/
+void undoCanvasStroke(Canvas* canvas, Pen* pen, PenInput* input, bool redo) {
+    // finish any stroke in progress first so it can be undone too
+    endPenTransform(canvas, pen, input);
+    endHistoryStroke(&canvas->history, getActiveTiles(canvas));
+    int layer = redo ? getRedoLayer(&canvas->history) : getUndoLayer(&canvas->history);
+    if (layer < 0 || layer >= getLayerCount(&canvas->layers)) {
+        return;
+    }
+    TileGrid* tiles = &canvas->layers.layers[layer].tiles;
+    SDL_Rect changedRect;
+    bool changed = redo ?
+        redoHistory(&canvas->history, tiles, &changedRect) :
+        undoHistory(&canvas->history, tiles, &changedRect);
+    if (changed) {
+        markLayerDirty(canvas, layer, changedRect.x, changedRect.y, changedRect.w, changedRect.h);
+    }
+}
+
+/*
+* Handle the layer keyboard shortcuts:
+* L adds a layer above the current one, Delete removes the current layer,
+* Page Up / Page Down pick the layer above / below, and move the current layer up / down with shift,
+* H hides / shows the current layer, O steps its opacity down, and K goes to the next blend mode.
+* @return true if the key was a layer shortcut
+*/
+bool handleLayerKey(Canvas* canvas, Pen* pen, PenInput* input, SDL_Keysym key) {
+    switch (key.sym) {
+        case SDLK_l: case SDLK_DELETE: case SDLK_PAGEUP: case SDLK_PAGEDOWN: case SDLK_h: case SDLK_o: case SDLK_k:
+            break;
+        default:
+            return false;
+    }
+    // strokes only go on one layer
+    if (input->strokeButtons) {
+        endPenStroke(canvas, pen, input);
+    }
+    endPenTransform(canvas, pen, input);
+
+    LayerStack* layers = &canvas->layers;
+    int numLayers = getLayerCount(layers);
+    int active = canvas->activeLayer;
+    // new index of each old layer, if layers get added, removed or moved
+    std::vector<int> newLayers;
+    bool changedImage = true;
+    switch (key.sym) {
+        case SDLK_l:
+            if (insertLayer(layers, active + 1) == 0) {
+                for (int i = 0; i < numLayers; i++) {
+                    newLayers.push_back(i <= active ? i : i + 1);
+                }
+                canvas->activeLayer++;
+            }
+            break;
+        case SDLK_DELETE:
+            if (numLayers > 1) {
+                for (int i = 0; i < numLayers; i++) {
+                    newLayers.push_back(i < active ? i : (i == active ? -1 : i - 1));
+                }
+                removeLayer(layers, active);
+                canvas->activeLayer = std::min(active, numLayers - 2);
+            }
+            break;
+        case SDLK_PAGEUP:
+        case SDLK_PAGEDOWN: {
+            int other = key.sym == SDLK_PAGEUP ? active + 1 : active - 1;
+            if (other < 0 || other >= numLayers) {
+                changedImage = false;
+                break;
+            }
+            if (key.mod & KMOD_SHIFT) {
+                swapLayerWithAbove(layers, std::min(active, other));
+                for (int i = 0; i < numLayers; i++) {
+                    newLayers.push_back(i == active ? other : (i == other ? active : i));
+                }
+            } else {
+                changedImage = false;
+            }
+            canvas->activeLayer = other;
+            break;
+        }
+        case SDLK_h:
+            layers->layers[active].visible = !layers->layers[active].visible;
+            break;
+        case SDLK_o: {
+            // 100, 75, 50, 25, then back to 100
+            float opacity = layers->layers[active].opacity;
+            layers->layers[active].opacity = opacity > 0.3f ? opacity - 0.25f : 1.0f;
+            break;
+        }
+        case SDLK_k:
+            layers->layers[active].blendMode = (BlendMode)((layers->layers[active].blendMode + 1) % BLEND_MODE_COUNT);
+            break;
+    }
+
+    if (!newLayers.empty()) {
+        remapHistoryLayers(&canvas->history, newLayers);
+    }
+    if (changedImage) {
+        // the composite changes from the lowest affected layer up, across the whole canvas
+        int lowestLayer = std::min(active, canvas->activeLayer);
+        markLayerDirty(canvas, std::min(lowestLayer, getLayerCount(layers) - 1), 0, 0, canvas->width, canvas->height);
+    }
+    // for the layer text
+    invalidateFrame(REDRAW_TEXT);
+    return true;
+}
 
 // Main game loop
 int update(Context ctx) {
+#ifndef __EMSCRIPTEN__
+    if (!frameSchedule.redraw && !isPenInputPending(ctx.penInput)) {
+        // nothing to draw, so sleep until there's input instead of spinning.
+        // the browser already only calls us once per animation frame
+        SDL_WaitEventTimeout(NULL, ctx.canvas->saveJob ? IDLE_WAIT_TIMEOUT_SAVING : IDLE_WAIT_TIMEOUT);
+    }
+#endif
     updateMetaData(ctx.metaData);
 
     bool quit = false;
@@ -361,12 +1165,13 @@ int update(Context ctx) {
     // handle events //
     // get user input state for this update
     int mouseX,mouseY;
-    Uint32 mouseButtons = SDL_GetMouseState(&mouseX, &mouseY);
+    SDL_GetMouseState(&mouseX, &mouseY);
     // scale relative to actual pixels
     mouseX *= ctx.sdlCtx->scale;
     mouseY *= ctx.sdlCtx->scale;
 
     Canvas* canvas = ctx.canvas;
+    PenInput* penInput = ctx.penInput;
 
     SDL_Event e;
     while (SDL_PollEvent(&e) != 0) {
@@ -384,17 +1189,50 @@ int update(Context ctx) {
                     windowFocused = true;
                 } else if (e.window.event == SDL_WINDOWEVENT_FOCUS_LOST) {
                     windowFocused = false;
+                } else if (e.window.event == SDL_WINDOWEVENT_EXPOSED || e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED ||
+                    e.window.event == SDL_WINDOWEVENT_SHOWN || e.window.event == SDL_WINDOWEVENT_RESTORED) {
+                    // the window contents might be gone
+                    invalidateFrame(REDRAW_WINDOW);
                 }
                 break;
+            case SDL_RENDER_TARGETS_RESET:
+            case SDL_RENDER_DEVICE_RESET:
+                invalidateFrame(REDRAW_WINDOW);
+                break;
+            case SDL_MOUSEMOTION:
+                // every motion event is kept so fast strokes don't get cut into straight lines between frames
+                addPenSample(penInput, canvas, e.motion.x * ctx.sdlCtx->scale, e.motion.y * ctx.sdlCtx->scale,
+                    e.motion.state, e.motion.timestamp);
+                break;
             case SDL_MOUSEBUTTONDOWN:
                 if (e.button.button == SDL_BUTTON_LEFT) {
                     SDL_Log("Mouse clicked at %d,%d", mouseX, mouseY);
                 } else if (e.button.button == SDL_BUTTON_RIGHT) {
 
                 }
+                addPenSample(penInput, canvas, e.button.x * ctx.sdlCtx->scale, e.button.y * ctx.sdlCtx->scale,
+                    penInput->buttons | SDL_BUTTON(e.button.button), e.button.timestamp);
+                break;
+            case SDL_MOUSEBUTTONUP:
+                addPenSample(penInput, canvas, e.button.x * ctx.sdlCtx->scale, e.button.y * ctx.sdlCtx->scale,
+                    penInput->buttons & ~SDL_BUTTON(e.button.button), e.button.timestamp);
                 break;
             case SDL_KEYDOWN:
+                if (handleLayerKey(canvas, ctx.pen, penInput, e.key.keysym)) {
+                    break;
+                }
                 switch(e.key.keysym.sym) {
+                    case SDLK_z:
+                        // ctrl on windows/linux, cmd on mac
+                        if (e.key.keysym.mod & (KMOD_CTRL | KMOD_GUI)) {
+                            undoCanvasStroke(canvas, ctx.pen, penInput, (e.key.keysym.mod & KMOD_SHIFT) != 0);
+                        }
+                        break;
+                    case SDLK_y:
+                        if (e.key.keysym.mod & (KMOD_CTRL | KMOD_GUI)) {
+                            undoCanvasStroke(canvas, ctx.pen, penInput, true);
+                        }
+                        break;
                     case SDLK_LEFT:
                         translateCanvas(canvas, -5, 0);
                         SDL_Log("translation: %d,%d", ctx.canvas->translateX, ctx.canvas->translateY);
@@ -408,20 +1246,97 @@ int update(Context ctx) {
                     case SDLK_UP:
                         translateCanvas(canvas, 0, -5);
                         break;
-                    /*
-                    // currently ultra broken, makes zero sense whatsoever, so just gonna give up
                     case SDLK_m:
                         // save canvas
-                        saveCanvas(canvas);
-                        renderEntireCanvas(ctx.sdlCtx->ren, canvas);
-                        *?
+                        saveCanvas(canvas, SAVE_FORMAT_PROJECT);
                         break;
                     case SDLK_n:
-                        // load canvas
+                        // load canvas. whatever's floating would be lost with the layer it came from, so put it down first
+                        endPenTransform(canvas, ctx.pen, penInput);
                         loadCanvasFromSave(canvas, ctx.sdlCtx->ren);
-                        renderEntireCanvas(ctx.sdlCtx->ren, canvas);
                         break;
-                    */
+                    case SDLK_e:
+                        saveCanvas(canvas, SAVE_FORMAT_PNG);
+                        break;
+                    case SDLK_i:
+                        if (e.key.keysym.mod & (KMOD_CTRL | KMOD_GUI)) {
+                            endPenTransform(canvas, ctx.pen, penInput);
+                            invertSelection(&canvas->selection);
+                            updateSelectionOutline(canvas);
+                        } else {
+                            endPenTransform(canvas, ctx.pen, penInput);
+                            importCanvasImage(canvas, ctx.sdlCtx->ren);
+                        }
+                        break;
+                    case SDLK_a:
+                        if (e.key.keysym.mod & (KMOD_CTRL | KMOD_GUI)) {
+                            endPenTransform(canvas, ctx.pen, penInput);
+                            selectAll(&canvas->selection);
+                            updateSelectionOutline(canvas);
+                        }
+                        break;
+                    case SDLK_d:
+                        if (e.key.keysym.mod & (KMOD_CTRL | KMOD_GUI)) {
+                            endPenTransform(canvas, ctx.pen, penInput);
+                            clearSelection(&canvas->selection);
+                            updateSelectionOutline(canvas);
+                        }
+                        break;
+                    case SDLK_LEFTBRACKET:
+                        if (ctx.pen->size > 1) ctx.pen->size--;
+                        break;
+                    case SDLK_RIGHTBRACKET:
+                        if (ctx.pen->size < PEN_MAX_SIZE) ctx.pen->size++;
+                        break;
+                    case SDLK_b:
+                        ctx.pen->shape = (ctx.pen->shape == BRUSH_ROUND) ? BRUSH_SQUARE : BRUSH_ROUND;
+                        break;
+                    case SDLK_s:
+                        // takes effect from the next stroke
+                        ctx.pen->smoothing = !ctx.pen->smoothing;
+                        break;
+                    case SDLK_p:
+                        // also takes effect from the next stroke
+                        ctx.pen->blendMode = (BlendMode)((ctx.pen->blendMode + 1) % BLEND_MODE_COUNT);
+                        invalidateFrame(REDRAW_TEXT);
+                        break;
+                    case SDLK_f:
+                        switchPenTool(canvas, ctx.pen, penInput, PEN_TOOL_FILL);
+                        break;
+                    case SDLK_r:
+                        switchPenTool(canvas, ctx.pen, penInput, PEN_TOOL_SELECT_RECT);
+                        break;
+                    case SDLK_q:
+                        switchPenTool(canvas, ctx.pen, penInput, PEN_TOOL_LASSO);
+                        break;
+                    case SDLK_w:
+                        switchPenTool(canvas, ctx.pen, penInput, PEN_TOOL_WAND);
+                        break;
+                    case SDLK_v:
+                        switchPenTool(canvas, ctx.pen, penInput, PEN_TOOL_TRANSFORM);
+                        break;
+                    case SDLK_RETURN:
+                        if (ctx.pen->tool == PEN_TOOL_TRANSFORM) {
+                            switchPenTool(canvas, ctx.pen, penInput, PEN_TOOL_TRANSFORM);
+                        }
+                        break;
+                    case SDLK_g:
+                        ctx.pen->fillMode = (ctx.pen->fillMode == FILL_GLOBAL) ? FILL_CONTIGUOUS : FILL_GLOBAL;
+                        invalidateFrame(REDRAW_TEXT);
+                        break;
+                    case SDLK_t:
+                        // 0, 16, 32, 64, 128, then back to 0
+                        ctx.pen->fillTolerance = ctx.pen->fillTolerance >= 128 ? 0 : std::max(ctx.pen->fillTolerance * 2, 16);
+                        invalidateFrame(REDRAW_TEXT);
+                        break;
+                    case SDLK_ESCAPE:
+                        if (canvas->floating) {
+                            endCanvasTransform(canvas, false);
+                            switchPenTool(canvas, ctx.pen, penInput, PEN_TOOL_TRANSFORM);
+                        } else if (canvas->saveJob) {
+                            cancelSave(canvas->saveJob);
+                        }
+                        break;
                 }
                 break;
             case SDL_MOUSEWHEEL:
@@ -446,72 +1361,20 @@ int update(Context ctx) {
     }
 #endif
 
-    Pen* pen = ctx.pen;
-    if ((mouseButtons & SDL_BUTTON_LMASK) == SDL_BUTTON_LMASK || (mouseButtons & SDL_BUTTON_RMASK) == SDL_BUTTON_RMASK) {
-
-        // save old pixel setting so we can set it back after
-        Pixel savedPenPixel = pen->pixel;
-        if ((mouseButtons & SDL_BUTTON_RMASK) == SDL_BUTTON_RMASK) {
-            pen->pixel = (Pixel){0, 0, 0, 0};
-        }
-
-        // check if mouse is within bounds of canvas
-        Vec2 mouseCanvasPos = screenToCanvasCoords(canvas, mouseX, mouseY);
-        if (mouseCanvasPos.x >= 0 && mouseCanvasPos.x < canvas->width &&
-            mouseCanvasPos.y >= 0 && mouseCanvasPos.y < canvas->height) {
-            // then do drawing on mouse
-            int penX = (int)floor(mouseCanvasPos.x);
-            int penY = (int)floor(mouseCanvasPos.y);
+    drawPenInput(canvas, ctx.pen, penInput);
 
-            penDrawOnCanvas(canvas, pen, penX, penY, ctx.sdlCtx->ren);
-        }
-
-        // the mouse state for the last update
-        // loop over with high iq techniques (size 5 array, just add 4 instead of subtracting 1)
-        MouseState lastMouseState = ctx.mouseStateHistory[(*ctx.mouseStateHistoryQueueIndex+4) % 5];
-        // connect lines between updates if both were drawing,
-        // for smoother line drawing on lower fps
-
-        if (lastMouseState.mouseButtons & (SDL_BUTTON_LMASK | SDL_BUTTON_RMASK)) {
+    updateCanvasSave(canvas);
 
-            /* draw along old and new pen positions to smooth out quickly drawn lines */
-            Vec2 lastMouseCanvasPos = screenToCanvasCoords(canvas, lastMouseState.mouseX, lastMouseState.mouseY);
+    // flag everything drawn this update for re-upload in one go
+    uploadCanvasChanges(canvas);
 
-            Vec2 mouseDelta = {mouseCanvasPos.x - lastMouseCanvasPos.x, mouseCanvasPos.y - lastMouseCanvasPos.y};
-            
-            float step;
-            if (abs(mouseDelta.x) >= abs(mouseDelta.y)) {
-                step = abs(mouseDelta.x);
-            } else {
-                step = abs(mouseDelta.y);
-            }
-            float dx = mouseDelta.x / step;
-            float dy = mouseDelta.y / step;
-            float x = lastMouseCanvasPos.x;
-            float y = lastMouseCanvasPos.y;
-            int i = 1;
-            while (i <= step) {
-                penDrawOnCanvas(canvas, pen, (int)floor(x), (int)floor(y), ctx.sdlCtx->ren);
-                x += dx;
-                y += dy;
-                i++;
-            }
-        }
-
-        // SDL_Log("saved pixel: %d,%d,%d", savedPenPixel.r, savedPenPixel.g, savedPenPixel.b);
-        pen->pixel = savedPenPixel;
+    // only draw a frame when it would look different from the last one
+    updateFrameText(&frameSchedule, ctx.metaData, canvas);
+    if (frameSchedule.redraw) {
+        render(ctx.sdlCtx->ren, ctx.sdlCtx->scale, ctx.canvas, ctx.pen, ctx.penInput, ctx.gui, &frameSchedule);
+        frameSchedule.redraw = 0;
     }
 
-    render(ctx.sdlCtx->ren, ctx.sdlCtx->scale, ctx.canvas, ctx.pen, ctx.gui, ctx.metaData);
-
-    ctx.mouseStateHistory[*ctx.mouseStateHistoryQueueIndex] = {
-        .mouseX = mouseX,
-        .mouseY = mouseY,
-        .mouseButtons = mouseButtons
-    };
-    (*ctx.mouseStateHistoryQueueIndex)++;
-    *ctx.mouseStateHistoryQueueIndex %= 5;
-
     if (quit) {
         SDL_Log("Update loop quitting...");
         return 1;
@@ -528,23 +1391,60 @@ int updateWrapper(void *param) {
 // load assets and stuff
 int load(SDL_Renderer *ren, float renderScale = 1.0f) {
     tex = IMG_LoadTexture(ren, "assets/pixelart/WatermelonSlice.png");
+    // fonts come from the atlases baked by make fontAtlases when they're there, see FontAtlas.hpp
     FreeSans = FC_CreateFont();
-    FC_LoadFont(FreeSans, ren, "assets/fonts/FreeSans.ttf", 24*renderScale, FC_MakeColor(0, 0, 0, 255), TTF_STYLE_NORMAL);
+    loadFontWithAtlas(FreeSans, ren, "assets/fonts/FreeSans.ttf", 24*renderScale, FC_MakeColor(0, 0, 0, 255), &FreeSansTTF);
 
     TitleFont = FC_CreateFont();
-    FC_LoadFont(TitleFont, ren, "assets/fonts/Ubuntu-Regular.ttf", 36*renderScale, FC_MakeColor(0, 0, 0, 255), TTF_STYLE_NORMAL);
+    loadFontWithAtlas(TitleFont, ren, "assets/fonts/Ubuntu-Regular.ttf", 36*renderScale, FC_MakeColor(0, 0, 0, 255), &TitleFontTTF);
     
     InfoFont = FC_CreateFont();
-    FC_LoadFont(InfoFont, ren, "assets/fonts/FreeSans.ttf", 12*renderScale, FC_MakeColor(0, 0, 0, 255), TTF_STYLE_NORMAL);
+    loadFontWithAtlas(InfoFont, ren, "assets/fonts/FreeSans.ttf", 12*renderScale, FC_MakeColor(0, 0, 0, 255), &InfoFontTTF);
+
+    FpsText = FC_CreateText(FreeSans);
+    SaveProgressText = FC_CreateText(InfoFont);
+    TitleText = FC_CreateText(TitleFont);
+    FC_SetTextAlign(TitleText, FC_ALIGN_CENTER);
+    FC_SetTextString(TitleText, "Pixel Art Maker");
+    LayerText = FC_CreateText(InfoFont);
+    FC_SetTextAlign(LayerText, FC_ALIGN_RIGHT);
+    ToolText = FC_CreateText(InfoFont);
+    FC_SetTextAlign(ToolText, FC_ALIGN_RIGHT);
+    HelpText = FC_CreateText(InfoFont);
+    FC_SetTextString(HelpText,
+    "Left mouse to draw, right mouse to erase. M to save, N to load, E to export PNG, I to import PNG.\n"
+    "Scroll with mouse to zoom in/out, arrow keys to move around when zoomed.\n"
+    "[ and ] to change pen size, B to switch between a round and square pen, S to toggle stroke smoothing, P for pen blend mode.\n"
+    "L to add a layer, Delete to remove it, Page Up/Down to pick a layer (shift to move it), H to hide, O for opacity, K for blend mode.\n"
+    "F to switch between the pen and fill bucket, G to fill everywhere or just the connected area, T for fill tolerance.\n"
+    "R, Q and W for rectangle, lasso and magic wand selection (shift adds, alt or right mouse subtracts). Ctrl+A/D/I to select all, deselect or invert.\n"
+    "V to move the selection, shift to scale it, right mouse to rotate it. Enter or V again to put it down, Esc to cancel.");
 
     return 0;
 }
 
+// lets SDL2_gfx's rotozoomer and filter pipelines split their work over the app's thread pool
+void gfxParallelFor(int count, void (*job)(void* data, int index), void* data) {
+    getThreadPool()->parallelFor(count, [&](int i) {
+        job(data, i);
+    });
+}
+
 // unload assets and stuff
 void unload() {
     SDL_DestroyTexture(tex);
+    FC_FreeText(FpsText);
+    FC_FreeText(SaveProgressText);
+    FC_FreeText(TitleText);
+    FC_FreeText(LayerText);
+    FC_FreeText(ToolText);
+    FC_FreeText(HelpText);
     FC_FreeFont(FreeSans);
     FC_FreeFont(TitleFont);
+    FC_FreeFont(InfoFont);
+    TTF_CloseFont(FreeSansTTF);
+    TTF_CloseFont(TitleFontTTF);
+    TTF_CloseFont(InfoFontTTF);
 }
 
 int main() {
@@ -555,6 +1455,8 @@ int main() {
     settings.vsync = true;
     SDLContext sdlCtx = initSDLAndContext(&settings); // SDL Context
     SDL_Log("Window scale: %f", sdlCtx.scale);
+    rotozoomSetParallelFor(gfxParallelFor);
+    SDL_imageFilterSetParallelFor(gfxParallelFor);
     int windowWidth,windowHeight;
     SDL_GetWindowSize(sdlCtx.win, &windowWidth, &windowHeight);
     struct MetaData metaData = initMetaData();
@@ -563,20 +1465,32 @@ int main() {
     canvas.scale = canvas.pixelSize * sdlCtx.scale;
     canvas.width = 256;
     canvas.height = 256;
-    canvas.pixels = createPixelBuffer(canvas.width, canvas.height);
+    initLayerStack(&canvas.layers, canvas.width, canvas.height);
+    canvas.activeLayer = 0;
     canvas.windowOffsetX = 0;
     canvas.windowOffsetY = 0;
     canvas.zoom = 1.0f;
     canvas.translateX = 0;
     canvas.translateY = 0;
-    canvas.texture = SDL_CreateTexture(sdlCtx.ren, SDL_PIXELFORMAT, SDL_TEXTUREACCESS_TARGET, canvas.width, canvas.height);
-    SDL_SetTextureBlendMode(canvas.texture, SDL_BLENDMODE_BLEND);
+    initTileTextureCache(&canvas.tileTextures, sdlCtx.ren, &canvas.layers.composite, CANVAS_VRAM_BUDGET);
+    canvas.dirtyRect = (SDL_Rect){0, 0, 0, 0};
+    initHistory(&canvas.history, HISTORY_MEMORY_BUDGET);
+    initSelection(&canvas.selection, canvas.width, canvas.height);
+    canvas.floating = NULL;
+    beginStrokeMask(&canvas.strokeMask, getActiveTiles(&canvas), NULL);
+    canvas.saveJob = NULL;
     resizeCanvas(&canvas, windowWidth, windowHeight, sdlCtx.scale);
 
 
     Pen pen;
     pen.pixel = (Pixel){0, 255, 255, 120};
     pen.size = 1;
+    pen.shape = BRUSH_ROUND;
+    pen.smoothing = true;
+    pen.blendMode = BLEND_NORMAL;
+    pen.tool = PEN_TOOL_BRUSH;
+    pen.fillTolerance = 0;
+    pen.fillMode = FILL_CONTIGUOUS;
 
     GUI gui;
     {
@@ -601,9 +1515,6 @@ int main() {
 
     load(sdlCtx.ren, sdlCtx.scale);
 
-    // do initial rendering
-    renderEntireCanvas(sdlCtx.ren, &canvas);
-
     windowFocused = true;
     
     struct Context context;
@@ -612,19 +1523,29 @@ int main() {
     context.canvas = &canvas;
     context.pen = &pen;
     context.gui = &gui;
-    context.mouseStateHistory = (MouseState*)malloc(5 * sizeof(MouseState));
-    for (int i = 0; i < 5; i++) {
-        context.mouseStateHistory[i].mouseButtons = 0;
-        context.mouseStateHistory[i].mouseX = 0;
-        context.mouseStateHistory[i].mouseY = 0;
-    }
-    int mouseStateHistoryQueueIndex = 0;
-    context.mouseStateHistoryQueueIndex = &mouseStateHistoryQueueIndex;
+    PenInput penInput;
+    penInput.buttons = 0;
+    penInput.strokeButtons = 0;
+    penInput.toolButtons = 0;
+    penInput.selectionOp = SELECTION_REPLACE;
+    beginStrokePath(&penInput.path, pen.smoothing);
+    context.penInput = &penInput;
 
     NC_SetMainLoop(updateWrapper, &context);
 
-    free(canvas.pixels);
-    SDL_DestroyTexture(canvas.texture);
+    if (canvas.saveJob) {
+        // let the save finish so it isn't lost
+        finishSave(canvas.saveJob);
+    }
+    destroyHistory(&canvas.history);
+    destroyStrokeMask(&canvas.strokeMask);
+    if (canvas.floating) {
+        destroyFloatingPixels(canvas.floating);
+        delete canvas.floating;
+    }
+    destroySelection(&canvas.selection);
+    destroyLayerStack(&canvas.layers);
+    destroyTileTextureCache(&canvas.tileTextures);
 
     unload();
 
@@ -0,0 +1,51 @@
+/*
+* Bakes the glyph atlases the app loads its fonts from, see FontAtlas.hpp.
+* Usage: BakeFontAtlases <ttf> <point size>... [<ttf> <point size>...]
+* Every point size after a TTF gets its own atlas. Fonts are rasterized with a software renderer, so no window is needed.
+*/
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+
+#include "../FontAtlas.hpp"
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        SDL_Log("Usage: %s <ttf> <point size>... [<ttf> <point size>...]", argv[0]);
+        return 1;
+    }
+
+    // the renderer draws into a surface nothing ever looks at, the glyph caches are its own render targets
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, 1, 1, 32, SDL_PIXELFORMAT_RGBA32);
+    SDL_Renderer* renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+    if (!renderer) {
+        SDL_Log("Error: Failed to create a software renderer. SDL_Error: %s", SDL_GetError());
+        SDL_FreeSurface(surface);
+        return 1;
+    }
+
+    int failed = 0;
+    const char* ttfPath = NULL;
+    for (int i = 1; i < argc; i++) {
+        char* end;
+        long pointSize = strtol(argv[i], &end, 10);
+        if (*end != '\0') {
+            ttfPath = argv[i];
+            continue;
+        }
+        if (!ttfPath || pointSize <= 0) {
+            SDL_Log("Error: %s isn't a point size following a font.", argv[i]);
+            failed++;
+            continue;
+        }
+        if (bakeFontAtlas(renderer, ttfPath, (int)pointSize)) {
+            failed++;
+        }
+    }
+
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(surface);
+    TTF_Quit();
+    SDL_Quit();
+    return failed ? 1 : 0;
+}